@@ -12,6 +12,9 @@ set CPP_FLAGS=/std:c++20 /GR- /EHsc /nologo /MP /Gm- /Zc:inline^
  /D"JPH_DEBUG_RENDERER"^
  /D"_TRACY_ENABLE"^
  /D"_TRACY_CALLSTACK"^
+ /D"_JPH_EXTERNAL_PROFILE"^
+ /D"_JPH_PROFILE_ENABLED"^
+ /D"_JPH_ENABLE_DETERMINISM_LOG"^
  /I"deps/d3d12"^
  /I"deps/imgui"^
  /I"deps/directxmath"^
@@ -29,6 +32,10 @@ set LINK_FLAGS=/INCREMENTAL:NO /OUT:%NAME%.exe
 if %CONFIG%==D set LINK_FLAGS=%LINK_FLAGS% /DEBUG:FULL
 if %CONFIG%==R set LINK_FLAGS=%LINK_FLAGS%
 
+set BENCH_LINK_FLAGS=/INCREMENTAL:NO /OUT:%NAME%_bench.exe
+if %CONFIG%==D set BENCH_LINK_FLAGS=%BENCH_LINK_FLAGS% /DEBUG:FULL
+if %CONFIG%==R set BENCH_LINK_FLAGS=%BENCH_LINK_FLAGS%
+
 set DXC=d3d12\dxc.exe
 set HLSL_OUT_DIR=assets
 set HLSL_SM=6_6
@@ -56,12 +63,15 @@ set SRC_JOLT=%SRC_JOLT_ROOT%\AABBTree\AABBTreeBuilder.cpp^
  %SRC_JOLT_ROOT%\Core\JobSystemSingleThreaded.cpp^
  %SRC_JOLT_ROOT%\Core\JobSystemThreadPool.cpp^
  %SRC_JOLT_ROOT%\Core\JobSystemWithBarrier.cpp^
+ %SRC_JOLT_ROOT%\Core\JobSystemWorkStealing.cpp^
  %SRC_JOLT_ROOT%\Core\LinearCurve.cpp^
  %SRC_JOLT_ROOT%\Core\Memory.cpp^
  %SRC_JOLT_ROOT%\Core\Profiler.cpp^
  %SRC_JOLT_ROOT%\Core\RTTI.cpp^
  %SRC_JOLT_ROOT%\Core\Semaphore.cpp^
  %SRC_JOLT_ROOT%\Core\StringTools.cpp^
+ %SRC_JOLT_ROOT%\Core\TempAllocatorGrowing.cpp^
+ %SRC_JOLT_ROOT%\Core\ThreadTopology.cpp^
  %SRC_JOLT_ROOT%\Core\TickCounter.cpp^
  %SRC_JOLT_ROOT%\Geometry\ConvexHullBuilder.cpp^
  %SRC_JOLT_ROOT%\Geometry\ConvexHullBuilder2D.cpp^
@@ -90,6 +100,7 @@ set SRC_JOLT=%SRC_JOLT_ROOT%\AABBTree\AABBTreeBuilder.cpp^
  %SRC_JOLT_ROOT%\Physics\Collision\BroadPhase\BroadPhase.cpp^
  %SRC_JOLT_ROOT%\Physics\Collision\BroadPhase\BroadPhaseBruteForce.cpp^
  %SRC_JOLT_ROOT%\Physics\Collision\BroadPhase\BroadPhaseQuadTree.cpp^
+ %SRC_JOLT_ROOT%\Physics\Collision\BroadPhase\BroadPhaseSAP.cpp^
  %SRC_JOLT_ROOT%\Physics\Collision\BroadPhase\QuadTree.cpp^
  %SRC_JOLT_ROOT%\Physics\Collision\CastConvexVsTriangles.cpp^
  %SRC_JOLT_ROOT%\Physics\Collision\CastSphereVsTriangles.cpp^
@@ -151,6 +162,7 @@ set SRC_JOLT=%SRC_JOLT_ROOT%\AABBTree\AABBTreeBuilder.cpp^
  %SRC_JOLT_ROOT%\Physics\PhysicsScene.cpp^
  %SRC_JOLT_ROOT%\Physics\PhysicsSystem.cpp^
  %SRC_JOLT_ROOT%\Physics\PhysicsUpdateContext.cpp^
+ %SRC_JOLT_ROOT%\Physics\PhysicsUpdateStats.cpp^
  %SRC_JOLT_ROOT%\Physics\Ragdoll\Ragdoll.cpp^
  %SRC_JOLT_ROOT%\Physics\SoftBody\SoftBodyCreationSettings.cpp^
  %SRC_JOLT_ROOT%\Physics\SoftBody\SoftBodyMotionProperties.cpp^
@@ -218,10 +230,15 @@ IF NOT EXIST pch.lib (
  cl %CPP_FLAGS% /Fo"pch.lib" /Fp"game.pch" /c /Yc"game_pch.h" "game_pch.cpp"
 ) & if ERRORLEVEL 1 GOTO error
 
-IF NOT "%1"=="hlsl" (
+IF NOT "%1"=="hlsl" IF NOT "%1"=="bench" (
  IF EXIST %NAME%.exe DEL %NAME%.exe
  cl %CPP_FLAGS% /Fp"game.pch" /Yu"game_pch.h" game_main.cpp /link %LINK_FLAGS%^
-  pch.lib imgui.lib jolt.lib tracy.lib kernel32.lib user32.lib dxgi.lib d3d12.lib d2d1.lib
+  pch.lib imgui.lib jolt.lib tracy.lib kernel32.lib user32.lib dxgi.lib d3d12.lib d2d1.lib dbghelp.lib
+) & if ERRORLEVEL 1 GOTO error
+
+IF "%1"=="bench" (
+ IF EXIST %NAME%_bench.exe DEL %NAME%_bench.exe
+ cl %CPP_FLAGS% /D"GAME_HEADLESS" game_bench.cpp /link %BENCH_LINK_FLAGS% jolt.lib tracy.lib kernel32.lib dbghelp.lib
 ) & if ERRORLEVEL 1 GOTO error
 
 GOTO end
@@ -235,6 +252,7 @@ IF EXIST *.obj DEL *.obj
 IF EXIST *.exp DEL *.exp
 
 IF "%1"=="run" IF EXIST %NAME%.exe %NAME%.exe
+IF "%1"=="bench" IF EXIST %NAME%_bench.exe %NAME%_bench.exe %2 %3 %4 %5 %6 %7 %8 %9
 
 set COMPILE_HLSL=0
 IF "%1"=="hlsl" set COMPILE_HLSL=1
@@ -244,4 +262,6 @@ IF %COMPILE_HLSL%==1 (
  IF EXIST %HLSL_OUT_DIR%\*.cso DEL %HLSL_OUT_DIR%\*.cso
  %DXC% %HLSL_FLAGS% /T vs_%HLSL_SM% /E s00_vs /D_S00 game_shaders.cpp /Fo %HLSL_OUT_DIR%\s00_vs.cso
  %DXC% %HLSL_FLAGS% /T ps_%HLSL_SM% /E s00_ps /D_S00 game_shaders.cpp /Fo %HLSL_OUT_DIR%\s00_ps.cso
+ %DXC% %HLSL_FLAGS% /T vs_%HLSL_SM% /E s01_vs /D_S01 game_shaders.cpp /Fo %HLSL_OUT_DIR%\s01_vs.cso
+ %DXC% %HLSL_FLAGS% /T ps_%HLSL_SM% /E s01_ps /D_S01 game_shaders.cpp /Fo %HLSL_OUT_DIR%\s01_ps.cso
 )
@@ -10,9 +10,56 @@
 
 JPH_NAMESPACE_BEGIN
 
+/// Hands out a small index per thread for the magazines of FixedSizeFreeList, indices are reused after a thread exits
+class FixedSizeFreeListThreadIndex
+{
+public:
+	/// Max number of threads that can have an index at the same time, other threads don't use magazines
+	static constexpr uint32	cMaxThreads = 64;
+
+	/// Index of the calling thread, >= cMaxThreads if all indices are taken
+	static uint32			sGet()
+	{
+		static thread_local FixedSizeFreeListThreadIndex sIndex;
+		return sIndex.mIndex;
+	}
+
+private:
+	/// Claim the lowest free index
+							FixedSizeFreeListThreadIndex()
+	{
+		uint64 used = sUsed.load(memory_order_relaxed);
+		while (used != ~uint64(0))
+		{
+			uint64 free = ~used;
+			uint32 index = uint32(free) != 0? CountTrailingZeros(uint32(free)) : 32 + CountTrailingZeros(uint32(free >> 32));
+			if (sUsed.compare_exchange_weak(used, used | (uint64(1) << index), memory_order_acquire))
+			{
+				mIndex = index;
+				return;
+			}
+		}
+	}
+
+	/// Release the index, the next thread that gets it takes over the magazines (and the objects in them)
+							~FixedSizeFreeListThreadIndex()
+	{
+		if (mIndex < cMaxThreads)
+			sUsed.fetch_and(~(uint64(1) << mIndex), memory_order_release);
+	}
+
+	uint32					mIndex = cMaxThreads;
+	static inline atomic<uint64> sUsed { 0 };
+};
+
 /// Class that allows lock free creation / destruction of objects (unless a new page of objects needs to be allocated)
 /// It contains a fixed pool of objects and also allows batching up a lot of objects to be destroyed
 /// and doing the actual free in a single atomic operation
+///
+/// Optionally every thread gets a magazine: a small private list of free objects in front of the shared list.
+/// ConstructObject / DestructObject then only touch the shared list once per inMagazineSize objects (moving a batch in
+/// one CAS) instead of on every call. Each thread can hold up to 2 * inMagazineSize free objects that other threads
+/// can't use, so reserve that many extra objects per thread when sizing the list.
 template <typename Object>
 class FixedSizeFreeList : public NonCopyable
 {
@@ -69,6 +116,32 @@ private:
 	/// Mutex that is used to allocate a new page if the storage runs out
 	Mutex					mPageMutex;
 
+	/// Private list of free objects of a thread, linked through mNextFreeObject
+	struct alignas(JPH_CACHE_LINE_SIZE) Magazine
+	{
+		uint32				mFirstObjectIndex;
+		uint32				mLastObjectIndex;
+		atomic<uint32>		mNumObjects { 0 };						///< Only written by the owning thread, atomic so other threads can read statistics
+	};
+
+	/// Magazine per FixedSizeFreeListThreadIndex or nullptr if magazines are disabled
+	Magazine *				mMagazines = nullptr;
+
+	/// Number of objects that a magazine takes from / returns to the shared list at once
+	uint32					mMagazineSize = 0;
+
+	/// Get the magazine of the calling thread, nullptr if magazines are disabled or the thread didn't get an index
+	inline Magazine *		GetMagazine();
+
+	/// Take an object from the shared list (or a new page), returns cInvalidObjectIndex if out of space
+	inline uint32			PopObject();
+
+	/// Take up to inMaxObjects objects from the shared list in a single atomic operation, returns the number of objects taken
+	inline uint32			PopObjects(uint32 inMaxObjects, uint32 &outFirstObjectIndex, uint32 &outLastObjectIndex);
+
+	/// Return a linked list of objects to the shared list in a single atomic operation
+	inline void				PushObjects(uint32 inFirstObjectIndex, uint32 inLastObjectIndex);
+
 public:
 	/// Invalid index
 	static const uint32		cInvalidObjectIndex = 0xffffffff;
@@ -79,8 +152,9 @@ public:
 	/// Destructor
 	inline					~FixedSizeFreeList();
 
-	/// Initialize the free list, up to inMaxObjects can be allocated
-	inline void				Init(uint inMaxObjects, uint inPageSize);
+	/// Initialize the free list, up to inMaxObjects can be allocated.
+	/// inMagazineSize > 0 gives every thread a magazine that moves that many objects to / from the shared list at once.
+	inline void				Init(uint inMaxObjects, uint inPageSize, uint inMagazineSize = 0);
 
 	/// Lockless construct a new object, inParameters are passed on to the constructor
 	template <typename... Parameters>
@@ -108,6 +182,12 @@ public:
 	/// Lockless destruct batch of objects
 	inline void				DestructObjectBatch(Batch &ioBatch);
 
+	/// Number of free objects that are parked in the magazines of threads (approximate while other threads use the list)
+	inline uint				GetNumObjectsInMagazines() const;
+
+	/// Memory used by the magazines: the magazine array plus the storage of the objects parked in them
+	inline size_t			GetMagazineMemoryUsage() const;
+
 	/// Access an object by index.
 	inline Object &			Get(uint32 inObjectIndex)				{ return GetStorage(inObjectIndex).mObject; }
 
@@ -18,11 +18,19 @@ FixedSizeFreeList<Object>::~FixedSizeFreeList()
 		for (uint32 page = 0; page < num_pages; ++page)
 			AlignedFree(mPages[page]);
 		Free(mPages);
+
+		// Free magazines, the objects in them live in the pages
+		if (mMagazines != nullptr)
+		{
+			for (uint32 i = 0; i < FixedSizeFreeListThreadIndex::cMaxThreads; ++i)
+				mMagazines[i].~Magazine();
+			AlignedFree(mMagazines);
+		}
 	}
 }
 
 template <typename Object>
-void FixedSizeFreeList<Object>::Init(uint inMaxObjects, uint inPageSize)
+void FixedSizeFreeList<Object>::Init(uint inMaxObjects, uint inPageSize, uint inMagazineSize)
 {
 	// Check sanity
 	JPH_ASSERT(inPageSize > 0 && IsPowerOf2(inPageSize));
@@ -47,11 +55,28 @@ void FixedSizeFreeList<Object>::Init(uint inMaxObjects, uint inPageSize)
 
 	// Set first free object (with tag 0)
 	mFirstFreeObjectAndTag = cInvalidObjectIndex;
+
+	// Allocate magazines
+	mMagazineSize = inMagazineSize;
+	if (inMagazineSize > 0)
+	{
+		mMagazines = reinterpret_cast<Magazine *>(AlignedAllocate(FixedSizeFreeListThreadIndex::cMaxThreads * sizeof(Magazine), alignof(Magazine)));
+		for (uint32 i = 0; i < FixedSizeFreeListThreadIndex::cMaxThreads; ++i)
+			::new (&mMagazines[i]) Magazine();
+	}
 }
 
 template <typename Object>
-template <typename... Parameters>
-uint32 FixedSizeFreeList<Object>::ConstructObject(Parameters &&... inParameters)
+typename FixedSizeFreeList<Object>::Magazine *FixedSizeFreeList<Object>::GetMagazine()
+{
+	if (mMagazines == nullptr)
+		return nullptr;
+	uint32 thread_index = FixedSizeFreeListThreadIndex::sGet();
+	return thread_index < FixedSizeFreeListThreadIndex::cMaxThreads? &mMagazines[thread_index] : nullptr;
+}
+
+template <typename Object>
+uint32 FixedSizeFreeList<Object>::PopObject()
 {
 	for (;;)
 	{
@@ -76,11 +101,6 @@ uint32 FixedSizeFreeList<Object>::ConstructObject(Parameters &&... inParameters)
 				}
 			}
 
-			// Allocation successful
-			JPH_IF_ENABLE_ASSERTS(mNumFreeObjects.fetch_sub(1, memory_order_relaxed);)
-			ObjectStorage &storage = GetStorage(first_free);
-			::new (&storage.mObject) Object(std::forward<Parameters>(inParameters)...);
-			storage.mNextFreeObject.store(first_free, memory_order_release);
 			return first_free;
 		}
 		else
@@ -93,18 +113,105 @@ uint32 FixedSizeFreeList<Object>::ConstructObject(Parameters &&... inParameters)
 
 			// Compare and swap
 			if (mFirstFreeObjectAndTag.compare_exchange_weak(first_free_object_and_tag, new_first_free_object_and_tag, memory_order_release))
-			{
-				// Allocation successful
-				JPH_IF_ENABLE_ASSERTS(mNumFreeObjects.fetch_sub(1, memory_order_relaxed);)
-				ObjectStorage &storage = GetStorage(first_free);
-				::new (&storage.mObject) Object(std::forward<Parameters>(inParameters)...);
-				storage.mNextFreeObject.store(first_free, memory_order_release);
 				return first_free;
-			}
 		}
 	}
 }
 
+template <typename Object>
+uint32 FixedSizeFreeList<Object>::PopObjects(uint32 inMaxObjects, uint32 &outFirstObjectIndex, uint32 &outLastObjectIndex)
+{
+	for (;;)
+	{
+		// Get first object from the linked list
+		uint64 first_free_object_and_tag = mFirstFreeObjectAndTag.load(memory_order_acquire);
+		uint32 first_free = uint32(first_free_object_and_tag);
+		if (first_free == cInvalidObjectIndex)
+			return 0;
+
+		// Walk the list. Another thread may change it while we do this, in which case the tag changes and the CAS below fails.
+		// The walk is bounded by inMaxObjects so a list that is being modified can't make us loop forever.
+		uint32 last_free = first_free;
+		uint32 num_objects = 1;
+		uint32 new_first_free = GetStorage(last_free).mNextFreeObject.load(memory_order_acquire);
+		while (num_objects < inMaxObjects && new_first_free != cInvalidObjectIndex)
+		{
+			last_free = new_first_free;
+			++num_objects;
+			new_first_free = GetStorage(last_free).mNextFreeObject.load(memory_order_acquire);
+		}
+
+		// Construct a new first free object tag
+		uint64 new_first_free_object_and_tag = uint64(new_first_free) + (uint64(mAllocationTag.fetch_add(1, memory_order_relaxed)) << 32);
+
+		// Compare and swap
+		if (mFirstFreeObjectAndTag.compare_exchange_weak(first_free_object_and_tag, new_first_free_object_and_tag, memory_order_release))
+		{
+			outFirstObjectIndex = first_free;
+			outLastObjectIndex = last_free;
+			return num_objects;
+		}
+	}
+}
+
+template <typename Object>
+void FixedSizeFreeList<Object>::PushObjects(uint32 inFirstObjectIndex, uint32 inLastObjectIndex)
+{
+	ObjectStorage &storage = GetStorage(inLastObjectIndex);
+	for (;;)
+	{
+		// Get first object from the list
+		uint64 first_free_object_and_tag = mFirstFreeObjectAndTag.load(memory_order_acquire);
+		uint32 first_free = uint32(first_free_object_and_tag);
+
+		// Make it the next pointer of the last object in the batch that is to be freed
+		storage.mNextFreeObject.store(first_free, memory_order_release);
+
+		// Construct a new first free object tag
+		uint64 new_first_free_object_and_tag = uint64(inFirstObjectIndex) + (uint64(mAllocationTag.fetch_add(1, memory_order_relaxed)) << 32);
+
+		// Compare and swap
+		if (mFirstFreeObjectAndTag.compare_exchange_weak(first_free_object_and_tag, new_first_free_object_and_tag, memory_order_release))
+			return;
+	}
+}
+
+template <typename Object>
+template <typename... Parameters>
+uint32 FixedSizeFreeList<Object>::ConstructObject(Parameters &&... inParameters)
+{
+	uint32 first_free = cInvalidObjectIndex;
+
+	Magazine *magazine = GetMagazine();
+	if (magazine != nullptr)
+	{
+		// Refill an empty magazine from the shared list, if that is empty too we fall back to PopObject to get a new page
+		uint32 num_objects = magazine->mNumObjects.load(memory_order_relaxed);
+		if (num_objects == 0)
+			num_objects = PopObjects(mMagazineSize, magazine->mFirstObjectIndex, magazine->mLastObjectIndex);
+		if (num_objects > 0)
+		{
+			first_free = magazine->mFirstObjectIndex;
+			magazine->mFirstObjectIndex = GetStorage(first_free).mNextFreeObject.load(memory_order_relaxed);
+			magazine->mNumObjects.store(num_objects - 1, memory_order_relaxed);
+		}
+	}
+
+	if (first_free == cInvalidObjectIndex)
+	{
+		first_free = PopObject();
+		if (first_free == cInvalidObjectIndex)
+			return cInvalidObjectIndex;
+	}
+
+	// Allocation successful
+	JPH_IF_ENABLE_ASSERTS(mNumFreeObjects.fetch_sub(1, memory_order_relaxed);)
+	ObjectStorage &storage = GetStorage(first_free);
+	::new (&storage.mObject) Object(std::forward<Parameters>(inParameters)...);
+	storage.mNextFreeObject.store(first_free, memory_order_release);
+	return first_free;
+}
+
 template <typename Object>
 void FixedSizeFreeList<Object>::AddObjectToBatch(Batch &ioBatch, uint32 inObjectIndex)
 {
@@ -139,32 +246,13 @@ void FixedSizeFreeList<Object>::DestructObjectBatch(Batch &ioBatch)
 		}
 
 		// Add to objects free list
-		ObjectStorage &storage = GetStorage(ioBatch.mLastObjectIndex);
-		for (;;)
-		{
-			// Get first object from the list
-			uint64 first_free_object_and_tag = mFirstFreeObjectAndTag.load(memory_order_acquire);
-			uint32 first_free = uint32(first_free_object_and_tag);
-
-			// Make it the next pointer of the last object in the batch that is to be freed
-			storage.mNextFreeObject.store(first_free, memory_order_release);
+		PushObjects(ioBatch.mFirstObjectIndex, ioBatch.mLastObjectIndex);
+		JPH_IF_ENABLE_ASSERTS(mNumFreeObjects.fetch_add(ioBatch.mNumObjects, memory_order_relaxed);)
 
-			// Construct a new first free object tag
-			uint64 new_first_free_object_and_tag = uint64(ioBatch.mFirstObjectIndex) + (uint64(mAllocationTag.fetch_add(1, memory_order_relaxed)) << 32);
-
-			// Compare and swap
-			if (mFirstFreeObjectAndTag.compare_exchange_weak(first_free_object_and_tag, new_first_free_object_and_tag, memory_order_release))
-			{
-				// Free successful
-				JPH_IF_ENABLE_ASSERTS(mNumFreeObjects.fetch_add(ioBatch.mNumObjects, memory_order_relaxed);)
-
-				// Mark the batch as freed
+		// Mark the batch as freed
 #ifdef JPH_ENABLE_ASSERTS
-				ioBatch.mNumObjects = uint32(-1);
+		ioBatch.mNumObjects = uint32(-1);
 #endif
-				return;
-			}
-		}
 	}
 }
 
@@ -177,27 +265,36 @@ void FixedSizeFreeList<Object>::DestructObject(uint32 inObjectIndex)
 	ObjectStorage &storage = GetStorage(inObjectIndex);
 	storage.mObject.~Object();
 
-	// Add to object free list
-	for (;;)
-	{
-		// Get first object from the list
-		uint64 first_free_object_and_tag = mFirstFreeObjectAndTag.load(memory_order_acquire);
-		uint32 first_free = uint32(first_free_object_and_tag);
+	JPH_IF_ENABLE_ASSERTS(mNumFreeObjects.fetch_add(1, memory_order_relaxed);)
 
-		// Make it the next pointer of the last object in the batch that is to be freed
-		storage.mNextFreeObject.store(first_free, memory_order_release);
+	Magazine *magazine = GetMagazine();
+	if (magazine == nullptr)
+	{
+		// Add to object free list
+		PushObjects(inObjectIndex, inObjectIndex);
+		return;
+	}
 
-		// Construct a new first free object tag
-		uint64 new_first_free_object_and_tag = uint64(inObjectIndex) + (uint64(mAllocationTag.fetch_add(1, memory_order_relaxed)) << 32);
+	// Add to the front of the magazine, objects that were freed last are the most likely to be in the cache
+	uint32 num_objects = magazine->mNumObjects.load(memory_order_relaxed);
+	if (num_objects == 0)
+		magazine->mLastObjectIndex = inObjectIndex;
+	else
+		storage.mNextFreeObject.store(magazine->mFirstObjectIndex, memory_order_relaxed);
+	magazine->mFirstObjectIndex = inObjectIndex;
+	++num_objects;
 
-		// Compare and swap
-		if (mFirstFreeObjectAndTag.compare_exchange_weak(first_free_object_and_tag, new_first_free_object_and_tag, memory_order_release))
-		{
-			// Free successful
-			JPH_IF_ENABLE_ASSERTS(mNumFreeObjects.fetch_add(1, memory_order_relaxed);)
-			return;
-		}
+	// When the magazine is full, return the oldest half to the shared list
+	if (num_objects >= 2 * mMagazineSize)
+	{
+		uint32 keep_last = magazine->mFirstObjectIndex;
+		for (uint32 i = 1; i < mMagazineSize; ++i)
+			keep_last = GetStorage(keep_last).mNextFreeObject.load(memory_order_relaxed);
+		PushObjects(GetStorage(keep_last).mNextFreeObject.load(memory_order_relaxed), magazine->mLastObjectIndex);
+		magazine->mLastObjectIndex = keep_last;
+		num_objects = mMagazineSize;
 	}
+	magazine->mNumObjects.store(num_objects, memory_order_relaxed);
 }
 
 template<typename Object>
@@ -208,4 +305,22 @@ inline void FixedSizeFreeList<Object>::DestructObject(Object *inObject)
 	DestructObject(index);
 }
 
+template <typename Object>
+uint FixedSizeFreeList<Object>::GetNumObjectsInMagazines() const
+{
+	uint num_objects = 0;
+	if (mMagazines != nullptr)
+		for (uint32 i = 0; i < FixedSizeFreeListThreadIndex::cMaxThreads; ++i)
+			num_objects += mMagazines[i].mNumObjects.load(memory_order_relaxed);
+	return num_objects;
+}
+
+template <typename Object>
+size_t FixedSizeFreeList<Object>::GetMagazineMemoryUsage() const
+{
+	if (mMagazines == nullptr)
+		return 0;
+	return FixedSizeFreeListThreadIndex::cMaxThreads * sizeof(Magazine) + GetNumObjectsInMagazines() * sizeof(ObjectStorage);
+}
+
 JPH_NAMESPACE_END
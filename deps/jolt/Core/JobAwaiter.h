@@ -0,0 +1,113 @@
+// Jolt Physics Library (https://github.com/jrouwe/JoltPhysics)
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Jolt/Core/JobSystem.h>
+
+#ifdef __cpp_impl_coroutine
+
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <coroutine>
+JPH_SUPPRESS_WARNINGS_STD_END
+
+JPH_NAMESPACE_BEGIN
+
+/// Awaitable that suspends a C++20 coroutine until a set of jobs has finished, without blocking a thread.
+///
+/// The awaiter is the barrier of the jobs it waits for, so a job can't be awaited and added to another barrier at the same time.
+/// The coroutine is resumed on the thread that finishes the last job (normally a worker thread of the job system), or continues
+/// on the current thread if all jobs had already finished. The job system needs at least one worker thread because nobody
+/// executes queued jobs while the waiting coroutine is suspended.
+///
+/// Usage:
+///
+///		co_await JobAwaiter(job_system->CreateJob("Job", Color::sGreen, []() { ... }));
+///
+///		JobAwaiter all;
+///		all.AddJobs(handles.data(), uint(handles.size()));
+///		co_await all;
+class JobAwaiter final : public JobSystem::Barrier
+{
+public:
+	JPH_OVERRIDE_NEW_DELETE
+
+	using JobHandle = JobSystem::JobHandle;
+
+	/// Construct an awaiter without jobs, use AddJob / AddJobs to add them
+							JobAwaiter() = default;
+
+	/// Construct an awaiter that waits for a single job
+	explicit				JobAwaiter(const JobHandle &inJob)						{ AddJob(inJob); }
+
+	/// Destructor, the awaiter must not be destroyed while jobs still refer to it
+	virtual					~JobAwaiter() override									{ JPH_ASSERT(mNumPending.load(memory_order_relaxed) <= 1); }
+
+	// See Barrier
+	virtual void			AddJob(const JobHandle &inJob) override
+	{
+		// If the job already finished we don't need to wait for it
+		mNumPending.fetch_add(1, memory_order_relaxed);
+		if (!inJob.GetPtr()->SetBarrier(this))
+			mNumPending.fetch_sub(1, memory_order_relaxed);
+	}
+
+	virtual void			AddJobs(const JobHandle *inHandles, uint inNumHandles) override
+	{
+		for (const JobHandle *handle = inHandles, *handles_end = inHandles + inNumHandles; handle < handles_end; ++handle)
+			AddJob(*handle);
+	}
+
+	/// Coroutine interface: don't suspend when there is nothing to wait for
+	bool					await_ready() const noexcept							{ return mNumPending.load(memory_order_acquire) == 1; }
+
+	/// Coroutine interface: store the coroutine and drop the reference that kept the count from reaching zero while jobs were being added.
+	/// Returns false (continue without suspending) if all jobs finished in the meantime.
+	bool					await_suspend(std::coroutine_handle<> inCoroutine) noexcept
+	{
+		mContinuation = inCoroutine;
+		return mNumPending.fetch_sub(1, memory_order_acq_rel) != 1;
+	}
+
+	/// Coroutine interface: nothing to return
+	void					await_resume() const noexcept							{ }
+
+protected:
+	// See Barrier
+	virtual void			OnJobFinished(JobSystem::Job *inJob) override
+	{
+		JPH_UNUSED(inJob);
+
+		// The last job to finish resumes the coroutine, which may destroy this awaiter so don't touch it afterwards
+		if (mNumPending.fetch_sub(1, memory_order_acq_rel) == 1)
+		{
+			std::coroutine_handle<> continuation = mContinuation;
+			continuation.resume();
+		}
+	}
+
+private:
+	std::coroutine_handle<>	mContinuation;											///< Coroutine to resume when all jobs are done
+	atomic<uint32>			mNumPending { 1 };										///< Number of unfinished jobs + 1 until the coroutine is suspended
+};
+
+/// Awaitable that continues a coroutine on a worker thread of a job system, e.g. to start a task from the main thread without running any of it there
+class ResumeOnJobSystem
+{
+public:
+	/// Constructor
+	explicit				ResumeOnJobSystem(JobSystem *inJobSystem, const char *inName = "ResumeCoroutine") : mJobSystem(inJobSystem), mName(inName) { }
+
+	/// Coroutine interface
+	bool					await_ready() const noexcept							{ return false; }
+	void					await_suspend(std::coroutine_handle<> inCoroutine)		{ mJobSystem->CreateJob(mName, Color::sGrey, [inCoroutine]() { inCoroutine.resume(); }); }
+	void					await_resume() const noexcept							{ }
+
+private:
+	JobSystem *				mJobSystem;
+	const char *			mName;
+};
+
+JPH_NAMESPACE_END
+
+#endif // __cpp_impl_coroutine
@@ -13,6 +13,8 @@
 
 JPH_NAMESPACE_BEGIN
 
+class TempAllocator;
+
 /// A class that allows units of work (Jobs) to be scheduled across multiple threads.
 /// It allows dependencies between the jobs so that the jobs form a graph.
 ///
@@ -66,11 +68,29 @@ JPH_NAMESPACE_BEGIN
 /// to wait for these in this function after the barrier is finished waiting.
 ///
 /// An example implementation is JobSystemThreadPool. If you don't want to write the Barrier class you can also inherit from JobSystemWithBarrier.
+///
+/// Jobs have a priority class (see EJobPriority). Job systems that support priorities run executable High jobs before Normal jobs before Low jobs,
+/// other job systems may ignore it.
+
+/// Priority class of a job
+enum class EJobPriority : uint8
+{
+	High,																///< Job is on the critical path, other jobs are waiting for it
+	Normal,																///< Default priority
+	Low,																///< Nothing needs the result of this job soon
+};
+
+/// Number of values in EJobPriority
+static constexpr uint cNumJobPriorities = 3;
+
 class JPH_EXPORT JobSystem : public NonCopyable
 {
 protected:
 	class Job;
 
+	/// Needs to attach itself as the barrier of the jobs it waits for
+	friend class JobAwaiter;
+
 public:
 	JPH_OVERRIDE_NEW_DELETE
 
@@ -154,7 +174,7 @@ public:
 
 	/// Create a new job, the job is started immediately if inNumDependencies == 0 otherwise it starts when
 	/// RemoveDependency causes the dependency counter to reach 0.
-	virtual JobHandle		CreateJob(const char *inName, ColorArg inColor, const JobFunction &inJobFunction, uint32 inNumDependencies = 0) = 0;
+	virtual JobHandle		CreateJob(const char *inName, ColorArg inColor, const JobFunction &inJobFunction, uint32 inNumDependencies = 0, EJobPriority inPriority = EJobPriority::Normal) = 0;
 
 	/// Create a new barrier, used to wait on jobs
 	virtual Barrier *		CreateBarrier() = 0;
@@ -165,7 +185,14 @@ public:
 	/// Wait for a set of jobs to be finished, note that only 1 thread can be waiting on a barrier at a time
 	virtual void			WaitForJobs(Barrier *inBarrier) = 0;
 
+	/// Scratch memory for the job that is running on the calling thread, or nullptr if the job system doesn't provide it on this thread
+	/// (see JobSystemThreadPool::SetThreadTempAllocatorSize). There's no locking, allocations must be freed in reverse order before the job returns.
+	static TempAllocator *	sGetThreadTempAllocator()					{ return sThreadTempAllocator; }
+
 protected:
+	/// Set by the job system on its worker threads
+	static inline thread_local TempAllocator *sThreadTempAllocator = nullptr;
+
 	/// A class that contains information for a single unit of work
 	class Job
 	{
@@ -173,20 +200,24 @@ protected:
 		JPH_OVERRIDE_NEW_DELETE
 
 		/// Constructor
-							Job([[maybe_unused]] const char *inJobName, [[maybe_unused]] ColorArg inColor, JobSystem *inJobSystem, const JobFunction &inJobFunction, uint32 inNumDependencies) :
+							Job([[maybe_unused]] const char *inJobName, [[maybe_unused]] ColorArg inColor, JobSystem *inJobSystem, const JobFunction &inJobFunction, uint32 inNumDependencies, EJobPriority inPriority = EJobPriority::Normal) :
 		#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
 			mJobName(inJobName),
 			mColor(inColor),
 		#endif // defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
 			mJobSystem(inJobSystem),
 			mJobFunction(inJobFunction),
-			mNumDependencies(inNumDependencies)
+			mNumDependencies(inNumDependencies),
+			mPriority(inPriority)
 		{
 		}
 
 		/// Get the jobs system to which this job belongs
 		inline JobSystem *	GetJobSystem()								{ return mJobSystem; }
 
+		/// Get the priority class of this job
+		inline EJobPriority	GetPriority() const							{ return mPriority; }
+
 		/// Add or release a reference to this object
 		inline void			AddRef()
 		{
@@ -225,14 +256,18 @@ protected:
 			return false;
 		}
 
-		/// Run the job function, returns the number of dependencies that this job still has or cExecutingState or cDoneState
-		inline uint32		Execute()
+		/// Run the job function, returns the number of dependencies that this job still has or cExecutingState or cDoneState.
+		/// cDoneState is also returned when another thread already ran the job, ioNumExecuted (if provided) is only incremented when this call ran it.
+		inline uint32		Execute(uint *ioNumExecuted = nullptr)
 		{
 			// Transition job to executing state
 			uint32 state = 0; // We can only start running with a dependency counter of 0
 			if (!mNumDependencies.compare_exchange_strong(state, cExecutingState, memory_order_acquire))
 				return state; // state is updated by compare_exchange_strong to the current value
 
+			if (ioNumExecuted != nullptr)
+				++(*ioNumExecuted);
+
 			// Run the job function
 			{
 				JPH_PROFILE(mJobName, mColor.GetUInt32());
@@ -260,6 +295,10 @@ protected:
 			return cDoneState;
 		}
 
+		/// Time in nanoseconds at which the job was put in the queue, set by job systems that keep statistics (see JobSystemThreadPool::GetStats)
+		inline void			SetQueueTime(uint64 inTime)					{ mQueueTime = inTime; }
+		inline uint64		GetQueueTime() const						{ return mQueueTime; }
+
 		/// Test if the job can be executed
 		inline bool			CanBeExecuted() const						{ return mNumDependencies.load(memory_order_relaxed) == 0; }
 
@@ -286,6 +325,8 @@ private:
 		JobFunction			mJobFunction;								///< Main job function
 		atomic<uint32>		mReferenceCount = 0;						///< Amount of JobHandles pointing to this job
 		atomic<uint32>		mNumDependencies;							///< Amount of jobs that need to complete before this job can run
+		EJobPriority		mPriority;									///< Priority class of the job
+		uint64				mQueueTime = 0;								///< When the job was queued, written before the job is published to the queue and read by the thread that takes it
 	};
 
 	/// Adds a job to the job queue
@@ -25,7 +25,7 @@ public:
 
 	// See JobSystem
 	virtual int				GetMaxConcurrency() const override				{ return 1; }
-	virtual JobHandle		CreateJob(const char *inName, ColorArg inColor, const JobFunction &inJobFunction, uint32 inNumDependencies = 0) override;
+	virtual JobHandle		CreateJob(const char *inName, ColorArg inColor, const JobFunction &inJobFunction, uint32 inNumDependencies = 0, EJobPriority inPriority = EJobPriority::Normal) override;
 	virtual Barrier *		CreateBarrier() override;
 	virtual void			DestroyBarrier(Barrier *inBarrier) override;
 	virtual void			WaitForJobs(Barrier *inBarrier) override;
@@ -7,6 +7,7 @@
 #include <Jolt/Core/JobSystemThreadPool.h>
 #include <Jolt/Core/Profiler.h>
 #include <Jolt/Core/FPException.h>
+#include <Jolt/Core/TempAllocatorGrowing.h>
 
 #ifdef JPH_PLATFORM_WINDOWS
 	JPH_SUPPRESS_WARNING_PUSH
@@ -23,16 +24,27 @@
 
 JPH_NAMESPACE_BEGIN
 
+/// Job system and thread index of the worker that runs on the current thread
+static thread_local const JobSystemThreadPool *sCurrentJobSystem = nullptr;
+static thread_local int sCurrentThreadIndex = -1;
+
+/// Add to a statistics counter that only the current thread writes, a relaxed load and store is cheaper than a read-modify-write
+static inline void sAddToCounter(atomic<uint64> &ioCounter, uint64 inValue)
+{
+	ioCounter.store(ioCounter.load(memory_order_relaxed) + inValue, memory_order_relaxed);
+}
+
 void JobSystemThreadPool::Init(uint inMaxJobs, uint inMaxBarriers, int inNumThreads)
 {
 	JobSystemWithBarrier::Init(inMaxBarriers);
 
-	// Init freelist of jobs
-	mJobs.Init(inMaxJobs, inMaxJobs);
+	// Init freelist of jobs. Jobs parked in magazines don't count towards inMaxJobs, the pages for them are only allocated when they're needed.
+	mJobs.Init(inMaxJobs + FixedSizeFreeListThreadIndex::cMaxThreads * 2 * mJobMagazineSize, inMaxJobs, mJobMagazineSize);
 
-	// Init queue
-	for (atomic<Job *> &j : mQueue)
-		j = nullptr;
+	// Init queues
+	for (atomic<Job *> (&queue)[cQueueLength] : mQueue)
+		for (atomic<Job *> &j : queue)
+			j = nullptr;
 
 	// Start the worker threads
 	StartThreads(inNumThreads);
@@ -57,10 +69,15 @@ void JobSystemThreadPool::StartThreads(int inNumThreads)
 	mQuit = false;
 
 	// Allocate heads
-	mHeads = reinterpret_cast<atomic<uint> *>(Allocate(sizeof(atomic<uint>) * inNumThreads));
-	for (int i = 0; i < inNumThreads; ++i)
+	mHeads = reinterpret_cast<atomic<uint> *>(Allocate(sizeof(atomic<uint>) * inNumThreads * cNumJobPriorities));
+	for (uint i = 0; i < uint(inNumThreads) * cNumJobPriorities; ++i)
 		mHeads[i] = 0;
 
+	// Allocate statistics
+	mWorkerCounters = reinterpret_cast<WorkerCounters *>(AlignedAllocate(sizeof(WorkerCounters) * inNumThreads, alignof(WorkerCounters)));
+	for (int i = 0; i < inNumThreads; ++i)
+		new (&mWorkerCounters[i]) WorkerCounters;
+
 	// Start running threads
 	JPH_ASSERT(mThreads.empty());
 	mThreads.reserve(inNumThreads);
@@ -91,26 +108,32 @@ void JobSystemThreadPool::StopThreads()
 	// Delete all threads
 	mThreads.clear();
 
-	// Ensure that there are no lingering jobs in the queue
-	for (uint head = 0; head != mTail; ++head)
-	{
-		// Fetch job
-		Job *job_ptr = mQueue[head & (cQueueLength - 1)].exchange(nullptr);
-		if (job_ptr != nullptr)
+	// Ensure that there are no lingering jobs in the queues
+	for (uint priority = 0; priority < cNumJobPriorities; ++priority)
+		for (uint head = 0; head != mTail[priority]; ++head)
 		{
-			// And execute it
-			job_ptr->Execute();
-			job_ptr->Release();
+			// Fetch job
+			Job *job_ptr = mQueue[priority][head & (cQueueLength - 1)].exchange(nullptr);
+			if (job_ptr != nullptr)
+			{
+				// And execute it
+				job_ptr->Execute();
+				job_ptr->Release();
+			}
 		}
-	}
 
-	// Destroy heads and reset tail
+	// Destroy heads and reset tails
 	Free(mHeads);
 	mHeads = nullptr;
-	mTail = 0;
+	for (atomic<uint> &tail : mTail)
+		tail = 0;
+
+	// Destroy statistics, WorkerCounters is trivially destructible
+	AlignedFree(mWorkerCounters);
+	mWorkerCounters = nullptr;
 }
 
-JobHandle JobSystemThreadPool::CreateJob(const char *inJobName, ColorArg inColor, const JobFunction &inJobFunction, uint32 inNumDependencies)
+JobHandle JobSystemThreadPool::CreateJob(const char *inJobName, ColorArg inColor, const JobFunction &inJobFunction, uint32 inNumDependencies, EJobPriority inPriority)
 {
 	JPH_PROFILE_FUNCTION();
 
@@ -118,7 +141,7 @@ JobHandle JobSystemThreadPool::CreateJob(const char *inJobName, ColorArg inColor
 	uint32 index;
 	for (;;)
 	{
-		index = mJobs.ConstructObject(inJobName, inColor, this, inJobFunction, inNumDependencies);
+		index = mJobs.ConstructObject(inJobName, inColor, this, inJobFunction, inNumDependencies, inPriority);
 		if (index != AvailableJobs::cInvalidObjectIndex)
 			break;
 		JPH_ASSERT(false, "No jobs available!");
@@ -142,40 +165,81 @@ void JobSystemThreadPool::FreeJob(Job *inJob)
 	mJobs.DestructObject(inJob);
 }
 
-uint JobSystemThreadPool::GetHead() const
+uint JobSystemThreadPool::GetHead(uint inPriority) const
 {
 	// Find the minimal value across all threads
-	uint head = mTail;
+	uint head = mTail[inPriority];
 	for (size_t i = 0; i < mThreads.size(); ++i)
-		head = min(head, mHeads[i].load());
+		head = min(head, mHeads[i * cNumJobPriorities + inPriority].load());
 	return head;
 }
 
-void JobSystemThreadPool::QueueJobInternal(Job *inJob)
+JobSystem::Job *JobSystemThreadPool::TakeJob(int inThreadIndex)
+{
+	atomic<uint> *heads = mHeads + size_t(inThreadIndex) * cNumJobPriorities;
+	for (uint priority = 0; priority < cNumJobPriorities; ++priority)
+	{
+		// Loop over the queue
+		atomic<uint> &head = heads[priority];
+		while (head != mTail[priority])
+		{
+			// Exchange any job pointer we find with a nullptr
+			atomic<Job *> &job = mQueue[priority][head & (cQueueLength - 1)];
+			Job *job_ptr = job.load() != nullptr? job.exchange(nullptr) : nullptr;
+			head++;
+			if (job_ptr != nullptr)
+				return job_ptr;
+		}
+	}
+	return nullptr;
+}
+
+void JobSystemThreadPool::QueueJobInternal(Job *inJob, uint64 inQueueTime)
 {
 	// Add reference to job because we're adding the job to the queue
 	inJob->AddRef();
+	inJob->SetQueueTime(inQueueTime);
+
+	// Select the queue for the priority of the job
+	uint priority = uint(inJob->GetPriority());
+	JPH_ASSERT(priority < cNumJobPriorities);
+	atomic<Job *> *queue = mQueue[priority];
+	atomic<uint> &tail = mTail[priority];
 
 	// Need to read head first because otherwise the tail can already have passed the head
 	// We read the head outside of the loop since it involves iterating over all threads and we only need to update
 	// it if there's not enough space in the queue.
-	uint head = GetHead();
+	uint head = GetHead(priority);
 
 	for (;;)
 	{
 		// Check if there's space in the queue
-		uint old_value = mTail;
+		uint old_value = tail;
 		if (old_value - head >= cQueueLength)
 		{
 			// We calculated the head outside of the loop, update head (and we also need to update tail to prevent it from passing head)
-			head = GetHead();
-			old_value = mTail;
+			head = GetHead(priority);
+			old_value = tail;
 
 			// Second check if there's space in the queue
 			if (old_value - head >= cQueueLength)
 			{
+				// If a job running on one of our workers queues a job (e.g. when it resumes a coroutine) that worker may be the one holding
+				// back the head, and it won't update its head while it's waiting here. Skip the empty slots, they have been processed by the
+				// other workers already.
+				if (sCurrentJobSystem == this)
+				{
+					atomic<uint> &own_head = mHeads[size_t(sCurrentThreadIndex) * cNumJobPriorities + priority];
+					while (own_head != old_value && queue[own_head & (cQueueLength - 1)].load() == nullptr)
+						own_head++;
+					head = GetHead(priority);
+					if (old_value - head < cQueueLength)
+						continue;
+				}
+
 				// Wake up all threads in order to ensure that they can clear any nullptrs they may not have processed yet
 				mSemaphore.Release((uint)mThreads.size());
+				mNumQueueFullStalls.fetch_add(1, memory_order_relaxed);
 
 				// Sleep a little (we have to wait for other threads to update their head pointer in order for us to be able to continue)
 				std::this_thread::sleep_for(std::chrono::microseconds(100));
@@ -185,18 +249,44 @@ void JobSystemThreadPool::QueueJobInternal(Job *inJob)
 
 		// Write the job pointer if the slot is empty
 		Job *expected_job = nullptr;
-		bool success = mQueue[old_value & (cQueueLength - 1)].compare_exchange_strong(expected_job, inJob);
+		bool success = queue[old_value & (cQueueLength - 1)].compare_exchange_strong(expected_job, inJob);
 
 		// Regardless of who wrote the slot, we will update the tail (if the successful thread got scheduled out
 		// after writing the pointer we still want to be able to continue)
-		mTail.compare_exchange_strong(old_value, old_value + 1);
+		bool tail_updated = tail.compare_exchange_strong(old_value, old_value + 1);
+
+		// If the tail had already moved on, the slot may have been filled and emptied again by other threads before we wrote it.
+		// The workers could all be past it, in which case the job would only be found when the queue wraps around (or by a barrier
+		// that is waiting for it). Take the job back and try again, if that fails a worker has already taken it.
+		if (success && !tail_updated)
+		{
+			Job *our_job = inJob;
+			if (queue[old_value & (cQueueLength - 1)].compare_exchange_strong(our_job, nullptr))
+				continue;
+		}
 
 		// If we successfully added our job we're done
 		if (success)
+		{
+			// Track the high water mark of the queue, this only needs a store when the maximum grows
+			uint depth = old_value + 1 - head;
+			atomic<uint> &max_depth = mMaxQueueDepth[priority];
+			uint old_max = max_depth.load(memory_order_relaxed);
+			while (depth > old_max && !max_depth.compare_exchange_weak(old_max, depth, memory_order_relaxed))
+				continue;
 			break;
+		}
 	}
 }
 
+void JobSystemThreadPool::CountQueuedJobs(uint inNumJobs)
+{
+	if (sCurrentJobSystem == this)
+		sAddToCounter(mWorkerCounters[sCurrentThreadIndex].mNumJobsQueued, inNumJobs);
+	else
+		mNumJobsQueuedExternally.fetch_add(inNumJobs, memory_order_relaxed);
+}
+
 void JobSystemThreadPool::QueueJob(Job *inJob)
 {
 	JPH_PROFILE_FUNCTION();
@@ -206,7 +296,8 @@ void JobSystemThreadPool::QueueJob(Job *inJob)
 		return;
 
 	// Queue the job
-	QueueJobInternal(inJob);
+	QueueJobInternal(inJob, sGetStatsTime());
+	CountQueuedJobs(1);
 
 	// Wake up thread
 	mSemaphore.Release();
@@ -223,8 +314,10 @@ void JobSystemThreadPool::QueueJobs(Job **inJobs, uint inNumJobs)
 		return;
 
 	// Queue all jobs
+	uint64 queue_time = sGetStatsTime();
 	for (Job **job = inJobs, **job_end = inJobs + inNumJobs; job < job_end; ++job)
-		QueueJobInternal(*job);
+		QueueJobInternal(*job, queue_time);
+	CountQueuedJobs(inNumJobs);
 
 	// Wake up threads
 	mSemaphore.Release(min(inNumJobs, (uint)mThreads.size()));
@@ -280,37 +373,117 @@ void JobSystemThreadPool::ThreadMain(int inThreadIndex)
 
 	JPH_PROFILE_THREAD_START(name);
 
-	atomic<uint> &head = mHeads[inThreadIndex];
+	// Remember which worker we are so that jobs queued from this thread can move our head
+	sCurrentJobSystem = this;
+	sCurrentThreadIndex = inThreadIndex;
+
+	// Call the thread init function
+	mThreadInitFunction(inThreadIndex);
+
+	// Scratch memory for the jobs that run on this thread, allocated after the init function so it ends up on the node the thread got pinned to
+	TempAllocatorGrowing *temp_allocator = mThreadTempAllocatorSize > 0? new TempAllocatorGrowing(mThreadTempAllocatorSize) : nullptr;
+	sThreadTempAllocator = temp_allocator;
+
+	WorkerCounters &counters = mWorkerCounters[inThreadIndex];
 
 	while (!mQuit)
 	{
 		// Wait for jobs
+		uint64 idle_start = sGetStatsTime();
 		mSemaphore.Acquire();
+		uint64 busy_start = sGetStatsTime();
+		sAddToCounter(counters.mIdleTime, busy_start - idle_start);
+		sAddToCounter(counters.mNumWakeups, 1);
 
 		{
 			JPH_PROFILE("Executing Jobs");
 
-			// Loop over the queue
-			while (head != mTail)
+			// Execute jobs until all queues are empty, the higher priority queues are checked again after every job
+			uint num_jobs = 0;
+			for (Job *job_ptr = TakeJob(inThreadIndex); job_ptr != nullptr; job_ptr = TakeJob(inThreadIndex))
 			{
-				// Exchange any job pointer we find with a nullptr
-				atomic<Job *> &job = mQueue[head & (cQueueLength - 1)];
-				if (job.load() != nullptr)
+				// Time between queuing and starting the job, the clock is read once per job. A job that a thread waiting on a barrier already ran doesn't count.
+				uint64 start = sGetStatsTime();
+				uint prev_num_jobs = num_jobs;
+				job_ptr->Execute(&num_jobs);
+				if (num_jobs != prev_num_jobs)
 				{
-					Job *job_ptr = job.exchange(nullptr);
-					if (job_ptr != nullptr)
-					{
-						// And execute it
-						job_ptr->Execute();
-						job_ptr->Release();
-					}
+					uint64 latency = start - job_ptr->GetQueueTime();
+					sAddToCounter(counters.mQueueLatency, latency);
+					if (latency > counters.mMaxQueueLatency.load(memory_order_relaxed))
+						counters.mMaxQueueLatency.store(latency, memory_order_relaxed);
+				}
+				job_ptr->Release();
+
+				// Scratch memory only lives as long as the job, take back anything that the job didn't free so the next job starts with an empty allocator
+				if (temp_allocator != nullptr && !temp_allocator->IsEmpty())
+				{
+					JPH_ASSERT(false, "Job didn't free its thread temp memory");
+					temp_allocator->Reset();
 				}
-				head++;
 			}
+
+			sAddToCounter(counters.mNumJobsExecuted, num_jobs);
+			if (num_jobs == 0)
+				sAddToCounter(counters.mNumEmptyWakeups, 1);
 		}
+
+		sAddToCounter(counters.mBusyTime, sGetStatsTime() - busy_start);
 	}
 
+	sThreadTempAllocator = nullptr;
+	delete temp_allocator;
+
+	// Call the thread exit function
+	mThreadExitFunction(inThreadIndex);
+
+	sCurrentJobSystem = nullptr;
+	sCurrentThreadIndex = -1;
+
 	JPH_PROFILE_THREAD_END();
 }
 
+void JobSystemThreadPool::GetStats(Stats &outStats) const
+{
+	outStats.mWorkers.resize(mThreads.size());
+	for (size_t i = 0; i < mThreads.size(); ++i)
+	{
+		const WorkerCounters &c = mWorkerCounters[i];
+		WorkerStats &w = outStats.mWorkers[i];
+		w.mNumJobsQueued = c.mNumJobsQueued.load(memory_order_relaxed);
+		w.mNumJobsExecuted = c.mNumJobsExecuted.load(memory_order_relaxed);
+		w.mQueueLatency = c.mQueueLatency.load(memory_order_relaxed);
+		w.mMaxQueueLatency = c.mMaxQueueLatency.load(memory_order_relaxed);
+		w.mBusyTime = c.mBusyTime.load(memory_order_relaxed);
+		w.mIdleTime = c.mIdleTime.load(memory_order_relaxed);
+		w.mNumWakeups = c.mNumWakeups.load(memory_order_relaxed);
+		w.mNumEmptyWakeups = c.mNumEmptyWakeups.load(memory_order_relaxed);
+	}
+
+	outStats.mNumJobsQueuedExternally = mNumJobsQueuedExternally.load(memory_order_relaxed);
+	outStats.mNumQueueFullStalls = mNumQueueFullStalls.load(memory_order_relaxed);
+
+	// Count the jobs that are still in the queues, slots before the head of the slowest worker are all empty
+	for (uint priority = 0; priority < cNumJobPriorities; ++priority)
+	{
+		uint depth = 0;
+		for (uint index = GetHead(priority), tail = mTail[priority]; index != tail; ++index)
+			if (mQueue[priority][index & (cQueueLength - 1)].load(memory_order_relaxed) != nullptr)
+				++depth;
+		outStats.mQueueDepth[priority] = depth;
+		outStats.mMaxQueueDepth[priority] = mMaxQueueDepth[priority].load(memory_order_relaxed);
+	}
+
+	GetBarrierStats(outStats.mBarriers);
+}
+
+void JobSystemThreadPool::ResetPeakStats()
+{
+	// A worker that is updating its maximum at the same time may overwrite the reset, that only makes the next maximum a little too high
+	for (size_t i = 0; i < mThreads.size(); ++i)
+		mWorkerCounters[i].mMaxQueueLatency.store(0, memory_order_relaxed);
+	for (atomic<uint> &max_depth : mMaxQueueDepth)
+		max_depth.store(0, memory_order_relaxed);
+}
+
 JPH_NAMESPACE_END
@@ -22,6 +22,9 @@ using std::thread;
 /// Note that this is considered an example implementation. It is expected that when you integrate
 /// the physics engine into your own project that you'll provide your own implementation of the
 /// JobSystem built on top of whatever job system your project uses.
+///
+/// There is a queue per EJobPriority. A worker always takes the next job from the highest priority queue that has one,
+/// so a job on the critical path doesn't have to wait until all previously queued bulk work has been picked up.
 class JPH_EXPORT JobSystemThreadPool final : public JobSystemWithBarrier
 {
 public:
@@ -33,6 +36,54 @@ public:
 							JobSystemThreadPool() = default;
 	virtual					~JobSystemThreadPool() override;
 
+	/// Functions to call when a thread is initialized or exits, must be set before calling Init()
+	using InitExitFunction = function<void(int)>;
+	void					SetThreadInitFunction(const InitExitFunction &inInitFunction)	{ mThreadInitFunction = inInitFunction; }
+	void					SetThreadExitFunction(const InitExitFunction &inExitFunction)	{ mThreadExitFunction = inExitFunction; }
+
+	/// Give every worker thread a temp allocator of inSize bytes (it grows when needed), jobs get it through JobSystem::sGetThreadTempAllocator.
+	/// The memory is allocated by the worker itself, so it is local to the node the worker runs on. 0 (the default) disables it. Must be set before calling Init().
+	void					SetThreadTempAllocatorSize(uint inSize)							{ mThreadTempAllocatorSize = inSize; }
+
+	/// Give every thread that creates or frees jobs a magazine of free jobs, so it only touches the shared free list once per inSize jobs (see FixedSizeFreeList).
+	/// Init() reserves 2 * inSize extra jobs per thread for this, allocated in pages of inMaxJobs when needed. 0 (the default) disables it. Must be set before calling Init().
+	void					SetJobMagazineSize(uint inSize)									{ mJobMagazineSize = inSize; }
+
+	/// Number of free jobs parked in magazines and the memory the magazines use (approximate while jobs are running)
+	uint					GetNumJobsInMagazines() const									{ return mJobs.GetNumObjectsInMagazines(); }
+	size_t					GetJobMagazineMemoryUsage() const								{ return mJobs.GetMagazineMemoryUsage(); }
+
+	/// Counters of a worker thread, times are in nanoseconds. Unless noted otherwise the counters only go up, subtract two snapshots to get the numbers for an interval.
+	struct WorkerStats
+	{
+		uint64				mNumJobsQueued = 0;								///< Jobs queued by jobs running on this worker
+		uint64				mNumJobsExecuted = 0;							///< Jobs run by this worker, jobs that it took from the queue after a thread waiting on a barrier ran them are not counted
+		uint64				mQueueLatency = 0;								///< Sum over the jobs run by this worker of the time between queuing the job and starting it
+		uint64				mMaxQueueLatency = 0;							///< Highest queue latency of a single job since the last ResetPeakStats
+		uint64				mBusyTime = 0;									///< Time spent taking and executing jobs
+		uint64				mIdleTime = 0;									///< Time spent parked on the semaphore waiting for work
+		uint64				mNumWakeups = 0;								///< Number of times the worker woke up
+		uint64				mNumEmptyWakeups = 0;							///< Number of times the worker woke up and found no job to run (another thread took or ran it first)
+	};
+
+	/// Statistics of the thread pool, cheap enough to collect every physics step. Workers update their own counters
+	/// with relaxed atomics on their own cache line, so collecting them costs nothing while jobs run.
+	struct Stats
+	{
+		Array<WorkerStats>	mWorkers;										///< Per worker thread (reuse the Stats object to avoid allocating)
+		uint64				mNumJobsQueuedExternally = 0;					///< Jobs queued by threads that are not workers of this pool (e.g. the thread that calls PhysicsSystem::Update)
+		uint64				mNumQueueFullStalls = 0;						///< Number of times a thread had to sleep because a queue was full
+		uint				mQueueDepth[cNumJobPriorities] = { };			///< Number of jobs waiting in each queue at the time of the call
+		uint				mMaxQueueDepth[cNumJobPriorities] = { };		///< Highest number of slots in use in each queue since the last ResetPeakStats, counts from the slowest worker so it includes slots that were already taken
+		BarrierStats		mBarriers;										///< See JobSystemWithBarrier::GetBarrierStats
+	};
+
+	/// Get a snapshot of the statistics, can be called from any thread but not while the number of threads changes
+	void					GetStats(Stats &outStats) const;
+
+	/// Start a new measurement interval for the maximums in Stats (mMaxQueueLatency and mMaxQueueDepth)
+	void					ResetPeakStats();
+
 	/// Initialize the thread pool
 	/// @param inMaxJobs Max number of jobs that can be allocated at any time
 	/// @param inMaxBarriers Max number of barriers that can be allocated at any time
@@ -41,7 +92,7 @@ public:
 
 	// See JobSystem
 	virtual int				GetMaxConcurrency() const override				{ return int(mThreads.size()) + 1; }
-	virtual JobHandle		CreateJob(const char *inName, ColorArg inColor, const JobFunction &inJobFunction, uint32 inNumDependencies = 0) override;
+	virtual JobHandle		CreateJob(const char *inName, ColorArg inColor, const JobFunction &inJobFunction, uint32 inNumDependencies = 0, EJobPriority inPriority = EJobPriority::Normal) override;
 
 	/// Change the max concurrency after initialization
 	void					SetNumThreads(int inNumThreads)					{ StopThreads(); StartThreads(inNumThreads); }
@@ -60,11 +111,30 @@ private:
 	/// Entry point for a thread
 	void					ThreadMain(int inThreadIndex);
 
-	/// Get the head of the thread that has processed the least amount of jobs
-	inline uint				GetHead() const;
+	/// Get the head of the thread that has processed the least amount of jobs in the queue of inPriority
+	inline uint				GetHead(uint inPriority) const;
+
+	/// Take the next job for a thread, highest priority first, returns nullptr if all queues are empty
+	inline Job *			TakeJob(int inThreadIndex);
+
+	/// Internal helper function to queue a job, inQueueTime is stored in the job for the queue latency statistics
+	inline void				QueueJobInternal(Job *inJob, uint64 inQueueTime);
+
+	/// Count inNumJobs jobs queued by the current thread in the statistics
+	inline void				CountQueuedJobs(uint inNumJobs);
 
-	/// Internal helper function to queue a job
-	inline void				QueueJobInternal(Job *inJob);
+	/// Counters of a worker, only written by the worker itself (see WorkerStats)
+	struct alignas(JPH_CACHE_LINE_SIZE) WorkerCounters
+	{
+		atomic<uint64>		mNumJobsQueued { 0 };
+		atomic<uint64>		mNumJobsExecuted { 0 };
+		atomic<uint64>		mQueueLatency { 0 };
+		atomic<uint64>		mMaxQueueLatency { 0 };
+		atomic<uint64>		mBusyTime { 0 };
+		atomic<uint64>		mIdleTime { 0 };
+		atomic<uint64>		mNumWakeups { 0 };
+		atomic<uint64>		mNumEmptyWakeups { 0 };
+	};
 
 	/// Array of jobs (fixed size)
 	using AvailableJobs = FixedSizeFreeList<Job>;
@@ -73,14 +143,30 @@ private:
 	/// Threads running jobs
 	Array<thread>			mThreads;
 
-	// The job queue
+	/// Called on the worker thread (with its index) before it runs any jobs and after it ran its last job, e.g. to pin or name the thread
+	InitExitFunction		mThreadInitFunction = [](int) { };
+	InitExitFunction		mThreadExitFunction = [](int) { };
+
+	/// Initial size of the temp allocator of each worker thread, 0 if workers don't have one
+	uint					mThreadTempAllocatorSize = 0;
+
+	/// Number of jobs a magazine moves to / from the shared free list at once, 0 if magazines are disabled
+	uint					mJobMagazineSize = 0;
+
+	// The job queues, one per priority
 	static constexpr uint32 cQueueLength = 1024;
 	static_assert(IsPowerOf2(cQueueLength));								// We do bit operations and require queue length to be a power of 2
-	atomic<Job *>			mQueue[cQueueLength];
+	atomic<Job *>			mQueue[cNumJobPriorities][cQueueLength];
+
+	// Heads and tails of the queues, do this value modulo cQueueLength - 1 to get the element in the mQueue array
+	atomic<uint> *			mHeads = nullptr;								///< Per executing thread and per priority the head of the queue, index is thread * cNumJobPriorities + priority
+	alignas(JPH_CACHE_LINE_SIZE) atomic<uint> mTail[cNumJobPriorities] { };	///< Tail (write end) of each queue
 
-	// Head and tail of the queue, do this value modulo cQueueLength - 1 to get the element in the mQueue array
-	atomic<uint> *			mHeads = nullptr;								///< Per executing thread the head of the current queue
-	alignas(JPH_CACHE_LINE_SIZE) atomic<uint> mTail = 0;					///< Tail (write end) of the queue
+	// Statistics
+	WorkerCounters *		mWorkerCounters = nullptr;						///< Per worker thread
+	alignas(JPH_CACHE_LINE_SIZE) atomic<uint64> mNumJobsQueuedExternally { 0 }; ///< Jobs queued by threads that are not workers
+	atomic<uint64>			mNumQueueFullStalls { 0 };						///< Number of times QueueJobInternal had to wait for space
+	atomic<uint>			mMaxQueueDepth[cNumJobPriorities] { };			///< See Stats::mMaxQueueDepth
 
 	// Semaphore used to signal worker threads that there is new work
 	Semaphore				mSemaphore;
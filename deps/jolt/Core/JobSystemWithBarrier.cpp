@@ -9,6 +9,7 @@
 
 JPH_SUPPRESS_WARNINGS_STD_BEGIN
 #include <thread>
+#include <chrono>
 JPH_SUPPRESS_WARNINGS_STD_END
 
 JPH_NAMESPACE_BEGIN
@@ -104,6 +105,10 @@ void JobSystemWithBarrier::BarrierImpl::OnJobFinished(Job *inJob)
 
 void JobSystemWithBarrier::BarrierImpl::Wait()
 {
+	uint64 wait_start = sGetStatsTime();
+	uint64 sleep_time = 0;
+	uint num_jobs_executed = 0;
+
 	while (mNumToAcquire > 0)
 	{
 		{
@@ -129,17 +134,37 @@ void JobSystemWithBarrier::BarrierImpl::Wait()
 					++mJobReadIndex;
 				}
 
-				// Loop through the jobs and execute the first executable job
+				// Loop through the jobs and find the first executable job with the highest priority
+				uint best_index = mJobWriteIndex;
+				Job *best_job = nullptr;
 				for (uint index = mJobReadIndex; index < mJobWriteIndex; ++index)
 				{
 					const atomic<Job *> &job = mJobs[index & (cMaxJobs - 1)];
 					Job *job_ptr = job.load();
-					if (job_ptr != nullptr && job_ptr->CanBeExecuted())
+					if (job_ptr != nullptr && job_ptr->CanBeExecuted() && (best_job == nullptr || job_ptr->GetPriority() < best_job->GetPriority()))
 					{
-						// This will only execute the job if it has not already executed
-						job_ptr->Execute();
-						has_executed = true;
-						break;
+						best_index = index;
+						best_job = job_ptr;
+						if (best_job->GetPriority() == EJobPriority::High)
+							break;
+					}
+				}
+
+				if (best_job != nullptr)
+				{
+					// Execute all executable jobs of that priority in this pass, rescanning after every job would make a wait O(N^2) in the number of jobs.
+					// Jobs of a higher priority that become executable in the meantime are picked up by the next pass.
+					EJobPriority best_priority = best_job->GetPriority();
+					for (uint index = best_index; index < mJobWriteIndex; ++index)
+					{
+						const atomic<Job *> &job = mJobs[index & (cMaxJobs - 1)];
+						Job *job_ptr = job.load();
+						if (job_ptr != nullptr && job_ptr->GetPriority() == best_priority && job_ptr->CanBeExecuted())
+						{
+							// This will only execute the job if it has not already executed
+							job_ptr->Execute(&num_jobs_executed);
+							has_executed = true;
+						}
 					}
 				}
 
@@ -148,7 +173,9 @@ void JobSystemWithBarrier::BarrierImpl::Wait()
 
 		// Wait for another thread to wake us when either there is more work to do or when all jobs have completed
 		int num_to_acquire = max(1, mSemaphore.GetValue()); // When there have been multiple releases, we acquire them all at the same time to avoid needlessly spinning on executing jobs
+		uint64 sleep_start = sGetStatsTime();
 		mSemaphore.Acquire(num_to_acquire);
+		sleep_time += sGetStatsTime() - sleep_start;
 		mNumToAcquire -= num_to_acquire;
 	}
 
@@ -162,6 +189,17 @@ void JobSystemWithBarrier::BarrierImpl::Wait()
 		job = nullptr;
 		++mJobReadIndex;
 	}
+
+	// Only one thread waits on a barrier at a time, so no need for read-modify-write
+	mNumWaits.store(mNumWaits.load(memory_order_relaxed) + 1, memory_order_relaxed);
+	mWaitTime.store(mWaitTime.load(memory_order_relaxed) + sGetStatsTime() - wait_start, memory_order_relaxed);
+	mSleepTime.store(mSleepTime.load(memory_order_relaxed) + sleep_time, memory_order_relaxed);
+	mNumJobsExecuted.store(mNumJobsExecuted.load(memory_order_relaxed) + num_jobs_executed, memory_order_relaxed);
+}
+
+uint64 JobSystemWithBarrier::sGetStatsTime()
+{
+	return uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
 }
 
 void JobSystemWithBarrier::Init(uint inMaxBarriers)
@@ -216,6 +254,18 @@ void JobSystemWithBarrier::DestroyBarrier(Barrier *inBarrier)
 	JPH_ASSERT(expected);
 }
 
+void JobSystemWithBarrier::GetBarrierStats(BarrierStats &outStats) const
+{
+	outStats = BarrierStats();
+	for (const BarrierImpl *b = mBarriers, *b_end = mBarriers + mMaxBarriers; b < b_end; ++b)
+	{
+		outStats.mNumWaits += b->mNumWaits.load(memory_order_relaxed);
+		outStats.mWaitTime += b->mWaitTime.load(memory_order_relaxed);
+		outStats.mSleepTime += b->mSleepTime.load(memory_order_relaxed);
+		outStats.mNumJobsExecuted += b->mNumJobsExecuted.load(memory_order_relaxed);
+	}
+}
+
 void JobSystemWithBarrier::WaitForJobs(Barrier *inBarrier)
 {
 	JPH_PROFILE_FUNCTION();
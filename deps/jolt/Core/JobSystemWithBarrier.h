@@ -40,6 +40,22 @@ public:
 	virtual void			DestroyBarrier(Barrier *inBarrier) override;
 	virtual void			WaitForJobs(Barrier *inBarrier) override;
 
+	/// Time spent in WaitForJobs, times are in nanoseconds. The counters only go up, subtract two snapshots to get the numbers for an interval (e.g. a physics step).
+	struct BarrierStats
+	{
+		uint64				mNumWaits = 0;									///< Number of calls to WaitForJobs
+		uint64				mWaitTime = 0;									///< Total time spent in WaitForJobs
+		uint64				mSleepTime = 0;									///< Part of mWaitTime during which the waiting thread was asleep because none of the barrier's jobs could be executed
+		uint64				mNumJobsExecuted = 0;							///< Number of jobs that the waiting thread executed itself
+	};
+
+	/// Get the barrier statistics summed over all barriers, can be called from any thread
+	void					GetBarrierStats(BarrierStats &outStats) const;
+
+protected:
+	/// Clock used for statistics, in nanoseconds
+	static uint64			sGetStatsTime();
+
 private:
 	class BarrierImpl : public Barrier
 	{
@@ -63,6 +79,12 @@ private:
 		/// Flag to indicate if a barrier has been handed out
 		atomic<bool>		mInUse { false };
 
+		/// Statistics of Wait, only written by the waiting thread (see BarrierStats)
+		atomic<uint64>		mNumWaits { 0 };
+		atomic<uint64>		mWaitTime { 0 };
+		atomic<uint64>		mSleepTime { 0 };
+		atomic<uint64>		mNumJobsExecuted { 0 };
+
 	protected:
 		/// Called by a Job to mark that it is finished
 		virtual void		OnJobFinished(Job *inJob) override;
@@ -0,0 +1,397 @@
+// Jolt Physics Library (https://github.com/jrouwe/JoltPhysics)
+// SPDX-License-Identifier: MIT
+
+#include <Jolt/Jolt.h>
+
+#include <Jolt/Core/JobSystemWorkStealing.h>
+#include <Jolt/Core/Profiler.h>
+#include <Jolt/Core/FPException.h>
+
+JPH_NAMESPACE_BEGIN
+
+// Worker of the calling thread, nullptr for threads that are not started by a JobSystemWorkStealing
+static thread_local void *sCurrentWorker = nullptr;
+
+bool JobSystemWorkStealing::Worker::Push(Job *inJob)
+{
+	int64_t bottom = mBottom.load(memory_order_relaxed);
+	int64_t top = mTop.load(memory_order_acquire);
+	if (bottom - top >= int64_t(cDequeLength))
+		return false;
+
+	mDeque[bottom & (cDequeLength - 1)].store(inJob, memory_order_relaxed);
+
+	// Make the job visible before the new bottom
+	atomic_thread_fence(memory_order_release);
+	mBottom.store(bottom + 1, memory_order_relaxed);
+	return true;
+}
+
+JobSystem::Job *JobSystemWorkStealing::Worker::Pop()
+{
+	// Reserve the bottom element before looking at top, a thief that reads the old bottom races with us below
+	int64_t bottom = mBottom.load(memory_order_relaxed) - 1;
+	mBottom.store(bottom, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t top = mTop.load(memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		// Empty, restore bottom
+		mBottom.store(bottom + 1, memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job *job = mDeque[bottom & (cDequeLength - 1)].load(memory_order_relaxed);
+	if (top == bottom)
+	{
+		// Last element, compete with thieves for it
+		if (!mTop.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+			job = nullptr;
+		mBottom.store(bottom + 1, memory_order_relaxed);
+	}
+	return job;
+}
+
+JobSystem::Job *JobSystemWorkStealing::Worker::Steal()
+{
+	int64_t top = mTop.load(memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t bottom = mBottom.load(memory_order_acquire);
+	if (top >= bottom)
+		return nullptr;
+
+	// Read the job before claiming it, the owner can't overwrite this slot until top has moved past it
+	Job *job = mDeque[top & (cDequeLength - 1)].load(memory_order_relaxed);
+	if (!mTop.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+		return nullptr;
+	return job;
+}
+
+uint32 JobSystemWorkStealing::Worker::NextRandom()
+{
+	uint32 x = mRandomState;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	mRandomState = x;
+	return x;
+}
+
+void JobSystemWorkStealing::Init(uint inMaxJobs, uint inMaxBarriers, int inNumThreads)
+{
+	JobSystemWithBarrier::Init(inMaxBarriers);
+
+	// Init freelist of jobs
+	mJobs.Init(inMaxJobs, inMaxJobs);
+
+	// Start the worker threads
+	StartThreads(inNumThreads);
+}
+
+JobSystemWorkStealing::JobSystemWorkStealing(uint inMaxJobs, uint inMaxBarriers, int inNumThreads)
+{
+	Init(inMaxJobs, inMaxBarriers, inNumThreads);
+}
+
+JobSystemWorkStealing::~JobSystemWorkStealing()
+{
+	// Stop all worker threads
+	StopThreads();
+}
+
+void JobSystemWorkStealing::StartThreads(int inNumThreads)
+{
+	// Auto detect number of threads
+	if (inNumThreads < 0)
+		inNumThreads = thread::hardware_concurrency() - 1;
+
+	// If no threads are requested we're done
+	if (inNumThreads == 0)
+		return;
+
+	// Don't quit the threads
+	mQuit = false;
+
+	// Create workers, each with its own non-zero random seed
+	mWorkers = new Worker [inNumThreads];
+	for (int i = 0; i < inNumThreads; ++i)
+	{
+		Worker &w = mWorkers[i];
+		w.mJobSystem = this;
+		w.mIndex = uint(i);
+		w.mRandomState = 0x9e3779b9u * uint32(i + 1);
+		for (atomic<Job *> &j : w.mDeque)
+			j = nullptr;
+	}
+
+	// Start running threads
+	JPH_ASSERT(mThreads.empty());
+	mThreads.reserve(inNumThreads);
+	for (int i = 0; i < inNumThreads; ++i)
+		mThreads.emplace_back([this, i] { ThreadMain(i); });
+}
+
+void JobSystemWorkStealing::StopThreads()
+{
+	if (mThreads.empty())
+		return;
+
+	// Signal threads that we want to stop and wake them up
+	mQuit = true;
+	mSemaphore.Release((uint)mThreads.size());
+
+	// Wait for all threads to finish
+	for (thread &t : mThreads)
+		if (t.joinable())
+			t.join();
+
+	// Ensure that there are no lingering jobs in the deques or the injection queue
+	for (size_t i = 0; i < mThreads.size(); ++i)
+		for (Job *job = mWorkers[i].Pop(); job != nullptr; job = mWorkers[i].Pop())
+		{
+			job->Execute();
+			job->Release();
+		}
+	for (; mInjectHead != mInjectTail; ++mInjectHead)
+	{
+		Job *job = mInjectQueue[mInjectHead & (cInjectQueueLength - 1)];
+		job->Execute();
+		job->Release();
+	}
+	mInjectHead = mInjectTail = 0;
+	mNumInjected = 0;
+	mNumSleeping = 0;
+
+	// Delete all threads and workers
+	mThreads.clear();
+	delete [] mWorkers;
+	mWorkers = nullptr;
+}
+
+JobHandle JobSystemWorkStealing::CreateJob(const char *inJobName, ColorArg inColor, const JobFunction &inJobFunction, uint32 inNumDependencies, EJobPriority inPriority)
+{
+	JPH_PROFILE_FUNCTION();
+
+	// Loop until we can get a job from the free list
+	uint32 index;
+	for (;;)
+	{
+		index = mJobs.ConstructObject(inJobName, inColor, this, inJobFunction, inNumDependencies, inPriority);
+		if (index != AvailableJobs::cInvalidObjectIndex)
+			break;
+		JPH_ASSERT(false, "No jobs available!");
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+	Job *job = &mJobs.Get(index);
+
+	// Construct handle to keep a reference, the job is queued below and may immediately complete
+	JobHandle handle(job);
+
+	// If there are no dependencies, queue the job now
+	if (inNumDependencies == 0)
+		QueueJob(job);
+
+	// Return the handle
+	return handle;
+}
+
+void JobSystemWorkStealing::FreeJob(Job *inJob)
+{
+	mJobs.DestructObject(inJob);
+}
+
+JobSystemWorkStealing::Worker *JobSystemWorkStealing::GetCurrentWorker() const
+{
+	Worker *worker = static_cast<Worker *>(sCurrentWorker);
+	return worker != nullptr && worker->mJobSystem == this? worker : nullptr;
+}
+
+void JobSystemWorkStealing::QueueJobInternal(Job *inJob)
+{
+	// Jobs queued from one of our workers stay on that worker
+	Worker *worker = GetCurrentWorker();
+	if (worker != nullptr && worker->Push(inJob))
+		return;
+
+	for (;;)
+	{
+		{
+			lock_guard lock(mInjectMutex);
+			if (mInjectTail - mInjectHead < cInjectQueueLength)
+			{
+				mInjectQueue[mInjectTail++ & (cInjectQueueLength - 1)] = inJob;
+				mNumInjected.fetch_add(1, memory_order_release);
+				return;
+			}
+		}
+
+		// Queue is full, wake up all threads so that they empty it and wait a little
+		mSemaphore.Release((uint)mThreads.size());
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+}
+
+void JobSystemWorkStealing::WakeWorkers(uint inNumJobs)
+{
+	// Pairs with the fence in ThreadMain: either we see the sleeping worker or it sees the job we just queued
+	atomic_thread_fence(memory_order_seq_cst);
+	uint num_sleeping = mNumSleeping.load(memory_order_relaxed);
+	if (num_sleeping > 0)
+		mSemaphore.Release(min(inNumJobs, num_sleeping));
+}
+
+void JobSystemWorkStealing::QueueJob(Job *inJob)
+{
+	JPH_PROFILE_FUNCTION();
+
+	// If we have no worker threads, we can't queue the job either. We assume in this case that the job will be added to a barrier and that the barrier will execute the job when it's Wait() function is called.
+	if (mThreads.empty())
+		return;
+
+	// Add reference to job because we're adding the job to the queue
+	inJob->AddRef();
+	QueueJobInternal(inJob);
+
+	// Wake up thread
+	WakeWorkers(1);
+}
+
+void JobSystemWorkStealing::QueueJobs(Job **inJobs, uint inNumJobs)
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(inNumJobs > 0);
+
+	// If we have no worker threads, we can't queue the job either. We assume in this case that the job will be added to a barrier and that the barrier will execute the job when it's Wait() function is called.
+	if (mThreads.empty())
+		return;
+
+	// Queue all jobs
+	for (Job **job = inJobs, **job_end = inJobs + inNumJobs; job < job_end; ++job)
+	{
+		(*job)->AddRef();
+		QueueJobInternal(*job);
+	}
+
+	// Wake up threads
+	WakeWorkers(inNumJobs);
+}
+
+JobSystem::Job *JobSystemWorkStealing::TakeInjectedJobs(Worker &ioWorker)
+{
+	Job *batch[cInjectBatchSize];
+	uint num_taken = 0;
+	{
+		lock_guard lock(mInjectMutex);
+
+		// Take a fair share so that other workers that wake up at the same time also find something
+		uint available = mInjectTail - mInjectHead;
+		uint share = max(1u, available / uint(mThreads.size()));
+		num_taken = min(min(available, share), cInjectBatchSize);
+		for (uint i = 0; i < num_taken; ++i)
+			batch[i] = mInjectQueue[mInjectHead++ & (cInjectQueueLength - 1)];
+		mNumInjected.fetch_sub(num_taken, memory_order_relaxed);
+	}
+	if (num_taken == 0)
+		return nullptr;
+
+	// Keep the first, push the rest in reverse so they pop in queue order; they can be stolen from there
+	for (uint i = num_taken - 1; i > 0; --i)
+		if (!ioWorker.Push(batch[i]))
+		{
+			batch[i]->Execute();
+			batch[i]->Release();
+		}
+	if (num_taken > 1)
+		WakeWorkers(num_taken - 1);
+	return batch[0];
+}
+
+JobSystem::Job *JobSystemWorkStealing::FindJob(Worker &ioWorker)
+{
+	// Own deque (most recently queued first)
+	Job *job = ioWorker.Pop();
+	if (job != nullptr)
+		return job;
+
+	// Jobs queued from outside
+	if (mNumInjected.load(memory_order_acquire) > 0)
+	{
+		job = TakeInjectedJobs(ioWorker);
+		if (job != nullptr)
+			return job;
+	}
+
+	// Steal from the other workers, starting at a random one
+	uint num_workers = (uint)mThreads.size();
+	if (num_workers > 1)
+	{
+		uint first = ioWorker.NextRandom() % num_workers;
+		for (uint i = 0; i < num_workers; ++i)
+		{
+			uint victim = (first + i) % num_workers;
+			if (victim == ioWorker.mIndex)
+				continue;
+			job = mWorkers[victim].Steal();
+			if (job != nullptr)
+				return job;
+		}
+	}
+
+	return nullptr;
+}
+
+void JobSystemWorkStealing::ThreadMain(int inThreadIndex)
+{
+	// Name the thread
+	char name[64];
+	snprintf(name, sizeof(name), "Worker %d", int(inThreadIndex + 1));
+
+	// Enable floating point exceptions
+	FPExceptionsEnable enable_exceptions;
+	JPH_UNUSED(enable_exceptions);
+
+	JPH_PROFILE_THREAD_START(name);
+
+	// Call the thread init function
+	mThreadInitFunction(inThreadIndex);
+
+	Worker &worker = mWorkers[inThreadIndex];
+	sCurrentWorker = &worker;
+
+	while (!mQuit)
+	{
+		Job *job = FindJob(worker);
+		if (job == nullptr)
+		{
+			// Announce that we're going to sleep and look once more, so that a job queued in between is not missed
+			mNumSleeping.fetch_add(1, memory_order_relaxed);
+			atomic_thread_fence(memory_order_seq_cst);
+			job = FindJob(worker);
+			if (job == nullptr)
+			{
+				mSemaphore.Acquire();
+				mNumSleeping.fetch_sub(1, memory_order_relaxed);
+				continue;
+			}
+			mNumSleeping.fetch_sub(1, memory_order_relaxed);
+		}
+
+		// Execute the job, this is a no-op when the barrier already executed it
+		{
+			JPH_PROFILE("Executing Jobs");
+			job->Execute();
+			job->Release();
+		}
+	}
+
+	sCurrentWorker = nullptr;
+
+	// Call the thread exit function
+	mThreadExitFunction(inThreadIndex);
+
+	JPH_PROFILE_THREAD_END();
+}
+
+JPH_NAMESPACE_END
@@ -0,0 +1,147 @@
+// Jolt Physics Library (https://github.com/jrouwe/JoltPhysics)
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Jolt/Core/JobSystemWithBarrier.h>
+#include <Jolt/Core/FixedSizeFreeList.h>
+#include <Jolt/Core/Semaphore.h>
+#include <Jolt/Core/Mutex.h>
+
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <thread>
+JPH_SUPPRESS_WARNINGS_STD_END
+
+JPH_NAMESPACE_BEGIN
+
+/// Implementation of a JobSystem using a thread pool where every worker owns a work-stealing deque
+///
+/// Compared to JobSystemThreadPool, which has a single queue that all threads contend on, jobs queued from a worker
+/// thread (e.g. a job that becomes executable because the job that just finished on this thread was its last
+/// dependency) are pushed on the bottom of that worker's own Chase-Lev deque. The owner pops from the bottom (LIFO,
+/// so the data the previous job touched is likely still in cache) while idle workers steal from the top of a randomly
+/// chosen victim. Jobs queued from other threads (e.g. the main thread) go into a mutex protected injection queue
+/// that workers take from in small batches.
+///
+/// Job priorities (EJobPriority) are ignored, a job that becomes executable on a worker already runs next on that worker.
+class JPH_EXPORT JobSystemWorkStealing final : public JobSystemWithBarrier
+{
+public:
+	JPH_OVERRIDE_NEW_DELETE
+
+	/// Creates a thread pool.
+	/// @see JobSystemWorkStealing::Init
+							JobSystemWorkStealing(uint inMaxJobs, uint inMaxBarriers, int inNumThreads = -1);
+							JobSystemWorkStealing() = default;
+	virtual					~JobSystemWorkStealing() override;
+
+	/// Functions to call when a thread is initialized or exits, must be set before calling Init()
+	using InitExitFunction = function<void(int)>;
+	void					SetThreadInitFunction(const InitExitFunction &inInitFunction)	{ mThreadInitFunction = inInitFunction; }
+	void					SetThreadExitFunction(const InitExitFunction &inExitFunction)	{ mThreadExitFunction = inExitFunction; }
+
+	/// Initialize the thread pool
+	/// @param inMaxJobs Max number of jobs that can be allocated at any time
+	/// @param inMaxBarriers Max number of barriers that can be allocated at any time
+	/// @param inNumThreads Number of threads to start (the number of concurrent jobs is 1 more because the main thread will also run jobs while waiting for a barrier to complete). Use -1 to autodetect the amount of CPU's.
+	void					Init(uint inMaxJobs, uint inMaxBarriers, int inNumThreads = -1);
+
+	// See JobSystem
+	virtual int				GetMaxConcurrency() const override				{ return int(mThreads.size()) + 1; }
+	virtual JobHandle		CreateJob(const char *inName, ColorArg inColor, const JobFunction &inJobFunction, uint32 inNumDependencies = 0, EJobPriority inPriority = EJobPriority::Normal) override;
+
+	/// Change the max concurrency after initialization
+	void					SetNumThreads(int inNumThreads)					{ StopThreads(); StartThreads(inNumThreads); }
+
+protected:
+	// See JobSystem
+	virtual void			QueueJob(Job *inJob) override;
+	virtual void			QueueJobs(Job **inJobs, uint inNumJobs) override;
+	virtual void			FreeJob(Job *inJob) override;
+
+private:
+	/// Per worker state, the deque is only pushed / popped by the owning thread, other workers steal from its top
+	class alignas(JPH_CACHE_LINE_SIZE) Worker
+	{
+	public:
+		JPH_OVERRIDE_NEW_DELETE
+
+		static constexpr uint cDequeLength = 1024;
+		static_assert(IsPowerOf2(cDequeLength));							// We do bit operations and require deque length to be a power of 2
+
+		/// Owner only: push a job on the bottom of the deque, returns false if the deque is full
+		inline bool			Push(Job *inJob);
+
+		/// Owner only: pop the most recently pushed job, returns nullptr if the deque is empty
+		inline Job *		Pop();
+
+		/// Any thread: take the oldest job, returns nullptr if the deque is empty or another thread took it first
+		inline Job *		Steal();
+
+		/// Owner only: next random number for victim selection (xorshift32)
+		inline uint32		NextRandom();
+
+		JobSystemWorkStealing *	mJobSystem = nullptr;						///< Job system this worker belongs to
+		uint				mIndex = 0;										///< Index in mWorkers
+		uint32				mRandomState = 0;								///< State of the random generator used to pick victims
+
+		alignas(JPH_CACHE_LINE_SIZE) atomic<int64_t> mTop { 0 };				///< Steal end of the deque
+		alignas(JPH_CACHE_LINE_SIZE) atomic<int64_t> mBottom { 0 };			///< Owner end of the deque
+		atomic<Job *>		mDeque[cDequeLength];
+	};
+
+	/// Start/stop the worker threads
+	void					StartThreads(int inNumThreads);
+	void					StopThreads();
+
+	/// Entry point for a thread
+	void					ThreadMain(int inThreadIndex);
+
+	/// Get the worker of the calling thread if it belongs to this job system
+	inline Worker *			GetCurrentWorker() const;
+
+	/// Add a job to the deque of the calling worker or, if that is not possible, to the injection queue. The job needs to have a reference added already.
+	inline void				QueueJobInternal(Job *inJob);
+
+	/// Wake up to inNumJobs sleeping workers
+	inline void				WakeWorkers(uint inNumJobs);
+
+	/// Find a job for a worker: own deque first, then the injection queue, then steal from others
+	Job *					FindJob(Worker &ioWorker);
+
+	/// Take a batch of jobs from the injection queue, the first one is returned and the rest are pushed on the deque of ioWorker
+	Job *					TakeInjectedJobs(Worker &ioWorker);
+
+	/// Array of jobs (fixed size)
+	using AvailableJobs = FixedSizeFreeList<Job>;
+	AvailableJobs			mJobs;
+
+	/// Threads running jobs
+	Array<thread>			mThreads;
+
+	/// Called on the worker thread (with its index) before it runs any jobs and after it ran its last job, e.g. to pin or name the thread
+	InitExitFunction		mThreadInitFunction = [](int) { };
+	InitExitFunction		mThreadExitFunction = [](int) { };
+
+	/// One worker per thread
+	Worker *				mWorkers = nullptr;
+
+	// Injection queue for jobs queued from threads that are not workers of this job system
+	static constexpr uint32 cInjectQueueLength = 4096;
+	static_assert(IsPowerOf2(cInjectQueueLength));							// We do bit operations and require queue length to be a power of 2
+	static constexpr uint	cInjectBatchSize = 8;							///< Max number of jobs a worker takes from the injection queue at once
+	Mutex					mInjectMutex;
+	Job *					mInjectQueue[cInjectQueueLength];
+	uint					mInjectHead = 0;								///< Protected by mInjectMutex
+	uint					mInjectTail = 0;								///< Protected by mInjectMutex
+	alignas(JPH_CACHE_LINE_SIZE) atomic<uint> mNumInjected = 0;				///< Number of jobs in the injection queue, allows checking for work without taking the lock
+
+	// Semaphore used to signal worker threads that there is new work
+	alignas(JPH_CACHE_LINE_SIZE) atomic<uint> mNumSleeping = 0;				///< Number of workers that found no work and are (about to be) waiting on mSemaphore
+	Semaphore				mSemaphore;
+
+	/// Boolean to indicate that we want to stop the job system
+	atomic<bool>			mQuit = false;
+};
+
+JPH_NAMESPACE_END
@@ -0,0 +1,120 @@
+// Jolt Physics Library (https://github.com/jrouwe/JoltPhysics)
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Jolt/Core/NonCopyable.h>
+#include <Jolt/Core/Atomics.h>
+
+JPH_NAMESPACE_BEGIN
+
+/// Lock free hash map with open addressing that only allows insertion and retrieval, an alternative to LockFreeHashMap.
+///
+/// Key value pairs live in a flat array next to an array of control bytes, one per slot: empty, busy (being inserted) or
+/// 0x80 | 7 bits of the hash. Slots are probed in groups of 16 and a whole group of control bytes is compared against
+/// the hash bits with a single SIMD compare, so a lookup usually touches one cache line of control bytes and one key.
+///
+/// The capacity is fixed while threads insert (Create returns nullptr and counts an overflow when the map is full).
+/// Between epochs (e.g. physics steps), when no other thread uses the map, GrowIfNeeded doubles the capacity when the
+/// map got too full or overflowed, so unlike LockFreeHashMap it adapts to the number of key value pairs it needs to hold.
+///
+/// Note: This class assumes key and value are simple types that need no calls to the destructor.
+template <class Key, class Value>
+class LockFreeOpenHashMap : public NonCopyable
+{
+public:
+	/// A key / value pair that is inserted in the map
+	class KeyValue
+	{
+	public:
+		const Key &			GetKey() const					{ return mKey; }
+		Value &				GetValue()						{ return mValue; }
+		const Value &		GetValue() const				{ return mValue; }
+
+	private:
+		template <class K, class V> friend class LockFreeOpenHashMap;
+
+		Key					mKey;							///< Key for this entry
+		Value				mValue;							///< Value for this entry
+	};
+
+	/// Number of slots that are probed at once
+	static constexpr uint32	cGroupSize = 16;
+
+	/// Destructor
+							~LockFreeOpenHashMap();
+
+	/// Initialization
+	/// @param inCapacity Number of key value pairs the map can hold before it needs to grow, will be rounded up to a power of 2 (at least cGroupSize).
+	void					Init(uint32 inCapacity);
+
+	/// Remove all elements.
+	/// Note that this cannot happen simultaneously with adding new elements.
+	void					Clear();
+
+	/// Insert a new element, returns null if the map is full.
+	/// Multiple threads can be inserting in the map at the same time, but they must not insert the same key at the same time.
+	template <class... Params>
+	inline KeyValue *		Create(const Key &inKey, uint64 inKeyHash, Params &&... inConstructorParams);
+
+	/// Find an element, returns null if not found.
+	/// Can be called while other threads insert, an element that is being inserted may or may not be found.
+	inline const KeyValue *	Find(const Key &inKey, uint64 inKeyHash) const;
+
+	/// Grow the map if during the last epoch it got fuller than 5/8 or Create failed. Existing elements are rehashed, so pointers and handles
+	/// to them become invalid. Cannot happen simultaneously with any other operation on the map. Key::GetHash() must return the hash that was passed to Create.
+	/// @return True if the map grew.
+	bool					GrowIfNeeded();
+
+	/// Value of an invalid handle
+	const static uint32		cInvalidHandle = uint32(-1);
+
+	/// Convert key value pair to uint32 handle
+	inline uint32			ToHandle(const KeyValue *inKeyValue) const	{ return uint32(inKeyValue - mKeyValues); }
+
+	/// Convert uint32 handle back to key and value
+	inline const KeyValue *	FromHandle(uint32 inHandle) const			{ JPH_ASSERT(inHandle < mCapacity); return mKeyValues + inHandle; }
+
+	/// Number of slots in the map
+	uint32					GetCapacity() const				{ return mCapacity; }
+
+	/// Get the number of key value pairs that this map currently contains (scans the control bytes, not safe while inserting)
+	uint32					GetNumKeyValues() const;
+
+	/// Number of times Create failed because the map was full since the last GrowIfNeeded
+	uint32					GetNumOverflows() const			{ return mNumOverflows.load(memory_order_relaxed); }
+
+	/// Memory used by the map in bytes
+	size_t					GetMemoryUsage() const			{ return size_t(mCapacity) * (sizeof(KeyValue) + 1); }
+
+	/// Get all key/value pairs
+	inline void				GetAllKeyValues(Array<const KeyValue *> &outAll) const;
+
+private:
+	/// Control byte values
+	static constexpr uint8	cEmpty = 0x00;
+	static constexpr uint8	cBusy = 0x01;
+	static constexpr uint8	cOccupied = 0x80;
+
+	/// Control byte for a hash
+	static inline uint8		sGetControl(uint64 inKeyHash)	{ return uint8(cOccupied | (inKeyHash & 0x7f)); }
+
+	/// Bit mask of the slots in the group starting at inControl that have control byte inValue
+	static inline uint32	sMatchGroup(const atomic<uint8> *inControl, uint8 inValue);
+
+	/// Allocate storage for inCapacity slots, all empty
+	void					AllocateSlots(uint32 inCapacity);
+
+	/// Free storage
+	void					FreeSlots();
+
+	atomic<uint8> *			mControl = nullptr;				///< Control byte per slot
+	KeyValue *				mKeyValues = nullptr;			///< Key value pair per slot
+	uint32					mCapacity = 0;					///< Number of slots, power of 2
+	uint32					mGroupMask = 0;					///< Number of groups - 1
+	atomic<uint32>			mNumOverflows { 0 };			///< Number of failed inserts since the last GrowIfNeeded
+};
+
+JPH_NAMESPACE_END
+
+#include "LockFreeOpenHashMap.inl"
@@ -0,0 +1,197 @@
+// Jolt Physics Library (https://github.com/jrouwe/JoltPhysics)
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+JPH_NAMESPACE_BEGIN
+
+template <class Key, class Value>
+LockFreeOpenHashMap<Key, Value>::~LockFreeOpenHashMap()
+{
+	FreeSlots();
+}
+
+template <class Key, class Value>
+void LockFreeOpenHashMap<Key, Value>::AllocateSlots(uint32 inCapacity)
+{
+	static_assert(sizeof(atomic<uint8>) == sizeof(uint8));
+	JPH_ASSERT(inCapacity >= cGroupSize && IsPowerOf2(inCapacity));
+
+	mCapacity = inCapacity;
+	mGroupMask = inCapacity / cGroupSize - 1;
+	mControl = reinterpret_cast<atomic<uint8> *>(AlignedAllocate(inCapacity, JPH_CACHE_LINE_SIZE));
+	mKeyValues = reinterpret_cast<KeyValue *>(AlignedAllocate(inCapacity * sizeof(KeyValue), max<size_t>(alignof(KeyValue), JPH_CACHE_LINE_SIZE)));
+	Clear();
+}
+
+template <class Key, class Value>
+void LockFreeOpenHashMap<Key, Value>::FreeSlots()
+{
+	if (mControl != nullptr)
+	{
+		AlignedFree(mControl);
+		AlignedFree(mKeyValues);
+		mControl = nullptr;
+		mKeyValues = nullptr;
+	}
+}
+
+template <class Key, class Value>
+void LockFreeOpenHashMap<Key, Value>::Init(uint32 inCapacity)
+{
+	JPH_ASSERT(mControl == nullptr);
+
+	AllocateSlots(max(GetNextPowerOf2(inCapacity), cGroupSize));
+}
+
+template <class Key, class Value>
+void LockFreeOpenHashMap<Key, Value>::Clear()
+{
+	memset(reinterpret_cast<void *>(mControl), cEmpty, mCapacity);
+}
+
+template <class Key, class Value>
+inline uint32 LockFreeOpenHashMap<Key, Value>::sMatchGroup(const atomic<uint8> *inControl, uint8 inValue)
+{
+	// Other threads may be claiming slots in this group while we read it, a stale byte is fine:
+	// a slot that changes from empty to busy to occupied is re-checked with an atomic load before its key is used
+#if defined(JPH_USE_SSE)
+	__m128i control = _mm_load_si128(reinterpret_cast<const __m128i *>(inControl));
+	return uint32(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(char(inValue)))));
+#elif defined(JPH_USE_NEON)
+	static constexpr uint8 cBits[] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+	uint8x16_t equal = vceqq_u8(vld1q_u8(reinterpret_cast<const uint8 *>(inControl)), vdupq_n_u8(inValue));
+	uint8x16_t bits = vandq_u8(equal, vld1q_u8(cBits));
+	return uint32(vaddv_u8(vget_low_u8(bits))) | (uint32(vaddv_u8(vget_high_u8(bits))) << 8);
+#else
+	uint32 mask = 0;
+	for (uint32 i = 0; i < cGroupSize; ++i)
+		if (inControl[i].load(memory_order_relaxed) == inValue)
+			mask |= uint32(1) << i;
+	return mask;
+#endif
+}
+
+template <class Key, class Value>
+template <class... Params>
+inline typename LockFreeOpenHashMap<Key, Value>::KeyValue *LockFreeOpenHashMap<Key, Value>::Create(const Key &inKey, uint64 inKeyHash, Params &&... inConstructorParams)
+{
+	// This is not a multi map, test the key hasn't been inserted yet
+	JPH_ASSERT(Find(inKey, inKeyHash) == nullptr);
+
+	// Probe the groups with triangular steps (visits every group once because the number of groups is a power of 2)
+	uint32 group = uint32(inKeyHash >> 7) & mGroupMask;
+	for (uint32 step = 1; step <= mGroupMask + 1; ++step)
+	{
+		atomic<uint8> *control = mControl + group * cGroupSize;
+		for (uint32 empty = sMatchGroup(control, cEmpty); empty != 0; empty &= empty - 1)
+		{
+			// Try to claim the slot, if another thread was first try the next empty slot
+			uint32 slot = CountTrailingZeros(empty);
+			uint8 expected = cEmpty;
+			if (!control[slot].compare_exchange_strong(expected, cBusy, memory_order_relaxed))
+				continue;
+
+			// Construct the key/value pair and publish it
+			KeyValue *kv = mKeyValues + group * cGroupSize + slot;
+			kv->mKey = inKey;
+			new (&kv->mValue) Value(std::forward<Params>(inConstructorParams)...);
+			control[slot].store(sGetControl(inKeyHash), memory_order_release);
+			return kv;
+		}
+
+		group = (group + step) & mGroupMask;
+	}
+
+	// Map is full
+	mNumOverflows.fetch_add(1, memory_order_relaxed);
+	return nullptr;
+}
+
+template <class Key, class Value>
+inline const typename LockFreeOpenHashMap<Key, Value>::KeyValue *LockFreeOpenHashMap<Key, Value>::Find(const Key &inKey, uint64 inKeyHash) const
+{
+	uint8 tag = sGetControl(inKeyHash);
+	uint32 group = uint32(inKeyHash >> 7) & mGroupMask;
+	for (uint32 step = 1; step <= mGroupMask + 1; ++step)
+	{
+		const atomic<uint8> *control = mControl + group * cGroupSize;
+		for (uint32 match = sMatchGroup(control, tag); match != 0; match &= match - 1)
+		{
+			// Load the control byte again to synchronize with the thread that inserted the key
+			uint32 slot = CountTrailingZeros(match);
+			if (control[slot].load(memory_order_acquire) != tag)
+				continue;
+			const KeyValue *kv = mKeyValues + group * cGroupSize + slot;
+			if (kv->mKey == inKey)
+				return kv;
+		}
+
+		// Slots never become empty again, so if this group has an empty slot the key would have been inserted here
+		if (sMatchGroup(control, cEmpty) != 0)
+			break;
+
+		group = (group + step) & mGroupMask;
+	}
+
+	// Not found
+	return nullptr;
+}
+
+template <class Key, class Value>
+uint32 LockFreeOpenHashMap<Key, Value>::GetNumKeyValues() const
+{
+	uint32 num_key_values = 0;
+	for (uint32 group = 0; group <= mGroupMask; ++group)
+		num_key_values += CountBits(~sMatchGroup(mControl + group * cGroupSize, cEmpty) & 0xffff);
+	return num_key_values;
+}
+
+template <class Key, class Value>
+bool LockFreeOpenHashMap<Key, Value>::GrowIfNeeded()
+{
+	// Check if the last epoch got too full
+	uint32 num_key_values = GetNumKeyValues();
+	uint32 num_overflows = mNumOverflows.load(memory_order_relaxed);
+	mNumOverflows.store(0, memory_order_relaxed);
+	if (num_overflows == 0 && num_key_values * 8 <= mCapacity * 5)
+		return false;
+
+	// Keep the load below 1/2 for the number of elements we saw plus the ones that didn't fit
+	uint32 new_capacity = max(GetNextPowerOf2(2 * (num_key_values + num_overflows)), 2 * mCapacity);
+
+	// Swap in new storage and reinsert the old elements
+	atomic<uint8> *old_control = mControl;
+	KeyValue *old_key_values = mKeyValues;
+	uint32 old_capacity = mCapacity;
+	AllocateSlots(new_capacity);
+	for (uint32 i = 0; i < old_capacity; ++i)
+	{
+		uint8 control = old_control[i].load(memory_order_relaxed);
+		JPH_ASSERT(control != cBusy);
+		if (control == cEmpty)
+			continue;
+
+		// The control byte only stores 7 bits of the hash so we can't recompute the group from it, use the hash of the key
+		const KeyValue &kv = old_key_values[i];
+		uint64 hash = kv.mKey.GetHash();
+		JPH_ASSERT(sGetControl(hash) == control);
+		KeyValue *new_kv = Create(kv.mKey, hash, kv.mValue);
+		JPH_ASSERT(new_kv != nullptr);
+		JPH_UNUSED(new_kv);
+	}
+	AlignedFree(old_control);
+	AlignedFree(old_key_values);
+
+	return true;
+}
+
+template <class Key, class Value>
+inline void LockFreeOpenHashMap<Key, Value>::GetAllKeyValues(Array<const KeyValue *> &outAll) const
+{
+	for (uint32 i = 0; i < mCapacity; ++i)
+		if ((mControl[i].load(memory_order_relaxed) & cOccupied) != 0)
+			outAll.push_back(mKeyValues + i);
+}
+
+JPH_NAMESPACE_END
@@ -11,6 +11,8 @@
 
 JPH_SUPPRESS_WARNINGS_STD_BEGIN
 #include <fstream>
+#include <thread>
+#include <condition_variable>
 JPH_SUPPRESS_WARNINGS_STD_END
 
 #ifdef JPH_PROFILE_ENABLED
@@ -41,6 +43,266 @@ Profiler *Profiler::sInstance = nullptr;
 
 bool ProfileMeasurement::sOutOfSamplesReported = false;
 
+//////////////////////////////////////////////////////////////////////////////////////////
+// Profiler::FlightRecorder
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/// Samples of the last frames, copied out of the ring buffers so they can be written while the threads continue
+struct FlightRecording
+{
+	struct Sample
+	{
+		const char *			mName;
+		uint64					mStartCycle;
+		uint64					mEndCycle;
+	};
+
+	struct Thread
+	{
+		String					mThreadName;
+		Array<Sample>			mSamples;
+	};
+
+	String						mPath;
+	uint64						mStartTick;															///< Start of the first frame, time 0 in the trace
+	uint64						mEndTick;															///< End of the last frame
+	uint64						mTicksPerSecond;
+	uint64						mFirstFrame;														///< Number of the first frame
+	Array<uint64>				mFrameTicks;														///< Start tick of every frame in the recording
+	Array<Thread>				mThreads;
+};
+
+class Profiler::FlightRecorder
+{
+public:
+	JPH_OVERRIDE_NEW_DELETE
+
+	/// Constructor, starts the thread that writes the dumps
+	explicit					FlightRecorder(const FlightRecorderSettings &inSettings) :
+		mSettings(inSettings),
+		mFrameTicks(inSettings.mNumFrames + 1, GetProcessorTickCount()),
+		mThread([this] { ThreadMain(); })
+	{
+	}
+
+	/// Destructor, writes the dumps that are still pending
+								~FlightRecorder()
+	{
+		{
+			std::lock_guard lock(mQueueLock);
+			mQuit = true;
+		}
+		mQueueChanged.notify_one();
+		mThread.join();
+	}
+
+	/// Hand a recording over to the writer thread
+	void						Write(FlightRecording *inRecording)
+	{
+		{
+			std::lock_guard lock(mQueueLock);
+			mQueue.push_back(inRecording);
+		}
+		mQueueChanged.notify_one();
+	}
+
+	FlightRecorderSettings		mSettings;
+	Array<uint64>				mFrameTicks;														///< Ring buffer with the start tick of the last mNumFrames + 1 frames, indexed by frame number
+	uint64						mFrame = 0;															///< Number of the current frame
+	uint64						mLastDumpFrame = 0;													///< Frame that triggered the last hitch dump, frames that are still in that dump don't trigger another one
+	uint						mNumDumps = 0;														///< Number of hitch dumps so far
+
+private:
+	/// Writes recordings until the recorder is destroyed
+	void						ThreadMain()
+	{
+		for (;;)
+		{
+			FlightRecording *recording;
+			{
+				std::unique_lock lock(mQueueLock);
+				mQueueChanged.wait(lock, [this] { return mQuit || !mQueue.empty(); });
+				if (mQueue.empty())
+					return;
+				recording = mQueue.front();
+				mQueue.erase(mQueue.begin());
+			}
+
+			sWriteChromeTrace(*recording);
+			delete recording;
+		}
+	}
+
+	/// Write a recording in the Chrome Trace Event format
+	static void					sWriteChromeTrace(const FlightRecording &inRecording);
+
+	std::mutex					mQueueLock;															///< Protects mQueue and mQuit
+	std::condition_variable		mQueueChanged;
+	Array<FlightRecording *>	mQueue;																///< Recordings that still need to be written
+	bool						mQuit = false;
+	std::thread					mThread;															///< Writer thread, last member so it starts after the others are constructed
+};
+
+static String sJSONEncode(const char *inString)
+{
+	String str(inString);
+	StringReplace(str, "\\", "\\\\");
+	StringReplace(str, "\"", "\\\"");
+	return str;
+}
+
+void Profiler::FlightRecorder::sWriteChromeTrace(const FlightRecording &inRecording)
+{
+	std::ofstream f;
+	f.open(inRecording.mPath.c_str(), std::ofstream::out | std::ofstream::trunc);
+	if (!f.is_open())
+	{
+		Trace("Profiler: Failed to write %s", inRecording.mPath.c_str());
+		return;
+	}
+
+	// Timestamps are in microseconds
+	double us_per_tick = 1.0e6 / double(inRecording.mTicksPerSecond);
+	auto to_us = [&inRecording, us_per_tick](uint64 inTick) { return double(inTick - inRecording.mStartTick) * us_per_tick; };
+	f.setf(std::ios::fixed);
+	f.precision(3);
+
+	f << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	f << R"({"ph":"M","pid":1,"tid":0,"name":"process_name","args":{"name":"Jolt"}})";
+
+	// Mark the start of every frame
+	for (size_t i = 0; i < inRecording.mFrameTicks.size(); ++i)
+		f << ",\n" << R"({"ph":"i","s":"g","pid":1,"tid":0,"name":"Frame )" << inRecording.mFirstFrame + i << R"(","ts":)" << to_us(inRecording.mFrameTicks[i]) << "}";
+	f << ",\n" << R"({"ph":"i","s":"g","pid":1,"tid":0,"name":"End","ts":)" << to_us(inRecording.mEndTick) << "}";
+
+	// One complete event per sample
+	for (size_t t = 0; t < inRecording.mThreads.size(); ++t)
+	{
+		const FlightRecording::Thread &thread = inRecording.mThreads[t];
+		f << ",\n" << R"({"ph":"M","pid":1,"tid":)" << t << R"(,"name":"thread_name","args":{"name":")" << sJSONEncode(thread.mThreadName.c_str()) << "\"}}";
+		for (const FlightRecording::Sample &s : thread.mSamples)
+			f << ",\n" << R"({"ph":"X","pid":1,"tid":)" << t << R"(,"name":")" << sJSONEncode(s.mName) << R"(","ts":)" << to_us(s.mStartCycle) << R"(,"dur":)" << double(s.mEndCycle - s.mStartCycle) * us_per_tick << "}";
+	}
+
+	f << "\n]}\n";
+
+	Trace("Profiler: Wrote %s", inRecording.mPath.c_str());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Profiler
+//////////////////////////////////////////////////////////////////////////////////////////
+
+Profiler::~Profiler()
+{
+	delete mFlightRecorder;
+}
+
+void Profiler::SetFlightRecorder(const FlightRecorderSettings &inSettings)
+{
+	std::lock_guard lock(mLock);
+
+	delete mFlightRecorder;
+	mFlightRecorder = inSettings.mNumFrames > 0? new FlightRecorder(inSettings) : nullptr;
+
+	// Start with empty buffers
+	for (ProfileThread *t : mThreads)
+	{
+		t->mCurrentSample = 0;
+		t->mFrameStartSample = 0;
+	}
+	UpdateReferenceTime();
+}
+
+void Profiler::FlightRecorderNextFrame(uint64 inEndTick)
+{
+	FlightRecorder &recorder = *mFlightRecorder;
+	const FlightRecorderSettings &settings = recorder.mSettings;
+	uint num_ticks = uint(recorder.mFrameTicks.size());
+	uint64 frame_start_tick = recorder.mFrameTicks[recorder.mFrame % num_ticks];
+
+	// Check if this frame went over budget: from the first sample any thread took this frame until now. The first slot of a thread
+	// can still hold an older sample if the scope that claimed it hasn't finished yet, those are skipped.
+	String tag;
+	if (settings.mFrameBudget > 0.0f
+		&& recorder.mNumDumps < settings.mMaxDumps
+		&& (recorder.mNumDumps == 0 || recorder.mFrame - recorder.mLastDumpFrame >= settings.mNumFrames))
+	{
+		uint64 first_tick = inEndTick;
+		for (const ProfileThread *t : mThreads)
+			if (t->mCurrentSample != t->mFrameStartSample)
+			{
+				const ProfileSample &s = t->mSamples[t->mFrameStartSample & (ProfileThread::cMaxSamples - 1)];
+				if (s.mStartCycle >= frame_start_tick)
+					first_tick = min(first_tick, s.mStartCycle);
+			}
+		uint64 budget_ticks = uint64(double(settings.mFrameBudget) * double(GetProcessorTicksPerSecond()));
+		if (inEndTick - first_tick > budget_ticks)
+		{
+			tag = StringFormat("hitch_%llu", (unsigned long long)recorder.mFrame);
+			Trace("Profiler: Frame %llu took %.2f ms, dumping the last %u frames", (unsigned long long)recorder.mFrame, 1000.0 * double(inEndTick - first_tick) / double(GetProcessorTicksPerSecond()), settings.mNumFrames);
+			recorder.mLastDumpFrame = recorder.mFrame;
+			++recorder.mNumDumps;
+		}
+	}
+
+	// A requested dump also goes through the flight recorder
+	if (mDump)
+	{
+		if (mDumpTag.empty())
+		{
+			static int number = 0;
+			++number;
+			tag = ConvertToString(number);
+		}
+		else
+		{
+			tag = mDumpTag;
+			mDumpTag.clear();
+		}
+		mDump = false;
+	}
+
+	if (!tag.empty())
+	{
+		// Oldest frame that's still in the ring buffer
+		uint num_frames = uint(min<uint64>(recorder.mFrame + 1, num_ticks - 1));
+		uint64 first_frame = recorder.mFrame + 1 - num_frames;
+
+		FlightRecording *recording = new FlightRecording;
+		recording->mPath = settings.mPathPrefix + tag + ".json";
+		recording->mStartTick = recorder.mFrameTicks[first_frame % num_ticks];
+		recording->mEndTick = inEndTick;
+		recording->mTicksPerSecond = GetProcessorTicksPerSecond();
+		recording->mFirstFrame = first_frame;
+		for (uint64 frame = first_frame; frame <= recorder.mFrame; ++frame)
+			recording->mFrameTicks.push_back(recorder.mFrameTicks[frame % num_ticks]);
+
+		// Copy the samples that finished within the recorded frames, they're in the order in which they started.
+		// Like DumpInternal this is not completely thread safe, a thread that is still running may overwrite a sample while we copy it.
+		recording->mThreads.reserve(mThreads.size());
+		for (const ProfileThread *t : mThreads)
+		{
+			FlightRecording::Thread &thread = recording->mThreads.emplace_back();
+			thread.mThreadName = t->mThreadName;
+			for (uint64 i = t->mCurrentSample > ProfileThread::cMaxSamples? t->mCurrentSample - ProfileThread::cMaxSamples : 0; i < t->mCurrentSample; ++i)
+			{
+				const ProfileSample &s = t->mSamples[i & (ProfileThread::cMaxSamples - 1)];
+				if (s.mStartCycle >= recording->mStartTick && s.mStartCycle <= s.mEndCycle && s.mEndCycle <= inEndTick)
+					thread.mSamples.push_back({ s.mName, s.mStartCycle, s.mEndCycle });
+			}
+		}
+
+		recorder.Write(recording);
+	}
+
+	// Start the next frame
+	++recorder.mFrame;
+	recorder.mFrameTicks[recorder.mFrame % num_ticks] = inEndTick;
+	for (ProfileThread *t : mThreads)
+		t->mFrameStartSample = t->mCurrentSample;
+}
+
 void Profiler::UpdateReferenceTime()
 {
 	mReferenceTick = GetProcessorTickCount();
@@ -59,6 +321,13 @@ void Profiler::NextFrame()
 {
 	std::lock_guard lock(mLock);
 
+	if (mFlightRecorder != nullptr)
+	{
+		// Samples are kept in the ring buffers and the reference time keeps running so the tick rate gets more accurate
+		FlightRecorderNextFrame(GetProcessorTickCount());
+		return;
+	}
+
 	if (mDump)
 	{
 		DumpInternal();
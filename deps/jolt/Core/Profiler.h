@@ -17,21 +17,35 @@ JPH_SUPPRESS_WARNINGS_STD_END
 
 JPH_NAMESPACE_BEGIN
 
+/// Static information about the place in the code where a JPH_PROFILE scope starts, one instance per JPH_PROFILE.
+/// The name and color are passed separately because they're not always constant (e.g. the name of a job).
+struct ExternalProfileSite
+{
+	const char *					mFunction;
+	const char *					mFile;
+	uint32							mLine;
+};
+
 /// Create this class on the stack to start sampling timing information of a particular scope.
 ///
 /// Left unimplemented intentionally. Needs to be implemented by the user of the library.
 /// On construction a measurement should start, on destruction it should be stopped.
+/// inColor is a Color::GetUInt32() value or 0 if the scope didn't specify one.
 class alignas(16) ExternalProfileMeasurement : public NonCopyable
 {
 public:
 	/// Constructor
-									ExternalProfileMeasurement(const char *inName, uint32 inColor = 0);
+									ExternalProfileMeasurement(const ExternalProfileSite &inSite, const char *inName, uint32 inColor = 0);
 									~ExternalProfileMeasurement();
 
 private:
 	uint8							mUserData[64];
 };
 
+/// Called by JPH_PROFILE_THREAD_START when a thread that runs Jolt jobs starts, e.g. to name the thread in the profiler.
+/// Left unimplemented intentionally, like ExternalProfileMeasurement.
+void								ExternalProfileThreadStart(const char *inName);
+
 JPH_NAMESPACE_END
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -41,8 +55,8 @@ JPH_NAMESPACE_END
 JPH_SUPPRESS_WARNING_PUSH
 JPH_CLANG_SUPPRESS_WARNING("-Wc++98-compat-pedantic")
 
-// Dummy implementations
-#define JPH_PROFILE_THREAD_START(name)
+// Thread naming, the other functions are dummy implementations
+#define JPH_PROFILE_THREAD_START(name)	ExternalProfileThreadStart(name)
 #define JPH_PROFILE_THREAD_END()
 #define JPH_PROFILE_NEXTFRAME()
 #define JPH_PROFILE_DUMP(...)
@@ -60,7 +74,9 @@ JPH_CLANG_SUPPRESS_WARNING("-Wc++98-compat-pedantic")
 ///			do operation;
 ///		}
 ///
-#define JPH_PROFILE(...)			ExternalProfileMeasurement JPH_PROFILE_TAG(__LINE__)(__VA_ARGS__)
+/// Expands to a single declaration like the other profilers, the ExternalProfileSite is a static local of a lambda that is called in the constructor argument.
+/// The function name is passed into the lambda because inside it JPH_FUNCTION_NAME would name the lambda.
+#define JPH_PROFILE(...)			ExternalProfileMeasurement JPH_PROFILE_TAG(__LINE__)([](const char *inFunction) -> const ExternalProfileSite & { static const ExternalProfileSite sSite { inFunction, __FILE__, __LINE__ }; return sSite; }(JPH_FUNCTION_NAME), __VA_ARGS__)
 
 // Scope profiling for function
 #define JPH_PROFILE_FUNCTION()		JPH_PROFILE(JPH_FUNCTION_NAME)
@@ -83,13 +99,34 @@ public:
 	/// Constructor
 								Profiler()															{ UpdateReferenceTime(); }
 
+	/// Destructor, waits until the flight recorder has written its dumps
+								~Profiler();
+
 	/// Increments the frame counter to provide statistics per frame
 	void						NextFrame();
 
-	/// Dump profiling statistics at the start of the next frame
+	/// Dump profiling statistics at the start of the next frame (with the flight recorder enabled the recorded frames are written as a trace instead)
 	/// @param inTag If not empty, this overrides the auto incrementing number in the filename of the dump file
 	void						Dump(const string_view &inTag = string_view());
 
+	/// Settings for the flight recorder
+	struct FlightRecorderSettings
+	{
+		uint					mNumFrames = 0;														///< Number of frames to keep, 0 disables the flight recorder
+		float					mFrameBudget = 0.0f;												///< Seconds, when a frame takes longer (from its first sample to NextFrame) the last mNumFrames frames are dumped. 0 to only dump on Dump().
+		uint					mMaxDumps = 16;														///< Stop dumping hitches after this many, so that a machine that is simply too slow doesn't fill up the disk
+		String					mPathPrefix = "profile_trace_";										///< Dumps are written to mPathPrefix + tag + ".json"
+	};
+
+	/// Flight recorder mode: instead of clearing the samples every frame, every thread keeps its last cMaxSamples samples in a ring buffer.
+	/// When a frame goes over budget or when Dump() is called, the samples of the last frames are copied and written as a Chrome Trace Event
+	/// file (open it in chrome://tracing or Perfetto) by a background thread, so the frame that does the copy doesn't also pay for the file.
+	/// Should be called while no other thread is collecting samples.
+	void						SetFlightRecorder(const FlightRecorderSettings &inSettings);
+
+	/// Check if the flight recorder is enabled
+	inline bool					IsFlightRecorderEnabled() const										{ return mFlightRecorder != nullptr; }
+
 	/// Add a thread to be instrumented
 	void						AddThread(ProfileThread *inThread);
 
@@ -157,12 +194,19 @@ private:
 	void						DumpInternal();
 	void						DumpChart(const char *inTag, const Threads &inThreads, const KeyToAggregator &inKeyToAggregators, const Aggregators &inAggregators);
 
+	/// Flight recorder, defined in Profiler.cpp
+	class FlightRecorder;
+
+	/// Called by NextFrame when the flight recorder is enabled, inEndTick is the end of the frame
+	void						FlightRecorderNextFrame(uint64 inEndTick);
+
 	std::mutex					mLock;																///< Lock that protects mThreads
 	uint64						mReferenceTick;														///< Tick count at the start of the frame
 	std::chrono::high_resolution_clock::time_point mReferenceTime;									///< Time at the start of the frame
 	Array<ProfileThread *>		mThreads;															///< List of all active threads
 	bool						mDump = false;														///< When true, the samples are dumped next frame
 	String						mDumpTag;															///< When not empty, this overrides the auto incrementing number of the dump filename
+	FlightRecorder *			mFlightRecorder = nullptr;											///< Flight recorder state, nullptr when it's disabled
 };
 
 // Class that contains the information of a single scoped measurement
@@ -190,10 +234,12 @@ public:
 	inline						~ProfileThread();
 
 	static const uint cMaxSamples = 65536;
+	static_assert(IsPowerOf2(cMaxSamples));															// The flight recorder wraps around with a mask
 
 	String						mThreadName;														///< Name of the thread that we're collecting information for
 	ProfileSample				mSamples[cMaxSamples];												///< Buffer of samples
-	uint						mCurrentSample = 0;													///< Next position to write a sample to
+	uint64						mCurrentSample = 0;													///< Next position to write a sample to, the flight recorder keeps counting and writes to mCurrentSample % cMaxSamples
+	uint64						mFrameStartSample = 0;												///< Value of mCurrentSample at the start of the frame (flight recorder only)
 
 #ifdef JPH_SHARED_LIBRARY
 	JPH_EXPORT static void		sSetInstance(ProfileThread *inInstance);
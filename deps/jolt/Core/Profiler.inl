@@ -31,10 +31,10 @@ ProfileMeasurement::ProfileMeasurement(const char *inName, uint32 inColor)
 		// Thread not instrumented
 		mSample = nullptr;
 	}
-	else if (current_thread->mCurrentSample < ProfileThread::cMaxSamples)
+	else if (current_thread->mCurrentSample < ProfileThread::cMaxSamples || Profiler::sInstance->IsFlightRecorderEnabled())
 	{
-		// Get pointer to write data to
-		mSample = &current_thread->mSamples[current_thread->mCurrentSample++];
+		// Get pointer to write data to, the flight recorder wraps around and overwrites the oldest sample
+		mSample = &current_thread->mSamples[current_thread->mCurrentSample++ & (ProfileThread::cMaxSamples - 1)];
 
 		// Start constructing sample (will end up on stack)
 		mTemp.mName = inName;
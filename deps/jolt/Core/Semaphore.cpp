@@ -5,6 +5,7 @@
 #include <Jolt/Jolt.h>
 
 #include <Jolt/Core/Semaphore.h>
+#include <Jolt/Core/Atomics.h>
 
 #ifdef JPH_PLATFORM_WINDOWS
 	JPH_SUPPRESS_WARNING_PUSH
@@ -17,10 +18,86 @@
 #endif
 
 	JPH_SUPPRESS_WARNING_POP
+#elif defined(JPH_SEMAPHORE_USE_FUTEX)
+	#include <linux/futex.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+
+	JPH_SUPPRESS_WARNINGS_STD_BEGIN
+	#include <thread>
+	JPH_SUPPRESS_WARNINGS_STD_END
 #endif
 
 JPH_NAMESPACE_BEGIN
 
+#ifdef JPH_SEMAPHORE_USE_FUTEX
+
+static constexpr int cMinSpinCount = 16;								///< Spin budget never drops below this so that it can grow again
+static constexpr int cMaxSpinCount = 4096;								///< Upper bound, roughly a few microseconds
+
+static_assert(sizeof(atomic<uint32>) == sizeof(uint32), "Futex word needs to be a plain 32 bit integer");
+
+static inline void sFutexWait(atomic<uint32> &inWord, uint32 inExpected)
+{
+	syscall(SYS_futex, reinterpret_cast<uint32 *>(&inWord), FUTEX_WAIT_PRIVATE, inExpected, nullptr, nullptr, 0);
+}
+
+static inline void sFutexWake(atomic<uint32> &inWord, int inNumThreads)
+{
+	syscall(SYS_futex, reinterpret_cast<uint32 *>(&inWord), FUTEX_WAKE_PRIVATE, inNumThreads, nullptr, nullptr, 0);
+}
+
+static inline void sCpuPause()
+{
+#if defined(JPH_CPU_X86)
+	__builtin_ia32_pause();
+#elif defined(JPH_CPU_ARM)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+static inline bool sTryTakeWakeup(atomic<uint32> &ioWakeups)
+{
+	uint32 value = ioWakeups.load(memory_order_relaxed);
+	while (value > 0)
+		if (ioWakeups.compare_exchange_weak(value, value - 1, memory_order_acquire, memory_order_relaxed))
+			return true;
+	return false;
+}
+
+void Semaphore::WaitForWakeup()
+{
+	// Spinning only helps when the releasing thread can run at the same time
+	static const bool sCanSpin = std::thread::hardware_concurrency() > 1;
+
+	if (sCanSpin)
+	{
+		int spin_count = max(mSpinCount.load(memory_order_relaxed), cMinSpinCount);
+		int max_spins = min(2 * spin_count, cMaxSpinCount);
+		for (int spin = 0; spin < max_spins; ++spin)
+		{
+			if (sTryTakeWakeup(mWakeups))
+			{
+				// Move the budget towards what was needed (with some slack)
+				mSpinCount.store(spin_count + (min(2 * spin + cMinSpinCount, cMaxSpinCount) - spin_count) / 8, memory_order_relaxed);
+				return;
+			}
+			sCpuPause();
+		}
+
+		// Spinning was wasted, spin less next time
+		mSpinCount.store(max(spin_count - spin_count / 4, cMinSpinCount), memory_order_relaxed);
+	}
+
+	// Park. Release reads mNumParked after adding to mWakeups, we read mWakeups (in the kernel) after incrementing mNumParked, so one of us sees the other.
+	mNumParked.fetch_add(1, memory_order_seq_cst);
+	while (!sTryTakeWakeup(mWakeups))
+		sFutexWait(mWakeups, 0);
+	mNumParked.fetch_sub(1, memory_order_relaxed);
+}
+
+#endif // JPH_SEMAPHORE_USE_FUTEX
+
 Semaphore::Semaphore()
 {
 #ifdef JPH_PLATFORM_WINDOWS
@@ -47,6 +124,16 @@ void Semaphore::Release(uint inNumber)
 		int num_to_release = min(new_value, 0) - old_value;
 		::ReleaseSemaphore(mSemaphore, num_to_release, nullptr);
 	}
+#elif defined(JPH_SEMAPHORE_USE_FUTEX)
+	int old_value = mCount.fetch_add(inNumber, memory_order_release);
+	if (old_value < 0)
+	{
+		int new_value = old_value + (int)inNumber;
+		int num_to_release = min(new_value, 0) - old_value;
+		mWakeups.fetch_add(uint32(num_to_release), memory_order_seq_cst);
+		if (mNumParked.load(memory_order_seq_cst) > 0)
+			sFutexWake(mWakeups, num_to_release);
+	}
 #else
 	std::lock_guard lock(mLock);
 	mCount += (int)inNumber;
@@ -70,6 +157,15 @@ void Semaphore::Acquire(uint inNumber)
 		for (int i = 0; i < num_to_acquire; ++i)
 			WaitForSingleObject(mSemaphore, INFINITE);
 	}
+#elif defined(JPH_SEMAPHORE_USE_FUTEX)
+	int old_value = mCount.fetch_sub(inNumber, memory_order_acquire);
+	int new_value = old_value - (int)inNumber;
+	if (new_value < 0)
+	{
+		int num_to_acquire = min(old_value, 0) - new_value;
+		for (int i = 0; i < num_to_acquire; ++i)
+			WaitForWakeup();
+	}
 #else
 	std::unique_lock lock(mLock);
 	mCount -= (int)inNumber;
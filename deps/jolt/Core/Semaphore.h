@@ -10,6 +10,11 @@ JPH_SUPPRESS_WARNINGS_STD_BEGIN
 #include <condition_variable>
 JPH_SUPPRESS_WARNINGS_STD_END
 
+// On Linux waiting threads sleep on a futex, define JPH_SEMAPHORE_NO_FUTEX to use the mutex and condition variable emulation instead (e.g. to measure the difference)
+#if defined(JPH_PLATFORM_LINUX) && !defined(JPH_SEMAPHORE_NO_FUTEX)
+	#define JPH_SEMAPHORE_USE_FUTEX
+#endif
+
 JPH_NAMESPACE_BEGIN
 
 // Things we're using from STL
@@ -40,6 +45,15 @@ private:
 	// On windows we use a semaphore object since it is more efficient than a lock and a condition variable
 	alignas(JPH_CACHE_LINE_SIZE) atomic<int> mCount { 0 };				///< We increment mCount for every release, to acquire we decrement the count. If the count is negative we know that we are waiting on the actual semaphore.
 	void *				mSemaphore;										///< The semaphore is an expensive construct so we only acquire/release it if we know that we need to wait/have waiting threads
+#elif defined(JPH_SEMAPHORE_USE_FUTEX)
+	/// Take one wake up from mWakeups, spinning for a while before sleeping in the kernel
+	void				WaitForWakeup();
+
+	/// Same scheme as on windows, but waiting threads sleep on a futex (mWakeups) instead of a semaphore object
+	alignas(JPH_CACHE_LINE_SIZE) atomic<int> mCount { 0 };				///< We increment mCount for every release, to acquire we decrement the count. If the count is negative we know that threads need to wait for a wake up.
+	alignas(JPH_CACHE_LINE_SIZE) atomic<uint32> mWakeups { 0 };			///< Futex word: wake ups released to waiting threads that have not been taken yet
+	atomic<uint32>		mNumParked { 0 };								///< Number of threads sleeping on the futex, Release only does a system call when this is non-zero
+	atomic<int>			mSpinCount { 0 };								///< Adaptive number of spins before sleeping, grows when spinning finds a wake up and shrinks when it doesn't
 #else
 	// Other platforms: Emulate a semaphore using a mutex, condition variable and count
 	mutex				mLock;
@@ -0,0 +1,128 @@
+// Jolt Physics Library (https://github.com/jrouwe/JoltPhysics)
+// SPDX-License-Identifier: MIT
+
+#include <Jolt/Jolt.h>
+
+#include <Jolt/Core/TempAllocatorGrowing.h>
+
+JPH_NAMESPACE_BEGIN
+
+TempAllocatorGrowing::TempAllocatorGrowing(uint inInitialSize)
+{
+	AddBlock(inInitialSize);
+}
+
+TempAllocatorGrowing::~TempAllocatorGrowing()
+{
+	JPH_ASSERT(IsEmpty());
+
+	for (Block &block : mBlocks)
+		AlignedFree(block.mBase);
+}
+
+void TempAllocatorGrowing::AddBlock(uint inMinSize)
+{
+	// Grow geometrically so that a scene that is much bigger than the initial size only needs a few blocks
+	uint size = AlignUp(max(inMinSize, mStats.mCapacity), cBlockAlignment);
+
+	Block block;
+	block.mBase = static_cast<uint8 *>(AlignedAllocate(size, JPH_RVECTOR_ALIGNMENT));
+	block.mSize = size;
+	block.mTop = 0;
+	mBlocks.push_back(block);
+
+	mStats.mCapacity += size;
+	mStats.mNumBlocks = uint(mBlocks.size());
+	mStats.mPeakCapacity = max(mStats.mPeakCapacity, mStats.mCapacity);
+	mStats.mPeakNumBlocks = max(mStats.mPeakNumBlocks, mStats.mNumBlocks);
+	mStats.mMaxNumBlocks = max(mStats.mMaxNumBlocks, mStats.mNumBlocks);
+}
+
+void TempAllocatorGrowing::ReplaceBlocks(uint inSize)
+{
+	JPH_ASSERT(IsEmpty());
+
+	for (Block &block : mBlocks)
+		AlignedFree(block.mBase);
+	mBlocks.clear();
+	mCurrentBlock = 0;
+	mStats.mCapacity = 0;
+
+	AddBlock(inSize);
+}
+
+void *TempAllocatorGrowing::Allocate(uint inSize)
+{
+	if (inSize == 0)
+		return nullptr;
+
+	uint size = AlignUp(inSize, JPH_RVECTOR_ALIGNMENT);
+
+	Block *block = &mBlocks[mCurrentBlock];
+	if (size > block->mSize - block->mTop)
+	{
+		// Move to the next block, the blocks after the current one are empty so drop the ones that are too small
+		uint next = mCurrentBlock + 1;
+		while (next < mBlocks.size() && mBlocks[next].mSize < size)
+		{
+			mStats.mCapacity -= mBlocks[next].mSize;
+			AlignedFree(mBlocks[next].mBase);
+			mBlocks.erase(mBlocks.begin() + next);
+		}
+		if (next == mBlocks.size())
+		{
+			AddBlock(size);
+			++mStats.mNumOverflows;
+			++mStats.mTotalNumOverflows;
+		}
+		mStats.mNumBlocks = uint(mBlocks.size());
+		mCurrentBlock = next;
+		block = &mBlocks[next];
+	}
+
+	void *address = block->mBase + block->mTop;
+	block->mTop += size;
+
+	mStats.mUsage += size;
+	mStats.mPeakUsage = max(mStats.mPeakUsage, mStats.mUsage);
+	mStats.mMaxPeakUsage = max(mStats.mMaxPeakUsage, mStats.mUsage);
+	return address;
+}
+
+void TempAllocatorGrowing::Free(void *inAddress, uint inSize)
+{
+	if (inAddress == nullptr)
+	{
+		JPH_ASSERT(inSize == 0);
+		return;
+	}
+
+	uint size = AlignUp(inSize, JPH_RVECTOR_ALIGNMENT);
+
+	Block &block = mBlocks[mCurrentBlock];
+	block.mTop -= size;
+	if (block.mBase + block.mTop != inAddress)
+		JPH_CRASH; // Freeing in the wrong order
+	mStats.mUsage -= size;
+
+	// Go back to the previous block when this one becomes empty, it still holds the allocations made before we moved on
+	if (block.mTop == 0 && mCurrentBlock > 0)
+		--mCurrentBlock;
+
+	// When everything has been freed, merge the blocks into one that fits the highest usage so far
+	if (mStats.mUsage == 0 && mBlocks.size() > 1)
+		ReplaceBlocks(mStats.mMaxPeakUsage);
+}
+
+void TempAllocatorGrowing::Reset()
+{
+	for (Block &block : mBlocks)
+		block.mTop = 0;
+	mCurrentBlock = 0;
+	mStats.mUsage = 0;
+
+	if (mBlocks.size() > 1)
+		ReplaceBlocks(mStats.mMaxPeakUsage);
+}
+
+JPH_NAMESPACE_END
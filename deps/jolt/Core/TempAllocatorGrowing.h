@@ -0,0 +1,81 @@
+// Jolt Physics Library (https://github.com/jrouwe/JoltPhysics)
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Jolt/Core/TempAllocator.h>
+
+JPH_NAMESPACE_BEGIN
+
+/// Temp allocator that starts with a single block like TempAllocatorImpl, but instead of crashing when the block is full it
+/// chains extra blocks. Allocations still work as a stack. When the allocator becomes empty after it had to grow, the blocks
+/// are replaced by a single block that fits the highest usage seen so far, so that the next step doesn't need to grow again.
+///
+/// Usage is tracked in Stats, call ResetPeakUsage at the start of every measurement interval (e.g. every physics step).
+/// Like TempAllocatorImpl there's no locking, the order of allocations is guaranteed through job dependencies.
+class JPH_EXPORT TempAllocatorGrowing final : public TempAllocator
+{
+public:
+	JPH_OVERRIDE_NEW_DELETE
+
+	/// Usage statistics in bytes
+	struct Stats
+	{
+		uint				mUsage = 0;										///< Bytes currently allocated (including alignment)
+		uint				mPeakUsage = 0;									///< Highest usage since the last ResetPeakUsage
+		uint				mMaxPeakUsage = 0;								///< Highest usage since construction
+		uint				mCapacity = 0;									///< Total size of all blocks
+		uint				mNumBlocks = 0;									///< Number of blocks
+		uint				mPeakCapacity = 0;								///< Highest capacity since the last ResetPeakUsage, the blocks may have been merged since
+		uint				mPeakNumBlocks = 0;								///< Highest number of blocks since the last ResetPeakUsage
+		uint				mMaxNumBlocks = 0;								///< Highest number of blocks since construction
+		uint				mNumOverflows = 0;								///< Number of times a new block was needed since the last ResetPeakUsage
+		uint				mTotalNumOverflows = 0;							///< Number of times a new block was needed since construction
+	};
+
+	/// Constructs the allocator with an initial block of inInitialSize bytes
+	explicit				TempAllocatorGrowing(uint inInitialSize);
+
+	/// Destructor, frees all blocks
+	virtual					~TempAllocatorGrowing() override;
+
+	// See: TempAllocator
+	virtual void *			Allocate(uint inSize) override;
+	virtual void			Free(void *inAddress, uint inSize) override;
+
+	/// Free all allocations at once
+	void					Reset();
+
+	/// Check if no allocations have been made
+	bool					IsEmpty() const									{ return mStats.mUsage == 0; }
+
+	/// Get usage statistics
+	const Stats &			GetStats() const								{ return mStats; }
+
+	/// Start a new measurement interval for mPeakUsage, mPeakCapacity, mPeakNumBlocks and mNumOverflows
+	void					ResetPeakUsage()								{ mStats.mPeakUsage = mStats.mUsage; mStats.mPeakCapacity = mStats.mCapacity; mStats.mPeakNumBlocks = mStats.mNumBlocks; mStats.mNumOverflows = 0; }
+
+private:
+	/// A chunk of memory that is used as a stack
+	struct Block
+	{
+		uint8 *				mBase;											///< Base address of the block
+		uint				mSize;											///< Size of the block
+		uint				mTop;											///< Current top of the stack
+	};
+
+	/// Append a block that can hold at least inMinSize bytes
+	void					AddBlock(uint inMinSize);
+
+	/// Free all blocks and allocate a single block of inSize bytes, can only be called when empty
+	void					ReplaceBlocks(uint inSize);
+
+	/// Granularity of the size of blocks
+	static constexpr uint	cBlockAlignment = 64 * 1024;
+
+	Array<Block>			mBlocks;										///< Blocks, the ones after mCurrentBlock are empty
+	uint					mCurrentBlock = 0;								///< Block that holds the top of the stack
+	Stats					mStats;
+};
+
+JPH_NAMESPACE_END
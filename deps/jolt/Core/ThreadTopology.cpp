@@ -0,0 +1,302 @@
+// Jolt Physics Library (https://github.com/jrouwe/JoltPhysics)
+// SPDX-License-Identifier: MIT
+
+#include <Jolt/Jolt.h>
+
+#include <Jolt/Core/ThreadTopology.h>
+#include <Jolt/Core/QuickSort.h>
+
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+JPH_SUPPRESS_WARNINGS_STD_END
+
+#ifdef JPH_PLATFORM_LINUX
+	#include <sched.h>
+#endif
+
+JPH_NAMESPACE_BEGIN
+
+#ifdef JPH_PLATFORM_LINUX
+
+/// Read a small text file from /sys, returns false if it doesn't exist or is empty
+static bool sReadSysFile(const char *inPath, char *outBuffer, size_t inBufferSize)
+{
+	FILE *f = fopen(inPath, "r");
+	if (f == nullptr)
+		return false;
+	size_t len = fread(outBuffer, 1, inBufferSize - 1, f);
+	fclose(f);
+	outBuffer[len] = 0;
+	return len > 0;
+}
+
+/// Read a file from /sys that contains a single integer
+static bool sReadSysInt(const char *inPath, int64_t &outValue)
+{
+	char buffer[64];
+	if (!sReadSysFile(inPath, buffer, sizeof(buffer)))
+		return false;
+	char *end;
+	long long value = strtoll(buffer, &end, 10);
+	if (end == buffer)
+		return false;
+	outValue = int64_t(value);
+	return true;
+}
+
+/// Parse a list like "0-3,8,10-11" as used by /sys for CPU's and nodes
+static void sParseList(const char *inList, Array<int> &outValues)
+{
+	const char *p = inList;
+	for (;;)
+	{
+		char *end;
+		long first = strtol(p, &end, 10);
+		if (end == p)
+			break;
+		long last = first;
+		p = end;
+		if (*p == '-')
+		{
+			last = strtol(p + 1, &end, 10);
+			p = end;
+		}
+		for (long i = first; i <= last; ++i)
+			outValues.push_back(int(i));
+		if (*p != ',')
+			break;
+		++p;
+	}
+}
+
+#endif // JPH_PLATFORM_LINUX
+
+void ThreadTopology::Detect()
+{
+	mCpus.clear();
+	mNumCores = 0;
+	mNumNodes = 0;
+	mIsHybrid = false;
+	mCanPinThreads = false;
+
+#ifdef JPH_PLATFORM_LINUX
+	char path[128];
+	char buffer[4096];
+
+	// Only consider CPU's that are online and that we're allowed to run on (the process may be limited by taskset or a container)
+	Array<int> online;
+	if (sReadSysFile("/sys/devices/system/cpu/online", buffer, sizeof(buffer)))
+		sParseList(buffer, online);
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	bool has_allowed = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+	for (int cpu : online)
+		if (cpu < CPU_SETSIZE && (!has_allowed || CPU_ISSET(cpu, &allowed)))
+		{
+			LogicalCpu c;
+			c.mCpu = cpu;
+			mCpus.push_back(c);
+		}
+
+	if (!mCpus.empty())
+	{
+		mCanPinThreads = has_allowed;
+
+		// Physical cores, SMT siblings have the same package and core id. CPU's are visited in order so the lowest numbered sibling gets SMT index 0.
+		struct Core
+		{
+			int64_t			mPackage;
+			int64_t			mCoreId;
+			int				mNumThreads;
+		};
+		Array<Core> cores;
+		for (LogicalCpu &c : mCpus)
+		{
+			int64_t package = 0, core_id = c.mCpu;
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", c.mCpu);
+			sReadSysInt(path, package);
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", c.mCpu);
+			sReadSysInt(path, core_id);
+
+			size_t core = 0;
+			while (core < cores.size() && (cores[core].mPackage != package || cores[core].mCoreId != core_id))
+				++core;
+			if (core == cores.size())
+				cores.push_back({ package, core_id, 0 });
+			c.mCore = int(core);
+			c.mSMTIndex = cores[core].mNumThreads++;
+		}
+		mNumCores = int(cores.size());
+
+		// NUMA nodes, CPU's that are not listed in any node stay on node 0
+		Array<int> nodes;
+		if (sReadSysFile("/sys/devices/system/node/online", buffer, sizeof(buffer)))
+			sParseList(buffer, nodes);
+		for (int node : nodes)
+		{
+			Array<int> node_cpus;
+			snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+			if (sReadSysFile(path, buffer, sizeof(buffer)))
+				sParseList(buffer, node_cpus);
+			for (LogicalCpu &c : mCpus)
+				for (int cpu : node_cpus)
+					if (c.mCpu == cpu)
+						c.mNode = node;
+		}
+
+		// Relative performance: ARM reports a capacity per CPU, otherwise use the max frequency
+		uint32 max_capacity = 0;
+		for (LogicalCpu &c : mCpus)
+		{
+			int64_t capacity = 0;
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpu_capacity", c.mCpu);
+			if (!sReadSysInt(path, capacity))
+			{
+				snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", c.mCpu);
+				sReadSysInt(path, capacity);
+			}
+			c.mCapacity = uint32(Clamp<int64_t>(capacity, 0, 0xffffffff));
+			max_capacity = max(max_capacity, c.mCapacity);
+		}
+
+		// Efficiency cores: Intel hybrid CPU's list them explicitly, otherwise anything below 80% of the fastest core counts.
+		// The margin keeps 'favored' cores with a slightly higher turbo frequency from splitting a homogeneous CPU.
+		Array<int> atom_cpus;
+		bool has_atom = sReadSysFile("/sys/devices/cpu_atom/cpus", buffer, sizeof(buffer));
+		if (has_atom)
+			sParseList(buffer, atom_cpus);
+		for (LogicalCpu &c : mCpus)
+		{
+			if (has_atom)
+				c.mIsEfficiencyCore = std::find(atom_cpus.begin(), atom_cpus.end(), c.mCpu) != atom_cpus.end();
+			else
+				c.mIsEfficiencyCore = c.mCapacity > 0 && uint64(c.mCapacity) * 5 < uint64(max_capacity) * 4;
+			mIsHybrid |= c.mIsEfficiencyCore;
+		}
+	}
+#endif // JPH_PLATFORM_LINUX
+
+	if (mCpus.empty())
+	{
+		// Unknown topology: every logical CPU is a core of its own
+		uint num_cpus = max(std::thread::hardware_concurrency(), 1u);
+		mCpus.resize(num_cpus);
+		for (uint i = 0; i < num_cpus; ++i)
+		{
+			mCpus[i].mCpu = int(i);
+			mCpus[i].mCore = int(i);
+		}
+		mNumCores = int(num_cpus);
+		mCanPinThreads = false;
+	}
+
+	// Count distinct nodes
+	for (const LogicalCpu &c : mCpus)
+	{
+		bool seen = false;
+		for (const LogicalCpu &other : mCpus)
+			if (&other == &c)
+				break;
+			else if (other.mNode == c.mNode)
+			{
+				seen = true;
+				break;
+			}
+		if (!seen)
+			++mNumNodes;
+	}
+}
+
+void ThreadTopology::GetOrderedCpus(const Settings &inSettings, Array<const LogicalCpu *> &outCpus, int &outNumPreferred) const
+{
+	outCpus.clear();
+
+	// Restrict to the requested node, ignore the request if that node has no CPU's we can use
+	bool use_node = false;
+	if (inSettings.mNode >= 0)
+		for (const LogicalCpu &c : mCpus)
+			if (c.mNode == inSettings.mNode)
+			{
+				use_node = true;
+				break;
+			}
+	for (const LogicalCpu &c : mCpus)
+		if (!use_node || c.mNode == inSettings.mNode)
+			outCpus.push_back(&c);
+
+	// Order of preference: first thread of a core before SMT siblings (an efficiency core gives more throughput than a sibling of a
+	// busy performance core), performance cores before efficiency cores, then per node so consecutive workers share a node.
+	auto smt_rank = [&inSettings](const LogicalCpu *inCpu) { return inSettings.mAvoidSMT? inCpu->mSMTIndex : 0; };
+	auto efficiency_rank = [&inSettings](const LogicalCpu *inCpu) { return inSettings.mAvoidEfficiencyCores && inCpu->mIsEfficiencyCore? 1 : 0; };
+	QuickSort(outCpus.begin(), outCpus.end(), [&smt_rank, &efficiency_rank](const LogicalCpu *inLHS, const LogicalCpu *inRHS) {
+		int lhs_smt = smt_rank(inLHS), rhs_smt = smt_rank(inRHS);
+		if (lhs_smt != rhs_smt)
+			return lhs_smt < rhs_smt;
+		int lhs_efficiency = efficiency_rank(inLHS), rhs_efficiency = efficiency_rank(inRHS);
+		if (lhs_efficiency != rhs_efficiency)
+			return lhs_efficiency < rhs_efficiency;
+		if (inLHS->mNode != inRHS->mNode)
+			return inLHS->mNode < inRHS->mNode;
+		if (inLHS->mCore != inRHS->mCore)
+			return inLHS->mCore < inRHS->mCore;
+		return inLHS->mCpu < inRHS->mCpu;
+	});
+
+	outNumPreferred = 0;
+	for (const LogicalCpu *c : outCpus)
+		if (smt_rank(c) == 0 && efficiency_rank(c) == 0)
+			++outNumPreferred;
+}
+
+int ThreadTopology::GetRecommendedNumThreads(const Settings &inSettings) const
+{
+	Array<const LogicalCpu *> cpus;
+	int num_preferred;
+	GetOrderedCpus(inSettings, cpus, num_preferred);
+	return max(num_preferred - 1, 0);
+}
+
+void ThreadTopology::Plan(int inNumThreads, const Settings &inSettings, Array<Placement> &outPlacements) const
+{
+	outPlacements.clear();
+	outPlacements.resize(size_t(max(inNumThreads, 0)));
+	if (!inSettings.mPinThreads || !mCanPinThreads)
+		return;
+
+	Array<const LogicalCpu *> cpus;
+	int num_preferred;
+	GetOrderedCpus(inSettings, cpus, num_preferred);
+	if (cpus.empty())
+		return;
+
+	// Slot 0 is left for the main thread
+	for (size_t i = 0; i < outPlacements.size(); ++i)
+	{
+		const LogicalCpu &c = *cpus[(i + 1) % cpus.size()];
+		Placement &p = outPlacements[i];
+		p.mCpu = c.mCpu;
+		p.mCore = c.mCore;
+		p.mNode = c.mNode;
+		p.mIsSMTSibling = c.mSMTIndex > 0;
+		p.mIsEfficiencyCore = c.mIsEfficiencyCore;
+	}
+}
+
+bool ThreadTopology::sPinCurrentThread(int inCpu)
+{
+#ifdef JPH_PLATFORM_LINUX
+	if (inCpu < 0 || inCpu >= CPU_SETSIZE)
+		return false;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(inCpu, &set);
+	return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+	JPH_UNUSED(inCpu);
+	return false;
+#endif
+}
+
+JPH_NAMESPACE_END
@@ -0,0 +1,86 @@
+// Jolt Physics Library (https://github.com/jrouwe/JoltPhysics)
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+JPH_NAMESPACE_BEGIN
+
+/// Describes the logical CPU's that this process is allowed to run on and decides where worker threads of a job system should run.
+///
+/// On Linux the topology is read from /sys/devices/system (cores, SMT siblings, NUMA nodes and, on hybrid CPU's, which cores are
+/// efficiency cores) and threads are pinned with sched_setaffinity. On other platforms every logical CPU is reported as a separate
+/// performance core on node 0 and threads cannot be pinned.
+///
+/// Use it together with JobSystemThreadPool::SetThreadInitFunction (or JobSystemWorkStealing::SetThreadInitFunction) to pin every
+/// worker to the CPU that Plan assigned to it.
+class JPH_EXPORT ThreadTopology
+{
+public:
+	JPH_OVERRIDE_NEW_DELETE
+
+	/// A logical CPU (hardware thread)
+	struct LogicalCpu
+	{
+		int					mCpu = 0;											///< Index of the CPU as used by the OS
+		int					mCore = 0;											///< Index of the physical core this CPU belongs to (unique across packages)
+		int					mSMTIndex = 0;										///< 0 for the first hardware thread of a core, 1 for its first SMT sibling, etc.
+		int					mNode = 0;											///< NUMA node
+		uint32				mCapacity = 0;										///< Relative performance from cpu_capacity or cpuinfo_max_freq, 0 if unknown
+		bool				mIsEfficiencyCore = false;							///< True if this is an efficiency core of a hybrid CPU
+	};
+
+	/// How to place worker threads
+	struct Settings
+	{
+		bool				mPinThreads = true;									///< Pin every worker to a single logical CPU
+		bool				mAvoidSMT = true;									///< Use one hardware thread per physical core before using SMT siblings
+		bool				mAvoidEfficiencyCores = true;						///< Use performance cores of a hybrid CPU before using efficiency cores
+		int					mNode = -1;											///< Only use CPU's of this NUMA node, -1 to use all nodes (workers are then grouped per node)
+	};
+
+	/// Where a worker thread runs
+	struct Placement
+	{
+		int					mCpu = -1;											///< Logical CPU the thread is pinned to, -1 if it is not pinned
+		int					mCore = -1;											///< Physical core of mCpu
+		int					mNode = 0;											///< NUMA node of mCpu, workers with the same node form a group that shares memory bandwidth and L3
+		bool				mIsSMTSibling = false;								///< True if mCpu is not the first hardware thread of its core
+		bool				mIsEfficiencyCore = false;							///< True if mCpu is an efficiency core
+	};
+
+	/// Read the topology of the machine, can be called again to refresh it (e.g. when the affinity of the process changed)
+	void					Detect();
+
+	/// Access to the detected CPU's, sorted on mCpu
+	const Array<LogicalCpu> &GetCpus() const									{ return mCpus; }
+	int						GetNumCores() const									{ return mNumCores; }
+	int						GetNumNodes() const									{ return mNumNodes; }
+
+	/// True if the CPU has both performance and efficiency cores
+	bool					IsHybrid() const									{ return mIsHybrid; }
+
+	/// True if threads can be pinned on this platform
+	bool					CanPinThreads() const								{ return mCanPinThreads; }
+
+	/// Number of worker threads that fit on the preferred CPU's (see Settings) while leaving one for the main thread, which also runs jobs
+	int						GetRecommendedNumThreads(const Settings &inSettings) const;
+
+	/// Decide where inNumThreads workers run. The first preferred CPU is left for the main thread, if there are more workers than
+	/// CPU's the assignment wraps around.
+	void					Plan(int inNumThreads, const Settings &inSettings, Array<Placement> &outPlacements) const;
+
+	/// Pin the calling thread to a logical CPU, returns false if that is not possible
+	static bool				sPinCurrentThread(int inCpu);
+
+private:
+	/// Get the CPU's that can be used with inSettings, most preferred first
+	void					GetOrderedCpus(const Settings &inSettings, Array<const LogicalCpu *> &outCpus, int &outNumPreferred) const;
+
+	Array<LogicalCpu>		mCpus;
+	int						mNumCores = 0;
+	int						mNumNodes = 0;
+	bool					mIsHybrid = false;
+	bool					mCanPinThreads = false;
+};
+
+JPH_NAMESPACE_END
@@ -557,6 +557,7 @@ void BodyManager::ActivateBodies(const BodyID *inBodyIDs, int inNumber)
 				body.ResetSleepTestSpheres();
 
 				AddBodyToActiveBodies(body);
+				++mNumActivations;
 
 				// Call activation listener
 				if (mActivationListener != nullptr)
@@ -589,6 +590,7 @@ void BodyManager::DeactivateBodies(const BodyID *inBodyIDs, int inNumber)
 			{
 				// Remove the body from the active bodies list
 				RemoveBodyFromActiveBodies(body);
+				++mNumDeactivations;
 
 				// Mark this body as no longer active
 				body.mMotionProperties->mIslandIndex = Body::cInactiveIndex;
@@ -110,6 +110,10 @@ public:
 	/// Get the number of active bodies that are using continuous collision detection
 	uint32							GetNumActiveCCDBodies() const				{ return mNumActiveCCDBodies; }
 
+	/// Total number of times a body was activated / deactivated through ActivateBodies / DeactivateBodies, only valid when the active bodies mutex can't be taken by another thread
+	uint64							GetNumActivations() const					{ return mNumActivations; }
+	uint64							GetNumDeactivations() const					{ return mNumDeactivations; }
+
 	/// Listener that is notified whenever a body is activated/deactivated
 	void							SetBodyActivationListener(BodyActivationListener *inListener);
 	BodyActivationListener *		GetBodyActivationListener() const			{ return mActivationListener; }
@@ -333,6 +337,10 @@ private:
 	/// How many of the active bodies have continuous collision detection enabled
 	uint32							mNumActiveCCDBodies = 0;
 
+	/// How many times a body was added to / removed from the active bodies list, used to count bodies waking up and going to sleep
+	uint64							mNumActivations = 0;
+	uint64							mNumDeactivations = 0;
+
 	/// Mutex that protects the mBodiesCacheInvalid array
 	mutable Mutex					mBodiesCacheInvalidMutex;
 
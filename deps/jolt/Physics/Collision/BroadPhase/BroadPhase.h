@@ -17,6 +17,7 @@ JPH_NAMESPACE_BEGIN
 #endif // JPH_TRACK_BROADPHASE_STATS
 
 class BodyManager;
+class JobSystem;
 struct BodyPair;
 
 using BodyPairCollector = CollisionCollector<BodyPair, CollisionCollectorTraitsCollideShape>;
@@ -44,8 +45,9 @@ public:
 	struct UpdateState { void *mData[4]; };
 
 	/// Update the broadphase, needs to be called frequently to update the internal state when bodies have been modified.
-	/// The UpdatePrepare() function can run in a background thread without influencing the broadphase
-	virtual	UpdateState	UpdatePrepare()														{ return UpdateState(); }
+	/// The UpdatePrepare() function can run in a background thread without influencing the broadphase.
+	/// When inJobSystem is given the implementation may spread its work over jobs, it waits for them before returning.
+	virtual	UpdateState	UpdatePrepare([[maybe_unused]] JobSystem *inJobSystem = nullptr)	{ return UpdateState(); }
 
 	/// Finalizing the update will quickly apply the changes
 	virtual void		UpdateFinalize([[maybe_unused]] const UpdateState &inUpdateState)	{ /* Optionally overridden by implementation */ }
@@ -99,7 +99,7 @@ void BroadPhaseQuadTree::LockModifications()
 	PhysicsLock::sLock(mUpdateMutex JPH_IF_ENABLE_ASSERTS(, mLockContext, EPhysicsLockTypes::BroadPhaseUpdate));
 }
 
-BroadPhase::UpdateState BroadPhaseQuadTree::UpdatePrepare()
+BroadPhase::UpdateState BroadPhaseQuadTree::UpdatePrepare(JobSystem *inJobSystem)
 {
 	// LockModifications should have been called
 	JPH_ASSERT(mUpdateMutex.is_locked());
@@ -119,7 +119,7 @@ BroadPhase::UpdateState BroadPhaseQuadTree::UpdatePrepare()
 		if (tree.HasBodies() && tree.IsDirty() && tree.CanBeUpdated())
 		{
 			update_state_impl->mTree = &tree;
-			tree.UpdatePrepare(mBodyManager->GetBodies(), mTracking, update_state_impl->mUpdateState, false);
+			tree.UpdatePrepare(mBodyManager->GetBodies(), mTracking, update_state_impl->mUpdateState, false, inJobSystem);
 			return update_state;
 		}
 	}
@@ -579,6 +579,19 @@ void BroadPhaseQuadTree::FindCollidingPairs(BodyID *ioActiveBodies, int inNumAct
 	}
 }
 
+float BroadPhaseQuadTree::ComputeSurfaceAreaCost() const
+{
+	JPH_PROFILE_FUNCTION();
+
+	// Prevent this from running in parallel with node deletion in FrameSync(), see notes there
+	shared_lock lock(mQueryLocks[mQueryLockIdx]);
+
+	float cost = 0.0f;
+	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+		cost += mLayers[l].ComputeSurfaceAreaCost();
+	return cost;
+}
+
 #ifdef JPH_TRACK_BROADPHASE_STATS
 
 void BroadPhaseQuadTree::ReportStats()
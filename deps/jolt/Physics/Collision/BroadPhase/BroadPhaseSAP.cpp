@@ -0,0 +1,889 @@
+// Jolt Physics Library (https://github.com/jrouwe/JoltPhysics)
+// SPDX-License-Identifier: MIT
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseSAP.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/AABoxCast.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Body/BodyManager.h>
+#include <Jolt/Physics/Body/BodyPair.h>
+#include <Jolt/Geometry/RayAABox.h>
+#include <Jolt/Geometry/OrientedBox.h>
+#include <Jolt/Core/InsertionSort.h>
+#include <Jolt/Core/QuickSort.h>
+
+JPH_NAMESPACE_BEGIN
+
+BroadPhaseSAP::Tracking::Tracking(const Tracking &inRHS) :
+	mState(inRHS.mState.load()),
+	mTouched(inRHS.mTouched.load()),
+	mBroadPhaseLayer(inRHS.mBroadPhaseLayer.load()),
+	mObjectLayer(inRHS.mObjectLayer.load()),
+	mKey(inRHS.mKey),
+	mIsLarge(inRHS.mIsLarge),
+	mPendingSlot(inRHS.mPendingSlot)
+{
+	for (int i = 0; i < 6; ++i)
+		mBounds[i] = inRHS.mBounds[i].load();
+}
+
+inline AABox BroadPhaseSAP::Tracking::GetBounds() const
+{
+	return AABox(Vec3(mBounds[0].load(memory_order_relaxed), mBounds[1].load(memory_order_relaxed), mBounds[2].load(memory_order_relaxed)),
+				 Vec3(mBounds[3].load(memory_order_relaxed), mBounds[4].load(memory_order_relaxed), mBounds[5].load(memory_order_relaxed)));
+}
+
+BroadPhaseSAP::~BroadPhaseSAP()
+{
+	delete [] mLayers;
+}
+
+void BroadPhaseSAP::Init(BodyManager *inBodyManager, const BroadPhaseLayerInterface &inLayerInterface)
+{
+	BroadPhase::Init(inBodyManager, inLayerInterface);
+
+	// Store input parameters
+	mNumLayers = inLayerInterface.GetNumBroadPhaseLayers();
+	JPH_ASSERT(mNumLayers < (BroadPhaseLayer::Type)cBroadPhaseLayerInvalid);
+
+#ifdef JPH_ENABLE_ASSERTS
+	// Store lock context
+	mLockContext = inBodyManager;
+#endif // JPH_ENABLE_ASSERTS
+
+	// Store max bodies
+	mMaxBodies = inBodyManager->GetMaxBodies();
+
+	// Initialize tracking data, a body can be on every list only once so they can't overflow
+	mTracking.resize(mMaxBodies);
+	mPending.resize(mMaxBodies);
+	mMoved.resize(mMaxBodies);
+	mTouched.resize(mMaxBodies);
+
+	// Init layers
+	mLayers = new Layer [mNumLayers];
+}
+
+void BroadPhaseSAP::Optimize()
+{
+	JPH_PROFILE_FUNCTION();
+
+	UniqueLock query_lock(mQueryMutex JPH_IF_ENABLE_ASSERTS(, mLockContext, EPhysicsLockTypes::BroadPhaseQuery));
+	UniqueLock update_lock(mUpdateMutex JPH_IF_ENABLE_ASSERTS(, mLockContext, EPhysicsLockTypes::BroadPhaseUpdate));
+
+	TightenTouchedBodies();
+
+	Sync(true);
+}
+
+void BroadPhaseSAP::FrameSync()
+{
+	JPH_PROFILE_FUNCTION();
+
+	// Take a unique lock on the query mutex so that we know no one is walking the sorted arrays while we modify them.
+	// Note that nothing should be locked at this point to avoid risking a lock inversion deadlock, see BroadPhaseQuadTree::FrameSync.
+	UniqueLock query_lock(mQueryMutex JPH_IF_ENABLE_ASSERTS(, mLockContext, EPhysicsLockTypes::BroadPhaseQuery));
+	UniqueLock update_lock(mUpdateMutex JPH_IF_ENABLE_ASSERTS(, mLockContext, EPhysicsLockTypes::BroadPhaseUpdate));
+
+	Sync(false);
+}
+
+void BroadPhaseSAP::LockModifications()
+{
+	// From this point on we prevent modifications to the sorted arrays
+	PhysicsLock::sLock(mUpdateMutex JPH_IF_ENABLE_ASSERTS(, mLockContext, EPhysicsLockTypes::BroadPhaseUpdate));
+}
+
+BroadPhase::UpdateState BroadPhaseSAP::UpdatePrepare([[maybe_unused]] JobSystem *inJobSystem)
+{
+	JPH_PROFILE_FUNCTION();
+
+	// LockModifications should have been called
+	JPH_ASSERT(mUpdateMutex.is_locked());
+
+	// The sorting happens in FrameSync, here we only need to shrink the bounds of the bodies that moved
+	TightenTouchedBodies();
+
+	return UpdateState();
+}
+
+void BroadPhaseSAP::UnlockModifications()
+{
+	// From this point on we allow modifications to the sorted arrays again
+	PhysicsLock::sUnlock(mUpdateMutex JPH_IF_ENABLE_ASSERTS(, mLockContext, EPhysicsLockTypes::BroadPhaseUpdate));
+}
+
+void BroadPhaseSAP::AddBodiesFinalize(BodyID *ioBodies, int inNumber, [[maybe_unused]] AddState inAddState)
+{
+	JPH_PROFILE_FUNCTION();
+
+	// Adding bodies appends to the pending list, this cannot run concurrently with itself or with UpdatePrepare()/Sync()
+	UniqueLock lock(mUpdateMutex JPH_IF_ENABLE_ASSERTS(, mLockContext, EPhysicsLockTypes::BroadPhaseUpdate));
+
+	BodyVector &bodies = mBodyManager->GetBodies();
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	uint32 num_pending = mNumPending.load(memory_order_relaxed);
+	for (const BodyID *b = ioBodies, *b_end = ioBodies + inNumber; b < b_end; ++b)
+	{
+		uint32 index = b->GetIndex();
+		Body &body = *bodies[index];
+		JPH_ASSERT(body.GetID() == *b, "Provided BodyID doesn't match BodyID in body manager");
+		JPH_ASSERT(!body.IsInBroadPhase());
+		Tracking &t = mTracking[index];
+		JPH_ASSERT(t.mState == EState::Invalid);
+
+		// Store bounds and layers
+		const AABox &bounds = body.GetWorldSpaceBounds();
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			t.mBounds[axis].store(bounds.mMin[axis], memory_order_relaxed);
+			t.mBounds[axis + 3].store(bounds.mMax[axis], memory_order_relaxed);
+		}
+		t.mBroadPhaseLayer = (BroadPhaseLayer::Type)body.GetBroadPhaseLayer();
+		JPH_ASSERT(t.mBroadPhaseLayer < mNumLayers);
+		t.mObjectLayer = body.GetObjectLayer();
+		MarkDirty(t.mBroadPhaseLayer);
+
+		// Add to the pending list, a body that was removed and added again since the last sync reuses its slot
+		if (t.mPendingSlot == cInvalidSlot)
+			t.mPendingSlot = num_pending++;
+		mPending[t.mPendingSlot].mBodyID.store(b->GetIndexAndSequenceNumber(), memory_order_release);
+		t.mState.store(EState::Pending, memory_order_release);
+
+		// Mark added to broadphase
+		body.SetInBroadPhaseInternal(true);
+	}
+
+	// Make the new entries visible to queries
+	mNumPending.store(num_pending, memory_order_release);
+}
+
+void BroadPhaseSAP::RemoveBodies(BodyID *ioBodies, int inNumber)
+{
+	JPH_PROFILE_FUNCTION();
+
+	// This cannot run concurrently with UpdatePrepare()/Sync()
+	SharedLock lock(mUpdateMutex JPH_IF_ENABLE_ASSERTS(, mLockContext, EPhysicsLockTypes::BroadPhaseUpdate));
+
+	JPH_ASSERT(inNumber > 0);
+
+	BodyVector &bodies = mBodyManager->GetBodies();
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	for (const BodyID *b = ioBodies, *b_end = ioBodies + inNumber; b < b_end; ++b)
+	{
+		// The body stays in the sorted array and on the lists until the next sync, its state makes queries skip it
+		uint32 index = b->GetIndex();
+		JPH_ASSERT(bodies[index]->GetID() == *b, "Provided BodyID doesn't match BodyID in body manager");
+		Tracking &t = mTracking[index];
+		JPH_ASSERT(t.mState != EState::Invalid);
+		MarkDirty(t.mBroadPhaseLayer.load(memory_order_relaxed));
+		t.mState.store(EState::Invalid, memory_order_release);
+		t.mBroadPhaseLayer = (BroadPhaseLayer::Type)cBroadPhaseLayerInvalid;
+		t.mObjectLayer = cObjectLayerInvalid;
+
+		// Mark removed from broadphase
+		JPH_ASSERT(bodies[index]->IsInBroadPhase());
+		bodies[index]->SetInBroadPhaseInternal(false);
+	}
+}
+
+void BroadPhaseSAP::NotifyBodiesAABBChanged(BodyID *ioBodies, int inNumber, bool inTakeLock)
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(inNumber > 0);
+
+	// This cannot run concurrently with UpdatePrepare()/Sync()
+	if (inTakeLock)
+		PhysicsLock::sLockShared(mUpdateMutex JPH_IF_ENABLE_ASSERTS(, mLockContext, EPhysicsLockTypes::BroadPhaseUpdate));
+	else
+		JPH_ASSERT(mUpdateMutex.is_locked());
+
+	const BodyVector &bodies = mBodyManager->GetBodies();
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	for (const BodyID *b = ioBodies, *b_end = ioBodies + inNumber; b < b_end; ++b)
+	{
+		uint32 index = b->GetIndex();
+		const Body *body = bodies[index];
+		JPH_ASSERT(body->GetID() == *b, "Provided BodyID doesn't match BodyID in body manager");
+		Tracking &t = mTracking[index];
+		JPH_ASSERT(t.mState != EState::Invalid);
+
+		// Grow the cached bounds so that a concurrent query finds the body at both its old and new position
+		const AABox &bounds = body->GetWorldSpaceBounds();
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			AtomicMin(t.mBounds[axis], bounds.mMin[axis], memory_order_relaxed);
+			AtomicMax(t.mBounds[axis + 3], bounds.mMax[axis], memory_order_relaxed);
+		}
+
+		// Remember to shrink the bounds again in UpdatePrepare() and to resort the layer in the next sync
+		if (!t.mTouched.exchange(true, memory_order_relaxed))
+			mTouched[mNumTouched.fetch_add(1, memory_order_relaxed)] = index;
+		MarkDirty(t.mBroadPhaseLayer.load(memory_order_relaxed));
+
+		// Bodies in the sorted array need to stay inside the sweep window of their layer
+		if (t.mState.load(memory_order_relaxed) == EState::Sorted && !t.mIsLarge)
+		{
+			Layer &layer = mLayers[t.mBroadPhaseLayer.load(memory_order_relaxed)];
+			uint axis = layer.mAxis;
+			float below = t.mKey - t.mBounds[axis].load(memory_order_relaxed);
+			float above = t.mBounds[axis + 3].load(memory_order_relaxed) - t.mKey;
+			if (below <= layer.mMaxDrift && above <= layer.mMaxExtent + layer.mMaxDrift)
+			{
+				// Small move, widen the sweep window
+				AtomicMax(layer.mKeyBelow, below, memory_order_relaxed);
+				AtomicMax(layer.mKeyAbove, above, memory_order_relaxed);
+			}
+			else
+			{
+				// Moved too far, test it separately until the next sync
+				EState expected = EState::Sorted;
+				if (t.mState.compare_exchange_strong(expected, EState::SortedMoved))
+					mMoved[mNumMoved.fetch_add(1, memory_order_relaxed)].mBodyID.store(b->GetIndexAndSequenceNumber(), memory_order_release);
+			}
+		}
+	}
+
+	if (inTakeLock)
+		PhysicsLock::sUnlockShared(mUpdateMutex JPH_IF_ENABLE_ASSERTS(, mLockContext, EPhysicsLockTypes::BroadPhaseUpdate));
+}
+
+void BroadPhaseSAP::NotifyBodiesLayerChanged(BodyID *ioBodies, int inNumber)
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(inNumber > 0);
+
+	// First sort the bodies that actually changed layer to beginning of the array
+	const BodyVector &bodies = mBodyManager->GetBodies();
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+	for (BodyID *body_id = ioBodies + inNumber - 1; body_id >= ioBodies; --body_id)
+	{
+		uint32 index = body_id->GetIndex();
+		JPH_ASSERT(bodies[index]->GetID() == *body_id, "Provided BodyID doesn't match BodyID in body manager");
+		const Body *body = bodies[index];
+		BroadPhaseLayer::Type broadphase_layer = (BroadPhaseLayer::Type)body->GetBroadPhaseLayer();
+		JPH_ASSERT(broadphase_layer < mNumLayers);
+		if (mTracking[index].mBroadPhaseLayer == broadphase_layer)
+		{
+			// Update tracking information, queries read the object layer from the tracking data so the layer doesn't need a sync
+			mTracking[index].mObjectLayer = body->GetObjectLayer();
+
+			// Move the body to the end, layer didn't change
+			swap(*body_id, ioBodies[inNumber - 1]);
+			--inNumber;
+		}
+	}
+
+	if (inNumber > 0)
+	{
+		// Changing layer requires us to remove from one layer and add to another, so this is equivalent to removing all bodies first and then adding them again.
+		// This marks both the old and the new layer dirty.
+		RemoveBodies(ioBodies, inNumber);
+		AddState add_state = AddBodiesPrepare(ioBodies, inNumber);
+		AddBodiesFinalize(ioBodies, inNumber, add_state);
+	}
+}
+
+void BroadPhaseSAP::TightenTouchedBodies()
+{
+	const BodyVector &bodies = mBodyManager->GetBodies();
+
+	uint32 num_touched = mNumTouched.load(memory_order_relaxed);
+	for (uint32 i = 0; i < num_touched; ++i)
+	{
+		uint32 index = mTouched[i];
+		Tracking &t = mTracking[index];
+
+		// Bodies that were removed can still be on the list
+		if (t.mState.load(memory_order_relaxed) != EState::Invalid)
+		{
+			// The bounds of the body are inside the cached bounds, so shrinking them one component at a time never makes a concurrent query miss the body
+			const AABox &bounds = bodies[index]->GetWorldSpaceBounds();
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				t.mBounds[axis].store(bounds.mMin[axis], memory_order_relaxed);
+				t.mBounds[axis + 3].store(bounds.mMax[axis], memory_order_relaxed);
+			}
+		}
+
+		t.mTouched.store(false, memory_order_relaxed);
+	}
+
+	mNumTouched.store(0, memory_order_relaxed);
+}
+
+void BroadPhaseSAP::Sync(bool inFullSort)
+{
+	JPH_PROFILE_FUNCTION();
+
+	// Bodies on the moved list are still in the sorted array, the insertion sort in SyncLayer will move them to their new position
+	for (uint l = 0; l < mNumLayers; ++l)
+		mLayers[l].mNumMoved = 0;
+	uint32 num_moved = mNumMoved.load(memory_order_relaxed);
+	for (uint32 i = 0; i < num_moved; ++i)
+	{
+		BodyID body_id(mMoved[i].mBodyID.exchange(BodyID::cInvalidBodyID, memory_order_relaxed));
+		JPH_ASSERT(!body_id.IsInvalid());
+		Tracking &t = mTracking[body_id.GetIndex()];
+		EState expected = EState::SortedMoved;
+		if (t.mState.compare_exchange_strong(expected, EState::Sorted))
+			mLayers[t.mBroadPhaseLayer.load(memory_order_relaxed)].mNumMoved++;
+	}
+	mNumMoved.store(0, memory_order_relaxed);
+
+	// Sort the layers and insert the pending bodies
+	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+		SyncLayer(l, inFullSort);
+
+	// All pending bodies are now sorted
+	uint32 num_pending = mNumPending.load(memory_order_relaxed);
+	for (uint32 i = 0; i < num_pending; ++i)
+	{
+		BodyID body_id(mPending[i].mBodyID.exchange(BodyID::cInvalidBodyID, memory_order_relaxed));
+		mTracking[body_id.GetIndex()].mPendingSlot = cInvalidSlot;
+	}
+	mNumPending.store(0, memory_order_relaxed);
+}
+
+void BroadPhaseSAP::SyncLayer(BroadPhaseLayer::Type inLayer, bool inFullSort)
+{
+	Layer &layer = mLayers[inLayer];
+
+	// Nothing was added, removed or moved, the keys and the sweep window are still valid
+	if (!inFullSort && !layer.mDirty.load(memory_order_relaxed))
+		return;
+	layer.mDirty.store(false, memory_order_relaxed);
+
+	Array<SortedEntry> &sorted = layer.mSorted;
+	Array<SortedEntry> &insert = mInsert;
+	Tracking *tracking = mTracking.data(); // C pointer or else sort is incredibly slow in debug mode
+
+	// A body that was in this layer but was added to a layer that was synced before this one is already sorted there, so check the layer too
+	auto is_sorted_in_layer = [tracking, inLayer](BodyID inBodyID)
+	{
+		const Tracking &t = tracking[inBodyID.GetIndex()];
+		return t.mState.load(memory_order_relaxed) == EState::Sorted && t.mBroadPhaseLayer.load(memory_order_relaxed) == inLayer;
+	};
+
+	// Large bodies and bodies that were added since the last sync are (re)inserted
+	insert.clear();
+	for (BodyID body_id : layer.mLarge)
+		if (is_sorted_in_layer(body_id))
+			insert.push_back({ 0.0f, body_id });
+	layer.mLarge.clear();
+	uint32 num_pending = mNumPending.load(memory_order_relaxed);
+	for (uint32 i = 0; i < num_pending; ++i)
+	{
+		BodyID body_id(mPending[i].mBodyID.load(memory_order_relaxed));
+		const Tracking &t = tracking[body_id.GetIndex()];
+		if (t.mState.load(memory_order_relaxed) == EState::Pending && t.mBroadPhaseLayer.load(memory_order_relaxed) == inLayer)
+			insert.push_back({ 0.0f, body_id });
+	}
+
+	// Remove bodies that left the broad phase, that were added again or that changed layer
+	size_t num_sorted = 0;
+	for (const SortedEntry &e : sorted)
+		if (is_sorted_in_layer(e.mBodyID))
+			sorted[num_sorted++] = e;
+	sorted.resize(num_sorted);
+
+	size_t num_bodies = sorted.size() + insert.size();
+	if (num_bodies == 0)
+	{
+		layer.mMaxExtent = 0.0f;
+		layer.mMaxDrift = cMinMaxDrift;
+		layer.mKeyBelow.store(0.0f, memory_order_relaxed);
+		layer.mKeyAbove.store(0.0f, memory_order_relaxed);
+		return;
+	}
+
+	// Measure the spread of the body centers, relative to the first body to keep the sums small
+	const SortedEntry &first = sorted.empty()? insert[0] : sorted[0];
+	Vec3 reference = tracking[first.mBodyID.GetIndex()].GetBounds().GetCenter();
+	Vec3 center_sum = Vec3::sZero(), center_sq_sum = Vec3::sZero();
+	auto accumulate = [tracking, reference, &center_sum, &center_sq_sum](const Array<SortedEntry> &inEntries)
+	{
+		for (const SortedEntry &e : inEntries)
+		{
+			Vec3 center = tracking[e.mBodyID.GetIndex()].GetBounds().GetCenter() - reference;
+			center_sum += center;
+			center_sq_sum += center * center;
+		}
+	};
+	accumulate(sorted);
+	accumulate(insert);
+	float inv_num_bodies = 1.0f / float(num_bodies);
+	Vec3 mean_center = center_sum * inv_num_bodies;
+	Vec3 spread = center_sq_sum * inv_num_bodies - mean_center * mean_center;
+
+	// Switch to the axis with the largest spread if it is significantly better
+	bool full_sort = inFullSort || layer.mNumMoved > num_bodies / cFullSortFraction;
+	uint best_axis = (uint)spread.GetHighestComponentIndex();
+	if (best_axis != layer.mAxis && spread[best_axis] > cAxisSwitchRatio * spread[layer.mAxis])
+	{
+		layer.mAxis = best_axis;
+		full_sort = true;
+	}
+	uint axis = layer.mAxis;
+
+	// Update the keys and find the average extent along the axis
+	float extent_sum = 0.0f;
+	auto update_keys = [tracking, axis, &extent_sum](Array<SortedEntry> &ioEntries)
+	{
+		for (SortedEntry &e : ioEntries)
+		{
+			const Tracking &t = tracking[e.mBodyID.GetIndex()];
+			e.mKey = t.mBounds[axis].load(memory_order_relaxed);
+			extent_sum += t.mBounds[axis + 3].load(memory_order_relaxed) - e.mKey;
+		}
+	};
+	update_keys(sorted);
+	update_keys(insert);
+	float mean_extent = extent_sum * inv_num_bodies;
+
+	// Move bodies that would make the sweep window too big to the large body list
+	float large_extent = cLargeBodyFactor * mean_extent;
+	auto extract_large = [tracking, axis, large_extent, &layer](Array<SortedEntry> &ioEntries)
+	{
+		size_t num_kept = 0;
+		for (const SortedEntry &e : ioEntries)
+		{
+			Tracking &t = tracking[e.mBodyID.GetIndex()];
+			if (t.mBounds[axis + 3].load(memory_order_relaxed) - e.mKey > large_extent)
+			{
+				t.mKey = e.mKey;
+				t.mIsLarge = true;
+				t.mState.store(EState::Sorted, memory_order_relaxed);
+				layer.mLarge.push_back(e.mBodyID);
+			}
+			else
+				ioEntries[num_kept++] = e;
+		}
+		ioEntries.resize(num_kept);
+	};
+	extract_large(sorted);
+	extract_large(insert);
+
+	if (full_sort)
+	{
+		// Sort from scratch
+		sorted.insert(sorted.end(), insert.begin(), insert.end());
+		QuickSort(sorted.begin(), sorted.end());
+	}
+	else
+	{
+		// Bodies only moved a little since the last sync so the array is almost sorted
+		InsertionSort(sorted.begin(), sorted.end());
+
+		// Merge in the new bodies, starting at the back so that we can do it in place
+		QuickSort(insert.begin(), insert.end());
+		size_t num_old = sorted.size();
+		sorted.resize(num_old + insert.size());
+		SortedEntry *dst = sorted.data() + sorted.size();
+		SortedEntry *old_begin = sorted.data(), *old_end = sorted.data() + num_old;
+		const SortedEntry *new_begin = insert.data(), *new_end = insert.data() + insert.size();
+		while (new_end > new_begin)
+			if (old_end > old_begin && *(new_end - 1) < *(old_end - 1))
+				*--dst = *--old_end;
+			else
+				*--dst = *--new_end;
+	}
+
+	// Store the keys and determine the sweep window
+	float max_extent = 0.0f;
+	for (const SortedEntry &e : sorted)
+	{
+		Tracking &t = tracking[e.mBodyID.GetIndex()];
+		t.mKey = e.mKey;
+		t.mIsLarge = false;
+		t.mState.store(EState::Sorted, memory_order_relaxed);
+		max_extent = max(max_extent, t.mBounds[axis + 3].load(memory_order_relaxed) - e.mKey);
+	}
+	layer.mMaxExtent = max_extent;
+	layer.mMaxDrift = max(mean_extent, cMinMaxDrift);
+	layer.mKeyBelow.store(0.0f, memory_order_relaxed);
+	layer.mKeyAbove.store(max_extent, memory_order_relaxed);
+}
+
+template <class Visitor>
+void BroadPhaseSAP::WalkLayer(BroadPhaseLayer::Type inLayer, const AABox &inRange, const ObjectLayerFilter &inObjectLayerFilter, Visitor &ioVisitor) const
+{
+	const Layer &layer = mLayers[inLayer];
+
+	// Test a single body, returns false when the query should stop
+	auto visit = [&inRange, &inObjectLayerFilter, &ioVisitor](const BodyID &inBodyID, const Tracking &inTracking)
+	{
+		AABox bounds = inTracking.GetBounds();
+		if (bounds.Overlaps(inRange) && inObjectLayerFilter.ShouldCollide(inTracking.mObjectLayer.load(memory_order_relaxed)))
+		{
+			ioVisitor.VisitBody(inBodyID, bounds);
+			return !ioVisitor.ShouldAbort();
+		}
+		return true;
+	};
+
+	// A body can only overlap with the range if its key lies in [range min - max key above, range max + max key below]
+	uint axis = layer.mAxis;
+	float key_min = inRange.mMin[axis] - layer.mKeyAbove.load(memory_order_relaxed);
+	float key_max = inRange.mMax[axis] + layer.mKeyBelow.load(memory_order_relaxed);
+	const SortedEntry *e = std::lower_bound(layer.mSorted.data(), layer.mSorted.data() + layer.mSorted.size(), key_min, [](const SortedEntry &inEntry, float inKey) { return inEntry.mKey < inKey; });
+	for (const SortedEntry *e_end = layer.mSorted.data() + layer.mSorted.size(); e < e_end && e->mKey <= key_max; ++e)
+	{
+		const Tracking &t = mTracking[e->mBodyID.GetIndex()];
+		if (t.mState.load(memory_order_acquire) == EState::Sorted && !visit(e->mBodyID, t))
+			return;
+	}
+
+	// Test the large bodies
+	for (const BodyID &body_id : layer.mLarge)
+	{
+		const Tracking &t = mTracking[body_id.GetIndex()];
+		if (t.mState.load(memory_order_acquire) == EState::Sorted && !visit(body_id, t))
+			return;
+	}
+
+	// Test the bodies that moved too far and the ones that were added since the last sync
+	auto visit_list = [this, inLayer, &visit](const Array<BodySlot> &inList, uint32 inNumEntries, EState inState)
+	{
+		for (uint32 i = 0; i < inNumEntries; ++i)
+		{
+			BodyID body_id(inList[i].mBodyID.load(memory_order_acquire));
+			if (!body_id.IsInvalid())
+			{
+				const Tracking &t = mTracking[body_id.GetIndex()];
+				if (t.mState.load(memory_order_acquire) == inState && t.mBroadPhaseLayer.load(memory_order_relaxed) == inLayer && !visit(body_id, t))
+					return false;
+			}
+		}
+		return true;
+	};
+	if (visit_list(mMoved, mNumMoved.load(memory_order_acquire), EState::SortedMoved))
+		visit_list(mPending, mNumPending.load(memory_order_acquire), EState::Pending);
+}
+
+template <class Visitor>
+void BroadPhaseSAP::WalkLayers(const AABox &inRange, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter, Visitor &ioVisitor) const
+{
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	// Loop over all layers and test the ones that could hit
+	for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+		if (inBroadPhaseLayerFilter.ShouldCollide(BroadPhaseLayer(l)))
+		{
+			WalkLayer(l, inRange, inObjectLayerFilter, ioVisitor);
+			if (ioVisitor.ShouldAbort())
+				break;
+		}
+}
+
+void BroadPhaseSAP::CastRay(const RayCast &inRay, RayCastBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	class Visitor
+	{
+	public:
+		/// Constructor
+		JPH_INLINE				Visitor(const RayCast &inRay, RayCastBodyCollector &ioCollector) :
+			mOrigin(inRay.mOrigin),
+			mInvDirection(inRay.mDirection),
+			mCollector(ioCollector)
+		{
+		}
+
+		/// Returns true if further processing should be aborted
+		JPH_INLINE bool			ShouldAbort() const
+		{
+			return mCollector.ShouldEarlyOut();
+		}
+
+		/// Visit a body whose cached bounds overlap with the bounds of the ray
+		JPH_INLINE void			VisitBody(const BodyID &inBodyID, const AABox &inBounds)
+		{
+			// Test intersection with ray
+			float fraction = RayAABox(mOrigin, mInvDirection, inBounds.mMin, inBounds.mMax);
+			if (fraction < mCollector.GetEarlyOutFraction())
+			{
+				// Store hit
+				BroadPhaseCastResult result { inBodyID, fraction };
+				mCollector.AddHit(result);
+			}
+		}
+
+	private:
+		Vec3					mOrigin;
+		RayInvDirection			mInvDirection;
+		RayCastBodyCollector &	mCollector;
+	};
+
+	// Prevent this from running in parallel with Sync(), see notes in FrameSync()
+	shared_lock lock(mQueryMutex);
+
+	Visitor visitor(inRay, ioCollector);
+	WalkLayers(AABox::sFromTwoPoints(inRay.mOrigin, inRay.mOrigin + inRay.mDirection), inBroadPhaseLayerFilter, inObjectLayerFilter, visitor);
+}
+
+void BroadPhaseSAP::CollideAABox(const AABox &inBox, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	class Visitor
+	{
+	public:
+		/// Constructor
+		JPH_INLINE					Visitor(CollideShapeBodyCollector &ioCollector) :
+			mCollector(ioCollector)
+		{
+		}
+
+		/// Returns true if further processing should be aborted
+		JPH_INLINE bool				ShouldAbort() const
+		{
+			return mCollector.ShouldEarlyOut();
+		}
+
+		/// Visit a body whose cached bounds overlap with the box
+		JPH_INLINE void				VisitBody(const BodyID &inBodyID, const AABox &)
+		{
+			// Store hit
+			mCollector.AddHit(inBodyID);
+		}
+
+	private:
+		CollideShapeBodyCollector &	mCollector;
+	};
+
+	// Prevent this from running in parallel with Sync(), see notes in FrameSync()
+	shared_lock lock(mQueryMutex);
+
+	Visitor visitor(ioCollector);
+	WalkLayers(inBox, inBroadPhaseLayerFilter, inObjectLayerFilter, visitor);
+}
+
+void BroadPhaseSAP::CollideSphere(Vec3Arg inCenter, float inRadius, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	class Visitor
+	{
+	public:
+		/// Constructor
+		JPH_INLINE					Visitor(Vec3Arg inCenter, float inRadius, CollideShapeBodyCollector &ioCollector) :
+			mCenter(inCenter),
+			mRadiusSq(Square(inRadius)),
+			mCollector(ioCollector)
+		{
+		}
+
+		/// Returns true if further processing should be aborted
+		JPH_INLINE bool				ShouldAbort() const
+		{
+			return mCollector.ShouldEarlyOut();
+		}
+
+		/// Visit a body whose cached bounds overlap with the bounds of the sphere
+		JPH_INLINE void				VisitBody(const BodyID &inBodyID, const AABox &inBounds)
+		{
+			// Test intersection with sphere
+			if (inBounds.GetSqDistanceTo(mCenter) <= mRadiusSq)
+				mCollector.AddHit(inBodyID);
+		}
+
+	private:
+		Vec3						mCenter;
+		float						mRadiusSq;
+		CollideShapeBodyCollector &	mCollector;
+	};
+
+	// Prevent this from running in parallel with Sync(), see notes in FrameSync()
+	shared_lock lock(mQueryMutex);
+
+	Visitor visitor(inCenter, inRadius, ioCollector);
+	Vec3 radius = Vec3::sReplicate(inRadius);
+	WalkLayers(AABox(inCenter - radius, inCenter + radius), inBroadPhaseLayerFilter, inObjectLayerFilter, visitor);
+}
+
+void BroadPhaseSAP::CollidePoint(Vec3Arg inPoint, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
+{
+	// A point overlaps with a box when the box contains it
+	CollideAABox(AABox(inPoint, inPoint), ioCollector, inBroadPhaseLayerFilter, inObjectLayerFilter);
+}
+
+void BroadPhaseSAP::CollideOrientedBox(const OrientedBox &inBox, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	class Visitor
+	{
+	public:
+		/// Constructor
+		JPH_INLINE					Visitor(const OrientedBox &inBox, CollideShapeBodyCollector &ioCollector) :
+			mBox(inBox),
+			mCollector(ioCollector)
+		{
+		}
+
+		/// Returns true if further processing should be aborted
+		JPH_INLINE bool				ShouldAbort() const
+		{
+			return mCollector.ShouldEarlyOut();
+		}
+
+		/// Visit a body whose cached bounds overlap with the bounds of the oriented box
+		JPH_INLINE void				VisitBody(const BodyID &inBodyID, const AABox &inBounds)
+		{
+			// Test intersection with oriented box
+			if (mBox.Overlaps(inBounds))
+				mCollector.AddHit(inBodyID);
+		}
+
+	private:
+		const OrientedBox &			mBox;
+		CollideShapeBodyCollector &	mCollector;
+	};
+
+	// Prevent this from running in parallel with Sync(), see notes in FrameSync()
+	shared_lock lock(mQueryMutex);
+
+	Visitor visitor(inBox, ioCollector);
+	WalkLayers(AABox(-inBox.mHalfExtents, inBox.mHalfExtents).Transformed(inBox.mOrientation), inBroadPhaseLayerFilter, inObjectLayerFilter, visitor);
+}
+
+void BroadPhaseSAP::CastAABoxNoLock(const AABoxCast &inBox, CastShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	class Visitor
+	{
+	public:
+		/// Constructor
+		JPH_INLINE					Visitor(const AABoxCast &inBox, CastShapeBodyCollector &ioCollector) :
+			mOrigin(inBox.mBox.GetCenter()),
+			mExtent(inBox.mBox.GetExtent()),
+			mInvDirection(inBox.mDirection),
+			mCollector(ioCollector)
+		{
+		}
+
+		/// Returns true if further processing should be aborted
+		JPH_INLINE bool				ShouldAbort() const
+		{
+			return mCollector.ShouldEarlyOut();
+		}
+
+		/// Visit a body whose cached bounds overlap with the bounds of the swept box
+		JPH_INLINE void				VisitBody(const BodyID &inBodyID, const AABox &inBounds)
+		{
+			// Test intersection with the swept box
+			float fraction = RayAABox(mOrigin, mInvDirection, inBounds.mMin - mExtent, inBounds.mMax + mExtent);
+			if (fraction < mCollector.GetPositiveEarlyOutFraction())
+			{
+				// Store hit
+				BroadPhaseCastResult result { inBodyID, fraction };
+				mCollector.AddHit(result);
+			}
+		}
+
+	private:
+		Vec3						mOrigin;
+		Vec3						mExtent;
+		RayInvDirection				mInvDirection;
+		CastShapeBodyCollector &	mCollector;
+	};
+
+	// Bounds of the box over the length of the cast
+	AABox range = inBox.mBox;
+	range.Encapsulate(inBox.mBox.mMin + inBox.mDirection);
+	range.Encapsulate(inBox.mBox.mMax + inBox.mDirection);
+
+	Visitor visitor(inBox, ioCollector);
+	WalkLayers(range, inBroadPhaseLayerFilter, inObjectLayerFilter, visitor);
+}
+
+void BroadPhaseSAP::CastAABox(const AABoxCast &inBox, CastShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const
+{
+	// Prevent this from running in parallel with Sync(), see notes in FrameSync()
+	shared_lock lock(mQueryMutex);
+
+	CastAABoxNoLock(inBox, ioCollector, inBroadPhaseLayerFilter, inObjectLayerFilter);
+}
+
+void BroadPhaseSAP::FindCollidingPairs(BodyID *ioActiveBodies, int inNumActiveBodies, float inSpeculativeContactDistance, const ObjectVsBroadPhaseLayerFilter &inObjectVsBroadPhaseLayerFilter, const ObjectLayerPairFilter &inObjectLayerPairFilter, BodyPairCollector &ioPairCollector) const
+{
+	JPH_PROFILE_FUNCTION();
+
+	class Visitor
+	{
+	public:
+		/// Constructor
+		JPH_INLINE					Visitor(const BodyVector &inBodies, const Body &inBody1, const AABox &inBounds1, BodyPairCollector &ioPairCollector) :
+			mBodies(inBodies),
+			mBody1(inBody1),
+			mBounds1(inBounds1),
+			mPairCollector(ioPairCollector)
+		{
+		}
+
+		/// Returns true if further processing should be aborted
+		JPH_INLINE bool				ShouldAbort() const
+		{
+			return false;
+		}
+
+		/// Visit a body whose cached bounds overlap with the bounds of body 1
+		JPH_INLINE void				VisitBody(const BodyID &inBodyID, const AABox &)
+		{
+			// Don't collide with self
+			if (inBodyID != mBody1.GetID())
+			{
+				// Collision between dynamic pairs need to be picked up only once
+				const Body &body2 = *mBodies[inBodyID.GetIndex()];
+				if (Body::sFindCollidingPairsCanCollide(mBody1, body2)
+					&& mBounds1.Overlaps(body2.GetWorldSpaceBounds())) // The cached bounds grow when a body moves, do a final check to see if the bounding boxes actually overlap
+				{
+					// Store potential hit between bodies
+					mPairCollector.AddHit({ mBody1.GetID(), inBodyID });
+				}
+			}
+		}
+
+	private:
+		const BodyVector &			mBodies;
+		const Body &				mBody1;
+		const AABox &				mBounds1;
+		BodyPairCollector &			mPairCollector;
+	};
+
+	const BodyVector &bodies = mBodyManager->GetBodies();
+	JPH_ASSERT(mMaxBodies == mBodyManager->GetMaxBodies());
+
+	// Note that we don't take any locks at this point. We know that the sorted arrays are not going to be modified while finding collision pairs due to the way the jobs are scheduled in the PhysicsSystem::Update.
+	// Unlike a classic sweep and prune we don't sweep the whole array to build a list of all overlapping pairs: the active bodies are handed to us in batches from multiple threads,
+	// so each active body does a binary search and sweeps only its own window. Pairs between two active bodies are reported once by Body::sFindCollidingPairsCanCollide.
+	for (int b1 = 0; b1 < inNumActiveBodies; ++b1)
+	{
+		BodyID b1_id = ioActiveBodies[b1];
+		const Body &body1 = *bodies[b1_id.GetIndex()];
+		JPH_ASSERT(!body1.IsStatic());
+		ObjectLayer object_layer = body1.GetObjectLayer();
+
+		// Expand the bounding box by the speculative contact distance
+		AABox bounds1 = body1.GetWorldSpaceBounds();
+		bounds1.ExpandBy(Vec3::sReplicate(inSpeculativeContactDistance));
+
+		// Test against all layers that could hit
+		DefaultObjectLayerFilter object_layer_filter(inObjectLayerPairFilter, object_layer);
+		Visitor visitor(bodies, body1, bounds1, ioPairCollector);
+		for (BroadPhaseLayer::Type l = 0; l < mNumLayers; ++l)
+			if (inObjectVsBroadPhaseLayerFilter.ShouldCollide(object_layer, BroadPhaseLayer(l)))
+				WalkLayer(l, bounds1, object_layer_filter, visitor);
+	}
+}
+
+JPH_NAMESPACE_END
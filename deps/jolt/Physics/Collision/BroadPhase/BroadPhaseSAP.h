@@ -0,0 +1,192 @@
+// Jolt Physics Library (https://github.com/jrouwe/JoltPhysics)
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhase.h>
+#include <Jolt/Physics/PhysicsLock.h>
+#include <Jolt/Core/Mutex.h>
+#include <Jolt/Core/Atomics.h>
+
+JPH_NAMESPACE_BEGIN
+
+/// Sweep and prune BroadPhase that keeps the bodies of every broad phase layer sorted on the lower bound of their bounding box along a single axis.
+/// The axis is picked per layer as the one with the largest spread of body centers. Because bodies move a little every step the sorted arrays
+/// stay almost sorted and are resorted with an insertion sort in FrameSync(), queries do a binary search followed by a linear sweep.
+/// Layers in which no body was added, removed or moved since the last sync are skipped by FrameSync(), so static layers cost nothing.
+/// Bodies that move further than the sweep window can absorb between two syncs are kept on a separate list that every query tests.
+class JPH_EXPORT BroadPhaseSAP final : public BroadPhase
+{
+public:
+	JPH_OVERRIDE_NEW_DELETE
+
+	/// Destructor
+	virtual					~BroadPhaseSAP() override;
+
+	// Implementing interface of BroadPhase (see BroadPhase for documentation)
+	virtual void			Init(BodyManager *inBodyManager, const BroadPhaseLayerInterface &inLayerInterface) override;
+	virtual void			Optimize() override;
+	virtual void			FrameSync() override;
+	virtual void			LockModifications() override;
+	virtual	UpdateState		UpdatePrepare(JobSystem *inJobSystem = nullptr) override;
+	virtual void			UnlockModifications() override;
+	virtual void			AddBodiesFinalize(BodyID *ioBodies, int inNumber, AddState inAddState) override;
+	virtual void			RemoveBodies(BodyID *ioBodies, int inNumber) override;
+	virtual void			NotifyBodiesAABBChanged(BodyID *ioBodies, int inNumber, bool inTakeLock) override;
+	virtual void			NotifyBodiesLayerChanged(BodyID *ioBodies, int inNumber) override;
+	virtual void			CastRay(const RayCast &inRay, RayCastBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
+	virtual void			CollideAABox(const AABox &inBox, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
+	virtual void			CollideSphere(Vec3Arg inCenter, float inRadius, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
+	virtual void			CollidePoint(Vec3Arg inPoint, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
+	virtual void			CollideOrientedBox(const OrientedBox &inBox, CollideShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
+	virtual void			CastAABoxNoLock(const AABoxCast &inBox, CastShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
+	virtual void			CastAABox(const AABoxCast &inBox, CastShapeBodyCollector &ioCollector, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter) const override;
+	virtual void			FindCollidingPairs(BodyID *ioActiveBodies, int inNumActiveBodies, float inSpeculativeContactDistance, const ObjectVsBroadPhaseLayerFilter &inObjectVsBroadPhaseLayerFilter, const ObjectLayerPairFilter &inObjectLayerPairFilter, BodyPairCollector &ioPairCollector) const override;
+
+private:
+	/// Where a body is stored
+	enum class EState : uint8
+	{
+		Invalid,																	///< Body is not in the broad phase
+		Pending,																	///< Body was added since the last sync and is on the pending list
+		Sorted,																		///< Body is in the sorted array or the large body list of its layer
+		SortedMoved,																///< Body is in the sorted array but moved outside of the sweep window, it is on the moved list
+	};
+
+	/// Data stored per body, indexed by BodyID::GetIndex()
+	struct Tracking
+	{
+		/// Constructor to satisfy the vector class
+								Tracking() = default;
+								Tracking(const Tracking &inRHS);
+
+		/// Get the cached bounding box of the body
+		inline AABox			GetBounds() const;
+
+		/// Cached bounds, min x, y, z followed by max x, y, z. These only grow when a body moves and are shrunk to the bounds of the body in UpdatePrepare().
+		atomic<float>			mBounds[6] { };
+		atomic<EState>			mState { EState::Invalid };
+		atomic<bool>			mTouched { false };									///< If the body is on the touched list
+		atomic<BroadPhaseLayer::Type> mBroadPhaseLayer = (BroadPhaseLayer::Type)cBroadPhaseLayerInvalid;
+		atomic<ObjectLayer>		mObjectLayer = cObjectLayerInvalid;
+		float					mKey = 0.0f;										///< Sort key (lower bound along the layer axis) at the time of the last sync
+		bool					mIsLarge = false;									///< If the body is on the large body list of its layer
+		uint32					mPendingSlot = cInvalidSlot;						///< Index in the pending list or cInvalidSlot if the body is not on it
+	};
+
+	using TrackingVector = Array<Tracking>;
+
+	/// Entry of a list that can be read while it is being appended to
+	struct BodySlot
+	{
+		/// Constructor to satisfy the vector class
+								BodySlot() = default;
+								BodySlot(const BodySlot &inRHS) : mBodyID(inRHS.mBodyID.load()) { }
+
+		atomic<uint32>			mBodyID { BodyID::cInvalidBodyID };
+	};
+
+	/// Entry in the sorted array of a layer
+	struct SortedEntry
+	{
+		/// Sort on key, the body ID makes the order independent of the input order
+		inline bool				operator < (const SortedEntry &inRHS) const			{ return mKey < inRHS.mKey || (mKey == inRHS.mKey && mBodyID < inRHS.mBodyID); }
+
+		float					mKey;
+		BodyID					mBodyID;
+	};
+
+	/// All bodies of a single broad phase layer
+	struct Layer
+	{
+		Array<SortedEntry>		mSorted;											///< Bodies sorted on the lower bound of their bounds along mAxis
+		Array<BodyID>			mLarge;												///< Bodies that are so large that they would blow up the sweep window, these are tested one by one
+		uint					mAxis = 0;											///< Axis along which the bodies are sorted
+		float					mMaxExtent = 0.0f;									///< Largest extent along mAxis of a body in mSorted at the time of the last sync
+		float					mMaxDrift = 0.0f;									///< How far a body is allowed to grow beyond its key before it is moved to the moved list
+		uint32					mNumMoved = 0;										///< Number of bodies of this layer that were on the moved list, only valid during Sync()
+		atomic<bool>			mDirty { false };									///< If a body of this layer was added, removed or moved since the last sync
+		atomic<float>			mKeyBelow { 0.0f };									///< Largest distance a lower bound has moved below its key since the last sync
+		atomic<float>			mKeyAbove { 0.0f };									///< Largest distance between a key and the upper bound of its body since the last sync
+	};
+
+	/// Invalid index in the pending list
+	static constexpr uint32	cInvalidSlot = 0xffffffff;
+
+	/// Switch sorting axis only when the spread along the new axis is this much larger, avoids resorting when the spread along two axis is similar
+	static constexpr float	cAxisSwitchRatio = 1.5f;
+
+	/// Bodies that are this much larger than the average body of a layer go to the large body list
+	static constexpr float	cLargeBodyFactor = 4.0f;
+
+	/// Minimal distance a body can move before it is moved to the moved list
+	static constexpr float	cMinMaxDrift = 0.01f;
+
+	/// When more than 1 / cFullSortFraction of the bodies of a layer moved outside of the sweep window the layer is sorted from scratch instead of with an insertion sort
+	static constexpr uint32	cFullSortFraction = 16;
+
+	/// Move bodies that moved to their sorted position, insert new bodies and pick a new axis. When inFullSort is true the layers are resorted from scratch.
+	/// Both the query and the update mutex need to be locked.
+	void					Sync(bool inFullSort);
+
+	/// Sync a single layer, see Sync(). Does nothing when the layer is not dirty and inFullSort is false.
+	void					SyncLayer(BroadPhaseLayer::Type inLayer, bool inFullSort);
+
+	/// Mark a layer as needing a sync
+	inline void				MarkDirty(BroadPhaseLayer::Type inLayer)
+	{
+		// Check first to avoid writing the cache line of the layer for every body that moves
+		atomic<bool> &dirty = mLayers[inLayer].mDirty;
+		if (!dirty.load(memory_order_relaxed))
+			dirty.store(true, memory_order_relaxed);
+	}
+
+	/// Shrink the cached bounds of the bodies on the touched list to the bounds of the bodies and clear the list
+	void					TightenTouchedBodies();
+
+	/// Call ioVisitor.VisitBody(body_id, bounds) for every body in inLayer that passes inObjectLayerFilter and whose cached bounds overlap inRange
+	template <class Visitor>
+	void					WalkLayer(BroadPhaseLayer::Type inLayer, const AABox &inRange, const ObjectLayerFilter &inObjectLayerFilter, Visitor &ioVisitor) const;
+
+	/// Call WalkLayer() for all layers that pass inBroadPhaseLayerFilter
+	template <class Visitor>
+	void					WalkLayers(const AABox &inRange, const BroadPhaseLayerFilter &inBroadPhaseLayerFilter, const ObjectLayerFilter &inObjectLayerFilter, Visitor &ioVisitor) const;
+
+#ifdef JPH_ENABLE_ASSERTS
+	/// Context used to lock a physics lock
+	PhysicsLockContext		mLockContext = nullptr;
+#endif // JPH_ENABLE_ASSERTS
+
+	/// Max amount of bodies we support
+	size_t					mMaxBodies = 0;
+
+	/// Array that for each BodyID keeps track of where it is located
+	TrackingVector			mTracking;
+
+	/// One set of sorted bodies per broad phase layer
+	Layer *					mLayers = nullptr;
+	uint					mNumLayers = 0;
+
+	/// Bodies that were added since the last sync
+	Array<BodySlot>			mPending;
+	atomic<uint32>			mNumPending { 0 };
+
+	/// Bodies that moved outside of the sweep window since the last sync
+	Array<BodySlot>			mMoved;
+	atomic<uint32>			mNumMoved { 0 };
+
+	/// Indices of bodies whose cached bounds were grown since the last UpdatePrepare()
+	Array<uint32>			mTouched;
+	atomic<uint32>			mNumTouched { 0 };
+
+	/// Scratch space used by SyncLayer(), kept around so that a sync doesn't need to allocate
+	Array<SortedEntry>		mInsert;
+
+	/// Mutex that prevents object modification during UpdatePrepare() and Sync()
+	SharedMutex				mUpdateMutex;
+
+	/// Mutex that prevents queries from running while the sorted arrays are changed in Sync()
+	mutable SharedMutex		mQueryMutex;
+};
+
+JPH_NAMESPACE_END
@@ -10,6 +10,7 @@
 #include <Jolt/Physics/Collision/SortReverseAndStore.h>
 #include <Jolt/Physics/Body/BodyPair.h>
 #include <Jolt/Physics/PhysicsLock.h>
+#include <Jolt/Core/JobSystem.h>
 #include <Jolt/Geometry/AABox4.h>
 #include <Jolt/Geometry/RayAABox.h>
 #include <Jolt/Geometry/OrientedBox.h>
@@ -221,7 +222,7 @@ void QuadTree::DiscardOldTree()
 	}
 }
 
-void QuadTree::UpdatePrepare(const BodyVector &inBodies, TrackingVector &ioTracking, UpdateState &outUpdateState, bool inFullRebuild)
+void QuadTree::UpdatePrepare(const BodyVector &inBodies, TrackingVector &ioTracking, UpdateState &outUpdateState, bool inFullRebuild, JobSystem *inJobSystem)
 {
 #ifdef JPH_ENABLE_ASSERTS
 	// We only read positions
@@ -246,8 +247,9 @@ void QuadTree::UpdatePrepare(const BodyVector &inBodies, TrackingVector &ioTrack
 	ValidateTree(inBodies, ioTracking, root_node.mIndex, mNumBodies);
 #endif
 
-	// Create space for all body ID's
-	NodeID *node_ids = new NodeID [mNumBodies];
+	// Create space for all body ID's, the buffer is kept between updates so that a rebuild doesn't need to allocate
+	mUpdateNodeIDs.resize(max(mNumBodies.load(memory_order_relaxed), 1u));
+	NodeID *node_ids = mUpdateNodeIDs.data();
 	NodeID *cur_node_id = node_ids;
 
 	// Collect all bodies
@@ -329,7 +331,11 @@ void QuadTree::UpdatePrepare(const BodyVector &inBodies, TrackingVector &ioTrack
 
 		// Build new tree
 		AABox root_bounds;
-		root_node_id = BuildTree(inBodies, ioTracking, node_ids, num_node_ids, cMaxDepthMarkChanged, root_bounds);
+		mUpdateCenters.resize(num_node_ids);
+		if (inJobSystem != nullptr && inJobSystem->GetMaxConcurrency() > 1 && num_node_ids >= cMinParallelBuild)
+			root_node_id = BuildTreeParallel(inBodies, ioTracking, node_ids, mUpdateCenters.data(), num_node_ids, cMaxDepthMarkChanged, inJobSystem, root_bounds);
+		else
+			root_node_id = BuildTree(inBodies, ioTracking, node_ids, mUpdateCenters.data(), num_node_ids, cMaxDepthMarkChanged, root_bounds);
 
 		if (root_node_id.IsBody())
 		{
@@ -349,9 +355,6 @@ void QuadTree::UpdatePrepare(const BodyVector &inBodies, TrackingVector &ioTrack
 		root_node_id = NodeID::sFromNodeIndex(root_idx);
 	}
 
-	// Delete temporary data
-	delete [] node_ids;
-
 	outUpdateState.mRootNodeID = root_node_id;
 }
 
@@ -480,7 +483,7 @@ AABox QuadTree::GetNodeOrBodyBounds(const BodyVector &inBodies, NodeID inNodeID)
 	}
 }
 
-QuadTree::NodeID QuadTree::BuildTree(const BodyVector &inBodies, TrackingVector &ioTracking, NodeID *ioNodeIDs, int inNumber, uint inMaxDepthMarkChanged, AABox &outBounds)
+QuadTree::NodeID QuadTree::BuildTree(const BodyVector &inBodies, TrackingVector &ioTracking, NodeID *ioNodeIDs, Vec3 *ioCenters, int inNumber, uint inMaxDepthMarkChanged, AABox &outBounds)
 {
 	// Trivial case: No bodies in tree
 	if (inNumber == 0)
@@ -503,12 +506,19 @@ QuadTree::NodeID QuadTree::BuildTree(const BodyVector &inBodies, TrackingVector
 	}
 
 	// Calculate centers of all bodies that are to be inserted
-	Vec3 *centers = new Vec3 [inNumber];
-	JPH_ASSERT(IsAligned(centers, JPH_VECTOR_ALIGNMENT));
-	Vec3 *c = centers;
+	Vec3 *c = ioCenters;
 	for (const NodeID *n = ioNodeIDs, *n_end = ioNodeIDs + inNumber; n < n_end; ++n, ++c)
 		*c = GetNodeOrBodyBounds(inBodies, *n).GetCenter();
 
+	return BuildTreeFromCenters(inBodies, ioTracking, ioNodeIDs, ioCenters, inNumber, 0, inMaxDepthMarkChanged, outBounds);
+}
+
+QuadTree::NodeID QuadTree::BuildTreeFromCenters(const BodyVector &inBodies, TrackingVector &ioTracking, NodeID *ioNodeIDs, Vec3 *ioCenters, int inNumber, uint inDepth, uint inMaxDepthMarkChanged, AABox &outBounds)
+{
+	JPH_ASSERT(inNumber > 1);
+	Vec3 *centers = ioCenters;
+	JPH_ASSERT(IsAligned(centers, JPH_VECTOR_ALIGNMENT));
+
 	// The algorithm is a recursive tree build, but to avoid the call overhead we keep track of a stack here
 	struct StackEntry
 	{
@@ -524,9 +534,9 @@ QuadTree::NodeID QuadTree::BuildTree(const BodyVector &inBodies, TrackingVector
 	int top = 0;
 
 	// Create root node
-	stack[0].mNodeIdx = AllocateNode(inMaxDepthMarkChanged > 0);
+	stack[0].mNodeIdx = AllocateNode(inMaxDepthMarkChanged > inDepth);
 	stack[0].mChildIdx = -1;
-	stack[0].mDepth = 0;
+	stack[0].mDepth = inDepth;
 	stack[0].mNodeBoundsMin = Vec3::sReplicate(cLargeFloat);
 	stack[0].mNodeBoundsMax = Vec3::sReplicate(-cLargeFloat);
 	sPartition4(ioNodeIDs, centers, 0, inNumber, stack[0].mSplit);
@@ -612,9 +622,6 @@ QuadTree::NodeID QuadTree::BuildTree(const BodyVector &inBodies, TrackingVector
 		}
 	}
 
-	// Delete temporary data
-	delete [] centers;
-
 	// Store bounding box of root
 	outBounds.mMin = stack[0].mNodeBoundsMin;
 	outBounds.mMax = stack[0].mNodeBoundsMax;
@@ -623,6 +630,135 @@ QuadTree::NodeID QuadTree::BuildTree(const BodyVector &inBodies, TrackingVector
 	return NodeID::sFromNodeIndex(stack[0].mNodeIdx);
 }
 
+QuadTree::NodeID QuadTree::BuildTreeParallel(const BodyVector &inBodies, TrackingVector &ioTracking, NodeID *ioNodeIDs, Vec3 *ioCenters, int inNumber, uint inMaxDepthMarkChanged, JobSystem *inJobSystem, AABox &outBounds)
+{
+	JPH_PROFILE_FUNCTION();
+
+	JPH_ASSERT(inNumber > 1);
+
+	// If all barriers are in use, build the tree on this thread
+	JobSystem::Barrier *barrier = inJobSystem->CreateBarrier();
+	if (barrier == nullptr)
+		return BuildTree(inBodies, ioTracking, ioNodeIDs, ioCenters, inNumber, inMaxDepthMarkChanged, outBounds);
+
+	// Calls inFunction(i) for i = [0, inNumJobs) from jobs and waits until they're all done, this thread executes jobs while waiting
+	auto run_jobs = [inJobSystem, barrier](int inNumJobs, const auto &inFunction)
+	{
+		JPH_ASSERT(inNumJobs <= cParallelBuildSubTrees);
+		JobHandle handles[cParallelBuildSubTrees];
+		for (int i = 0; i < inNumJobs; ++i)
+			handles[i] = inJobSystem->CreateJob("BuildTree", Color::sGreen, [&inFunction, i]() { inFunction(i); });
+		barrier->AddJobs(handles, uint(inNumJobs));
+		inJobSystem->WaitForJobs(barrier);
+	};
+
+	// Calculate centers of all bodies and nodes
+	run_jobs(cParallelBuildSubTrees, [&inBodies, ioNodeIDs, ioCenters, inNumber, this](int inJob)
+	{
+		int begin = int(uint64(inNumber) * uint64(inJob) / cParallelBuildSubTrees);
+		int end = int(uint64(inNumber) * uint64(inJob + 1) / cParallelBuildSubTrees);
+		for (int i = begin; i < end; ++i)
+			ioCenters[i] = GetNodeOrBodyBounds(inBodies, ioNodeIDs[i]).GetCenter();
+	});
+
+	// The nodes of the top levels and the sub trees below them are stored breadth first, the children of node i are at 4 * i + 1 .. 4 * i + 4.
+	// The range of node i is ioNodeIDs[mBegin, mEnd). A range with 0 or 1 entries doesn't become a node, its entry is linked directly to the parent.
+	struct Range
+	{
+		int				mBegin;
+		int				mEnd;
+	};
+	constexpr int cNumRanges = cParallelBuildTopNodes + cParallelBuildSubTrees;
+	Range ranges[cNumRanges];
+	ranges[0] = { 0, inNumber };
+
+	// Partition the top levels, a level at a time. The nodes of a level are independent so they are partitioned in parallel.
+	for (int level = 0, first = 0, count = 1; level < cParallelBuildLevels; ++level, first += count, count *= 4)
+	{
+		auto partition = [ioNodeIDs, ioCenters, &ranges, first](int inIndex)
+		{
+			int node = first + inIndex;
+			const Range &range = ranges[node];
+			int split[5];
+			if (range.mEnd - range.mBegin > 1)
+				sPartition4(ioNodeIDs, ioCenters, range.mBegin, range.mEnd, split);
+			else
+				split[0] = split[1] = split[2] = split[3] = split[4] = range.mEnd; // Not a node, its children will not be visited
+			for (int child = 0; child < 4; ++child)
+				ranges[4 * node + 1 + child] = { split[child], split[child + 1] };
+		};
+		if (count == 1)
+			partition(0);
+		else
+			run_jobs(count, partition);
+	}
+
+	// Build the sub trees
+	NodeID node_ids[cNumRanges];
+	AABox node_bounds[cNumRanges];
+	run_jobs(cParallelBuildSubTrees, [&inBodies, &ioTracking, ioNodeIDs, ioCenters, inMaxDepthMarkChanged, &ranges, &node_ids, &node_bounds, this](int inIndex)
+	{
+		int node = cParallelBuildTopNodes + inIndex;
+		const Range &range = ranges[node];
+		int number = range.mEnd - range.mBegin;
+		if (number > 1)
+			node_ids[node] = BuildTreeFromCenters(inBodies, ioTracking, ioNodeIDs + range.mBegin, ioCenters + range.mBegin, number, cParallelBuildLevels, inMaxDepthMarkChanged, node_bounds[node]);
+	});
+
+	inJobSystem->DestroyBarrier(barrier);
+
+	// Create the nodes of the top levels bottom up and link their children
+	for (int node = cParallelBuildTopNodes - 1; node >= 0; --node)
+	{
+		const Range &range = ranges[node];
+		if (range.mEnd - range.mBegin <= 1)
+			continue;
+
+		uint depth = 0;
+		for (int n = node; n > 0; n = (n - 1) / 4)
+			++depth;
+
+		uint32 node_idx = AllocateNode(inMaxDepthMarkChanged > depth);
+		Node &new_node = mAllocator->Get(node_idx);
+		AABox bounds;
+		for (int child = 0; child < 4; ++child)
+		{
+			int child_range_idx = 4 * node + 1 + child;
+			const Range &child_range = ranges[child_range_idx];
+			int number = child_range.mEnd - child_range.mBegin;
+			if (number == 0)
+				continue;
+
+			NodeID child_node_id;
+			AABox child_bounds;
+			if (number == 1)
+			{
+				child_node_id = ioNodeIDs[child_range.mBegin];
+				child_bounds = GetNodeOrBodyBounds(inBodies, child_node_id);
+			}
+			else
+			{
+				child_node_id = node_ids[child_range_idx];
+				child_bounds = node_bounds[child_range_idx];
+			}
+
+			new_node.mChildNodeID[child] = child_node_id;
+			new_node.SetChildBounds(child, child_bounds);
+			if (child_node_id.IsNode())
+				mAllocator->Get(child_node_id.GetNodeIndex()).mParentNodeIndex = node_idx;
+			else
+				SetBodyLocation(ioTracking, child_node_id.GetBodyID(), node_idx, child);
+			bounds.Encapsulate(child_bounds);
+		}
+
+		node_ids[node] = NodeID::sFromNodeIndex(node_idx);
+		node_bounds[node] = bounds;
+	}
+
+	outBounds = node_bounds[0];
+	return node_ids[0];
+}
+
 void QuadTree::MarkNodeAndParentsChanged(uint32 inNodeIndex)
 {
 	uint32 node_idx = inNodeIndex;
@@ -788,7 +924,9 @@ void QuadTree::AddBodiesPrepare(const BodyVector &inBodies, TrackingVector &ioTr
 
 	// Build subtree for the new bodies, note that we mark all nodes as 'not changed'
 	// so they will stay together as a batch and will make the tree rebuild cheaper
-	outState.mLeafID = BuildTree(inBodies, ioTracking, (NodeID *)ioBodyIDs, inNumber, 0, outState.mLeafBounds);
+	Array<Vec3> centers;
+	centers.resize(inNumber);
+	outState.mLeafID = BuildTree(inBodies, ioTracking, (NodeID *)ioBodyIDs, centers.data(), inNumber, 0, outState.mLeafBounds);
 
 #ifdef _DEBUG
 	if (outState.mLeafID.IsNode())
@@ -1442,6 +1580,46 @@ void QuadTree::FindCollidingPairs(const BodyVector &inBodies, const BodyID *inAc
 	JPH_ASSERT(&root_node == &GetCurrentRoot());
 }
 
+float QuadTree::ComputeSurfaceAreaCost() const
+{
+	// Get bounds of the root, an empty tree has no cost
+	uint32 root_idx = GetCurrentRoot().GetNodeID().GetNodeIndex();
+	AABox root_bounds;
+	mAllocator->Get(root_idx).GetNodeBounds(root_bounds);
+	if (!root_bounds.IsValid())
+		return 0.0f;
+
+	// Sum the surface area of all nodes below the root
+	float total_area = 0.0f;
+	uint32 node_stack[cStackSize];
+	node_stack[0] = root_idx;
+	int top = 0;
+	do
+	{
+		const Node &node = mAllocator->Get(node_stack[top]);
+		--top;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			NodeID child_node_id = node.mChildNodeID[i];
+			if (child_node_id.IsValid() && child_node_id.IsNode())
+			{
+				AABox child_bounds;
+				node.GetChildBounds(i, child_bounds);
+				if (child_bounds.IsValid())
+					total_area += child_bounds.GetSurfaceArea();
+
+				JPH_ASSERT(top < cStackSize - 1);
+				node_stack[++top] = child_node_id.GetNodeIndex();
+			}
+		}
+	}
+	while (top >= 0);
+
+	// The root is always visited
+	return 1.0f + total_area / root_bounds.GetSurfaceArea();
+}
+
 #ifdef _DEBUG
 
 void QuadTree::ValidateTree(const BodyVector &inBodies, const TrackingVector &inTracking, uint32 inNodeIndex, uint32 inNumExpectedBodies) const
@@ -141,6 +141,18 @@ private:
 	// Maximum size of the stack during tree walk
 	static constexpr int		cStackSize = 128;
 
+	/// Number of tree levels that BuildTreeParallel partitions before building the sub trees below them in parallel
+	static constexpr int		cParallelBuildLevels = 3;
+
+	/// Number of sub trees that BuildTreeParallel builds in parallel (4^cParallelBuildLevels)
+	static constexpr int		cParallelBuildSubTrees = 1 << (2 * cParallelBuildLevels);
+
+	/// Number of nodes above the sub trees that BuildTreeParallel builds (sum of 4^i with i = [0, cParallelBuildLevels))
+	static constexpr int		cParallelBuildTopNodes = (cParallelBuildSubTrees - 1) / 3;
+
+	/// Below this amount of bodies / nodes the tree is built on the calling thread as spreading the work costs more than it gains
+	static constexpr int		cMinParallelBuild = 4096;
+
 	static_assert(sizeof(atomic<float>) == 4, "Assuming that an atomic doesn't add any additional storage");
 	static_assert(sizeof(atomic<uint32>) == 4, "Assuming that an atomic doesn't add any additional storage");
 	static_assert(is_trivially_destructible<Node>(), "Assuming that we don't have a destructor");
@@ -199,7 +211,8 @@ public:
 
 	/// Update the broadphase, needs to be called regularly to achieve a tight fit of the tree when bodies have been modified.
 	/// UpdatePrepare() will build the tree, UpdateFinalize() will lock the root of the tree shortly and swap the trees and afterwards clean up temporary data structures.
-	void						UpdatePrepare(const BodyVector &inBodies, TrackingVector &ioTracking, UpdateState &outUpdateState, bool inFullRebuild);
+	/// When inJobSystem is given, large trees are built on multiple threads (see BuildTreeParallel).
+	void						UpdatePrepare(const BodyVector &inBodies, TrackingVector &ioTracking, UpdateState &outUpdateState, bool inFullRebuild, JobSystem *inJobSystem = nullptr);
 	void						UpdateFinalize(const BodyVector &inBodies, const TrackingVector &inTracking, const UpdateState &inUpdateState);
 
 	/// Temporary data structure to pass information between AddBodiesPrepare and AddBodiesFinalize/Abort
@@ -248,6 +261,10 @@ public:
 	/// Find all colliding pairs between dynamic bodies, calls ioPairCollector for every pair found
 	void						FindCollidingPairs(const BodyVector &inBodies, const BodyID *inActiveBodies, int inNumActiveBodies, float inSpeculativeContactDistance, BodyPairCollector &ioPairCollector, const ObjectLayerPairFilter &inObjectLayerPairFilter) const;
 
+	/// Surface area heuristic cost of the current tree: the summed surface area of all nodes divided by the surface area of the root.
+	/// This is the expected number of nodes a random ray through the root visits, lower means a tighter tree. Used to compare tree builds.
+	float						ComputeSurfaceAreaCost() const;
+
 #ifdef JPH_TRACK_BROADPHASE_STATS
 	/// Sum up all the ticks spent in the various layers
 	uint64						GetTicks100Pct() const;
@@ -299,8 +316,16 @@ private:
 	/// Try to replace the existing root with a new root that contains both the existing root and the new leaf
 	inline bool					TryCreateNewRoot(TrackingVector &ioTracking, atomic<uint32> &ioRootNodeIndex, NodeID inLeafID, const AABox &inLeafBounds, int inLeafNumBodies);
 
-	/// Build a tree for ioBodyIDs, returns the NodeID of the root (which will be the ID of a single body if inNumber = 1). All tree levels up to inMaxDepthMarkChanged will be marked as 'changed'.
-	NodeID						BuildTree(const BodyVector &inBodies, TrackingVector &ioTracking, NodeID *ioNodeIDs, int inNumber, uint inMaxDepthMarkChanged, AABox &outBounds);
+	/// Build a tree for ioBodyIDs, returns the NodeID of the root (which will be the ID of a single body if inNumber = 1). All tree levels up to inMaxDepthMarkChanged will be marked as 'changed'. ioCenters is scratch space for inNumber centers.
+	NodeID						BuildTree(const BodyVector &inBodies, TrackingVector &ioTracking, NodeID *ioNodeIDs, Vec3 *ioCenters, int inNumber, uint inMaxDepthMarkChanged, AABox &outBounds);
+
+	/// Build the tree below a node at depth inDepth for inNumber > 1 bodies / nodes, ioCenters must contain the centers of their bounds. Returns the ID of the root node.
+	NodeID						BuildTreeFromCenters(const BodyVector &inBodies, TrackingVector &ioTracking, NodeID *ioNodeIDs, Vec3 *ioCenters, int inNumber, uint inDepth, uint inMaxDepthMarkChanged, AABox &outBounds);
+
+	/// Same as BuildTree for inNumber > 1, but the work is spread over jobs of inJobSystem. The top cParallelBuildLevels levels are partitioned
+	/// in the same way as BuildTree does it, then the sub trees below them are built in parallel and linked to the top levels.
+	/// This results in the same tree as BuildTree would build, only the node indices differ.
+	NodeID						BuildTreeParallel(const BodyVector &inBodies, TrackingVector &ioTracking, NodeID *ioNodeIDs, Vec3 *ioCenters, int inNumber, uint inMaxDepthMarkChanged, JobSystem *inJobSystem, AABox &outBounds);
 
 	/// Sorts ioNodeIDs spatially into 2 groups. Second groups starts at ioNodeIDs + outMidPoint.
 	/// After the function returns ioNodeIDs and ioNodeCenters will be shuffled
@@ -378,6 +403,10 @@ private:
 	/// This is a list of nodes that must be deleted after the trees are swapped and the old tree is no longer in use
 	Allocator::Batch			mFreeNodeBatch;
 
+	/// Scratch buffers for UpdatePrepare(), kept around so that rebuilding the tree doesn't allocate every update
+	Array<NodeID>				mUpdateNodeIDs;
+	Array<Vec3>					mUpdateCenters;
+
 	/// Flag to keep track of changes to the broadphase, if false, we don't need to UpdatePrepare/Finalize()
 	atomic<bool>				mIsDirty = false;
 };
@@ -9,140 +9,196 @@
 
 #include <Jolt/Physics/Body/BodyID.h>
 #include <Jolt/Physics/Collision/Shape/SubShapeID.h>
+#include <Jolt/Core/Mutex.h>
+#include <Jolt/Core/Atomics.h>
 
 JPH_SUPPRESS_WARNINGS_STD_BEGIN
 #include <iomanip>
 #include <fstream>
+#include <sstream>
 JPH_SUPPRESS_WARNINGS_STD_END
 
 JPH_NAMESPACE_BEGIN
 
 /// A simple class that logs the state of the simulation. The resulting text file can be used to diff between platforms and find issues in determinism.
+/// Lines are written as a whole, so jobs on multiple threads can log at the same time. The order of the lines then depends on the scheduling,
+/// so compare the logs of multi threaded runs as sets of lines.
 class DeterminismLog
 {
-private:
-	JPH_INLINE uint32		Convert(float inValue) const
-	{
-		return *(uint32 *)&inValue;
-	}
-
-	JPH_INLINE uint64		Convert(double inValue) const
-	{
-		return *(uint64 *)&inValue;
-	}
-
 public:
-							DeterminismLog()
-	{
-		mLog.open("detlog.txt", std::ios::out | std::ios::trunc | std::ios::binary); // Binary because we don't want a difference between Unix and Windows line endings.
-		mLog.fill('0');
-	}
-
-	DeterminismLog &		operator << (char inValue)
-	{
-		mLog << inValue;
-		return *this;
-	}
-
-	DeterminismLog &		operator << (const char *inValue)
-	{
-		mLog << std::dec << inValue;
-		return *this;
-	}
-
-	DeterminismLog &		operator << (const string &inValue)
-	{
-		mLog << std::dec << inValue;
-		return *this;
-	}
-
-	DeterminismLog &		operator << (const BodyID &inValue)
-	{
-		mLog << std::hex << std::setw(8) << inValue.GetIndexAndSequenceNumber();
-		return *this;
-	}
+	/// A line of the log, written when it goes out of scope
+	class Line
+	{
+	private:
+		JPH_INLINE uint32		Convert(float inValue) const
+		{
+			return *(uint32 *)&inValue;
+		}
+
+		JPH_INLINE uint64		Convert(double inValue) const
+		{
+			return *(uint64 *)&inValue;
+		}
+
+	public:
+								Line()
+		{
+			mLine.fill('0');
+		}
+
+								~Line()
+		{
+			sLog.Write(mLine.str());
+		}
+
+		Line &					operator << (char inValue)
+		{
+			mLine << inValue;
+			return *this;
+		}
+
+		Line &					operator << (const char *inValue)
+		{
+			mLine << std::dec << inValue;
+			return *this;
+		}
+
+		Line &					operator << (const string &inValue)
+		{
+			mLine << std::dec << inValue;
+			return *this;
+		}
+
+		Line &					operator << (const BodyID &inValue)
+		{
+			mLine << std::hex << std::setw(8) << inValue.GetIndexAndSequenceNumber();
+			return *this;
+		}
+
+		Line &					operator << (const SubShapeID &inValue)
+		{
+			mLine << std::hex << std::setw(8) << inValue.GetValue();
+			return *this;
+		}
+
+		Line &					operator << (float inValue)
+		{
+			mLine << std::hex << std::setw(8) << Convert(inValue);
+			return *this;
+		}
+
+		Line &					operator << (int inValue)
+		{
+			mLine << inValue;
+			return *this;
+		}
+
+		Line &					operator << (uint32 inValue)
+		{
+			mLine << std::hex << std::setw(8) << inValue;
+			return *this;
+		}
+
+		Line &					operator << (uint64 inValue)
+		{
+			mLine << std::hex << std::setw(16) << inValue;
+			return *this;
+		}
+
+		Line &					operator << (Vec3Arg inValue)
+		{
+			mLine << std::hex << std::setw(8) << Convert(inValue.GetX()) << " " << std::setw(8) << Convert(inValue.GetY()) << " " << std::setw(8) << Convert(inValue.GetZ());
+			return *this;
+		}
+
+		Line &					operator << (DVec3Arg inValue)
+		{
+			mLine << std::hex << std::setw(16) << Convert(inValue.GetX()) << " " << std::setw(16) << Convert(inValue.GetY()) << " " << std::setw(16) << Convert(inValue.GetZ());
+			return *this;
+		}
+
+		Line &					operator << (Vec4Arg inValue)
+		{
+			mLine << std::hex << std::setw(8) << Convert(inValue.GetX()) << " " << std::setw(8) << Convert(inValue.GetY()) << " " << std::setw(8) << Convert(inValue.GetZ()) << " " << std::setw(8) << Convert(inValue.GetW());
+			return *this;
+		}
+
+		Line &					operator << (const Float3 &inValue)
+		{
+			mLine << std::hex << std::setw(8) << Convert(inValue.x) << " " << std::setw(8) << Convert(inValue.y) << " " << std::setw(8) << Convert(inValue.z);
+			return *this;
+		}
+
+		Line &					operator << (Mat44Arg inValue)
+		{
+			*this << inValue.GetColumn4(0) << " " << inValue.GetColumn4(1) << " " << inValue.GetColumn4(2) << " " << inValue.GetColumn4(3);
+			return *this;
+		}
+
+		Line &					operator << (DMat44Arg inValue)
+		{
+			*this << inValue.GetColumn4(0) << " " << inValue.GetColumn4(1) << " " << inValue.GetColumn4(2) << " " << inValue.GetTranslation();
+			return *this;
+		}
+
+		Line &					operator << (QuatArg inValue)
+		{
+			*this << inValue.GetXYZW();
+			return *this;
+		}
+
+	private:
+		std::ostringstream		mLine;
+	};
 
-	DeterminismLog &		operator << (const SubShapeID &inValue)
-	{
-		mLog << std::hex << std::setw(8) << inValue.GetValue();
-		return *this;
-	}
-
-	DeterminismLog &		operator << (float inValue)
-	{
-		mLog << std::hex << std::setw(8) << Convert(inValue);
-		return *this;
-	}
-
-	DeterminismLog &		operator << (int inValue)
-	{
-		mLog << inValue;
-		return *this;
-	}
-
-	DeterminismLog &		operator << (uint32 inValue)
-	{
-		mLog << std::hex << std::setw(8) << inValue;
-		return *this;
-	}
-
-	DeterminismLog &		operator << (uint64 inValue)
-	{
-		mLog << std::hex << std::setw(16) << inValue;
-		return *this;
-	}
-
-	DeterminismLog &		operator << (Vec3Arg inValue)
-	{
-		mLog << std::hex << std::setw(8) << Convert(inValue.GetX()) << " " << std::setw(8) << Convert(inValue.GetY()) << " " << std::setw(8) << Convert(inValue.GetZ());
-		return *this;
-	}
-
-	DeterminismLog &		operator << (DVec3Arg inValue)
-	{
-		mLog << std::hex << std::setw(16) << Convert(inValue.GetX()) << " " << std::setw(16) << Convert(inValue.GetY()) << " " << std::setw(16) << Convert(inValue.GetZ());
-		return *this;
-	}
-
-	DeterminismLog &		operator << (Vec4Arg inValue)
+							DeterminismLog()
 	{
-		mLog << std::hex << std::setw(8) << Convert(inValue.GetX()) << " " << std::setw(8) << Convert(inValue.GetY()) << " " << std::setw(8) << Convert(inValue.GetZ()) << " " << std::setw(8) << Convert(inValue.GetW());
-		return *this;
+		Open("detlog.txt");
 	}
 
-	DeterminismLog &		operator << (const Float3 &inValue)
+	/// Start writing the log to inFileName, the file is truncated
+	void					Open(const char *inFileName)
 	{
-		mLog << std::hex << std::setw(8) << Convert(inValue.x) << " " << std::setw(8) << Convert(inValue.y) << " " << std::setw(8) << Convert(inValue.z);
-		return *this;
+		std::lock_guard lock(mMutex);
+		if (mLog.is_open())
+			mLog.close();
+		mLog.open(inFileName, std::ios::out | std::ios::trunc | std::ios::binary); // Binary because we don't want a difference between Unix and Windows line endings.
+		mIsOpen.store(mLog.is_open(), memory_order_relaxed);
 	}
 
-	DeterminismLog &		operator << (Mat44Arg inValue)
+	/// Stop logging until the next Open()
+	void					Close()
 	{
-		*this << inValue.GetColumn4(0) << " " << inValue.GetColumn4(1) << " " << inValue.GetColumn4(2) << " " << inValue.GetColumn4(3);
-		return *this;
+		std::lock_guard lock(mMutex);
+		mIsOpen.store(false, memory_order_relaxed);
+		mLog.close();
 	}
 
-	DeterminismLog &		operator << (DMat44Arg inValue)
+	/// True while a file is open, JPH_DET_LOG skips formatting its line otherwise
+	inline bool				IsOpen() const
 	{
-		*this << inValue.GetColumn4(0) << " " << inValue.GetColumn4(1) << " " << inValue.GetColumn4(2) << " " << inValue.GetTranslation();
-		return *this;
+		return mIsOpen.load(memory_order_relaxed);
 	}
 
-	DeterminismLog &		operator << (QuatArg inValue)
+	/// Append a line to the log
+	void					Write(const std::string &inLine)
 	{
-		*this << inValue.GetXYZW();
-		return *this;
+		std::lock_guard lock(mMutex);
+		if (mLog.is_open())
+			mLog << inLine << '\n';
 	}
 
 	// Singleton instance
 	static DeterminismLog	sLog;
 
 private:
+	Mutex					mMutex;
 	std::ofstream			mLog;
+	atomic<bool>			mIsOpen { false };
 };
 
 /// Will log something to the determinism log, usage: JPH_DET_LOG("label " << value);
-#define JPH_DET_LOG(...)	DeterminismLog::sLog << __VA_ARGS__ << '\n'
+#define JPH_DET_LOG(...)	do { if (DeterminismLog::sLog.IsOpen()) { DeterminismLog::Line det_log_line; det_log_line << __VA_ARGS__; } } while (false)
 
 JPH_NAMESPACE_END
 
@@ -515,6 +515,14 @@ void LargeIslandSplitter::MarkBatchProcessed(uint inSplitIslandIndex, const uint
 	splits.MarkBatchProcessed(num_items_processed, outLastIteration, outFinalBatch);
 }
 
+uint LargeIslandSplitter::GetNumSplits() const
+{
+	uint num_splits = 0;
+	for (const Splits *s = mSplitIslands, *s_end = mSplitIslands + mNumSplitIslands; s < s_end; ++s)
+		num_splits += s->GetNumSplits();
+	return num_splits;
+}
+
 void LargeIslandSplitter::PrepareForSolvePositions()
 {
 	for (Splits *s = mSplitIslands, *s_end = mSplitIslands + mNumSplitIslands; s < s_end; ++s)
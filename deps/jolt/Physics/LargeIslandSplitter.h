@@ -157,6 +157,12 @@ public:
 		return mSplitIslands[inSplitIslandIndex].mIslandIndex;
 	}
 
+	/// Get the number of islands that required splitting
+	inline uint				GetNumSplitIslands() const							{ return mNumSplitIslands; }
+
+	/// Get the total number of splits that the split islands were split into (excluding the non-parallel splits). Only valid after all islands have been split.
+	uint					GetNumSplits() const;
+
 	/// Prepare the island splitter for iterating over the split islands again for position solving. Marks all batches as startable.
 	void					PrepareForSolvePositions();
 
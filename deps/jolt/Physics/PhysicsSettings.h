@@ -92,6 +92,10 @@ struct PhysicsSettings
 	/// By default the simulation is deterministic, it is possible to turn this off by setting this setting to false. This will make the simulation run faster but it will no longer be deterministic.
 	bool		mDeterministicSimulation = true;
 
+	/// Create the jobs on the critical path of a step (broadphase update, island building, solvers and CCD) with EJobPriority::High and the jobs that nothing waits for until the end of the step with EJobPriority::Low.
+	/// Job systems that support priorities then run them ahead of the bulk parallel work (collision detection, integration), which shortens the step when threads are oversubscribed.
+	bool		mUseJobPriorities = true;
+
 	///@name These variables are mainly for debugging purposes, they allow turning on/off certain subsystems. You probably want to leave them alone.
 	///@{
 
@@ -10,6 +10,7 @@
 #include <Jolt/Physics/PhysicsStepListener.h>
 #include <Jolt/Physics/Collision/BroadPhase/BroadPhaseBruteForce.h>
 #include <Jolt/Physics/Collision/BroadPhase/BroadPhaseQuadTree.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseSAP.h>
 #include <Jolt/Physics/Collision/CollisionDispatch.h>
 #include <Jolt/Physics/Collision/AABoxCast.h>
 #include <Jolt/Physics/Collision/ShapeCast.h>
@@ -69,7 +70,7 @@ PhysicsSystem::~PhysicsSystem()
 	delete mBroadPhase;
 }
 
-void PhysicsSystem::Init(uint inMaxBodies, uint inNumBodyMutexes, uint inMaxBodyPairs, uint inMaxContactConstraints, const BroadPhaseLayerInterface &inBroadPhaseLayerInterface, const ObjectVsBroadPhaseLayerFilter &inObjectVsBroadPhaseLayerFilter, const ObjectLayerPairFilter &inObjectLayerPairFilter)
+void PhysicsSystem::Init(uint inMaxBodies, uint inNumBodyMutexes, uint inMaxBodyPairs, uint inMaxContactConstraints, const BroadPhaseLayerInterface &inBroadPhaseLayerInterface, const ObjectVsBroadPhaseLayerFilter &inObjectVsBroadPhaseLayerFilter, const ObjectLayerPairFilter &inObjectLayerPairFilter, EBroadPhaseType inBroadPhaseType)
 {
 	mObjectVsBroadPhaseLayerFilter = &inObjectVsBroadPhaseLayerFilter;
 	mObjectLayerPairFilter = &inObjectLayerPairFilter;
@@ -78,7 +79,10 @@ void PhysicsSystem::Init(uint inMaxBodies, uint inNumBodyMutexes, uint inMaxBody
 	mBodyManager.Init(inMaxBodies, inNumBodyMutexes, inBroadPhaseLayerInterface);
 
 	// Create broadphase
-	mBroadPhase = new BROAD_PHASE();
+	if (inBroadPhaseType == EBroadPhaseType::SweepAndPrune)
+		mBroadPhase = new BroadPhaseSAP();
+	else
+		mBroadPhase = new BROAD_PHASE();
 	mBroadPhase->Init(&mBodyManager, inBroadPhaseLayerInterface);
 
 	// Init contact constraint manager
@@ -119,10 +123,18 @@ void PhysicsSystem::RemoveStepListener(PhysicsStepListener *inListener)
 	mStepListeners.pop_back();
 }
 
-EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, TempAllocator *inTempAllocator, JobSystem *inJobSystem)
+EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionSteps, TempAllocator *inTempAllocator, JobSystem *inJobSystem, PhysicsUpdateStats *outStats)
 {
 	JPH_PROFILE_FUNCTION();
 
+	// Remember where we started when statistics are requested
+	uint64 stats_start_time = 0;
+	if (outStats != nullptr)
+	{
+		*outStats = PhysicsUpdateStats();
+		stats_start_time = PhysicsUpdateStats::sGetTime();
+	}
+
 	JPH_DET_LOG("PhysicsSystem::Update: dt: " << inDeltaTime << " steps: " << inCollisionSteps);
 
 	JPH_ASSERT(inCollisionSteps > 0);
@@ -130,6 +142,8 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 
 	// Sync point for the broadphase. This will allow it to do clean up operations without having any mutexes locked yet.
 	mBroadPhase->FrameSync();
+	if (outStats != nullptr)
+		outStats->mBroadPhaseFrameSyncTime = PhysicsUpdateStats::sGetTime() - stats_start_time;
 
 	// If there are no active bodies or there's no time delta
 	uint32 num_active_rigid_bodies = mBodyManager.GetNumActiveBodies(EBodyType::RigidBody);
@@ -140,7 +154,7 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 
 		// Update broadphase
 		mBroadPhase->LockModifications();
-		BroadPhase::UpdateState update_state = mBroadPhase->UpdatePrepare();
+		BroadPhase::UpdateState update_state = mBroadPhase->UpdatePrepare(inJobSystem);
 		mBroadPhase->UpdateFinalize(update_state);
 		mBroadPhase->UnlockModifications();
 
@@ -148,6 +162,13 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 		mContactManager.FinalizeContactCacheAndCallContactPointRemovedCallbacks(0, 0);
 
 		mBodyManager.UnlockAllBodies();
+
+		if (outStats != nullptr)
+		{
+			outStats->mNumActiveBodies = num_active_rigid_bodies;
+			outStats->mNumActiveSoftBodies = num_active_soft_bodies;
+			outStats->mTotalTime = PhysicsUpdateStats::sGetTime() - stats_start_time;
+		}
 		return EPhysicsUpdateError::None;
 	}
 
@@ -161,9 +182,15 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 	context.mPhysicsSystem = this;
 	context.mJobSystem = inJobSystem;
 	context.mBarrier = inJobSystem->CreateBarrier();
+	if (mPhysicsSettings.mUseJobPriorities)
+	{
+		context.mCriticalJobPriority = EJobPriority::High;
+		context.mBackgroundJobPriority = EJobPriority::Low;
+	}
 	context.mIslandBuilder = &mIslandBuilder;
 	context.mStepDeltaTime = step_delta_time;
 	context.mWarmStartImpulseRatio = warm_start_impulse_ratio;
+	context.mStats = outStats;
 	context.mSteps.resize(inCollisionSteps);
 
 	// Allocate space for body pairs
@@ -175,6 +202,10 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 	mBodyManager.LockAllBodies();
 	mBroadPhase->LockModifications();
 
+	// Bodies that are activated / deactivated from here on woke up / went to sleep during this update
+	uint64 num_activations_at_start = mBodyManager.GetNumActivations();
+	uint64 num_deactivations_at_start = mBodyManager.GetNumDeactivations();
+
 	// Get max number of concurrent jobs
 	int max_concurrency = context.GetMaxConcurrency();
 
@@ -216,6 +247,8 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 			// This job must finish before integrating velocities. Until then the positions will not be updated neither will bodies be added / removed.
 			step.mUpdateBroadphaseFinalize = inJobSystem->CreateJob("UpdateBroadPhaseFinalize", cColorUpdateBroadPhaseFinalize, [&context, &step]()
 				{
+					PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::BroadPhaseFinalize);
+
 					// Validate that all find collision jobs have stopped
 					JPH_ASSERT(step.mActiveFindCollisionJobs == 0);
 
@@ -224,7 +257,7 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 
 					// Signal that it is done
 					step.mPreIntegrateVelocity.RemoveDependency();
-				}, num_find_collisions_jobs + 2); // depends on: find collisions, broadphase prepare update, finish building jobs
+				}, num_find_collisions_jobs + 2, context.mCriticalJobPriority); // depends on: find collisions, broadphase prepare update, finish building jobs
 
 			// The immediate jobs below are only immediate for the first step, the all finished job will kick them for the next step
 			int previous_step_dependency_count = is_first_step? 0 : 1;
@@ -234,12 +267,14 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 			// If this is turned around the RemoveBody call will hang since it locks in that order
 			step.mBroadPhasePrepare = inJobSystem->CreateJob("UpdateBroadPhasePrepare", cColorUpdateBroadPhasePrepare, [&context, &step]()
 				{
+					PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::BroadPhasePrepare);
+
 					// Prepare the broadphase update
-					step.mBroadPhaseUpdateState = context.mPhysicsSystem->mBroadPhase->UpdatePrepare();
+					step.mBroadPhaseUpdateState = context.mPhysicsSystem->mBroadPhase->UpdatePrepare(context.mJobSystem);
 
 					// Now the finalize can run (if other dependencies are met too)
 					step.mUpdateBroadphaseFinalize.RemoveDependency();
-				}, previous_step_dependency_count);
+				}, previous_step_dependency_count, context.mCriticalJobPriority);
 
 			// This job will find all collisions
 			step.mBodyPairQueues.resize(max_concurrency);
@@ -252,6 +287,8 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 				int num_dep_build_islands_from_constraints = i == 0? 1 : 0;
 				step.mFindCollisions[i] = inJobSystem->CreateJob("FindCollisions", cColorFindCollisions, [&step, i]()
 					{
+						PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::FindCollisions);
+
 						step.mContext->mPhysicsSystem->JobFindCollisions(&step, i);
 					}, num_apply_gravity_jobs + num_determine_active_constraints_jobs + 1 + num_dep_build_islands_from_constraints); // depends on: apply gravity, determine active constraints, finish building jobs, build islands from constraints
 			}
@@ -285,6 +322,8 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 			for (int i = 0; i < num_apply_gravity_jobs; ++i)
 				step.mApplyGravity[i] = inJobSystem->CreateJob("ApplyGravity", cColorApplyGravity, [&context, &step]()
 					{
+						PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::ApplyGravity);
+
 						context.mPhysicsSystem->JobApplyGravity(&context, &step);
 
 						JobHandle::sRemoveDependencies(step.mFindCollisions);
@@ -293,25 +332,31 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 			// This job will setup velocity constraints for non-collision constraints
 			step.mSetupVelocityConstraints = inJobSystem->CreateJob("SetupVelocityConstraints", cColorSetupVelocityConstraints, [&context, &step]()
 				{
+					PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::SetupVelocityConstraints);
+
 					context.mPhysicsSystem->JobSetupVelocityConstraints(context.mStepDeltaTime, &step);
 
 					JobHandle::sRemoveDependencies(step.mSolveVelocityConstraints);
-				}, num_determine_active_constraints_jobs + 1); // depends on: determine active constraints, finish building jobs
+				}, num_determine_active_constraints_jobs + 1, context.mCriticalJobPriority); // depends on: determine active constraints, finish building jobs
 
 			// This job will build islands from constraints
 			step.mBuildIslandsFromConstraints = inJobSystem->CreateJob("BuildIslandsFromConstraints", cColorBuildIslandsFromConstraints, [&context, &step]()
 				{
+					PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::BuildIslandsFromConstraints);
+
 					context.mPhysicsSystem->JobBuildIslandsFromConstraints(&context, &step);
 
 					step.mFindCollisions[0].RemoveDependency(); // The first collisions job cannot start running until we've finished building islands and activated all bodies
 					step.mFinalizeIslands.RemoveDependency();
-				}, num_determine_active_constraints_jobs + 1); // depends on: determine active constraints, finish building jobs
+				}, num_determine_active_constraints_jobs + 1, context.mCriticalJobPriority); // depends on: determine active constraints, finish building jobs
 
 			// This job determines active constraints
 			step.mDetermineActiveConstraints.resize(num_determine_active_constraints_jobs);
 			for (int i = 0; i < num_determine_active_constraints_jobs; ++i)
 				step.mDetermineActiveConstraints[i] = inJobSystem->CreateJob("DetermineActiveConstraints", cColorDetermineActiveConstraints, [&context, &step]()
 					{
+						PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::DetermineActiveConstraints);
+
 						context.mPhysicsSystem->JobDetermineActiveConstraints(&step);
 
 						step.mSetupVelocityConstraints.RemoveDependency();
@@ -326,6 +371,8 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 			for (int i = 0; i < num_step_listener_jobs; ++i)
 				step.mStepListeners[i] = inJobSystem->CreateJob("StepListeners", cColorStepListeners, [&context, &step]()
 					{
+						PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::StepListeners);
+
 						// Call the step listeners
 						context.mPhysicsSystem->JobStepListeners(&step);
 
@@ -341,14 +388,23 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 			// This job will finalize the simulation islands
 			step.mFinalizeIslands = inJobSystem->CreateJob("FinalizeIslands", cColorFinalizeIslands, [&context, &step]()
 				{
+					PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::FinalizeIslands);
+
 					// Validate that all find collision jobs have stopped
 					JPH_ASSERT(step.mActiveFindCollisionJobs == 0);
 
 					context.mPhysicsSystem->JobFinalizeIslands(&context);
 
+					// The contacts and islands of this step are known now
+					if (context.mStats != nullptr)
+					{
+						step.mNumContactConstraints = context.mPhysicsSystem->mContactManager.GetNumConstraints();
+						step.mNumIslands = context.mIslandBuilder->GetNumIslands();
+					}
+
 					JobHandle::sRemoveDependencies(step.mSolveVelocityConstraints);
 					step.mBodySetIslandIndex.RemoveDependency();
-				}, num_find_collisions_jobs + 2); // depends on: find collisions, build islands from constraints, finish building jobs
+				}, num_find_collisions_jobs + 2, context.mCriticalJobPriority); // depends on: find collisions, build islands from constraints, finish building jobs
 
 			// Unblock previous job
 			// Note: technically we could release find collisions here but we don't want to because that could make them run before 'setup velocity constraints' which means that job won't have a thread left
@@ -357,21 +413,25 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 			// This job will call the contact removed callbacks
 			step.mContactRemovedCallbacks = inJobSystem->CreateJob("ContactRemovedCallbacks", cColorContactRemovedCallbacks, [&context, &step]()
 				{
+					PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::ContactRemovedCallbacks);
+
 					context.mPhysicsSystem->JobContactRemovedCallbacks(&step);
 
 					if (step.mStartNextStep.IsValid())
 						step.mStartNextStep.RemoveDependency();
-				}, 1); // depends on the find ccd contacts
+				}, 1, is_last_step? context.mBackgroundJobPriority : EJobPriority::Normal); // depends on the find ccd contacts
 
 			// This job will set the island index on each body (only used for debug drawing purposes)
 			// It will also delete any bodies that have been destroyed in the last frame
 			step.mBodySetIslandIndex = inJobSystem->CreateJob("BodySetIslandIndex", cColorBodySetIslandIndex, [&context, &step]()
 				{
+					PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::BodySetIslandIndex);
+
 					context.mPhysicsSystem->JobBodySetIslandIndex();
 
 					if (step.mStartNextStep.IsValid())
 						step.mStartNextStep.RemoveDependency();
-				}, 1); // depends on: finalize islands
+				}, 1, is_last_step? context.mBackgroundJobPriority : EJobPriority::Normal); // depends on: finalize islands
 
 			// Job to start the next collision step
 			if (!is_last_step)
@@ -413,7 +473,7 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 							// Kick the step listeners job first
 							JobHandle::sRemoveDependencies(next_step->mStepListeners);
 						}
-					}, 4); // depends on: update soft bodies, body set island index, contact removed callbacks, finish building the previous step
+					}, 4, context.mCriticalJobPriority); // depends on: update soft bodies, body set island index, contact removed callbacks, finish building the previous step
 			}
 
 			// This job will solve the velocity constraints
@@ -421,10 +481,12 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 			for (int i = 0; i < max_concurrency; ++i)
 				step.mSolveVelocityConstraints[i] = inJobSystem->CreateJob("SolveVelocityConstraints", cColorSolveVelocityConstraints, [&context, &step]()
 					{
+						PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::SolveVelocityConstraints);
+
 						context.mPhysicsSystem->JobSolveVelocityConstraints(&context, &step);
 
 						step.mPreIntegrateVelocity.RemoveDependency();
-					}, 3); // depends on: finalize islands, setup velocity constraints, finish building jobs.
+					}, 3, context.mCriticalJobPriority); // depends on: finalize islands, setup velocity constraints, finish building jobs.
 
 			// Kick find collisions after setup velocity constraints because the former job will use up all CPU cores
 			step.mSetupVelocityConstraints.RemoveDependency();
@@ -436,10 +498,19 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 			// This job will prepare the position update of all active bodies
 			step.mPreIntegrateVelocity = inJobSystem->CreateJob("PreIntegrateVelocity", cColorPreIntegrateVelocity, [&context, &step]()
 				{
+					PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::IntegrateVelocity);
+
+					// All large islands have been split by the velocity solver
+					if (context.mStats != nullptr)
+					{
+						step.mNumLargeIslands = context.mPhysicsSystem->mLargeIslandSplitter.GetNumSplitIslands();
+						step.mNumLargeIslandSplits = context.mPhysicsSystem->mLargeIslandSplitter.GetNumSplits();
+					}
+
 					context.mPhysicsSystem->JobPreIntegrateVelocity(&context, &step);
 
 					JobHandle::sRemoveDependencies(step.mIntegrateVelocity);
-				}, 2 + max_concurrency); // depends on: broadphase update finalize, solve velocity constraints, finish building jobs.
+				}, 2 + max_concurrency, context.mCriticalJobPriority); // depends on: broadphase update finalize, solve velocity constraints, finish building jobs.
 
 			// Unblock previous jobs
 			step.mUpdateBroadphaseFinalize.RemoveDependency();
@@ -450,6 +521,8 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 			for (int i = 0; i < num_integrate_velocity_jobs; ++i)
 				step.mIntegrateVelocity[i] = inJobSystem->CreateJob("IntegrateVelocity", cColorIntegrateVelocity, [&context, &step]()
 					{
+						PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::IntegrateVelocity);
+
 						context.mPhysicsSystem->JobIntegrateVelocity(&context, &step);
 
 						step.mPostIntegrateVelocity.RemoveDependency();
@@ -461,10 +534,12 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 			// This job will finish the position update of all active bodies
 			step.mPostIntegrateVelocity = inJobSystem->CreateJob("PostIntegrateVelocity", cColorPostIntegrateVelocity, [&context, &step]()
 				{
+					PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::IntegrateVelocity);
+
 					context.mPhysicsSystem->JobPostIntegrateVelocity(&context, &step);
 
 					step.mResolveCCDContacts.RemoveDependency();
-				}, num_integrate_velocity_jobs + 1); // depends on: integrate velocity, finish building jobs
+				}, num_integrate_velocity_jobs + 1, context.mCriticalJobPriority); // depends on: integrate velocity, finish building jobs
 
 			// Unblock previous jobs
 			JobHandle::sRemoveDependencies(step.mIntegrateVelocity);
@@ -472,10 +547,12 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 			// This job will update the positions and velocities for all bodies that need continuous collision detection
 			step.mResolveCCDContacts = inJobSystem->CreateJob("ResolveCCDContacts", cColorResolveCCDContacts, [&context, &step]()
 				{
+					PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::ResolveCCDContacts);
+
 					context.mPhysicsSystem->JobResolveCCDContacts(&context, &step);
 
 					JobHandle::sRemoveDependencies(step.mSolvePositionConstraints);
-				}, 2); // depends on: integrate velocities, detect ccd contacts (added dynamically), finish building jobs.
+				}, 2, context.mCriticalJobPriority); // depends on: integrate velocities, detect ccd contacts (added dynamically), finish building jobs.
 
 			// Unblock previous job
 			step.mPostIntegrateVelocity.RemoveDependency();
@@ -485,12 +562,14 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 			for (int i = 0; i < max_concurrency; ++i)
 				step.mSolvePositionConstraints[i] = inJobSystem->CreateJob("SolvePositionConstraints", cColorSolvePositionConstraints, [&context, &step]()
 					{
+						PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::SolvePositionConstraints);
+
 						context.mPhysicsSystem->JobSolvePositionConstraints(&context, &step);
 
 						// Kick the next step
 						if (step.mSoftBodyPrepare.IsValid())
 							step.mSoftBodyPrepare.RemoveDependency();
-					}, 2); // depends on: resolve ccd contacts, finish building jobs.
+					}, 2, context.mCriticalJobPriority); // depends on: resolve ccd contacts, finish building jobs.
 
 			// Unblock previous job.
 			step.mResolveCCDContacts.RemoveDependency();
@@ -498,6 +577,8 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 			// The soft body prepare job will create other jobs if needed
 			step.mSoftBodyPrepare = inJobSystem->CreateJob("SoftBodyPrepare", cColorSoftBodyPrepare, [&context, &step]()
 				{
+					PhysicsUpdateContext::PhaseScope phase(step, EPhysicsUpdatePhase::SoftBodies);
+
 					context.mPhysicsSystem->JobSoftBodyPrepare(&context, &step);
 				}, max_concurrency); // depends on: solve position constraints.
 
@@ -597,6 +678,40 @@ EPhysicsUpdateError PhysicsSystem::Update(float inDeltaTime, int inCollisionStep
 	// Unlock step listeners
 	mStepListenersMutex.unlock();
 
+	// Merge the statistics of all steps
+	if (outStats != nullptr)
+	{
+		outStats->mNumCollisionSteps = uint32(inCollisionSteps);
+		outStats->mNumActiveBodies = mBodyManager.GetNumActiveBodies(EBodyType::RigidBody);
+		outStats->mNumActiveSoftBodies = mBodyManager.GetNumActiveBodies(EBodyType::SoftBody);
+		outStats->mNumBodiesWokeUp = uint32(mBodyManager.GetNumActivations() - num_activations_at_start);
+		outStats->mNumBodiesWentToSleep = uint32(mBodyManager.GetNumDeactivations() - num_deactivations_at_start);
+		for (const PhysicsUpdateContext::Step &step : context.mSteps)
+		{
+			for (int phase = 0; phase < int(EPhysicsUpdatePhase::Count); ++phase)
+			{
+				const PhysicsUpdateContext::PhaseTiming &timing = step.mPhaseTimings[phase];
+				uint32 num_jobs = timing.mNumJobs.load(memory_order_relaxed);
+				if (num_jobs == 0)
+					continue;
+
+				PhysicsUpdateStats::Phase &out_phase = outStats->mPhases[phase];
+				out_phase.mWallTime += timing.mEnd.load(memory_order_relaxed) - timing.mStart.load(memory_order_relaxed);
+				out_phase.mThreadTime += timing.mThreadTime.load(memory_order_relaxed);
+				out_phase.mNumJobs += num_jobs;
+			}
+			outStats->mNumActiveConstraints += step.mNumActiveConstraints.load(memory_order_relaxed);
+			outStats->mNumBodyPairs += step.mNumBodyPairs.load(memory_order_relaxed);
+			outStats->mNumManifolds += step.mNumManifolds.load(memory_order_relaxed);
+			outStats->mNumContactConstraints += step.mNumContactConstraints;
+			outStats->mNumIslands += step.mNumIslands;
+			outStats->mNumLargeIslands += step.mNumLargeIslands;
+			outStats->mNumLargeIslandSplits += step.mNumLargeIslandSplits;
+			outStats->mNumCCDBodies += step.mNumCCDBodies.load(memory_order_relaxed);
+		}
+		outStats->mTotalTime = PhysicsUpdateStats::sGetTime() - stats_start_time;
+	}
+
 	// Return any errors
 	EPhysicsUpdateError errors = static_cast<EPhysicsUpdateError>(context.mErrors.load(memory_order_acquire));
 	JPH_ASSERT(errors == EPhysicsUpdateError::None, "An error occured during the physics update, see EPhysicsUpdateError for more information");
@@ -770,6 +885,8 @@ void PhysicsSystem::TrySpawnJobFindCollisions(PhysicsUpdateContext::Step *ioStep
 					// Start the job
 					JobHandle job = ioStep->mContext->mJobSystem->CreateJob("FindCollisions", cColorFindCollisions, [step = ioStep, job_index]()
 						{
+							PhysicsUpdateContext::PhaseScope phase(*step, EPhysicsUpdatePhase::FindCollisions);
+
 							step->mContext->mPhysicsSystem->JobFindCollisions(step, job_index);
 						});
 
@@ -1560,11 +1677,13 @@ void PhysicsSystem::JobPostIntegrateVelocity(PhysicsUpdateContext *ioContext, Ph
 		{
 			JobHandle job = ioContext->mJobSystem->CreateJob("FindCCDContacts", cColorFindCCDContacts, [ioContext, ioStep]()
 			{
+				PhysicsUpdateContext::PhaseScope phase(*ioStep, EPhysicsUpdatePhase::FindCCDContacts);
+
 				ioContext->mPhysicsSystem->JobFindCCDContacts(ioContext, ioStep);
 
 				ioStep->mResolveCCDContacts.RemoveDependency();
 				ioStep->mContactRemovedCallbacks.RemoveDependency();
-			});
+			}, 0, ioContext->mCriticalJobPriority);
 			ioContext->mBarrier->AddJob(job);
 		}
 	}
@@ -2355,12 +2474,11 @@ void PhysicsSystem::JobSoftBodyPrepare(PhysicsUpdateContext *ioContext, PhysicsU
 		BodyAccess::Grant grant(BodyAccess::EAccess::None, BodyAccess::EAccess::Read);
 	#endif
 
-		// Get the active soft bodies
-		BodyIDVector active_bodies;
-		mBodyManager.GetActiveBodies(EBodyType::SoftBody, active_bodies);
+		// Get the active soft bodies, no bodies can be activated while this job runs
+		uint num_active_bodies = mBodyManager.GetNumActiveBodies(EBodyType::SoftBody);
 
 		// Quit if there are no active soft bodies
-		if (active_bodies.empty())
+		if (num_active_bodies == 0)
 		{
 			// Kick the next step
 			if (ioStep->mStartNextStep.IsValid())
@@ -2368,13 +2486,15 @@ void PhysicsSystem::JobSoftBodyPrepare(PhysicsUpdateContext *ioContext, PhysicsU
 			return;
 		}
 
-		// Sort to get a deterministic update order
-		QuickSort(active_bodies.begin(), active_bodies.end());
-
 		// Allocate soft body contexts
-		ioContext->mNumSoftBodies = (uint)active_bodies.size();
+		ioContext->mNumSoftBodies = num_active_bodies;
 		ioContext->mSoftBodyUpdateContexts = (SoftBodyUpdateContext *)ioContext->mTempAllocator->Allocate(ioContext->mNumSoftBodies * sizeof(SoftBodyUpdateContext));
 
+		// Copy the active bodies to temporary memory (freed before the contexts) and sort them to get a deterministic update order
+		BodyID *active_bodies = (BodyID *)ioContext->mTempAllocator->Allocate(num_active_bodies * sizeof(BodyID));
+		memcpy(active_bodies, mBodyManager.GetActiveBodiesUnsafe(EBodyType::SoftBody), num_active_bodies * sizeof(BodyID));
+		QuickSort(active_bodies, active_bodies + num_active_bodies);
+
 		// Initialize soft body contexts
 		for (SoftBodyUpdateContext *sb_ctx = ioContext->mSoftBodyUpdateContexts, *sb_ctx_end = ioContext->mSoftBodyUpdateContexts + ioContext->mNumSoftBodies; sb_ctx < sb_ctx_end; ++sb_ctx)
 		{
@@ -2383,6 +2503,8 @@ void PhysicsSystem::JobSoftBodyPrepare(PhysicsUpdateContext *ioContext, PhysicsU
 			SoftBodyMotionProperties *mp = static_cast<SoftBodyMotionProperties *>(body.GetMotionProperties());
 			mp->InitializeUpdateContext(ioContext->mStepDeltaTime, body, *this, *sb_ctx);
 		}
+
+		ioContext->mTempAllocator->Free(active_bodies, num_active_bodies * sizeof(BodyID));
 	}
 
 	// We're ready to collide the first soft body
@@ -2394,6 +2516,8 @@ void PhysicsSystem::JobSoftBodyPrepare(PhysicsUpdateContext *ioContext, PhysicsU
 	// Create finalize job
 	ioStep->mSoftBodyFinalize = ioContext->mJobSystem->CreateJob("SoftBodyFinalize", cColorSoftBodyFinalize, [ioContext, ioStep]()
 	{
+		PhysicsUpdateContext::PhaseScope phase(*ioStep, EPhysicsUpdatePhase::SoftBodies);
+
 		ioContext->mPhysicsSystem->JobSoftBodyFinalize(ioContext);
 
 		// Kick the next step
@@ -2407,6 +2531,8 @@ void PhysicsSystem::JobSoftBodyPrepare(PhysicsUpdateContext *ioContext, PhysicsU
 	for (int i = 0; i < num_soft_body_jobs; ++i)
 		ioStep->mSoftBodySimulate[i] = ioContext->mJobSystem->CreateJob("SoftBodySimulate", cColorSoftBodySimulate, [ioStep, i]()
 			{
+				PhysicsUpdateContext::PhaseScope phase(*ioStep, EPhysicsUpdatePhase::SoftBodies);
+
 				ioStep->mContext->mPhysicsSystem->JobSoftBodySimulate(ioStep->mContext, i);
 
 				ioStep->mSoftBodyFinalize.RemoveDependency();
@@ -2418,6 +2544,8 @@ void PhysicsSystem::JobSoftBodyPrepare(PhysicsUpdateContext *ioContext, PhysicsU
 	for (int i = 0; i < num_soft_body_jobs; ++i)
 		ioStep->mSoftBodyCollide[i] = ioContext->mJobSystem->CreateJob("SoftBodyCollide", cColorSoftBodyCollide, [ioContext, ioStep]()
 			{
+				PhysicsUpdateContext::PhaseScope phase(*ioStep, EPhysicsUpdatePhase::SoftBodies);
+
 				ioContext->mPhysicsSystem->JobSoftBodyCollide(ioContext);
 
 				for (const JobHandle &h : ioStep->mSoftBodySimulate)
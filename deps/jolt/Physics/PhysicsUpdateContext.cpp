@@ -20,4 +20,43 @@ PhysicsUpdateContext::~PhysicsUpdateContext()
 	JPH_ASSERT(mActiveConstraints == nullptr);
 }
 
+thread_local PhysicsUpdateContext::PhaseScope *PhysicsUpdateContext::PhaseScope::sActive = nullptr;
+
+void PhysicsUpdateContext::PhaseScope::Start(PhaseTiming &ioTiming)
+{
+	uint64 now = PhysicsUpdateStats::sGetTime();
+
+	// Pause the job that is executing us inline
+	mParent = sActive;
+	if (mParent != nullptr)
+		mParent->mThreadTime += now - mParent->mResume;
+	sActive = this;
+
+	mTiming = &ioTiming;
+	mStart = now;
+	mResume = now;
+}
+
+void PhysicsUpdateContext::PhaseScope::Stop()
+{
+	uint64 now = PhysicsUpdateStats::sGetTime();
+	mThreadTime += now - mResume;
+
+	// Merge into the timing of the phase
+	uint64 start = mTiming->mStart.load(memory_order_relaxed);
+	while (mStart < start && !mTiming->mStart.compare_exchange_weak(start, mStart, memory_order_relaxed))
+		continue;
+	uint64 end = mTiming->mEnd.load(memory_order_relaxed);
+	while (now > end && !mTiming->mEnd.compare_exchange_weak(end, now, memory_order_relaxed))
+		continue;
+	mTiming->mThreadTime.fetch_add(mThreadTime, memory_order_relaxed);
+	mTiming->mNumJobs.fetch_add(1, memory_order_relaxed);
+
+	// Resume the job that executed us
+	JPH_ASSERT(sActive == this);
+	sActive = mParent;
+	if (mParent != nullptr)
+		mParent->mResume = now;
+}
+
 JPH_NAMESPACE_END
@@ -7,6 +7,7 @@
 #include <Jolt/Physics/Body/BodyPair.h>
 #include <Jolt/Physics/Collision/ContactListener.h>
 #include <Jolt/Physics/Collision/BroadPhase/BroadPhase.h>
+#include <Jolt/Physics/PhysicsUpdateStats.h>
 #include <Jolt/Core/StaticArray.h>
 #include <Jolt/Core/JobSystem.h>
 #include <Jolt/Core/STLTempAllocator.h>
@@ -44,6 +45,15 @@ public:
 
 	using BodyPairQueues = StaticArray<BodyPairQueue, cMaxConcurrency>;
 
+	/// Timing of the jobs of a phase during a single step, only filled in when mStats is set
+	struct PhaseTiming
+	{
+		atomic<uint64>		mStart { ~uint64(0) };									///< Start time of the first job that ran
+		atomic<uint64>		mEnd { 0 };												///< End time of the last job that finished
+		atomic<uint64>		mThreadTime { 0 };										///< Time spent in all jobs
+		atomic<uint32>		mNumJobs { 0 };											///< Number of jobs that ran
+	};
+
 	using JobMask = uint32;															///< A mask that has as many bits as we can have concurrent jobs
 	static_assert(sizeof(JobMask) * 8 >= cMaxConcurrency);
 
@@ -86,6 +96,13 @@ public:
 		atomic<uint>		mNumBodyPairs { 0 };									///< The number of body pairs found in this step (used to size the contact cache in the next step)
 		atomic<uint>		mNumManifolds { 0 };									///< The number of manifolds found in this step (used to size the contact cache in the next step)
 
+		uint32				mNumContactConstraints = 0;								///< The number of contact constraints in this step (only stored when mStats is set)
+		uint32				mNumIslands = 0;										///< The number of islands in this step (only stored when mStats is set)
+		uint32				mNumLargeIslands = 0;									///< The number of islands that were split in this step (only stored when mStats is set)
+		uint32				mNumLargeIslandSplits = 0;								///< The number of splits the large islands were split into (only stored when mStats is set)
+
+		PhaseTiming			mPhaseTimings[int(EPhysicsUpdatePhase::Count)];			///< Timing per phase (only stored when mStats is set)
+
 		atomic<uint32>		mSolveVelocityConstraintsNextIsland { 0 };				///< Next island that needs to be processed for the solve velocity constraints step (doesn't need own cache line since position jobs don't run at same time)
 		atomic<uint32>		mSolvePositionConstraintsNextIsland { 0 };				///< Next island that needs to be processed for the solve position constraints step (doesn't need own cache line since velocity jobs don't run at same time)
 
@@ -140,6 +157,27 @@ public:
 
 	using Steps = std::vector<Step, STLTempAllocator<Step>>;
 
+	/// Times a job of a phase when statistics were requested, put one at the top of the job.
+	/// Time spent in jobs that are executed inline by the job (e.g. when kicking a job on a single threaded job system) is not counted towards this job's thread time.
+	class PhaseScope : public NonCopyable
+	{
+	public:
+							PhaseScope(Step &ioStep, EPhysicsUpdatePhase inPhase)	{ if (ioStep.mContext->mStats != nullptr) Start(ioStep.mPhaseTimings[int(inPhase)]); }
+							~PhaseScope()											{ if (mTiming != nullptr) Stop(); }
+
+	private:
+		void				Start(PhaseTiming &ioTiming);
+		void				Stop();
+
+		PhaseTiming *		mTiming = nullptr;
+		PhaseScope *		mParent = nullptr;
+		uint64				mStart = 0;
+		uint64				mResume = 0;
+		uint64				mThreadTime = 0;
+
+		static thread_local PhaseScope *sActive;
+	};
+
 	/// Maximum amount of concurrent jobs on this machine
 	int						GetMaxConcurrency() const								{ const int max_concurrency = PhysicsUpdateContext::cMaxConcurrency; return min(max_concurrency, mJobSystem->GetMaxConcurrency()); } ///< Need to put max concurrency in temp var as min requires a reference
 
@@ -147,10 +185,13 @@ public:
 	TempAllocator *			mTempAllocator;											///< Temporary allocator used during the update
 	JobSystem *				mJobSystem;												///< Job system that processes jobs
 	JobSystem::Barrier *	mBarrier;												///< Barrier used to wait for all physics jobs to complete
+	EJobPriority			mCriticalJobPriority = EJobPriority::Normal;			///< Priority of jobs on the critical path of a step, see PhysicsSettings::mUseJobPriorities
+	EJobPriority			mBackgroundJobPriority = EJobPriority::Normal;			///< Priority of jobs that nothing waits for until the end of the update
 
 	float					mStepDeltaTime;											///< Delta time for a simulation step (collision step)
 	float					mWarmStartImpulseRatio;									///< Ratio of this step delta time vs last step
 	atomic<uint32>			mErrors { 0 };											///< Errors that occurred during the update, actual type is EPhysicsUpdateError
+	PhysicsUpdateStats *	mStats = nullptr;										///< Statistics to fill in, nullptr when they were not requested
 
 	Constraint **			mActiveConstraints = nullptr;							///< Constraints that were active at the start of the physics update step (activating bodies can activate constraints and we need a consistent snapshot). Only these constraints will be resolved.
 
@@ -0,0 +1,47 @@
+// Jolt Physics Library (https://github.com/jrouwe/JoltPhysics)
+// SPDX-License-Identifier: MIT
+
+#include <Jolt/Jolt.h>
+
+#include <Jolt/Physics/PhysicsUpdateStats.h>
+
+JPH_SUPPRESS_WARNINGS_STD_BEGIN
+#include <chrono>
+JPH_SUPPRESS_WARNINGS_STD_END
+
+JPH_NAMESPACE_BEGIN
+
+const char *PhysicsUpdateStats::sGetPhaseName(EPhysicsUpdatePhase inPhase)
+{
+	switch (inPhase)
+	{
+	case EPhysicsUpdatePhase::StepListeners:				return "StepListeners";
+	case EPhysicsUpdatePhase::ApplyGravity:					return "ApplyGravity";
+	case EPhysicsUpdatePhase::DetermineActiveConstraints:	return "DetermineActiveConstraints";
+	case EPhysicsUpdatePhase::BuildIslandsFromConstraints:	return "BuildIslandsFromConstraints";
+	case EPhysicsUpdatePhase::SetupVelocityConstraints:		return "SetupVelocityConstraints";
+	case EPhysicsUpdatePhase::BroadPhasePrepare:			return "BroadPhasePrepare";
+	case EPhysicsUpdatePhase::FindCollisions:				return "FindCollisions";
+	case EPhysicsUpdatePhase::BroadPhaseFinalize:			return "BroadPhaseFinalize";
+	case EPhysicsUpdatePhase::FinalizeIslands:				return "FinalizeIslands";
+	case EPhysicsUpdatePhase::BodySetIslandIndex:			return "BodySetIslandIndex";
+	case EPhysicsUpdatePhase::SolveVelocityConstraints:		return "SolveVelocityConstraints";
+	case EPhysicsUpdatePhase::IntegrateVelocity:			return "IntegrateVelocity";
+	case EPhysicsUpdatePhase::FindCCDContacts:				return "FindCCDContacts";
+	case EPhysicsUpdatePhase::ResolveCCDContacts:			return "ResolveCCDContacts";
+	case EPhysicsUpdatePhase::SolvePositionConstraints:		return "SolvePositionConstraints";
+	case EPhysicsUpdatePhase::ContactRemovedCallbacks:		return "ContactRemovedCallbacks";
+	case EPhysicsUpdatePhase::SoftBodies:					return "SoftBodies";
+	case EPhysicsUpdatePhase::Count:						break;
+	}
+
+	JPH_ASSERT(false);
+	return "Invalid";
+}
+
+uint64 PhysicsUpdateStats::sGetTime()
+{
+	return uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+JPH_NAMESPACE_END
@@ -0,0 +1,72 @@
+// Jolt Physics Library (https://github.com/jrouwe/JoltPhysics)
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+JPH_NAMESPACE_BEGIN
+
+/// The phases of a PhysicsSystem::Update call that are timed when statistics are requested
+enum class EPhysicsUpdatePhase : uint8
+{
+	StepListeners,																	///< Calling the PhysicsStepListeners
+	ApplyGravity,																	///< Applying gravity to the active bodies
+	DetermineActiveConstraints,														///< Collecting the constraints that are active this step
+	BuildIslandsFromConstraints,													///< Linking bodies that share a constraint
+	SetupVelocityConstraints,														///< Calculating constraint properties
+	BroadPhasePrepare,																///< Building the new broad phase tree in the background
+	FindCollisions,																	///< Broad phase pair finding and narrow phase collision detection
+	BroadPhaseFinalize,																///< Swapping in the new broad phase tree
+	FinalizeIslands,																///< Building the simulation islands
+	BodySetIslandIndex,																///< Storing the island index on the bodies and deleting destroyed bodies
+	SolveVelocityConstraints,														///< Velocity solver, including splitting large islands
+	IntegrateVelocity,																///< Pre integrate, integrate and post integrate of the body positions
+	FindCCDContacts,																///< Casting the bodies that use continuous collision detection
+	ResolveCCDContacts,																///< Moving CCD bodies to their time of impact
+	SolvePositionConstraints,														///< Position solver, also updates body bounds and sleeping
+	ContactRemovedCallbacks,														///< Calling ContactListener::OnContactRemoved
+	SoftBodies,																		///< Preparing, colliding, simulating and finalizing the soft bodies
+	Count																			///< Number of phases
+};
+
+/// Statistics of a single PhysicsSystem::Update call, see the outStats parameter of PhysicsSystem::Update.
+/// Jobs only touch the statistics when they start and finish, so requesting them is cheap enough to do every frame.
+/// Times are in nanoseconds and counts are summed over the collision steps of the update unless noted otherwise.
+class JPH_EXPORT PhysicsUpdateStats
+{
+public:
+	/// Timing of the jobs of a single phase
+	struct Phase
+	{
+		uint64				mWallTime = 0;											///< Time from the first job of the phase starting until the last one finishing
+		uint64				mThreadTime = 0;										///< Time spent in the jobs of the phase, summed over all threads
+		uint32				mNumJobs = 0;											///< Number of jobs that executed for the phase
+	};
+
+	/// Get the name of a phase
+	static const char *		sGetPhaseName(EPhysicsUpdatePhase inPhase);
+
+	/// Get the current time in nanoseconds, this is the clock that is used for all timings
+	static uint64			sGetTime();
+
+	/// Access the timing of a phase
+	const Phase &			GetPhase(EPhysicsUpdatePhase inPhase) const				{ return mPhases[int(inPhase)]; }
+
+	uint64					mTotalTime = 0;											///< Time spent in PhysicsSystem::Update
+	uint64					mBroadPhaseFrameSyncTime = 0;							///< Time spent in BroadPhase::FrameSync at the start of the update, this runs on the calling thread before any job starts and is not part of a phase
+	Phase					mPhases[int(EPhysicsUpdatePhase::Count)];				///< Timing per phase
+	uint32					mNumCollisionSteps = 0;									///< Number of collision steps that were simulated (0 if there was nothing to simulate)
+	uint32					mNumActiveBodies = 0;									///< Number of active rigid bodies at the end of the update
+	uint32					mNumActiveSoftBodies = 0;								///< Number of active soft bodies at the end of the update
+	uint32					mNumActiveConstraints = 0;								///< Number of constraints that were solved
+	uint32					mNumBodyPairs = 0;										///< Number of body pairs found by the broad phase that were processed by the narrow phase
+	uint32					mNumManifolds = 0;										///< Number of contact manifolds that were found
+	uint32					mNumContactConstraints = 0;								///< Number of contact constraints that were solved
+	uint32					mNumIslands = 0;										///< Number of simulation islands
+	uint32					mNumLargeIslands = 0;									///< Number of islands that were big enough to be split up by the LargeIslandSplitter
+	uint32					mNumLargeIslandSplits = 0;								///< Number of parallel splits that the large islands were split into
+	uint32					mNumCCDBodies = 0;										///< Number of bodies that needed continuous collision detection
+	uint32					mNumBodiesWokeUp = 0;									///< Number of bodies that were activated during the update
+	uint32					mNumBodiesWentToSleep = 0;								///< Number of bodies that were deactivated during the update
+};
+
+JPH_NAMESPACE_END
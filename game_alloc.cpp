@@ -0,0 +1,326 @@
+//
+// Optional rpmalloc mode (GAME_RPMALLOC): Jolt (JPH::Allocate and friends), ImGui and global operator new/delete use the
+// rpmalloc that ships with Tracy instead of the CRT heap. Every thread gets its own heap with a thread cache on its
+// first allocation; threads we start call alloc_thread_exit() before they return so their heap and cached spans go back
+// to the global cache. The headless bench always compiles rpmalloc so it can compare both.
+//
+
+#if GAME_RPMALLOC || defined(GAME_HEADLESS)
+
+#if defined(TRACY_ENABLE)
+#include "client/tracy_rpmalloc.hpp" // Compiled into tracy.lib
+#else
+// tracy.lib only contains rpmalloc when the profiler is enabled, compile our own copy.
+#define TRACY_ENABLE
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+#pragma warning(push, 0)
+#pragma push_macro("defer") // rpmalloc has variables called `defer`
+#undef defer
+#include "client/tracy_rpmalloc.cpp"
+#pragma pop_macro("defer")
+#pragma warning(pop)
+#undef TRACY_ENABLE
+namespace tracy { thread_local bool RpThreadShutdown = false; } // Normally defined in TracyProfiler.cpp
+#endif
+
+func alloc_rpmalloc_thread_init() -> void
+{
+    // The first call (from the CRT startup code on the main thread) also initializes the global state
+    if (!tracy::rpmalloc_is_thread_initialized()) tracy::rpmalloc_initialize();
+}
+
+// rpmalloc returns 16 byte aligned blocks of any size.
+func alloc_rpmalloc(usize size) -> void*
+{
+    alloc_rpmalloc_thread_init();
+    return tracy::rpmalloc(size);
+}
+
+func alloc_rpfree(void* ptr) -> void
+{
+    tracy::rpfree(ptr);
+}
+
+// tracy.lib doesn't export rpmalloc's aligned functions, so over-allocate and keep the original pointer in front of
+// the aligned block.
+func alloc_rpmalloc_aligned(usize size, usize alignment) -> void*
+{
+    assert((alignment & (alignment - 1)) == 0);
+    alignment = std::max(alignment, sizeof(void*));
+
+    alloc_rpmalloc_thread_init();
+    void* ptr = tracy::rpmalloc(size + alignment - 1 + sizeof(void*));
+    if (ptr == nullptr) return nullptr;
+
+    const usize aligned = (reinterpret_cast<usize>(ptr) + sizeof(void*) + alignment - 1) & ~(alignment - 1);
+    reinterpret_cast<void**>(aligned)[-1] = ptr;
+    return reinterpret_cast<void*>(aligned);
+}
+
+func alloc_rpfree_aligned(void* ptr) -> void
+{
+    if (ptr) tracy::rpfree(reinterpret_cast<void**>(ptr)[-1]);
+}
+
+#endif // GAME_RPMALLOC || GAME_HEADLESS
+
+// Registers the Jolt default allocator, or rpmalloc for Jolt and ImGui in GAME_RPMALLOC mode. Call before the ImGui
+// context and any Jolt object are created.
+func alloc_init() -> void
+{
+    JPH::RegisterDefaultAllocator();
+
+#if GAME_RPMALLOC
+    JPH::Allocate = alloc_rpmalloc;
+    JPH::Free = alloc_rpfree;
+    JPH::AlignedAllocate = alloc_rpmalloc_aligned;
+    JPH::AlignedFree = alloc_rpfree_aligned;
+
+#if !defined(GAME_HEADLESS)
+    ImGui::SetAllocatorFunctions([](usize size, void*) { return alloc_rpmalloc(size); }, [](void* ptr, void*) { alloc_rpfree(ptr); });
+#endif
+    LOG("[alloc] Using rpmalloc for Jolt, ImGui and operator new");
+#endif
+}
+
+// Hands the heap of the calling thread back to rpmalloc, call it last thing on threads we start.
+func alloc_thread_exit() -> void
+{
+#if GAME_RPMALLOC || defined(GAME_HEADLESS)
+    if (tracy::rpmalloc_is_thread_initialized()) tracy::rpmalloc_thread_finalize(1);
+#endif
+}
+
+//
+// Allocation watch: while armed, every JPH::Allocate and JPH::AlignedAllocate is counted per call site (the stack above
+// the hook) so a physics step can be checked for heap use. alloc_watch_install() wraps whatever alloc_init() installed,
+// disarmed that costs an atomic load per allocation. Allocations from every thread count. A worker temp allocator
+// that runs out shows up as TempAllocatorGrowing::AddBlock.
+//
+
+#define ALLOC_WATCH_FRAMES 12
+#define ALLOC_WATCH_MAX_SITES 256 // Power of 2
+
+struct AllocWatchSite
+{
+    void* frames[ALLOC_WATCH_FRAMES];
+    u32 num_frames;
+    u32 count;
+    u64 num_bytes;
+};
+
+struct AllocWatch
+{
+    JPH::AllocateFunction allocate;
+    JPH::AlignedAllocateFunction aligned_allocate;
+    std::atomic<bool> armed;
+    std::atomic<u32> count; // Since alloc_watch_begin()
+
+    // Since alloc_watch_clear()
+    std::atomic_flag lock;
+    u32 num_untracked; // Didn't fit in `sites`
+    AllocWatchSite sites[ALLOC_WATCH_MAX_SITES];
+};
+
+static AllocWatch alloc_watch;
+
+func alloc_watch_capture(void** frames) -> u32
+{
+#if defined(_WIN32)
+    return RtlCaptureStackBackTrace(1, ALLOC_WATCH_FRAMES, frames, nullptr);
+#else
+    void* all[ALLOC_WATCH_FRAMES + 1];
+    const i32 n = backtrace(all, ALLOC_WATCH_FRAMES + 1);
+    if (n <= 1) return 0;
+    memcpy(frames, all + 1, static_cast<usize>(n - 1) * sizeof(void*));
+    return static_cast<u32>(n - 1);
+#endif
+}
+
+func alloc_watch_record(usize size) -> void
+{
+    alloc_watch.count.fetch_add(1, std::memory_order_relaxed);
+
+    void* frames[ALLOC_WATCH_FRAMES];
+    const u32 num_frames = alloc_watch_capture(frames);
+    const u64 hash = JPH::HashBytes(frames, num_frames * static_cast<u32>(sizeof(void*)));
+
+    while (alloc_watch.lock.test_and_set(std::memory_order_acquire)) { std::this_thread::yield(); }
+    defer { alloc_watch.lock.clear(std::memory_order_release); };
+
+    for (u32 i = 0; i < ALLOC_WATCH_MAX_SITES; ++i) {
+        AllocWatchSite* site = &alloc_watch.sites[(hash + i) & (ALLOC_WATCH_MAX_SITES - 1)];
+        if (site->count == 0) {
+            memcpy(site->frames, frames, num_frames * sizeof(void*));
+            site->num_frames = num_frames;
+            site->count = 1;
+            site->num_bytes = size;
+            return;
+        }
+        if (site->num_frames == num_frames && memcmp(site->frames, frames, num_frames * sizeof(void*)) == 0) {
+            site->count += 1;
+            site->num_bytes += size;
+            return;
+        }
+    }
+    alloc_watch.num_untracked += 1;
+}
+
+func alloc_watch_allocate(usize size) -> void*
+{
+    if (alloc_watch.armed.load(std::memory_order_relaxed)) alloc_watch_record(size);
+    return alloc_watch.allocate(size);
+}
+
+func alloc_watch_aligned_allocate(usize size, usize alignment) -> void*
+{
+    if (alloc_watch.armed.load(std::memory_order_relaxed)) alloc_watch_record(size);
+    return alloc_watch.aligned_allocate(size, alignment);
+}
+
+// Call after alloc_init() while no other thread uses Jolt
+func alloc_watch_install() -> void
+{
+    alloc_watch.allocate = JPH::Allocate;
+    alloc_watch.aligned_allocate = JPH::AlignedAllocate;
+    JPH::Allocate = alloc_watch_allocate;
+    JPH::AlignedAllocate = alloc_watch_aligned_allocate;
+}
+
+func alloc_watch_uninstall() -> void
+{
+    JPH::Allocate = alloc_watch.allocate;
+    JPH::AlignedAllocate = alloc_watch.aligned_allocate;
+}
+
+func alloc_watch_begin() -> void
+{
+    alloc_watch.count.store(0, std::memory_order_relaxed);
+    alloc_watch.armed.store(true, std::memory_order_relaxed);
+}
+
+// Returns the number of allocations since alloc_watch_begin()
+func alloc_watch_end() -> u32
+{
+    alloc_watch.armed.store(false, std::memory_order_relaxed);
+    return alloc_watch.count.load(std::memory_order_relaxed);
+}
+
+func alloc_watch_clear() -> void
+{
+    while (alloc_watch.lock.test_and_set(std::memory_order_acquire)) { std::this_thread::yield(); }
+    memset(alloc_watch.sites, 0, sizeof(alloc_watch.sites));
+    alloc_watch.num_untracked = 0;
+    alloc_watch.lock.clear(std::memory_order_release);
+}
+
+func alloc_watch_symbol(void* address, char* name, usize size) -> void
+{
+#if defined(_WIN32)
+    const HANDLE process = GetCurrentProcess();
+    static const bool initialized = [process]() {
+        SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS | SYMOPT_LOAD_LINES);
+        return SymInitialize(process, nullptr, TRUE) == TRUE;
+    }();
+
+    alignas(SYMBOL_INFO) char buffer[sizeof(SYMBOL_INFO) + 256];
+    SYMBOL_INFO* symbol = reinterpret_cast<SYMBOL_INFO*>(buffer);
+    symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+    symbol->MaxNameLen = 256;
+    DWORD64 displacement = 0;
+    if (!initialized || !SymFromAddr(process, reinterpret_cast<DWORD64>(address), &displacement, symbol)) {
+        snprintf(name, size, "%p", address);
+        return;
+    }
+
+    IMAGEHLP_LINE64 line = {};
+    line.SizeOfStruct = sizeof(line);
+    DWORD line_displacement = 0;
+    if (SymGetLineFromAddr64(process, reinterpret_cast<DWORD64>(address), &line_displacement, &line)) {
+        snprintf(name, size, "%s (%s:%lu)", symbol->Name, line.FileName, line.LineNumber);
+    } else {
+        snprintf(name, size, "%s+0x%llx", symbol->Name, static_cast<unsigned long long>(displacement));
+    }
+#else
+    char** symbols = backtrace_symbols(&address, 1);
+    snprintf(name, size, "%s", symbols ? symbols[0] : "?");
+    free(symbols);
+#endif
+}
+
+// Logs the call sites recorded since alloc_watch_clear(), most allocations first
+func alloc_watch_report(const char* prefix) -> void
+{
+    std::vector<AllocWatchSite> sites;
+    while (alloc_watch.lock.test_and_set(std::memory_order_acquire)) { std::this_thread::yield(); }
+    for (const AllocWatchSite& site : alloc_watch.sites) {
+        if (site.count > 0) sites.push_back(site);
+    }
+    const u32 num_untracked = alloc_watch.num_untracked;
+    alloc_watch.lock.clear(std::memory_order_release);
+
+    std::sort(sites.begin(), sites.end(), [](const AllocWatchSite& a, const AllocWatchSite& b) { return a.count > b.count; });
+    for (const AllocWatchSite& site : sites) {
+        LOG("%s %u allocations, %llu bytes from:", prefix, site.count, static_cast<unsigned long long>(site.num_bytes));
+        for (u32 i = 0; i < site.num_frames; ++i) {
+            char name[512];
+            alloc_watch_symbol(site.frames[i], name, sizeof(name));
+            LOG("%s     %s", prefix, name);
+        }
+    }
+    if (num_untracked > 0) LOG("%s %u allocations from more call sites than fit in the table", prefix, num_untracked);
+}
+
+#if GAME_RPMALLOC
+
+void* operator new(usize size)
+{
+    void* ptr = alloc_rpmalloc(size);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](usize size)
+{
+    void* ptr = alloc_rpmalloc(size);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(usize size, const std::nothrow_t&) noexcept { return alloc_rpmalloc(size); }
+void* operator new[](usize size, const std::nothrow_t&) noexcept { return alloc_rpmalloc(size); }
+
+void* operator new(usize size, std::align_val_t alignment)
+{
+    void* ptr = alloc_rpmalloc_aligned(size, static_cast<usize>(alignment));
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](usize size, std::align_val_t alignment)
+{
+    void* ptr = alloc_rpmalloc_aligned(size, static_cast<usize>(alignment));
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(usize size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return alloc_rpmalloc_aligned(size, static_cast<usize>(alignment)); }
+void* operator new[](usize size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return alloc_rpmalloc_aligned(size, static_cast<usize>(alignment)); }
+
+void operator delete(void* ptr) noexcept { alloc_rpfree(ptr); }
+void operator delete[](void* ptr) noexcept { alloc_rpfree(ptr); }
+void operator delete(void* ptr, usize) noexcept { alloc_rpfree(ptr); }
+void operator delete[](void* ptr, usize) noexcept { alloc_rpfree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { alloc_rpfree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { alloc_rpfree(ptr); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept { alloc_rpfree_aligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { alloc_rpfree_aligned(ptr); }
+void operator delete(void* ptr, usize, std::align_val_t) noexcept { alloc_rpfree_aligned(ptr); }
+void operator delete[](void* ptr, usize, std::align_val_t) noexcept { alloc_rpfree_aligned(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { alloc_rpfree_aligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { alloc_rpfree_aligned(ptr); }
+
+#endif // GAME_RPMALLOC
@@ -0,0 +1,2531 @@
+// Headless benchmarks. Built without the window, D3D12 and ImGui backends (`build.bat bench`).
+// Usage: game_bench.exe [benchmark_name_filter] [options]
+//
+// Options for the physics benchmarks (see bench_physics, bench_zero_alloc, bench_determinism, bench_thread_tuner, bench_broad_phase and bench_sweep_and_prune):
+//   --scenes=box_pyramid,terrain  Scenes to run, all of game_scenes.cpp by default
+//   --bodies=1000,4000            Body counts, two per scene by default
+//   --threads=1,4                 Thread counts including the calling thread, 1 and all hardware threads by default
+//   --steps=120                   Measured steps per run
+//   --json=results.json           Write the results
+//   --baseline=baseline.json      Compare against results written earlier on the same machine, exits with 1 when a run got slower
+//   --tolerance=0.1               How much slower than the baseline a run may be
+
+#include "game_pch.h"
+#include "game_main.h"
+#include "game_cpp_hlsl_common.h"
+#include "game_alloc.cpp"
+#include "game_profile.cpp"
+#include "game_physics.cpp"
+#include "game_fracture.cpp"
+#include "game_stroke.cpp"
+#include "game_sim.cpp"
+#include "game_text.cpp"
+#include "game_task.cpp"
+#include "game_scenes.cpp"
+
+func bench_time() -> f64
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct BenchOptions
+{
+    std::vector<u32> scenes; // SceneType, empty for all
+    std::vector<u32> bodies; // Empty for SceneInfo::default_bodies
+    std::vector<u32> threads; // Empty for 1 and std::thread::hardware_concurrency()
+    u32 num_steps;
+    const char* json_path;
+    const char* baseline_path;
+    f64 tolerance;
+};
+
+struct BenchContext
+{
+    JPH::TempAllocatorGrowing* temp_allocator;
+    JPH::JobSystemThreadPool* job_system;
+    ObjectLayerPairFilter* object_layer_pair_filter;
+    BroadPhaseLayerInterface* broad_phase_layer_interface;
+    ObjectVsBroadPhaseLayerFilter* object_vs_broad_phase_layer_filter;
+    const BenchOptions* options;
+    bool failed; // Set by a benchmark that checks something, main() returns 1
+};
+
+func bench_create_physics_system(BenchContext* ctx, u32 max_bodies) -> JPH::PhysicsSystem*
+{
+    auto physics_system = new JPH::PhysicsSystem();
+    physics_system->Init(max_bodies, PHY_NUM_BODY_MUTEXES, max_bodies, max_bodies, *ctx->broad_phase_layer_interface, *ctx->object_vs_broad_phase_layer_filter, *ctx->object_layer_pair_filter, BROAD_PHASE_TYPE);
+    return physics_system;
+}
+
+//
+// Fracture: pieces spawned per millisecond, pooled + precomputed patterns vs. building hulls and bodies on the fly.
+//
+func bench_fracture(BenchContext* ctx) -> void
+{
+    constexpr u32 num_fractures = 256;
+    constexpr u32 num_cells = 12;
+
+    JPH::PhysicsSystem* physics_system = bench_create_physics_system(ctx, num_fractures * FRACTURE_MAX_CELLS);
+    defer { delete physics_system; };
+
+    std::vector<CppHlsl_Vertex> vertices;
+    std::vector<StaticMesh> meshes;
+
+    FractureSystem fs = {};
+    init_fracture_system(&fs, physics_system, num_fractures * num_cells);
+    defer { shutdown_fracture_system(&fs); };
+
+    const std::vector<CppHlsl_Vertex> outline = fracture_outline_round_rect(1.0f, 1.0f, 0.25f, 8);
+
+    const f64 precompute_begin = bench_time();
+    const u32 shape_index = fracture_add_shape(&fs, outline, num_cells, &vertices, &meshes);
+    const f64 precompute_time = bench_time() - precompute_begin;
+
+    std::vector<FracturePiece> pieces;
+    pieces.reserve(num_fractures * FRACTURE_MAX_CELLS);
+
+    std::vector<JPH::BodyID> release;
+    release.reserve(num_fractures * FRACTURE_MAX_CELLS);
+
+    // Pooled path
+    f64 pooled_time = 0.0;
+    u32 num_pooled = 0;
+    for (u32 round = 0; round < 4; ++round) {
+        pieces.clear();
+
+        const f64 begin = bench_time();
+        for (u32 i = 0; i < num_fractures; ++i) {
+            const f32 x = static_cast<f32>(i % 16) * 2.0f;
+            const f32 y = static_cast<f32>(i / 16) * 2.0f;
+            num_pooled += fracture_spawn(&fs, shape_index, x, y, 0.1f * static_cast<f32>(i), x + 0.2f, y - 0.1f, JPH::Vec3::sZero(), 1.0f, &pieces);
+        }
+        pooled_time += bench_time() - begin;
+
+        release.clear();
+        for (const FracturePiece& piece : pieces) release.push_back(piece.body_id);
+        fracture_release(&fs, release.data(), static_cast<u32>(release.size()));
+    }
+
+    // Unpooled path: what fracturing costs without precomputed patterns and the body pool
+    f64 unpooled_time = 0.0;
+    u32 num_unpooled = 0;
+    {
+        JPH::BodyInterface& bi = physics_system->GetBodyInterfaceNoLock();
+        std::vector<CppHlsl_Vertex> scratch_vertices;
+        std::vector<StaticMesh> scratch_meshes;
+        FracturePattern pattern;
+
+        for (u32 round = 0; round < 4; ++round) {
+            release.clear();
+
+            const f64 begin = bench_time();
+            for (u32 i = 0; i < num_fractures; ++i) {
+                const f32 x = static_cast<f32>(i % 16) * 2.0f;
+                const f32 y = static_cast<f32>(i / 16) * 2.0f;
+
+                scratch_vertices.clear();
+                scratch_meshes.clear();
+                fracture_build_pattern(outline, num_cells, 0.2f, -0.1f, 0x1234567u + i, &scratch_vertices, &scratch_meshes, &pattern);
+
+                for (const FractureCell& cell : pattern.cells) {
+                    JPH::BodyCreationSettings settings(cell.shape, JPH::RVec3(x + cell.x, y + cell.y, 0.0f), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, OBJECT_LAYER_MOVING);
+                    settings.mAllowedDOFs = JPH::EAllowedDOFs::Plane2D;
+                    release.push_back(bi.CreateAndAddBody(settings, JPH::EActivation::Activate));
+                    num_unpooled += 1;
+                }
+            }
+            unpooled_time += bench_time() - begin;
+
+            bi.RemoveBodies(release.data(), static_cast<i32>(release.size()));
+            bi.DestroyBodies(release.data(), static_cast<i32>(release.size()));
+        }
+    }
+
+    LOG("[bench] fracture: precompute %d patterns: %.3f ms", FRACTURE_NUM_VARIANTS, precompute_time * 1000.0);
+    LOG("[bench] fracture: pooled   %8.1f pieces/ms (%d pieces, %.3f ms)", num_pooled / (pooled_time * 1000.0), num_pooled, pooled_time * 1000.0);
+    LOG("[bench] fracture: unpooled %8.1f pieces/ms (%d pieces, %.3f ms)", num_unpooled / (unpooled_time * 1000.0), num_unpooled, unpooled_time * 1000.0);
+}
+
+//
+// Stroke: paths tessellated per millisecond with a cold cache (single thread and job-parallel) and a warm cache.
+//
+func bench_stroke(BenchContext* ctx) -> void
+{
+    constexpr u32 num_paths = 1024;
+    constexpr u32 num_rounds = 8;
+
+    // Random wobbly polylines, 16..143 points each.
+    std::vector<std::vector<CppHlsl_Vertex>> points(num_paths);
+    std::vector<StrokePath> paths(num_paths);
+    u32 random_state = 0x9e3779b9;
+    for (u32 i = 0; i < num_paths; ++i) {
+        const u32 num_points = 16 + (i * 7) % 128;
+        f32 x = 0.0f, y = 0.0f, angle = 0.0f;
+        for (u32 j = 0; j < num_points; ++j) {
+            angle += 1.5f * (fracture_random(&random_state) - 0.5f);
+            x += 0.1f * cosf(angle);
+            y += 0.1f * sinf(angle);
+            points[i].push_back({ x, y });
+        }
+        paths[i] = {
+            .points = points[i].data(),
+            .num_points = num_points,
+            .style = {
+                .width = 0.05f + 0.01f * static_cast<f32>(i % 4),
+                .miter_limit = 4.0f,
+                .tolerance = 0.005f,
+                .join = i % 3,
+                .cap = (i / 3) % 3,
+                .closed = i % 5 == 0 ? 1u : 0u,
+            },
+            .vertices = nullptr,
+        };
+    }
+
+    auto run = [&](JPH::JobSystem* job_system, bool is_cold) -> f64 {
+        StrokeCache cache;
+        init_stroke_cache(&cache, num_paths);
+        if (!is_cold) stroke_paths(&cache, job_system, paths.data(), num_paths);
+
+        f64 time = 0.0;
+        for (u32 round = 0; round < num_rounds; ++round) {
+            if (is_cold) init_stroke_cache(&cache, num_paths);
+
+            const f64 begin = bench_time();
+            stroke_paths(&cache, job_system, paths.data(), num_paths);
+            time += bench_time() - begin;
+        }
+        return time;
+    };
+
+    const f64 cold_st = run(nullptr, true);
+    const f64 cold_mt = run(ctx->job_system, true);
+    const f64 warm = run(ctx->job_system, false);
+
+    // Vertex count of one full tessellation
+    StrokeCache cache;
+    init_stroke_cache(&cache, num_paths);
+    stroke_paths(&cache, ctx->job_system, paths.data(), num_paths);
+    usize num_vertices = 0;
+    for (const StrokePath& path : paths) num_vertices += path.vertices->size();
+
+    const f64 num_total = static_cast<f64>(num_paths * num_rounds);
+    LOG("[bench] stroke: %d paths, %d vertices per batch", num_paths, static_cast<i32>(num_vertices));
+    LOG("[bench] stroke: cold 1 thread  %8.1f paths/ms", num_total / (cold_st * 1000.0));
+    LOG("[bench] stroke: cold %d threads %8.1f paths/ms", ctx->job_system->GetMaxConcurrency(), num_total / (cold_mt * 1000.0));
+    LOG("[bench] stroke: warm cache     %8.1f paths/ms", num_total / (warm * 1000.0));
+}
+
+//
+// Simulation thread handoff: SPSC queue round trips and throughput, snapshot publish cost and end-to-end command
+// latency through a free-running simulation thread.
+//
+func bench_sim(BenchContext* ctx) -> void
+{
+    using Queue = SpscQueue<SimCommand, SIM_COMMAND_QUEUE_SIZE>;
+
+    // Ping-pong: every command is echoed back by the other thread
+    {
+        constexpr u32 num_round_trips = 100 * 1000;
+
+        auto ping = new Queue();
+        auto pong = new Queue();
+        defer { delete ping; delete pong; };
+
+        std::thread echo([ping, pong]() {
+            SimCommand cmd;
+            for (u32 i = 0; i < num_round_trips; ++i) {
+                while (!spsc_pop(ping, &cmd)) { std::this_thread::yield(); }
+                while (!spsc_push(pong, cmd)) { std::this_thread::yield(); }
+            }
+        });
+
+        const f64 begin = bench_time();
+        for (u32 i = 0; i < num_round_trips; ++i) {
+            SimCommand cmd = { .id = i };
+            while (!spsc_push(ping, cmd)) { std::this_thread::yield(); }
+            while (!spsc_pop(pong, &cmd)) { std::this_thread::yield(); }
+            assert(cmd.id == i);
+        }
+        const f64 time = bench_time() - begin;
+        echo.join();
+
+        LOG("[bench] sim: queue round trip %8.1f ns", time * 1.0e9 / num_round_trips);
+    }
+
+    // One way throughput
+    {
+        constexpr u32 num_commands = 4 * 1000 * 1000;
+
+        auto queue = new Queue();
+        defer { delete queue; };
+
+        const f64 begin = bench_time();
+        std::thread consumer([queue]() {
+            SimCommand cmd;
+            for (u32 i = 0; i < num_commands; ++i) {
+                while (!spsc_pop(queue, &cmd)) { std::this_thread::yield(); }
+                assert(cmd.id == i);
+            }
+        });
+        for (u32 i = 0; i < num_commands; ++i) {
+            const SimCommand cmd = { .id = i };
+            while (!spsc_push(queue, cmd)) { std::this_thread::yield(); }
+        }
+        consumer.join();
+        const f64 time = bench_time() - begin;
+
+        LOG("[bench] sim: queue throughput %8.1f M commands/s", num_commands / (time * 1.0e6));
+    }
+
+    // Snapshot publishing with a full object array while another thread keeps acquiring
+    {
+        constexpr u32 num_publishes = 20 * 1000;
+
+        auto tb = new TripleBuffer<SimSnapshot>();
+        defer { delete tb; };
+        init_triple_buffer(tb);
+
+        std::atomic<bool> done = false;
+        u64 num_acquired = 0;
+        std::thread consumer([tb, &done, &num_acquired]() {
+            u64 last_step = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                bool is_new;
+                const SimSnapshot* snapshot = triple_buffer_acquire(tb, &is_new);
+                if (!is_new) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                assert(snapshot->step_index > last_step);
+                last_step = snapshot->step_index;
+                num_acquired += 1;
+            }
+        });
+
+        const f64 begin = bench_time();
+        for (u32 i = 0; i < num_publishes; ++i) {
+            SimSnapshot* snapshot = triple_buffer_back(tb);
+            snapshot->step_index = i + 1;
+            snapshot->num_objects = SIM_MAX_OBJECTS;
+            std::fill_n(snapshot->objects, SIM_MAX_OBJECTS, Object{});
+            std::fill_n(snapshot->cpp_hlsl_objects, SIM_MAX_OBJECTS, CppHlsl_Object{});
+            triple_buffer_publish(tb);
+        }
+        const f64 time = bench_time() - begin;
+        done.store(true, std::memory_order_relaxed);
+        consumer.join();
+
+        LOG("[bench] sim: snapshot publish %8.1f us (%d KB, %d of %d acquired)", time * 1.0e6 / num_publishes, static_cast<i32>(sizeof(SimSnapshot) / 1024), static_cast<i32>(num_acquired), num_publishes);
+    }
+
+    // Free-running simulation thread: shatter and respawn a round rect, measure command to snapshot latency
+    {
+        constexpr u32 num_commands = 200;
+
+        JPH::PhysicsSystem* physics_system = bench_create_physics_system(ctx, 1024);
+        defer { delete physics_system; };
+
+        FractureSystem fs = {};
+        init_fracture_system(&fs, physics_system, 256);
+        defer { shutdown_fracture_system(&fs); };
+
+        std::vector<CppHlsl_Vertex> vertices;
+        std::vector<StaticMesh> meshes(1);
+        const u32 shape_index = fracture_add_shape(&fs, fracture_outline_round_rect(1.0f, 1.0f, 0.25f, 8), 12, &vertices, &meshes);
+
+        auto sim = new SimState();
+        defer { delete sim; };
+        init_sim(sim, physics_system, ctx->temp_allocator, ctx->job_system, &fs, 0.0f, -10.0f);
+        sim->job_pool = ctx->job_system;
+        sim->objects.push_back({ .mesh_index = 0 });
+        sim->cpp_hlsl_objects.push_back({});
+        sim_start(sim);
+
+        f64 latency = 0.0;
+        f64 max_latency = 0.0;
+        const f64 begin = bench_time();
+        const u64 first_step = triple_buffer_acquire(&sim->snapshots)->step_index;
+
+        for (u32 i = 0; i < num_commands; ++i) {
+            const SimCommand cmd = {
+                .id = i + 1,
+                .type = (i % 2) == 0 ? SIM_COMMAND_SHATTER : SIM_COMMAND_SPAWN_OBJECT,
+                .mesh_index = 0,
+                .fracture_shape = shape_index,
+            };
+            const f64 push_time = bench_time();
+            while (!sim_push_command(sim, cmd)) { std::this_thread::yield(); }
+            while (triple_buffer_acquire(&sim->snapshots)->last_command_id < cmd.id) { std::this_thread::yield(); }
+
+            const f64 t = bench_time() - push_time;
+            latency += t;
+            max_latency = std::max(max_latency, t);
+        }
+
+        const u64 num_steps = triple_buffer_acquire(&sim->snapshots)->step_index - first_step;
+        const f64 time = bench_time() - begin;
+        sim_stop(sim);
+
+        LOG("[bench] sim: thread %8.1f steps/s, command latency avg %.3f ms, max %.3f ms", static_cast<f64>(num_steps) / time, latency * 1000.0 / num_commands, max_latency * 1000.0);
+    }
+}
+
+//
+// Text: SDF atlas generation (single thread vs. one job per glyph), cache load, and label layout throughput.
+// Run from the repository root so `assets/` is found.
+//
+func bench_text(BenchContext* ctx) -> void
+{
+    const std::vector<u8> font_data = text_read_file("assets/Roboto-Medium.ttf");
+    if (font_data.empty()) {
+        LOG("[bench] text: assets/Roboto-Medium.ttf not found, skipping");
+        return;
+    }
+
+    auto atlas = new TextAtlas();
+    defer { delete atlas; };
+
+    f64 begin = bench_time();
+    build_text_atlas(atlas, font_data, nullptr);
+    const f64 build_st = bench_time() - begin;
+
+    begin = bench_time();
+    build_text_atlas(atlas, font_data, ctx->job_system);
+    const f64 build_mt = bench_time() - begin;
+
+    // Cache round trip
+    char path[256];
+    text_atlas_cache_path("assets", atlas->header.key, path, sizeof(path));
+    write_text_atlas_cache(atlas, path);
+
+    auto cached = new TextAtlas();
+    defer { delete cached; };
+
+    begin = bench_time();
+    const u64 key = text_atlas_key(text_read_file("assets/Roboto-Medium.ttf"));
+    const bool is_loaded = read_text_atlas_cache(cached, path, key);
+    const f64 load_time = bench_time() - begin;
+
+    const bool is_same = is_loaded && cached->pixels == atlas->pixels && memcmp(cached->glyphs, atlas->glyphs, sizeof(atlas->glyphs)) == 0;
+
+    // Layout
+    constexpr u32 num_labels = 10 * 1000;
+    std::vector<CppHlsl_Glyph> glyphs;
+    glyphs.reserve(num_labels * 16);
+
+    char label[32];
+    begin = bench_time();
+    for (u32 i = 0; i < num_labels; ++i) {
+        snprintf(label, sizeof(label), "Body %u", i);
+        const f32 w = text_measure(atlas, label, 0.25f);
+        text_layout(atlas, label, static_cast<f32>(i % 100) - 0.5f * w, static_cast<f32>(i / 100), 0.25f, 0xffffffff, glyphs.capacity(), &glyphs);
+    }
+    const f64 layout_time = bench_time() - begin;
+
+    LOG("[bench] text: atlas %dx%d, %d glyphs, cache %s", atlas->header.width, atlas->header.height, TEXT_NUM_CHARS, is_same ? "matches" : "MISMATCH");
+    LOG("[bench] text: build 1 thread  %8.3f ms", build_st * 1000.0);
+    LOG("[bench] text: build %d threads %8.3f ms", ctx->job_system->GetMaxConcurrency(), build_mt * 1000.0);
+    LOG("[bench] text: cache load      %8.3f ms", load_time * 1000.0);
+    LOG("[bench] text: layout %d labels, %d glyphs: %.3f ms", num_labels, static_cast<i32>(glyphs.size()), layout_time * 1000.0);
+}
+
+// Static floor plus a grid of dynamic boxes falling onto it.
+func bench_add_box_pile(JPH::PhysicsSystem* physics_system, u32 num_boxes) -> void
+{
+    JPH::BodyInterface& bi = physics_system->GetBodyInterfaceNoLock();
+
+    JPH::BodyCreationSettings floor(new JPH::BoxShape(JPH::Vec3(200.0f, 1.0f, 1.0f)), JPH::RVec3(0.0f, -1.0f, 0.0f), JPH::Quat::sIdentity(), JPH::EMotionType::Static, OBJECT_LAYER_NON_MOVING);
+    bi.CreateAndAddBody(floor, JPH::EActivation::DontActivate);
+
+    JPH::RefConst<JPH::Shape> box = new JPH::BoxShape(JPH::Vec3(0.4f, 0.4f, 0.4f));
+    for (u32 i = 0; i < num_boxes; ++i) {
+        const f32 x = static_cast<f32>(i % 64) - 32.0f;
+        const f32 y = 1.0f + static_cast<f32>(i / 64);
+        JPH::BodyCreationSettings settings(box, JPH::RVec3(x, y, 0.0f), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, OBJECT_LAYER_MOVING);
+        settings.mAllowedDOFs = JPH::EAllowedDOFs::Plane2D;
+        bi.CreateAndAddBody(settings, JPH::EActivation::Activate);
+    }
+    physics_system->OptimizeBroadPhase();
+}
+
+//
+// Jobs: JobSystemThreadPool vs. JobSystemWorkStealing. Throughput of independent small jobs, hop latency through a
+// chain of dependent jobs, and physics step time of a box pile, at 1..64 worker threads. The pool's own stats show
+// where its time went.
+//
+func bench_jobs_run(BenchContext* ctx, JPH::JobSystem* js, f64* out_jobs_per_ms, f64* out_hop_us, f64* out_step_ms) -> void
+{
+    std::atomic<u64> sink = 0;
+    auto work = [&sink](u64 seed) {
+        u64 h = seed;
+        for (u32 i = 0; i < 256; ++i) h = h * 6364136223846793005ull + 1442695040888963407ull;
+        sink.fetch_add(h, std::memory_order_relaxed);
+    };
+
+    // Throughput
+    {
+        constexpr u32 num_rounds = 64;
+        constexpr u32 num_jobs = 1024;
+
+        const f64 begin = bench_time();
+        for (u32 round = 0; round < num_rounds; ++round) {
+            JPH::JobSystem::Barrier* barrier = js->CreateBarrier();
+            for (u32 i = 0; i < num_jobs; ++i) {
+                barrier->AddJob(js->CreateJob("BenchJob", JPH::Color::sGreen, [&work, i]() { work(i); }));
+            }
+            js->WaitForJobs(barrier);
+            js->DestroyBarrier(barrier);
+        }
+        *out_jobs_per_ms = num_rounds * num_jobs / ((bench_time() - begin) * 1000.0);
+    }
+
+    // Latency: each job releases the next one when it finishes
+    {
+        constexpr u32 num_rounds = 16;
+        constexpr u32 chain_length = 256;
+
+        std::vector<JPH::JobHandle> chain(chain_length);
+        const f64 begin = bench_time();
+        for (u32 round = 0; round < num_rounds; ++round) {
+            for (u32 i = chain_length; i-- > 0;) {
+                JPH::JobHandle next = i + 1 < chain_length ? chain[i + 1] : JPH::JobHandle();
+                chain[i] = js->CreateJob("BenchChain", JPH::Color::sYellow, [&work, next, i]() {
+                    work(i);
+                    if (next.IsValid()) next.RemoveDependency();
+                }, i == 0 ? 0 : 1);
+            }
+
+            JPH::JobSystem::Barrier* barrier = js->CreateBarrier();
+            barrier->AddJobs(chain.data(), chain_length);
+            js->WaitForJobs(barrier);
+            js->DestroyBarrier(barrier);
+        }
+        *out_hop_us = (bench_time() - begin) * 1.0e6 / (num_rounds * chain_length);
+    }
+
+    // Physics step
+    {
+        constexpr u32 num_warmup_steps = 30;
+        constexpr u32 num_steps = 60;
+
+        JPH::PhysicsSystem* physics_system = bench_create_physics_system(ctx, 4096);
+        defer { delete physics_system; };
+        bench_add_box_pile(physics_system, 2000);
+
+        for (u32 i = 0; i < num_warmup_steps; ++i) physics_system->Update(PHY_FIXED_TIME_STEP, 1, ctx->temp_allocator, js);
+
+        const f64 begin = bench_time();
+        for (u32 i = 0; i < num_steps; ++i) physics_system->Update(PHY_FIXED_TIME_STEP, 1, ctx->temp_allocator, js);
+        *out_step_ms = (bench_time() - begin) * 1000.0 / num_steps;
+    }
+}
+
+func bench_jobs(BenchContext* ctx) -> void
+{
+    LOG("[bench] jobs: %d hardware threads", static_cast<i32>(std::thread::hardware_concurrency()));
+    LOG("[bench] jobs: threads | pool jobs/ms  hop us  step ms | stealing jobs/ms  hop us  step ms");
+
+    for (i32 num_threads = 1; num_threads <= 64; num_threads *= 2) {
+        f64 pool_throughput, pool_hop, pool_step;
+        JPH::JobSystemThreadPool::Stats pool_stats;
+        {
+            auto js = new JPH::JobSystemThreadPool(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, num_threads);
+            defer { delete js; };
+            bench_jobs_run(ctx, js, &pool_throughput, &pool_hop, &pool_step);
+            js->GetStats(pool_stats);
+        }
+
+        f64 ws_throughput, ws_hop, ws_step;
+        {
+            auto js = new JPH::JobSystemWorkStealing(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, num_threads);
+            defer { delete js; };
+            bench_jobs_run(ctx, js, &ws_throughput, &ws_hop, &ws_step);
+        }
+
+        LOG("[bench] jobs: %7d | %13.1f %7.2f %8.3f | %17.1f %7.2f %8.3f", num_threads, pool_throughput, pool_hop, pool_step, ws_throughput, ws_hop, ws_step);
+
+        u64 executed = 0, latency = 0, max_latency = 0, busy = 0, idle = 0, wakeups = 0, empty_wakeups = 0;
+        for (const JPH::JobSystemThreadPool::WorkerStats& w : pool_stats.mWorkers) {
+            executed += w.mNumJobsExecuted;
+            latency += w.mQueueLatency;
+            max_latency = std::max(max_latency, w.mMaxQueueLatency);
+            busy += w.mBusyTime;
+            idle += w.mIdleTime;
+            wakeups += w.mNumWakeups;
+            empty_wakeups += w.mNumEmptyWakeups;
+        }
+        const JPH::JobSystemWithBarrier::BarrierStats& barriers = pool_stats.mBarriers;
+        LOG("[bench] jobs: %7s   pool stats: %llu jobs by workers (latency avg %.2f us, max %.1f us), busy %.0f%%, %llu / %llu empty wakeups, %llu jobs by barrier, barrier asleep %.0f%% of %.1f ms",
+            "", static_cast<unsigned long long>(executed), executed > 0 ? static_cast<f64>(latency) * 1.0e-3 / static_cast<f64>(executed) : 0.0, static_cast<f64>(max_latency) * 1.0e-3,
+            busy + idle > 0 ? 100.0 * static_cast<f64>(busy) / static_cast<f64>(busy + idle) : 0.0, static_cast<unsigned long long>(empty_wakeups), static_cast<unsigned long long>(wakeups),
+            static_cast<unsigned long long>(barriers.mNumJobsExecuted), barriers.mWaitTime > 0 ? 100.0 * static_cast<f64>(barriers.mSleepTime) / static_cast<f64>(barriers.mWaitTime) : 0.0, static_cast<f64>(barriers.mWaitTime) * 1.0e-6);
+    }
+}
+
+//
+// Semaphore: wake latency of JPH::Semaphore against the mutex + condition variable emulation it replaces on Linux.
+// Ping-pong measures wake ups between two busy threads, parked measures waking a thread that is asleep. Afterwards the
+// physics step time is measured at 1 to 64 threads (or --threads), see bench_semaphore_step.
+//
+struct CondVarSemaphore
+{
+    std::mutex lock;
+    std::condition_variable wait_variable;
+    i32 count = 0;
+
+    void Release(u32 num = 1) {
+        std::lock_guard guard(lock);
+        count += static_cast<i32>(num);
+        if (num > 1) wait_variable.notify_all(); else wait_variable.notify_one();
+    }
+    void Acquire(u32 num = 1) {
+        std::unique_lock guard(lock);
+        count -= static_cast<i32>(num);
+        wait_variable.wait(guard, [this]() { return count >= 0; });
+    }
+};
+
+template<typename T> func bench_semaphore_run(const char* name) -> void
+{
+    // Ping-pong
+    f64 round_trip;
+    {
+        constexpr u32 num_round_trips = 20 * 1000;
+
+        auto ping = new T();
+        auto pong = new T();
+        defer { delete ping; delete pong; };
+
+        std::thread echo([ping, pong]() {
+            for (u32 i = 0; i < num_round_trips; ++i) {
+                ping->Acquire();
+                pong->Release();
+            }
+        });
+
+        const f64 begin = bench_time();
+        for (u32 i = 0; i < num_round_trips; ++i) {
+            ping->Release();
+            pong->Acquire();
+        }
+        round_trip = (bench_time() - begin) / num_round_trips;
+        echo.join();
+    }
+
+    // Parked: the waiter has been asleep for a while when the release comes
+    std::vector<f64> latencies;
+    {
+        constexpr u32 num_wakes = 200;
+
+        auto sem = new T();
+        auto done = new T();
+        defer { delete sem; delete done; };
+
+        f64 release_time = 0.0;
+        latencies.reserve(num_wakes);
+
+        std::thread waiter([sem, done, &release_time, &latencies]() {
+            for (u32 i = 0; i < num_wakes; ++i) {
+                sem->Acquire();
+                latencies.push_back(bench_time() - release_time);
+                done->Release();
+            }
+        });
+
+        for (u32 i = 0; i < num_wakes; ++i) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            release_time = bench_time();
+            sem->Release();
+            done->Acquire();
+        }
+        waiter.join();
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    LOG("[bench] semaphore: %-10s ping-pong %7.2f us, parked wake p50 %7.2f us, p99 %7.2f us", name, round_trip * 1.0e6 * 0.5, latencies[latencies.size() / 2] * 1.0e6, latencies[latencies.size() * 99 / 100] * 1.0e6);
+}
+
+// Physics step time of a box pile on JobSystemThreadPool, whose idle workers sleep on JPH::Semaphore. The pool can only use
+// the semaphore Jolt was built with: to compare against the condition variable emulation, build Jolt and the bench a second
+// time with JPH_SEMAPHORE_NO_FUTEX defined and run both.
+func bench_semaphore_step(BenchContext* ctx, u32 num_threads) -> void
+{
+    constexpr u32 num_warmup_steps = 30;
+    constexpr u32 num_steps = 120;
+
+    auto js = new JPH::JobSystemThreadPool(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, static_cast<i32>(num_threads) - 1);
+    defer { delete js; };
+
+    JPH::PhysicsSystem* physics_system = bench_create_physics_system(ctx, 4096);
+    defer { delete physics_system; };
+    bench_add_box_pile(physics_system, 2000);
+
+    for (u32 i = 0; i < num_warmup_steps; ++i) physics_system->Update(PHY_FIXED_TIME_STEP, 1, ctx->temp_allocator, js);
+
+    std::vector<f64> step_times(num_steps);
+    for (u32 i = 0; i < num_steps; ++i) {
+        const f64 begin = bench_time();
+        physics_system->Update(PHY_FIXED_TIME_STEP, 1, ctx->temp_allocator, js);
+        step_times[i] = bench_time() - begin;
+    }
+
+    f64 total = 0.0;
+    for (f64 t : step_times) total += t;
+    std::sort(step_times.begin(), step_times.end());
+
+    LOG("[bench] semaphore: step %2d threads | mean %8.3f ms, p50 %8.3f ms, p99 %8.3f ms, max %8.3f ms", num_threads, total * 1000.0 / num_steps,
+        step_times[num_steps / 2] * 1000.0, step_times[num_steps * 99 / 100] * 1000.0, step_times.back() * 1000.0);
+}
+
+func bench_semaphore(BenchContext* ctx) -> void
+{
+    bench_semaphore_run<CondVarSemaphore>("condvar");
+    bench_semaphore_run<JPH::Semaphore>("jolt");
+
+    if (!ctx->options->threads.empty()) {
+        for (u32 num_threads : ctx->options->threads) bench_semaphore_step(ctx, num_threads);
+    } else {
+        for (u32 num_threads = 1; num_threads <= 64; num_threads *= 2) bench_semaphore_step(ctx, num_threads);
+    }
+}
+
+//
+// Topology: detected CPUs, and the physics step with workers pinned by JPH::ThreadTopology vs. unpinned, at the
+// recommended thread count and at one worker per logical CPU.
+//
+func bench_topology(BenchContext* ctx) -> void
+{
+    JPH::ThreadTopology topology;
+    topology.Detect();
+    for (const JPH::ThreadTopology::LogicalCpu& c : topology.GetCpus()) {
+        LOG("[bench] topology: cpu %3d  core %3d  smt %d  node %d  capacity %u%s", c.mCpu, c.mCore, c.mSMTIndex, c.mNode, c.mCapacity, c.mIsEfficiencyCore ? "  efficiency" : "");
+    }
+
+    const JPH::ThreadTopology::Settings pinned = {};
+    const JPH::ThreadTopology::Settings unpinned = { .mPinThreads = false };
+
+    const i32 recommended = topology.GetRecommendedNumThreads(pinned);
+    const i32 all = static_cast<i32>(topology.GetCpus().size()) - 1;
+
+    LOG("[bench] topology: threads | unpinned jobs/ms  hop us  step ms | pinned jobs/ms  hop us  step ms");
+    i32 prev_num_threads = -1;
+    for (i32 num_threads : { recommended, all }) {
+        if (num_threads == prev_num_threads) continue;
+        prev_num_threads = num_threads;
+
+        f64 throughput[2], hop[2], step[2];
+        for (u32 k = 0; k < 2; ++k) {
+            auto js = new JPH::JobSystemThreadPool();
+            defer { delete js; };
+            place_physics_workers(js, topology, k == 0 ? unpinned : pinned, num_threads);
+            js->Init(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, num_threads);
+            bench_jobs_run(ctx, js, &throughput[k], &hop[k], &step[k]);
+        }
+
+        LOG("[bench] topology: %7d | %17.1f %7.2f %8.3f | %15.1f %7.2f %8.3f", num_threads, throughput[0], hop[0], step[0], throughput[1], hop[1], step[1]);
+    }
+}
+
+//
+// Priorities: step time of the box pile with and without PhysicsSettings::mUseJobPriorities, idle and while another
+// thread keeps the same job system busy with unrelated jobs.
+//
+func bench_priorities_run(BenchContext* ctx, JPH::JobSystem* js, bool use_priorities, bool with_load, f64* out_mean_ms, f64* out_p99_ms) -> void
+{
+    constexpr u32 num_warmup_steps = 30;
+    constexpr u32 num_steps = 120;
+
+    JPH::PhysicsSystem* physics_system = bench_create_physics_system(ctx, 4096);
+    defer { delete physics_system; };
+    bench_add_box_pile(physics_system, 2000);
+
+    JPH::PhysicsSettings settings = physics_system->GetPhysicsSettings();
+    settings.mUseJobPriorities = use_priorities;
+    physics_system->SetPhysicsSettings(settings);
+
+    // Load: batches of small jobs, always some of them in flight
+    std::atomic<bool> quit = false;
+    std::atomic<u64> sink = 0;
+    std::thread load_thread;
+    if (with_load) {
+        load_thread = std::thread([js, &quit, &sink]() {
+            JPH::JobSystem::Barrier* barrier = js->CreateBarrier();
+            while (!quit.load(std::memory_order_relaxed)) {
+                for (u32 i = 0; i < 64; ++i) {
+                    barrier->AddJob(js->CreateJob("BenchLoad", JPH::Color::sGrey, [&sink, i]() {
+                        u64 h = i;
+                        for (u32 k = 0; k < 20000; ++k) h = h * 6364136223846793005ull + 1442695040888963407ull;
+                        sink.fetch_add(h, std::memory_order_relaxed);
+                    }));
+                }
+                js->WaitForJobs(barrier);
+            }
+            js->DestroyBarrier(barrier);
+        });
+    }
+    defer {
+        quit = true;
+        if (load_thread.joinable()) load_thread.join();
+    };
+
+    for (u32 i = 0; i < num_warmup_steps; ++i) physics_system->Update(PHY_FIXED_TIME_STEP, 1, ctx->temp_allocator, js);
+
+    std::vector<f64> step_times(num_steps);
+    for (u32 i = 0; i < num_steps; ++i) {
+        const f64 begin = bench_time();
+        physics_system->Update(PHY_FIXED_TIME_STEP, 1, ctx->temp_allocator, js);
+        step_times[i] = (bench_time() - begin) * 1000.0;
+    }
+
+    f64 total = 0.0;
+    for (f64 t : step_times) total += t;
+    std::sort(step_times.begin(), step_times.end());
+    *out_mean_ms = total / num_steps;
+    *out_p99_ms = step_times[step_times.size() * 99 / 100];
+}
+
+func bench_priorities(BenchContext* ctx) -> void
+{
+    LOG("[bench] priorities: threads | load | fifo mean ms  p99 ms | priorities mean ms  p99 ms");
+
+    for (i32 num_threads : { 1, 4, 16 }) {
+        auto js = new JPH::JobSystemThreadPool(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, num_threads);
+        defer { delete js; };
+
+        for (bool with_load : { false, true }) {
+            f64 fifo_mean, fifo_p99, prio_mean, prio_p99;
+            bench_priorities_run(ctx, js, false, with_load, &fifo_mean, &fifo_p99);
+            bench_priorities_run(ctx, js, true, with_load, &prio_mean, &prio_p99);
+            LOG("[bench] priorities: %7d | %4s | %12.3f %7.3f | %18.3f %7.3f", num_threads, with_load ? "yes" : "no", fifo_mean, fifo_p99, prio_mean, prio_p99);
+        }
+    }
+}
+
+//
+// Coroutines: tasks that walk a chain of dependent jobs, awaiting every job with JPH::JobAwaiter, vs. tasks that run as
+// jobs and block their worker until each job is done. A blocked task occupies a worker, so at most workers - 1 of them
+// can run at once before nobody is left to execute the chain jobs. Held workers are the ones running task code, which for
+// a blocking task includes the time it waits for its job.
+//
+struct CoroutineBenchState
+{
+    std::atomic<u32> num_done;
+    std::atomic<u32> num_suspended;
+    std::atomic<u32> peak_suspended;
+    std::atomic<u32> num_held;
+    std::atomic<u32> peak_held;
+    std::atomic<u64> sink;
+};
+
+func bench_coroutines_track_peak(std::atomic<u32>* counter, std::atomic<u32>* peak) -> void
+{
+    const u32 value = counter->fetch_add(1, std::memory_order_relaxed) + 1;
+    u32 prev = peak->load(std::memory_order_relaxed);
+    while (value > prev && !peak->compare_exchange_weak(prev, value, std::memory_order_relaxed)) {}
+}
+
+func bench_coroutines_work(CoroutineBenchState* state, u32 seed) -> void
+{
+    u64 h = seed;
+    for (u32 i = 0; i < 256; ++i) h = h * 6364136223846793005ull + 1442695040888963407ull;
+    state->sink.fetch_add(h, std::memory_order_relaxed);
+}
+
+func bench_coroutines_task(JPH::JobSystem* js, CoroutineBenchState* state, u32 depth) -> Task
+{
+    co_await JPH::ResumeOnJobSystem(js, "BenchTaskStart");
+    bench_coroutines_track_peak(&state->num_held, &state->peak_held);
+
+    for (u32 i = 0; i < depth; ++i) {
+        JPH::JobAwaiter step = task_run(js, "BenchTaskStep", [state, i]() { bench_coroutines_work(state, i); });
+
+        // The worker is released while the task is suspended
+        state->num_held.fetch_sub(1, std::memory_order_relaxed);
+        bench_coroutines_track_peak(&state->num_suspended, &state->peak_suspended);
+        co_await step;
+        state->num_suspended.fetch_sub(1, std::memory_order_relaxed);
+        bench_coroutines_track_peak(&state->num_held, &state->peak_held);
+    }
+
+    state->num_held.fetch_sub(1, std::memory_order_relaxed);
+    state->num_done.fetch_add(1, std::memory_order_release);
+}
+
+func bench_coroutines_blocking_task(JPH::JobSystem* js, CoroutineBenchState* state, u32 depth) -> void
+{
+    bench_coroutines_track_peak(&state->num_held, &state->peak_held);
+
+    for (u32 i = 0; i < depth; ++i) {
+        const JPH::JobHandle step = js->CreateJob("BenchBlockingStep", JPH::Color::sGreen, [state, i]() { bench_coroutines_work(state, i); });
+        while (!step.IsDone()) std::this_thread::yield();
+    }
+
+    state->num_held.fetch_sub(1, std::memory_order_relaxed);
+    state->num_done.fetch_add(1, std::memory_order_release);
+}
+
+func bench_coroutines(BenchContext*) -> void
+{
+    constexpr i32 num_threads = 4;
+    constexpr u32 depth = 64;
+
+    auto js = new JPH::JobSystemThreadPool(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, num_threads);
+    defer { delete js; };
+
+    LOG("[bench] coroutines: %d workers, chains of %u jobs", num_threads, depth);
+    LOG("[bench] coroutines: mode       tasks | total ms  us/hop | peak suspended  peak held workers");
+
+    for (u32 num_tasks : { 3u, 64u, 512u }) {
+        CoroutineBenchState state = {};
+        const f64 begin = bench_time();
+        for (u32 i = 0; i < num_tasks; ++i) bench_coroutines_task(js, &state, depth);
+        while (state.num_done.load(std::memory_order_acquire) < num_tasks) std::this_thread::yield();
+        const f64 ms = (bench_time() - begin) * 1000.0;
+
+        LOG("[bench] coroutines: coroutine %5u | %8.2f %7.2f | %14u %18u", num_tasks, ms, ms * 1000.0 / (num_tasks * depth), state.peak_suspended.load(), state.peak_held.load());
+    }
+
+    // More blocking tasks than this would take every worker and never finish
+    {
+        constexpr u32 num_tasks = num_threads - 1;
+
+        CoroutineBenchState state = {};
+        const f64 begin = bench_time();
+        for (u32 i = 0; i < num_tasks; ++i) js->CreateJob("BenchBlockingTask", JPH::Color::sRed, [js, &state]() { bench_coroutines_blocking_task(js, &state, depth); });
+        while (state.num_done.load(std::memory_order_acquire) < num_tasks) std::this_thread::yield();
+        const f64 ms = (bench_time() - begin) * 1000.0;
+
+        LOG("[bench] coroutines: blocking  %5u | %8.2f %7.2f | %14u %18u", num_tasks, ms, ms * 1000.0 / (num_tasks * depth), state.peak_suspended.load(), state.peak_held.load());
+    }
+}
+
+//
+// Temp allocator: peak temp memory per physics step of box piles of growing size, starting from a 1 MiB
+// JPH::TempAllocatorGrowing, and step time compared to a JPH::TempAllocatorImpl with 25% more than the measured peak.
+//
+func bench_temp_allocator(BenchContext* ctx) -> void
+{
+    constexpr u32 num_warmup_steps = 5;
+    constexpr u32 num_steps = 10;
+
+    LOG("[bench] temp_allocator: bodies | peak KiB  capacity KiB  blocks  overflows | grow ms/step  fixed ms/step");
+
+    for (u32 num_boxes : { 1000u, 10000u, 100000u }) {
+        JPH::PhysicsSystem* physics_system = bench_create_physics_system(ctx, num_boxes + 1);
+        defer { delete physics_system; };
+        bench_add_box_pile(physics_system, num_boxes);
+
+        auto growing = new JPH::TempAllocatorGrowing(1024 * 1024);
+        defer { delete growing; };
+
+        for (u32 i = 0; i < num_warmup_steps; ++i) physics_system->Update(PHY_FIXED_TIME_STEP, 1, growing, ctx->job_system);
+
+        // Blocks are merged when the allocator empties, so later steps shouldn't grow anymore
+        f64 begin = bench_time();
+        for (u32 i = 0; i < num_steps; ++i) {
+            growing->ResetPeakUsage();
+            physics_system->Update(PHY_FIXED_TIME_STEP, 1, growing, ctx->job_system);
+        }
+        const f64 grow_ms = (bench_time() - begin) * 1000.0 / num_steps;
+        const JPH::TempAllocatorGrowing::Stats stats = growing->GetStats();
+
+        auto fixed = new JPH::TempAllocatorImpl(stats.mMaxPeakUsage + stats.mMaxPeakUsage / 4);
+        defer { delete fixed; };
+
+        begin = bench_time();
+        for (u32 i = 0; i < num_steps; ++i) physics_system->Update(PHY_FIXED_TIME_STEP, 1, fixed, ctx->job_system);
+        const f64 fixed_ms = (bench_time() - begin) * 1000.0 / num_steps;
+
+        LOG("[bench] temp_allocator: %6u | %8u  %12u  %6u  %9u | %12.3f  %13.3f", num_boxes, stats.mMaxPeakUsage / 1024, stats.mCapacity / 1024, stats.mMaxNumBlocks, stats.mTotalNumOverflows, grow_ms, fixed_ms);
+    }
+}
+
+//
+// Alloc: JPH::Allocate and friends on the CRT heap vs. rpmalloc. Body add/remove churn with a fresh shape per body, and
+// convex hull building on the main thread and spread over 4 worker threads. Every object is created and destroyed while
+// the hooks are swapped so no block crosses allocators. operator new is only replaced at compile time (GAME_RPMALLOC).
+//
+struct BenchAllocHooks
+{
+    JPH::AllocateFunction allocate;
+    JPH::FreeFunction free;
+    JPH::AlignedAllocateFunction aligned_allocate;
+    JPH::AlignedFreeFunction aligned_free;
+};
+
+func bench_alloc_get_hooks() -> BenchAllocHooks
+{
+    return { JPH::Allocate, JPH::Free, JPH::AlignedAllocate, JPH::AlignedFree };
+}
+
+func bench_alloc_set_hooks(const BenchAllocHooks& hooks) -> void
+{
+    JPH::Allocate = hooks.allocate;
+    JPH::Free = hooks.free;
+    JPH::AlignedAllocate = hooks.aligned_allocate;
+    JPH::AlignedFree = hooks.aligned_free;
+}
+
+func bench_alloc_churn(BenchContext* ctx, u32 num_rounds, u32 num_bodies) -> f64
+{
+    // Removed bodies keep their tree nodes until the broad phase has been updated twice, leave room for that
+    JPH::PhysicsSystem* physics_system = bench_create_physics_system(ctx, 4 * num_bodies);
+    defer { delete physics_system; };
+    JPH::BodyInterface& bi = physics_system->GetBodyInterfaceNoLock();
+
+    std::vector<JPH::BodyID> ids(num_bodies);
+    const f64 begin = bench_time();
+    for (u32 round = 0; round < num_rounds; ++round) {
+        for (u32 i = 0; i < num_bodies; ++i) {
+            const f32 size = 0.25f + 0.01f * static_cast<f32>((i + round) % 32);
+            JPH::RefConst<JPH::Shape> shape = (i & 1) ? static_cast<JPH::Shape*>(new JPH::SphereShape(size)) : new JPH::BoxShape(JPH::Vec3::sReplicate(size));
+            JPH::BodyCreationSettings settings(shape, JPH::RVec3(static_cast<f32>(i % 64), static_cast<f32>(i / 64), 0.0f), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, OBJECT_LAYER_MOVING);
+            ids[i] = bi.CreateBody(settings)->GetID();
+        }
+        JPH::BodyInterface::AddState state = bi.AddBodiesPrepare(ids.data(), static_cast<i32>(num_bodies));
+        bi.AddBodiesFinalize(ids.data(), static_cast<i32>(num_bodies), state, JPH::EActivation::DontActivate);
+        bi.RemoveBodies(ids.data(), static_cast<i32>(num_bodies));
+        bi.DestroyBodies(ids.data(), static_cast<i32>(num_bodies));
+        physics_system->OptimizeBroadPhase();
+    }
+    return (bench_time() - begin) * 1000.0;
+}
+
+func bench_alloc_build_hulls(u32 first, u32 count) -> void
+{
+    JPH::Array<JPH::Vec3> points;
+    for (u32 h = first; h < first + count; ++h) {
+        u32 seed = h * 2654435761u + 1;
+        points.clear();
+        for (u32 i = 0; i < 64; ++i) {
+            f32 p[3];
+            for (f32& c : p) {
+                seed = seed * 1664525u + 1013904223u;
+                c = static_cast<f32>(seed >> 8) / static_cast<f32>(1u << 24) - 0.5f;
+            }
+            points.push_back(JPH::Vec3(p[0], p[1], p[2]));
+        }
+        JPH::ConvexHullShapeSettings settings(points);
+        JPH::ShapeSettings::ShapeResult result = settings.Create();
+        assert(result.IsValid());
+    }
+}
+
+func bench_alloc_hulls(u32 num_hulls, u32 num_threads) -> f64
+{
+    if (num_threads <= 1) {
+        const f64 begin = bench_time();
+        bench_alloc_build_hulls(0, num_hulls);
+        return (bench_time() - begin) * 1000.0;
+    }
+
+    // Created inside the swapped window too: the workers' temp allocators and job storage come from JPH::Allocate
+    auto js = new JPH::JobSystemThreadPool();
+    defer { delete js; };
+    js->SetThreadExitFunction([](int) { alloc_thread_exit(); });
+    js->Init(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, static_cast<i32>(num_threads));
+
+    JPH::JobSystem::Barrier* barrier = js->CreateBarrier();
+    defer { js->DestroyBarrier(barrier); };
+
+    constexpr u32 hulls_per_job = 16;
+    const f64 begin = bench_time();
+    for (u32 first = 0; first < num_hulls; first += hulls_per_job) {
+        const u32 count = std::min(hulls_per_job, num_hulls - first);
+        barrier->AddJob(js->CreateJob("Hulls", JPH::Color::sGreen, [first, count]() { bench_alloc_build_hulls(first, count); }));
+    }
+    js->WaitForJobs(barrier);
+    return (bench_time() - begin) * 1000.0;
+}
+
+func bench_alloc(BenchContext* ctx) -> void
+{
+    constexpr u32 num_rounds = 16;
+    constexpr u32 num_bodies = 4096;
+    constexpr u32 num_hulls = 2048;
+
+    const BenchAllocHooks current = bench_alloc_get_hooks();
+    JPH::RegisterDefaultAllocator();
+    const BenchAllocHooks crt = bench_alloc_get_hooks();
+    const BenchAllocHooks rp = { alloc_rpmalloc, alloc_rpfree, alloc_rpmalloc_aligned, alloc_rpfree_aligned };
+
+    LOG("[bench] alloc: allocator | churn %ux%u ms | %u hulls 1 thread ms | 4 threads ms", num_rounds, num_bodies, num_hulls);
+    for (const auto& [name, hooks] : { std::pair{ "crt", crt }, std::pair{ "rpmalloc", rp } }) {
+        bench_alloc_set_hooks(hooks);
+        bench_alloc_churn(ctx, 1, num_bodies); // Warm up the heap
+        const f64 churn_ms = bench_alloc_churn(ctx, num_rounds, num_bodies);
+        const f64 hulls_ms = bench_alloc_hulls(num_hulls, 1);
+        const f64 hulls_mt_ms = bench_alloc_hulls(num_hulls, 4);
+        LOG("[bench] alloc: %-9s | %13.3f | %19.3f | %12.3f", name, churn_ms, hulls_ms, hulls_mt_ms);
+    }
+    bench_alloc_set_hooks(current);
+    alloc_thread_exit();
+}
+
+//
+// Free list: construct / destruct throughput of JPH::FixedSizeFreeList with every thread hammering the shared list vs.
+// per-thread magazines, for a thread that frees its own objects and for objects freed by another thread (like jobs that
+// are created on one thread and released on a worker). Also the physics step time with and without job magazines.
+//
+struct BenchFreeListObject
+{
+    u64 payload[8];
+};
+
+using BenchFreeList = JPH::FixedSizeFreeList<BenchFreeListObject>;
+
+// Every thread constructs `batch` objects and destructs them, either its own or the previous batch of its neighbour.
+func bench_freelist_run(BenchFreeList* list, u32 num_threads, u32 num_rounds, u32 batch, bool cross_thread) -> f64
+{
+    std::vector<std::vector<u32>> indices(num_threads, std::vector<u32>(batch, BenchFreeList::cInvalidObjectIndex));
+    std::vector<std::thread> threads;
+    std::barrier round_barrier(static_cast<std::ptrdiff_t>(num_threads));
+
+    const f64 begin = bench_time();
+    for (u32 t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (u32 round = 0; round < num_rounds; ++round) {
+                for (u32& index : indices[t]) index = list->ConstructObject();
+                if (cross_thread) round_barrier.arrive_and_wait();
+                for (u32 index : indices[cross_thread ? (t + 1) % num_threads : t]) list->DestructObject(index);
+                if (cross_thread) round_barrier.arrive_and_wait();
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    return (bench_time() - begin) * 1e9 / (2.0 * num_threads * num_rounds * batch);
+}
+
+func bench_freelist(BenchContext* ctx) -> void
+{
+    constexpr u32 num_rounds = 2000;
+    constexpr u32 batch = 64;
+    constexpr u32 magazine_size = PHY_JOB_MAGAZINE_SIZE;
+
+    LOG("[bench] freelist: threads | own ns/op shared  magazine | cross ns/op shared  magazine | parked  magazine KiB");
+    for (u32 num_threads : { 1u, 2u, 4u, 8u, 16u }) {
+        f64 ns[2][2];
+        uint parked = 0;
+        size_t overhead = 0;
+        for (u32 cross = 0; cross < 2; ++cross) {
+            for (u32 use_magazines = 0; use_magazines < 2; ++use_magazines) {
+                // Every thread can park up to 2 magazines worth of objects
+                const u32 max_objects = num_threads * batch * 2 + JPH::FixedSizeFreeListThreadIndex::cMaxThreads * 2 * magazine_size;
+                BenchFreeList list;
+                list.Init(max_objects, 1024, use_magazines ? magazine_size : 0);
+                ns[cross][use_magazines] = bench_freelist_run(&list, num_threads, num_rounds, batch, cross != 0);
+                if (use_magazines && cross) {
+                    parked = list.GetNumObjectsInMagazines();
+                    overhead = list.GetMagazineMemoryUsage();
+                }
+            }
+        }
+        LOG("[bench] freelist: %7u | %16.1f  %8.1f | %18.1f  %8.1f | %6u  %12.1f", num_threads, ns[0][0], ns[0][1], ns[1][0], ns[1][1], parked, static_cast<f64>(overhead) / 1024.0);
+    }
+
+    // Job magazines in the physics step. The bench context's pool has them, compare to a pool without.
+    constexpr u32 num_boxes = 10000;
+    constexpr u32 num_steps = 20;
+
+    auto plain = new JPH::JobSystemThreadPool();
+    defer { delete plain; };
+    plain->SetThreadTempAllocatorSize(PHY_WORKER_TEMP_ALLOCATOR_SIZE);
+    plain->Init(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, ctx->job_system->GetMaxConcurrency() - 1);
+
+    for (JPH::JobSystemThreadPool* js : { plain, ctx->job_system }) {
+        JPH::PhysicsSystem* physics_system = bench_create_physics_system(ctx, num_boxes + 1);
+        defer { delete physics_system; };
+        bench_add_box_pile(physics_system, num_boxes);
+
+        physics_system->Update(PHY_FIXED_TIME_STEP, 1, ctx->temp_allocator, js);
+        const f64 begin = bench_time();
+        for (u32 i = 0; i < num_steps; ++i) physics_system->Update(PHY_FIXED_TIME_STEP, 1, ctx->temp_allocator, js);
+        LOG("[bench] freelist: step %u boxes, %s: %.3f ms, %u jobs parked, %.1f KiB", num_boxes, js == plain ? "shared list" : "magazines  ", (bench_time() - begin) * 1000.0 / num_steps, js->GetNumJobsInMagazines(), static_cast<f64>(js->GetJobMagazineMemoryUsage()) / 1024.0);
+    }
+}
+
+//
+// Hash map: concurrent insert and find of body pair keys at contact cache sizes, JPH::LockFreeHashMap (chained, fixed
+// buckets and storage, as used by the contact cache) vs. JPH::LockFreeOpenHashMap (open addressing, grows between epochs).
+// The open map starts at 1024 slots to show how many epochs it takes to grow to the working set.
+//
+struct BenchHashMapValue
+{
+    f32 data[8]; // About the size of a cached body pair
+};
+
+// Runs `fn(thread_index, first_key, end_key)` on `num_threads` threads and returns ns per key.
+template <typename Fn>
+func bench_hashmap_parallel(u32 num_threads, u32 num_keys, const Fn& fn) -> f64
+{
+    std::vector<std::thread> threads;
+    const f64 begin = bench_time();
+    for (u32 t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&fn, t, num_threads, num_keys]() {
+            fn(t, static_cast<u32>(u64(num_keys) * t / num_threads), static_cast<u32>(u64(num_keys) * (t + 1) / num_threads));
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    return (bench_time() - begin) * 1e9 / num_keys;
+}
+
+// Unique keys for i < 2^23, (i, i) is never one of them so it's used for misses
+func bench_hashmap_key(u32 i, bool hit) -> JPH::BodyPair
+{
+    return JPH::BodyPair(JPH::BodyID(i & JPH::BodyID::cMaxBodyIndex), JPH::BodyID(hit ? (i * 7 + 3) & JPH::BodyID::cMaxBodyIndex : i & JPH::BodyID::cMaxBodyIndex));
+}
+
+func bench_hashmap(BenchContext*) -> void
+{
+    constexpr u32 num_threads = 4;
+    using ChainedMap = JPH::LockFreeHashMap<JPH::BodyPair, BenchHashMapValue>;
+    using OpenMap = JPH::LockFreeOpenHashMap<JPH::BodyPair, BenchHashMapValue>;
+
+    LOG("[bench] hashmap: keys    | map     | insert ns  hit ns  miss ns | MiB    | epochs to grow");
+    for (u32 num_keys : { 10000u, 100000u, 1000000u }) {
+        std::atomic<u32> num_found = 0;
+        auto find_all = [&num_found](const auto& map, u32 first, u32 end, bool hit) {
+            u32 found = 0;
+            for (u32 i = first; i < end; ++i) {
+                const JPH::BodyPair key = bench_hashmap_key(i, hit);
+                found += map.Find(key, key.GetHash()) != nullptr;
+            }
+            num_found += found;
+        };
+
+        {
+            // Sized like the contact cache: one bucket per pair and storage for all pairs
+            JPH::LFHMAllocator allocator;
+            allocator.Init(num_keys * static_cast<u32>(sizeof(ChainedMap::KeyValue)) + num_threads * 4096);
+            ChainedMap map(allocator);
+            map.Init(JPH::GetNextPowerOf2(num_keys));
+
+            const f64 insert_ns = bench_hashmap_parallel(num_threads, num_keys, [&map, &allocator](u32, u32 first, u32 end) {
+                JPH::LFHMAllocatorContext context(allocator, 4096);
+                for (u32 i = first; i < end; ++i) {
+                    const JPH::BodyPair key = bench_hashmap_key(i, true);
+                    map.Create(context, key, key.GetHash(), 0, BenchHashMapValue());
+                }
+            });
+            const f64 hit_ns = bench_hashmap_parallel(num_threads, num_keys, [&](u32, u32 first, u32 end) { find_all(map, first, end, true); });
+            const f64 miss_ns = bench_hashmap_parallel(num_threads, num_keys, [&](u32, u32 first, u32 end) { find_all(map, first, end, false); });
+            const f64 mib = static_cast<f64>(num_keys * sizeof(ChainedMap::KeyValue) + map.GetMaxBuckets() * sizeof(u32)) / (1024.0 * 1024.0);
+            LOG("[bench] hashmap: %7u | chained | %9.1f  %6.1f  %7.1f | %6.1f | -", num_keys, insert_ns, hit_ns, miss_ns, mib);
+        }
+
+        {
+            OpenMap map;
+            map.Init(1024);
+
+            auto insert_all = [&map](u32, u32 first, u32 end) {
+                for (u32 i = first; i < end; ++i) {
+                    const JPH::BodyPair key = bench_hashmap_key(i, true);
+                    map.Create(key, key.GetHash(), BenchHashMapValue());
+                }
+            };
+
+            // Epochs like physics steps: insert everything, grow if needed, start over
+            u32 num_epochs = 0;
+            for (;;) {
+                map.Clear();
+                bench_hashmap_parallel(num_threads, num_keys, insert_all);
+                if (map.GetNumOverflows() == 0) break;
+                map.GrowIfNeeded();
+                ++num_epochs;
+            }
+
+            map.Clear();
+            const f64 insert_ns = bench_hashmap_parallel(num_threads, num_keys, insert_all);
+            const f64 hit_ns = bench_hashmap_parallel(num_threads, num_keys, [&](u32, u32 first, u32 end) { find_all(map, first, end, true); });
+            const f64 miss_ns = bench_hashmap_parallel(num_threads, num_keys, [&](u32, u32 first, u32 end) { find_all(map, first, end, false); });
+            const f64 mib = static_cast<f64>(map.GetMemoryUsage()) / (1024.0 * 1024.0);
+            LOG("[bench] hashmap: %7u | open    | %9.1f  %6.1f  %7.1f | %6.1f | %u (%u slots, %.0f%% full)", num_keys, insert_ns, hit_ns, miss_ns, mib, num_epochs, map.GetCapacity(), 100.0 * map.GetNumKeyValues() / map.GetCapacity());
+        }
+
+        if (num_found != 2 * num_keys) LOG("[bench] hashmap: found %u keys, expected %u", num_found.load(), 2 * num_keys);
+    }
+}
+
+//
+// Profile: cost of a Jolt profile scope (JPH_EXTERNAL_PROFILE, see game_profile.cpp) compared to a plain Tracy zone, with
+// a constant name and with names that change per scope like job names do. Needs a build with Tracy enabled.
+//
+func bench_profile(BenchContext*) -> void
+{
+#if defined(JPH_EXTERNAL_PROFILE) && defined(TRACY_ENABLE)
+    constexpr u32 num_zones = 200000;
+    static const char* const names[] = { "Job A", "Job B", "Job C", "Job D", "Job E", "Job F", "Job G", "Job H" };
+    static const JPH::ExternalProfileSite site = { __FUNCTION__, __FILE__, __LINE__ };
+
+    f64 begin = bench_time();
+    for (u32 i = 0; i < num_zones; ++i) {
+        ZoneScopedN("Bench");
+    }
+    const f64 tracy_ns = (bench_time() - begin) * 1e9 / num_zones;
+
+    begin = bench_time();
+    for (u32 i = 0; i < num_zones; ++i) {
+        JPH::ExternalProfileMeasurement measurement(site, "Bench");
+    }
+    const f64 jolt_ns = (bench_time() - begin) * 1e9 / num_zones;
+
+    begin = bench_time();
+    for (u32 i = 0; i < num_zones; ++i) {
+        JPH::ExternalProfileMeasurement measurement(site, names[i % std::size(names)], JPH::Color::sGreen.GetUInt32());
+    }
+    const f64 jolt_names_ns = (bench_time() - begin) * 1e9 / num_zones;
+
+    LOG("[bench] profile: ns/zone: tracy %.1f, jolt %.1f, jolt with changing names %.1f", tracy_ns, jolt_ns, jolt_names_ns);
+#else
+    LOG("[bench] profile: skipped, needs TRACY_ENABLE and JPH_EXTERNAL_PROFILE");
+#endif
+}
+
+//
+// Hitch: the JPH::Profiler flight recorder (see game_profile.cpp) on a box pile where one step is slow on purpose. Reports
+// what the recorder adds to a step and what the step that copies out the dump costs, the file itself is written in the
+// background to profile_trace_hitch_*.json. Without JPH_PROFILE_ENABLED this only measures the steps.
+//
+func bench_hitch(BenchContext* ctx) -> void
+{
+#if !defined(JPH_PROFILE_ENABLED) || defined(JPH_EXTERNAL_PROFILE)
+    LOG("[bench] hitch: built without JPH_PROFILE_ENABLED, nothing is recorded");
+#endif
+    constexpr u32 num_steps = 120;
+    constexpr u32 hitch_step = 90;
+    constexpr f32 budget = 0.050f;
+
+    profile_init(8, budget);
+    profile_thread_start("Bench");
+
+    // The workers only register with the profiler when they start, so the pool is created after profile_init
+    auto js = new JPH::JobSystemThreadPool(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, ctx->job_system->GetMaxConcurrency() - 1);
+    JPH::PhysicsSystem* physics_system = bench_create_physics_system(ctx, 4096);
+    bench_add_box_pile(physics_system, 2000);
+
+    f64 step_time = 0.0;
+    f64 next_frame_time = 0.0;
+    f64 dump_time = 0.0;
+    for (u32 i = 0; i < num_steps; ++i) {
+        const f64 begin = bench_time();
+        physics_system->Update(PHY_FIXED_TIME_STEP, 1, ctx->temp_allocator, js);
+        if (i == hitch_step) std::this_thread::sleep_for(std::chrono::duration<f32>(2.0f * budget));
+        const f64 end = bench_time();
+        profile_next_frame();
+        const f64 t = bench_time() - end;
+
+        if (i == hitch_step) {
+            dump_time = t;
+        } else {
+            step_time += end - begin;
+            next_frame_time += t;
+        }
+    }
+
+    delete physics_system;
+    delete js;
+    profile_thread_end();
+    profile_shutdown();
+
+    LOG("[bench] hitch: step %.3f ms, next frame %.2f us, next frame that dumps %.3f ms", step_time * 1000.0 / (num_steps - 1), next_frame_time * 1.0e6 / (num_steps - 1), dump_time * 1000.0);
+}
+
+//
+// Physics: steps per second of the scenes in game_scenes.cpp at several body and thread counts. A run builds the scene,
+// steps it BENCH_PHYSICS_WARMUP_STEPS times to let it settle and then measures the steps. A step is split into the parts
+// of scene_step() (characters, PhysicsSystem::Update, queries) and the update into the phases of JPH::PhysicsUpdateStats.
+// Results can be written as JSON (one run per line) and compared against a file written earlier.
+// Steps/s depend on the machine, so baselines are local only: write one with --json on the machine you compare on (e.g.
+// before a change) and don't commit it.
+//
+#define BENCH_PHYSICS_WARMUP_STEPS 60
+
+struct BenchPhysicsResult
+{
+    const char* scene;
+    u32 bodies;
+    u32 threads;
+    u32 steps;
+    f64 setup_ms;
+    f64 steps_per_second;
+    f64 step_mean_ms;
+    f64 step_p50_ms;
+    f64 step_p99_ms;
+    f64 step_max_ms;
+    f64 characters_ms; // Mean per step of each part of scene_step()
+    f64 update_ms;
+    f64 queries_ms;
+    f64 update_phases_ms[static_cast<usize>(JPH::EPhysicsUpdatePhase::Count)]; // Mean wall time per step
+    f64 frame_sync_ms; // Mean per step of BroadPhase::FrameSync, part of the update but of none of the phases
+    f64 body_pairs; // Mean per step
+    f64 contact_constraints;
+    f64 islands;
+    u32 first_body_pairs; // Of the first step, runs with other settings only start to diverge after it
+};
+
+struct BenchPhysicsBaseline
+{
+    std::string scene;
+    u32 bodies;
+    u32 threads;
+    f64 steps_per_second;
+};
+
+// Job system for `num_threads` threads including the calling thread
+func bench_create_physics_job_system(u32 num_threads) -> JPH::JobSystemThreadPool*
+{
+    auto js = new JPH::JobSystemThreadPool();
+    js->SetThreadTempAllocatorSize(PHY_WORKER_TEMP_ALLOCATOR_SIZE);
+    js->SetJobMagazineSize(PHY_JOB_MAGAZINE_SIZE);
+    js->Init(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, static_cast<i32>(num_threads) - 1);
+    return js;
+}
+
+func bench_physics_run(BenchContext* ctx, SceneType type, u32 num_bodies, u32 num_threads, u32 num_steps, JPH::EBroadPhaseType broad_phase_type) -> BenchPhysicsResult
+{
+    auto js = bench_create_physics_job_system(num_threads);
+    defer { delete js; };
+
+    const f64 setup_begin = bench_time();
+    Scene scene = {};
+    scene_create(&scene, type, num_bodies, ctx->broad_phase_layer_interface, ctx->object_vs_broad_phase_layer_filter, ctx->object_layer_pair_filter, broad_phase_type);
+    defer { scene_destroy(&scene); };
+    const f64 setup_time = bench_time() - setup_begin;
+
+    SceneStepStats stats;
+    scene_step(&scene, ctx->temp_allocator, js, &stats);
+    const u32 first_body_pairs = stats.physics.mNumBodyPairs;
+    for (u32 i = 1; i < BENCH_PHYSICS_WARMUP_STEPS; ++i) scene_step(&scene, ctx->temp_allocator, js, &stats);
+
+    std::vector<f64> step_times(num_steps);
+    f64 characters = 0.0, update = 0.0, queries = 0.0;
+    u64 update_phases[static_cast<usize>(JPH::EPhysicsUpdatePhase::Count)] = {};
+    u64 frame_sync = 0;
+    u64 body_pairs = 0, contact_constraints = 0, islands = 0;
+    for (u32 i = 0; i < num_steps; ++i) {
+        scene_step(&scene, ctx->temp_allocator, js, &stats);
+        step_times[i] = stats.characters + stats.update + stats.queries;
+        characters += stats.characters;
+        update += stats.update;
+        queries += stats.queries;
+        for (usize p = 0; p < std::size(update_phases); ++p) update_phases[p] += stats.physics.mPhases[p].mWallTime;
+        frame_sync += stats.physics.mBroadPhaseFrameSyncTime;
+        body_pairs += stats.physics.mNumBodyPairs;
+        contact_constraints += stats.physics.mNumContactConstraints;
+        islands += stats.physics.mNumIslands;
+    }
+
+    f64 total = 0.0;
+    for (f64 t : step_times) total += t;
+    std::sort(step_times.begin(), step_times.end());
+
+    BenchPhysicsResult result = {
+        .scene = scene_infos[type].name,
+        .bodies = num_bodies,
+        .threads = num_threads,
+        .steps = num_steps,
+        .setup_ms = setup_time * 1000.0,
+        .steps_per_second = num_steps / total,
+        .step_mean_ms = total * 1000.0 / num_steps,
+        .step_p50_ms = step_times[num_steps / 2] * 1000.0,
+        .step_p99_ms = step_times[std::min(num_steps - 1, num_steps * 99 / 100)] * 1000.0,
+        .step_max_ms = step_times[num_steps - 1] * 1000.0,
+        .characters_ms = characters * 1000.0 / num_steps,
+        .update_ms = update * 1000.0 / num_steps,
+        .queries_ms = queries * 1000.0 / num_steps,
+        .update_phases_ms = {},
+        .frame_sync_ms = static_cast<f64>(frame_sync) * 1.0e-6 / num_steps,
+        .body_pairs = static_cast<f64>(body_pairs) / num_steps,
+        .contact_constraints = static_cast<f64>(contact_constraints) / num_steps,
+        .islands = static_cast<f64>(islands) / num_steps,
+        .first_body_pairs = first_body_pairs,
+    };
+    for (usize p = 0; p < std::size(update_phases); ++p) result.update_phases_ms[p] = static_cast<f64>(update_phases[p]) * 1.0e-6 / num_steps;
+    return result;
+}
+
+func bench_physics_write_json(const char* path, const std::vector<BenchPhysicsResult>& results) -> bool
+{
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) return false;
+    defer { fclose(file); };
+
+    fprintf(file, "[\n");
+    for (usize i = 0; i < results.size(); ++i) {
+        const BenchPhysicsResult& r = results[i];
+        fprintf(file, "{ \"scenario\": \"%s\", \"bodies\": %u, \"threads\": %u, \"steps\": %u, \"setup_ms\": %.3f, \"steps_per_second\": %.2f, "
+            "\"step_ms\": { \"mean\": %.4f, \"p50\": %.4f, \"p99\": %.4f, \"max\": %.4f }, "
+            "\"step_parts_ms\": { \"characters\": %.4f, \"update\": %.4f, \"queries\": %.4f }, "
+            "\"counts\": { \"body_pairs\": %.1f, \"contact_constraints\": %.1f, \"islands\": %.1f }, \"frame_sync_ms\": %.4f, \"update_phases_ms\": { ",
+            r.scene, r.bodies, r.threads, r.steps, r.setup_ms, r.steps_per_second,
+            r.step_mean_ms, r.step_p50_ms, r.step_p99_ms, r.step_max_ms,
+            r.characters_ms, r.update_ms, r.queries_ms,
+            r.body_pairs, r.contact_constraints, r.islands, r.frame_sync_ms);
+        for (usize p = 0; p < std::size(r.update_phases_ms); ++p) {
+            fprintf(file, "%s\"%s\": %.4f", p > 0 ? ", " : "", JPH::PhysicsUpdateStats::sGetPhaseName(static_cast<JPH::EPhysicsUpdatePhase>(p)), r.update_phases_ms[p]);
+        }
+        fprintf(file, " } }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "]\n");
+    return true;
+}
+
+// Position after `"key":` in `line`, or nullptr
+func bench_json_value(const char* line, const char* key) -> const char*
+{
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char* value = strstr(line, pattern);
+    if (value == nullptr) return nullptr;
+    value += strlen(pattern);
+    while (*value == ' ') ++value;
+    return value;
+}
+
+// Reads what bench_physics_write_json() wrote, it's not a general JSON parser: one run per line
+func bench_physics_read_baseline(const char* path, std::vector<BenchPhysicsBaseline>* baseline) -> bool
+{
+    std::vector<u8> data = text_read_file(path);
+    if (data.empty()) return false;
+    data.push_back(0);
+
+    char* line = reinterpret_cast<char*>(data.data());
+    while (line) {
+        char* end = strchr(line, '\n');
+        if (end) *end = 0;
+
+        const char* scene = bench_json_value(line, "scenario");
+        const char* bodies = bench_json_value(line, "bodies");
+        const char* threads = bench_json_value(line, "threads");
+        const char* steps_per_second = bench_json_value(line, "steps_per_second");
+        if (scene && *scene == '"' && bodies && threads && steps_per_second) {
+            const char* scene_end = strchr(scene + 1, '"');
+            if (scene_end) {
+                baseline->push_back({
+                    .scene = std::string(scene + 1, scene_end),
+                    .bodies = static_cast<u32>(strtoul(bodies, nullptr, 10)),
+                    .threads = static_cast<u32>(strtoul(threads, nullptr, 10)),
+                    .steps_per_second = strtod(steps_per_second, nullptr),
+                });
+            }
+        }
+        line = end ? end + 1 : nullptr;
+    }
+    return true;
+}
+
+func bench_physics(BenchContext* ctx) -> void
+{
+    const BenchOptions* options = ctx->options;
+
+    std::vector<u32> scenes = options->scenes;
+    if (scenes.empty()) {
+        for (u32 i = 0; i < SCENE_NUM; ++i) scenes.push_back(i);
+    }
+
+    std::vector<u32> threads = options->threads;
+    if (threads.empty()) {
+        threads.push_back(1);
+        const u32 num_hardware_threads = std::thread::hardware_concurrency();
+        if (num_hardware_threads > 1) threads.push_back(num_hardware_threads);
+    }
+
+    std::vector<BenchPhysicsResult> results;
+    for (u32 type : scenes) {
+        std::vector<u32> bodies = options->bodies;
+        if (bodies.empty()) bodies.assign(std::begin(scene_infos[type].default_bodies), std::end(scene_infos[type].default_bodies));
+
+        for (u32 num_bodies : bodies) {
+            for (u32 num_threads : threads) {
+                const BenchPhysicsResult r = bench_physics_run(ctx, static_cast<SceneType>(type), num_bodies, num_threads, options->num_steps, BROAD_PHASE_TYPE);
+                LOG("[bench] physics: %-17s %6d bodies %3d threads | %8.1f steps/s | step mean %7.3f p50 %7.3f p99 %7.3f max %7.3f ms | characters %6.3f update %7.3f queries %6.3f ms | %.0f pairs %.0f contacts %.0f islands | setup %.1f ms",
+                    r.scene, r.bodies, r.threads, r.steps_per_second, r.step_mean_ms, r.step_p50_ms, r.step_p99_ms, r.step_max_ms, r.characters_ms, r.update_ms, r.queries_ms, r.body_pairs, r.contact_constraints, r.islands, r.setup_ms);
+                results.push_back(r);
+            }
+        }
+    }
+
+    if (options->json_path) {
+        if (bench_physics_write_json(options->json_path, results)) {
+            LOG("[bench] physics: wrote %s", options->json_path);
+        } else {
+            LOG("[bench] physics: failed to write %s", options->json_path);
+            ctx->failed = true;
+        }
+    }
+
+    if (options->baseline_path) {
+        std::vector<BenchPhysicsBaseline> baseline;
+        if (!bench_physics_read_baseline(options->baseline_path, &baseline)) {
+            LOG("[bench] physics: failed to read baseline %s", options->baseline_path);
+            ctx->failed = true;
+            return;
+        }
+
+        u32 num_regressions = 0;
+        for (const BenchPhysicsResult& r : results) {
+            const BenchPhysicsBaseline* b = nullptr;
+            for (const BenchPhysicsBaseline& candidate : baseline) {
+                if (candidate.scene == r.scene && candidate.bodies == r.bodies && candidate.threads == r.threads) b = &candidate;
+            }
+            if (b == nullptr || b->steps_per_second <= 0.0) {
+                LOG("[bench] physics: %-17s %6d bodies %3d threads | not in baseline", r.scene, r.bodies, r.threads);
+                continue;
+            }
+
+            const f64 ratio = r.steps_per_second / b->steps_per_second;
+            const bool is_regression = ratio < 1.0 - options->tolerance;
+            num_regressions += is_regression ? 1 : 0;
+            LOG("[bench] physics: %-17s %6d bodies %3d threads | %8.1f vs %8.1f steps/s (%+.1f%%)%s", r.scene, r.bodies, r.threads, r.steps_per_second, b->steps_per_second, (ratio - 1.0) * 100.0,
+                is_regression ? " REGRESSION" : ratio > 1.0 + options->tolerance ? " faster" : "");
+        }
+
+        LOG("[bench] physics: %d of %d runs slower than the baseline by more than %.0f%%", num_regressions, static_cast<i32>(results.size()), options->tolerance * 100.0);
+        if (num_regressions > 0) ctx->failed = true;
+    }
+}
+
+//
+// Zero alloc: checks that PhysicsSystem::Update doesn't touch the heap once a scene settled. Every scene runs
+// BENCH_ZERO_ALLOC_WARMUP_STEPS steps, then the heap allocations in Update (see alloc_watch_install()) and the temp
+// allocator overflows of BENCH_ZERO_ALLOC_STEPS more steps are counted. Fails and logs the call sites when any of those
+// steps allocated. Takes --scenes and the first of --bodies, the smaller default body count otherwise.
+//
+#define BENCH_ZERO_ALLOC_WARMUP_STEPS 300 // Long enough for the broad phase node pool to reach its high water mark in the terrain scene
+#define BENCH_ZERO_ALLOC_STEPS 480
+
+func bench_zero_alloc(BenchContext* ctx) -> void
+{
+    const BenchOptions* options = ctx->options;
+
+    std::vector<u32> scenes = options->scenes;
+    if (scenes.empty()) {
+        for (u32 i = 0; i < SCENE_NUM; ++i) scenes.push_back(i);
+    }
+
+    alloc_watch_install();
+    defer { alloc_watch_uninstall(); };
+
+    for (u32 type : scenes) {
+        const u32 num_bodies = options->bodies.empty() ? scene_infos[type].default_bodies[0] : options->bodies[0];
+
+        Scene scene = {};
+        scene_create(&scene, static_cast<SceneType>(type), num_bodies, ctx->broad_phase_layer_interface, ctx->object_vs_broad_phase_layer_filter, ctx->object_layer_pair_filter, BROAD_PHASE_TYPE);
+        defer { scene_destroy(&scene); };
+
+        SceneStepStats stats;
+        for (u32 i = 0; i < BENCH_ZERO_ALLOC_WARMUP_STEPS; ++i) scene_step(&scene, ctx->temp_allocator, ctx->job_system, &stats);
+
+        alloc_watch_clear();
+        scene.watch_allocations = true;
+
+        u32 num_allocating_steps = 0, num_allocations = 0, num_overflows = 0, first_step = 0;
+        for (u32 i = 0; i < BENCH_ZERO_ALLOC_STEPS; ++i) {
+            ctx->temp_allocator->ResetPeakUsage();
+            scene_step(&scene, ctx->temp_allocator, ctx->job_system, &stats);
+            const u32 overflows = ctx->temp_allocator->GetStats().mNumOverflows;
+            if (stats.update_allocations > 0 || overflows > 0) {
+                if (num_allocating_steps == 0) first_step = scene.step;
+                num_allocating_steps += 1;
+            }
+            num_allocations += stats.update_allocations;
+            num_overflows += overflows;
+        }
+
+        if (num_allocating_steps == 0) {
+            LOG("[bench] zero_alloc: %-17s %6d bodies | ok, %d steps without allocations", scene_infos[type].name, num_bodies, BENCH_ZERO_ALLOC_STEPS);
+            continue;
+        }
+        LOG("[bench] zero_alloc: %-17s %6d bodies | FAILED, %d of %d steps allocated (first is step %d): %d heap allocations, %d temp allocator overflows",
+            scene_infos[type].name, num_bodies, num_allocating_steps, BENCH_ZERO_ALLOC_STEPS, first_step, num_allocations, num_overflows);
+        alloc_watch_report("[bench] zero_alloc:");
+        ctx->failed = true;
+    }
+}
+
+//
+// Determinism: every scene runs in lock step on JPH::JobSystemSingleThreaded (the reference) and on thread pools with 1, 2, 4
+// ... hardware threads, a hash of PhysicsSystem::SaveState is compared after every step. At the first step where a run
+// diverges the scene stops and the runs that diverged are bisected to the first body and the first contact whose saved state
+// differs. Built with JPH_ENABLE_DETERMINISM_LOG every step also writes the DeterminismLog of each run to
+// detlog_<scene>_<threads>.txt and the first line of the diverging step that the run didn't log is reported. Takes --scenes,
+// the first of --bodies (the smaller default body count otherwise), --threads and --steps.
+//
+
+struct BenchDeterminismRun
+{
+    u32 num_threads; // 0 for the reference
+    JPH::JobSystem* job_system;
+    Scene scene;
+    u64 hash;
+};
+
+// Saves the bodies in one range of body indices and their contacts with bodies in another range, no constraints
+struct BenchDeterminismFilter final : public JPH::StateRecorderFilter
+{
+    struct Range
+    {
+        u32 begin, end;
+
+        auto contains(JPH::BodyID id) const -> bool { return id.GetIndex() >= begin && id.GetIndex() < end; }
+    };
+
+    Range bodies;
+    Range contacts_with;
+
+    BenchDeterminismFilter(Range b, Range c) : bodies(b), contacts_with(c) {}
+
+    virtual bool ShouldSaveBody(const JPH::Body& body) const override { return bodies.contains(body.GetID()); }
+    virtual bool ShouldSaveConstraint(const JPH::Constraint&) const override { return false; }
+    virtual bool ShouldSaveContact(const JPH::BodyID& body1, const JPH::BodyID& body2) const override { return bodies.contains(body1) && contacts_with.contains(body2); }
+};
+
+func bench_determinism_hash(const JPH::PhysicsSystem* physics_system, JPH::EStateRecorderState state, const JPH::StateRecorderFilter* filter) -> u64
+{
+    JPH::StateRecorderImpl recorder;
+    physics_system->SaveState(recorder, state, filter);
+    const std::string data = recorder.GetData();
+    return JPH::HashBytes(data.data(), static_cast<JPH::uint>(data.size()));
+}
+
+// First index in [begin, end) for which differs(index + 1) is true while differs(index) is false, ~0u if differs(end) isn't
+template<typename Fn> func bench_determinism_bisect(u32 begin, u32 end, const Fn& differs) -> u32
+{
+    if (!differs(end)) return ~0u;
+    while (end - begin > 1) {
+        const u32 mid = begin + (end - begin) / 2;
+        if (differs(mid)) {
+            end = mid;
+        } else {
+            begin = mid;
+        }
+    }
+    return begin;
+}
+
+func bench_determinism_find_body(const JPH::PhysicsSystem* physics_system, u32 index) -> JPH::BodyID
+{
+    JPH::BodyIDVector body_ids;
+    physics_system->GetBodies(body_ids);
+    for (JPH::BodyID id : body_ids) {
+        if (id.GetIndex() == index) return id;
+    }
+    return JPH::BodyID();
+}
+
+func bench_determinism_log_body(const char* label, const JPH::PhysicsSystem* physics_system, u32 index) -> void
+{
+    const JPH::BodyID id = bench_determinism_find_body(physics_system, index);
+    if (id.IsInvalid()) {
+        LOG("[bench] determinism:     %s: no body %u", label, index);
+        return;
+    }
+    const JPH::BodyInterface& bi = physics_system->GetBodyInterfaceNoLock();
+    const JPH::RVec3 p = bi.GetCenterOfMassPosition(id);
+    const JPH::Vec3 v = bi.GetLinearVelocity(id);
+    const JPH::Vec3 w = bi.GetAngularVelocity(id);
+    LOG("[bench] determinism:     %s: position (%.9g %.9g %.9g) velocity (%.9g %.9g %.9g) angular (%.9g %.9g %.9g)%s", label,
+        static_cast<f64>(p.GetX()), static_cast<f64>(p.GetY()), static_cast<f64>(p.GetZ()), static_cast<f64>(v.GetX()), static_cast<f64>(v.GetY()), static_cast<f64>(v.GetZ()),
+        static_cast<f64>(w.GetX()), static_cast<f64>(w.GetY()), static_cast<f64>(w.GetZ()), bi.IsActive(id) ? "" : " sleeping");
+}
+
+#if defined(JPH_ENABLE_DETERMINISM_LOG)
+
+func bench_determinism_log_path(char* path, usize size, SceneType type, u32 num_threads) -> void
+{
+    if (num_threads == 0) {
+        snprintf(path, size, "detlog_%s_ref.txt", scene_infos[type].name);
+    } else {
+        snprintf(path, size, "detlog_%s_%u.txt", scene_infos[type].name, num_threads);
+    }
+}
+
+func bench_determinism_read_lines(const char* path) -> std::vector<std::string>
+{
+    std::vector<std::string> lines;
+    const std::vector<u8> data = text_read_file(path);
+    const char* s = reinterpret_cast<const char*>(data.data());
+    const char* end = s + data.size();
+    while (s < end) {
+        const char* line_end = std::find(s, end, '\n');
+        lines.emplace_back(s, line_end);
+        s = line_end + 1;
+    }
+    return lines;
+}
+
+// Jobs log in any order, so the logs are compared as sets of lines. Reports the first line of the reference (which logs in
+// the order the single threaded job system ran the jobs) that the run didn't log.
+func bench_determinism_compare_logs(SceneType type, u32 num_threads) -> void
+{
+    char reference_path[128], run_path[128];
+    bench_determinism_log_path(reference_path, sizeof(reference_path), type, 0);
+    bench_determinism_log_path(run_path, sizeof(run_path), type, num_threads);
+
+    const std::vector<std::string> reference = bench_determinism_read_lines(reference_path);
+    const std::vector<std::string> run = bench_determinism_read_lines(run_path);
+
+    std::unordered_map<std::string, i32> run_lines;
+    for (const std::string& line : run) run_lines[line] += 1;
+
+    u32 num_missing = 0;
+    const std::string* first_missing = nullptr;
+    for (const std::string& line : reference) {
+        auto it = run_lines.find(line);
+        if (it != run_lines.end() && it->second > 0) {
+            it->second -= 1;
+            continue;
+        }
+        if (first_missing == nullptr) first_missing = &line;
+        num_missing += 1;
+    }
+
+    if (first_missing == nullptr) {
+        LOG("[bench] determinism:     log: %s and %s have the same %d lines", reference_path, run_path, static_cast<i32>(reference.size()));
+        return;
+    }
+    LOG("[bench] determinism:     log: %u of %d lines of %s are missing from %s (%d lines), first: %s",
+        num_missing, static_cast<i32>(reference.size()), reference_path, run_path, static_cast<i32>(run.size()), first_missing->c_str());
+}
+
+#endif // JPH_ENABLE_DETERMINISM_LOG
+
+// Called for a run whose state hash differs from the reference after a step
+func bench_determinism_report(const BenchDeterminismRun& reference, const BenchDeterminismRun& run) -> void
+{
+    const JPH::PhysicsSystem* a = reference.scene.physics_system;
+    const JPH::PhysicsSystem* b = run.scene.physics_system;
+    const u32 max_bodies = a->GetMaxBodies();
+
+    const JPH::EPhysicsUpdateError errors = reference.scene.update_errors | run.scene.update_errors;
+    if (errors != JPH::EPhysicsUpdateError::None) {
+        LOG("[bench] determinism:     Update ran out of%s%s%s, which drops contacts depending on the order of the jobs",
+            (errors & JPH::EPhysicsUpdateError::ManifoldCacheFull) != JPH::EPhysicsUpdateError::None ? " manifolds" : "",
+            (errors & JPH::EPhysicsUpdateError::BodyPairCacheFull) != JPH::EPhysicsUpdateError::None ? " body pairs" : "",
+            (errors & JPH::EPhysicsUpdateError::ContactConstraintsFull) != JPH::EPhysicsUpdateError::None ? " contact constraints" : "");
+    }
+
+    // Bodies with an index below `end`
+    const u32 body = bench_determinism_bisect(0, max_bodies, [a, b, max_bodies](u32 end) {
+        const BenchDeterminismFilter filter({ 0, end }, { 0, max_bodies });
+        return bench_determinism_hash(a, JPH::EStateRecorderState::Bodies, &filter) != bench_determinism_hash(b, JPH::EStateRecorderState::Bodies, &filter);
+    });
+    if (body == ~0u) {
+        LOG("[bench] determinism:     all bodies match");
+    } else {
+        LOG("[bench] determinism:     first body that differs: %u", body);
+        bench_determinism_log_body("reference", a, body);
+        bench_determinism_log_body(" diverged", b, body);
+    }
+
+    // Contacts of bodies with an index below `end`, then of that body with bodies below `end`
+    const u32 body1 = bench_determinism_bisect(0, max_bodies, [a, b, max_bodies](u32 end) {
+        const BenchDeterminismFilter filter({ 0, end }, { 0, max_bodies });
+        return bench_determinism_hash(a, JPH::EStateRecorderState::Contacts, &filter) != bench_determinism_hash(b, JPH::EStateRecorderState::Contacts, &filter);
+    });
+    if (body1 == ~0u) {
+        LOG("[bench] determinism:     all contacts match");
+    } else {
+        const u32 body2 = bench_determinism_bisect(0, max_bodies, [a, b, body1](u32 end) {
+            const BenchDeterminismFilter filter({ body1, body1 + 1 }, { 0, end });
+            return bench_determinism_hash(a, JPH::EStateRecorderState::Contacts, &filter) != bench_determinism_hash(b, JPH::EStateRecorderState::Contacts, &filter);
+        });
+        if (body2 == ~0u) {
+            LOG("[bench] determinism:     first contact that differs: body %u, the set of its contacts differs", body1);
+        } else {
+            LOG("[bench] determinism:     first contact that differs: body %u - body %u", body1, body2);
+        }
+    }
+
+    if (body == ~0u && body1 == ~0u) {
+        const bool constraints = bench_determinism_hash(a, JPH::EStateRecorderState::Constraints, nullptr) != bench_determinism_hash(b, JPH::EStateRecorderState::Constraints, nullptr);
+        LOG("[bench] determinism:     %s", constraints ? "constraint state differs" : "only the global state differs");
+    }
+
+#if defined(JPH_ENABLE_DETERMINISM_LOG)
+    bench_determinism_compare_logs(reference.scene.type, run.num_threads);
+#else
+    LOG("[bench] determinism:     build with JPH_ENABLE_DETERMINISM_LOG to compare the DeterminismLog of the step");
+#endif
+}
+
+func bench_determinism(BenchContext* ctx) -> void
+{
+    const BenchOptions* options = ctx->options;
+
+    std::vector<u32> scenes = options->scenes;
+    if (scenes.empty()) {
+        for (u32 i = 0; i < SCENE_NUM; ++i) scenes.push_back(i);
+    }
+
+    std::vector<u32> threads = options->threads;
+    if (threads.empty()) {
+        const u32 num_hardware_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        for (u32 n = 1; n < num_hardware_threads; n *= 2) threads.push_back(n);
+        threads.push_back(num_hardware_threads);
+    }
+
+    for (u32 type : scenes) {
+        const u32 num_bodies = options->bodies.empty() ? scene_infos[type].default_bodies[0] : options->bodies[0];
+
+        std::vector<BenchDeterminismRun> runs(threads.size() + 1);
+        runs[0].job_system = new JPH::JobSystemSingleThreaded(JPH::cMaxPhysicsJobs);
+        for (usize i = 0; i < threads.size(); ++i) {
+            runs[i + 1].num_threads = threads[i];
+            runs[i + 1].job_system = bench_create_physics_job_system(threads[i]);
+        }
+        for (BenchDeterminismRun& run : runs) {
+            scene_create(&run.scene, static_cast<SceneType>(type), num_bodies, ctx->broad_phase_layer_interface, ctx->object_vs_broad_phase_layer_filter, ctx->object_layer_pair_filter, BROAD_PHASE_TYPE);
+        }
+        defer {
+            for (BenchDeterminismRun& run : runs) {
+                scene_destroy(&run.scene);
+                delete run.job_system;
+            }
+        };
+
+        u32 num_diverged = 0;
+        SceneStepStats stats;
+        for (u32 step = 0; step < options->num_steps && num_diverged == 0; ++step) {
+            for (BenchDeterminismRun& run : runs) {
+#if defined(JPH_ENABLE_DETERMINISM_LOG)
+                char path[128];
+                bench_determinism_log_path(path, sizeof(path), static_cast<SceneType>(type), run.num_threads);
+                JPH::DeterminismLog::sLog.Open(path);
+#endif
+                scene_step(&run.scene, ctx->temp_allocator, run.job_system, &stats);
+#if defined(JPH_ENABLE_DETERMINISM_LOG)
+                JPH::DeterminismLog::sLog.Close();
+#endif
+                run.hash = bench_determinism_hash(run.scene.physics_system, JPH::EStateRecorderState::All, nullptr);
+            }
+
+            for (usize i = 1; i < runs.size(); ++i) {
+                if (runs[i].hash == runs[0].hash) continue;
+                LOG("[bench] determinism: %-17s %6d bodies %3d threads | FAILED, diverged from the single threaded job system at step %d",
+                    scene_infos[type].name, num_bodies, runs[i].num_threads, step);
+                bench_determinism_report(runs[0], runs[i]);
+                num_diverged += 1;
+            }
+        }
+
+        if (num_diverged > 0) {
+            ctx->failed = true;
+            continue;
+        }
+        for (usize i = 1; i < runs.size(); ++i) {
+            LOG("[bench] determinism: %-17s %6d bodies %3d threads | ok, %d steps match the single threaded job system", scene_infos[type].name, num_bodies, runs[i].num_threads, options->num_steps);
+        }
+    }
+}
+
+//
+// Thread tuner: every scene runs BENCH_THREAD_TUNER_STEPS steps with PhysicsThreadTuner picking how many threads of a pool
+// with the largest of --threads (all hardware threads by default) are used. Then the update time at the count it picked
+// is measured against 1 and all threads, --steps steps each. The scenes share the tuner, so from the second scene on it
+// also shows how the tuner reacts to a different workload. Takes --scenes, the first of --bodies (the larger default body
+// count otherwise), --threads and --steps.
+//
+#define BENCH_THREAD_TUNER_STEPS 600
+#define BENCH_THREAD_TUNER_SETTLE_STEPS 10
+
+// Mean update time in ms at `num_threads`
+func bench_thread_tuner_measure(BenchContext* ctx, Scene* scene, JPH::JobSystemThreadPool* js, u32 num_threads, u32 num_steps) -> f64
+{
+    js->SetNumThreads(static_cast<i32>(num_threads) - 1);
+
+    SceneStepStats stats;
+    for (u32 i = 0; i < BENCH_THREAD_TUNER_SETTLE_STEPS; ++i) scene_step(scene, ctx->temp_allocator, js, &stats);
+
+    u64 total = 0;
+    for (u32 i = 0; i < num_steps; ++i) {
+        scene_step(scene, ctx->temp_allocator, js, &stats);
+        total += stats.physics.mTotalTime;
+    }
+    return static_cast<f64>(total) * 1.0e-6 / num_steps;
+}
+
+func bench_thread_tuner(BenchContext* ctx) -> void
+{
+    const BenchOptions* options = ctx->options;
+
+    std::vector<u32> scenes = options->scenes;
+    if (scenes.empty()) {
+        for (u32 i = 0; i < SCENE_NUM; ++i) scenes.push_back(i);
+    }
+
+    const u32 max_threads = options->threads.empty() ? std::max(1u, std::thread::hardware_concurrency()) : *std::max_element(options->threads.begin(), options->threads.end());
+    auto js = bench_create_physics_job_system(max_threads);
+    defer { delete js; };
+
+    PhysicsThreadTuner tuner;
+    physics_thread_tuner_init(&tuner, max_threads);
+
+    for (u32 type : scenes) {
+        const u32 num_bodies = options->bodies.empty() ? scene_infos[type].default_bodies[1] : options->bodies[0];
+
+        Scene scene = {};
+        scene_create(&scene, static_cast<SceneType>(type), num_bodies, ctx->broad_phase_layer_interface, ctx->object_vs_broad_phase_layer_filter, ctx->object_layer_pair_filter, BROAD_PHASE_TYPE);
+        defer { scene_destroy(&scene); };
+
+        SceneStepStats stats;
+        u32 num_changes = 0;
+        for (u32 i = 0; i < BENCH_THREAD_TUNER_STEPS; ++i) {
+            scene_step(&scene, ctx->temp_allocator, js, &stats);
+            const i32 num_threads = static_cast<i32>(physics_thread_tuner_add_step(&tuner, static_cast<f64>(stats.physics.mTotalTime) * 1.0e-9));
+            if (num_threads != js->GetMaxConcurrency()) {
+                js->SetNumThreads(num_threads - 1);
+                num_changes += 1;
+            }
+        }
+
+        const u32 picked = tuner.threads;
+        const bool settled = tuner.phase == PHYSICS_THREAD_TUNER_SETTLED;
+        const f64 picked_ms = bench_thread_tuner_measure(ctx, &scene, js, picked, options->num_steps);
+        const f64 one_ms = bench_thread_tuner_measure(ctx, &scene, js, 1, options->num_steps);
+        const f64 all_ms = bench_thread_tuner_measure(ctx, &scene, js, max_threads, options->num_steps);
+        LOG("[bench] thread_tuner: %-17s %6d bodies | %s on %d threads after %d changes | update %.3f ms, 1 thread %.3f ms, %d threads %.3f ms",
+            scene_infos[type].name, num_bodies, settled ? "settled" : "still exploring", picked, num_changes, picked_ms, one_ms, max_threads, all_ms);
+
+        // The next scene starts where the tuner left off
+        js->SetNumThreads(static_cast<i32>(picked) - 1);
+    }
+}
+
+//
+// Broad phase: time to rebuild the broad phase tree after every body moved, at 10k to 1M bodies and several thread counts.
+// Runs twice: once without active bodies, where JPH::PhysicsSystem::Update only rebuilds the tree, and once with every body
+// active and drifting, where the tree is rebuilt by the broad phase prepare job of the step. Both pass the job system on, so
+// trees of more than JPH::QuadTree::cMinParallelBuild bodies are built with BuildTreeParallel when there's more than one
+// thread. The first thread count is always the serial build and the others are checked against it: the surface area cost
+// of the tree may not be worse and the query hits have to be the same. Query time is logged next to it.
+//
+#define BENCH_BROAD_PHASE_ROUNDS 8
+#define BENCH_BROAD_PHASE_MAX_COST_RATIO 1.01
+
+struct BenchBroadPhaseCounter : JPH::CollideShapeBodyCollector
+{
+    u32 hits = 0;
+
+    void AddHit(const JPH::BodyID&) override { hits += 1; }
+};
+
+func bench_broad_phase(BenchContext* ctx) -> void
+{
+    const BenchOptions* options = ctx->options;
+
+    std::vector<u32> bodies = options->bodies;
+    if (bodies.empty()) bodies = { 10000, 100000, 1000000 };
+
+    // The serial build is the reference, always run it and run a parallel build even on a single core
+    std::vector<u32> threads = options->threads;
+    if (threads.empty()) threads.push_back(std::max(std::thread::hardware_concurrency(), 4u));
+    if (threads[0] != 1) threads.insert(threads.begin(), 1);
+
+    for (u32 active = 0; active < 2; ++active) {
+        for (u32 num_bodies : bodies) {
+            // A step of a million active bodies takes seconds, only run it when asked for
+            if (active && options->bodies.empty() && num_bodies > 100000) continue;
+
+            // Always the quad tree, the surface area cost is specific to it
+            auto physics_system = new JPH::PhysicsSystem();
+            defer { delete physics_system; };
+            physics_system->Init(num_bodies, PHY_NUM_BODY_MUTEXES, num_bodies, num_bodies, *ctx->broad_phase_layer_interface, *ctx->object_vs_broad_phase_layer_filter, *ctx->object_layer_pair_filter, JPH::EBroadPhaseType::QuadTree);
+            const JPH::BroadPhaseQuadTree& broad_phase = static_cast<const JPH::BroadPhaseQuadTree&>(physics_system->GetBroadPhaseQuery());
+
+            // A square grid of boxes in a single layer. Active bodies drift along z without gravity or damping so they never
+            // touch, 0.2 m apart in the grid, and the query hits don't change.
+            JPH::BodyInterface& bi = physics_system->GetBodyInterfaceNoLock();
+            const u32 width = static_cast<u32>(std::ceil(std::sqrt(static_cast<f64>(num_bodies))));
+            JPH::RefConst<JPH::Shape> box = new JPH::BoxShape(JPH::Vec3(0.4f, 0.4f, 0.4f));
+            std::vector<JPH::BodyID> ids;
+            ids.reserve(num_bodies);
+            for (u32 i = 0; i < num_bodies; ++i) {
+                JPH::BodyCreationSettings settings(box, JPH::RVec3(static_cast<f32>(i % width), static_cast<f32>(i / width), 0.0f), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, OBJECT_LAYER_MOVING);
+                settings.mGravityFactor = 0.0f;
+                settings.mLinearDamping = 0.0f;
+                settings.mAllowSleeping = false;
+                ids.push_back(bi.CreateBody(settings)->GetID());
+            }
+            const JPH::BodyInterface::AddState add_state = bi.AddBodiesPrepare(ids.data(), static_cast<i32>(ids.size()));
+            bi.AddBodiesFinalize(ids.data(), static_cast<i32>(ids.size()), add_state, active ? JPH::EActivation::Activate : JPH::EActivation::DontActivate);
+
+            u32 reference_hits = 0;
+            f32 reference_cost = 0.0f;
+            f64 reference_query_ms = 0.0;
+            for (u32 num_threads : threads) {
+                auto js = bench_create_physics_job_system(num_threads);
+                defer { delete js; };
+
+                // Every thread count starts from the grid so that the bodies end up in the same place
+                for (u32 i = 0; i < num_bodies; ++i) {
+                    bi.SetPosition(ids[i], JPH::RVec3(static_cast<f32>(i % width), static_cast<f32>(i / width), 0.0f), JPH::EActivation::DontActivate);
+                    if (active) bi.SetLinearVelocity(ids[i], JPH::Vec3(0.0f, 0.0f, static_cast<f32>(static_cast<i32>(i % 3) - 1)));
+                }
+
+                JPH::PhysicsUpdateStats stats;
+                u64 rebuild_time = 0;
+                for (u32 round = 0; round <= BENCH_BROAD_PHASE_ROUNDS; ++round) {
+                    // Nudge every body so that the whole tree is rebuilt, active bodies move by themselves. The first round is a warm up.
+                    if (!active) {
+                        for (u32 i = 0; i < num_bodies; ++i) {
+                            const f32 offset = 0.05f * static_cast<f32>(static_cast<i32>((i + round) % 3) - 1);
+                            bi.SetPosition(ids[i], JPH::RVec3(static_cast<f32>(i % width) + offset, static_cast<f32>(i / width) - offset, 0.0f), JPH::EActivation::DontActivate);
+                        }
+                    }
+                    physics_system->Update(PHY_FIXED_TIME_STEP, 1, ctx->temp_allocator, js, &stats);
+                    if (round > 0) rebuild_time += active ? stats.GetPhase(JPH::EPhysicsUpdatePhase::BroadPhasePrepare).mWallTime : stats.mTotalTime;
+                }
+
+                // Query boxes spread over the grid, each overlaps a few bodies
+                const u32 num_queries = std::max(num_bodies / 16, 1u);
+                BenchBroadPhaseCounter counter;
+                const f64 begin = bench_time();
+                for (u32 q = 0; q < num_queries; ++q) {
+                    const u32 i = static_cast<u32>((u64(q) * 2654435761u) % num_bodies);
+                    const JPH::Vec3 center(static_cast<f32>(i % width), static_cast<f32>(i / width), 0.0f);
+                    physics_system->GetBroadPhaseQuery().CollideAABox(JPH::AABox(center - JPH::Vec3::sReplicate(1.5f), center + JPH::Vec3::sReplicate(1.5f)), counter);
+                }
+                const f64 query_ms = (bench_time() - begin) * 1000.0;
+                const f32 cost = broad_phase.ComputeSurfaceAreaCost();
+
+                if (num_threads == threads[0]) {
+                    reference_hits = counter.hits;
+                    reference_cost = cost;
+                    reference_query_ms = query_ms;
+                }
+
+                LOG("[bench] broad_phase: %-8s %7u bodies %3u threads | rebuild %8.3f ms | cost %9.2f (%+.2f%%) | %u queries %8.3f ms (%+.1f%%), %u hits",
+                    active ? "active" : "inactive", num_bodies, num_threads, static_cast<f64>(rebuild_time) * 1.0e-6 / BENCH_BROAD_PHASE_ROUNDS,
+                    static_cast<f64>(cost), (static_cast<f64>(cost) / static_cast<f64>(reference_cost) - 1.0) * 100.0, num_queries, query_ms, (query_ms / reference_query_ms - 1.0) * 100.0, counter.hits);
+
+                if (counter.hits != reference_hits) {
+                    LOG("[bench] broad_phase: %u hits with %u threads, the serial build has %u", counter.hits, num_threads, reference_hits);
+                    ctx->failed = true;
+                }
+                if (static_cast<f64>(cost) > static_cast<f64>(reference_cost) * BENCH_BROAD_PHASE_MAX_COST_RATIO) {
+                    LOG("[bench] broad_phase: tree cost %.2f with %u threads, the serial build has %.2f", static_cast<f64>(cost), num_threads, static_cast<f64>(reference_cost));
+                    ctx->failed = true;
+                }
+            }
+        }
+    }
+}
+
+//
+// Sweep and prune queries: the same random queries and pair searches on a JPH::BroadPhaseQuadTree and a JPH::BroadPhaseSAP
+// that hold the same bodies, compared as sorted sets of body IDs. Checked on the new broad phases and after a quarter of the
+// bodies was removed, half of those were added back, some changed layer and some moved far away. The queries run right after
+// every change, while the sweep and prune still has the bodies on its pending and moved lists and both broad phases report a
+// moved body at its old and new bounds, and again after JPH::PhysicsSystem::OptimizeBroadPhase. Pair searches only run after
+// it: JPH::PhysicsSystem::Update syncs the broad phase before it looks for pairs and the quad tree reports pairs on the grown
+// bounds until its tree is rebuilt.
+//
+#define BENCH_SAP_QUERY_BODIES 4000
+#define BENCH_SAP_QUERY_ROUNDS 256
+#define BENCH_SAP_QUERY_TYPES 7
+
+static const char* bench_sap_query_names[BENCH_SAP_QUERY_TYPES] = {
+    "CastRay", "CollideAABox", "CollideSphere", "CollidePoint", "CollideOrientedBox", "CastAABox", "CastAABoxNoLock",
+};
+
+struct BenchBodyIdCollector : JPH::CollideShapeBodyCollector
+{
+    std::vector<u64> ids;
+
+    void AddHit(const JPH::BodyID& id) override { ids.push_back(id.GetIndexAndSequenceNumber()); }
+};
+
+struct BenchRayCastIdCollector : JPH::RayCastBodyCollector
+{
+    std::vector<u64> ids;
+
+    void AddHit(const JPH::BroadPhaseCastResult& result) override { ids.push_back(result.mBodyID.GetIndexAndSequenceNumber()); }
+};
+
+struct BenchCastShapeIdCollector : JPH::CastShapeBodyCollector
+{
+    std::vector<u64> ids;
+
+    void AddHit(const JPH::BroadPhaseCastResult& result) override { ids.push_back(result.mBodyID.GetIndexAndSequenceNumber()); }
+};
+
+struct BenchPairIdCollector : JPH::BodyPairCollector
+{
+    std::vector<u64> ids;
+
+    void AddHit(const JPH::BodyPair& pair) override
+    {
+        const u64 a = pair.mBodyA.GetIndexAndSequenceNumber();
+        const u64 b = pair.mBodyB.GetIndexAndSequenceNumber();
+        ids.push_back((std::min(a, b) << 32) | std::max(a, b));
+    }
+};
+
+func bench_sap_random_position(u32* random_state) -> JPH::Vec3
+{
+    const f32 x = 50.0f * (fracture_random(random_state) - 0.5f);
+    const f32 y = 50.0f * (fracture_random(random_state) - 0.5f);
+    const f32 z = 50.0f * (fracture_random(random_state) - 0.5f);
+    return JPH::Vec3(x, y, z);
+}
+
+// Runs BENCH_SAP_QUERY_ROUNDS rounds of every query type, with the same random numbers on every call. Odd rounds only look
+// for what a non moving object collides with, every eighth round is where the far bodies went. The hits of every query are
+// sorted, the pairs of the pair search are the last entry.
+func bench_sap_run_queries(BenchContext* ctx, JPH::PhysicsSystem* physics_system, bool find_pairs) -> std::vector<std::vector<u64>>
+{
+    const JPH::BroadPhase& query = static_cast<const JPH::BroadPhase&>(physics_system->GetBroadPhaseQuery());
+    const JPH::BroadPhaseLayerFilter all_broad_phase_layers;
+    const JPH::ObjectLayerFilter all_object_layers;
+    const JPH::DefaultBroadPhaseLayerFilter non_moving_broad_phase_layers(*ctx->object_vs_broad_phase_layer_filter, OBJECT_LAYER_NON_MOVING);
+    const JPH::DefaultObjectLayerFilter non_moving_object_layers(*ctx->object_layer_pair_filter, OBJECT_LAYER_NON_MOVING);
+
+    std::vector<std::vector<u64>> results;
+    results.reserve(BENCH_SAP_QUERY_ROUNDS * BENCH_SAP_QUERY_TYPES + 1);
+    u32 random_state = 0x85ebca6b;
+    for (u32 round = 0; round < BENCH_SAP_QUERY_ROUNDS; ++round) {
+        const JPH::BroadPhaseLayerFilter& broad_phase_filter = (round & 1) ? non_moving_broad_phase_layers : all_broad_phase_layers;
+        const JPH::ObjectLayerFilter& object_filter = (round & 1) ? non_moving_object_layers : all_object_layers;
+        const JPH::Vec3 far_offset = (round % 8 == 7) ? JPH::Vec3(1000.0f, 0.0f, 0.0f) : JPH::Vec3::sZero();
+        const JPH::Vec3 from = bench_sap_random_position(&random_state) + far_offset;
+        const JPH::Vec3 to = bench_sap_random_position(&random_state) + far_offset;
+        const JPH::Vec3 half_extent = JPH::Vec3::sReplicate(0.5f + 4.0f * fracture_random(&random_state));
+        const JPH::Quat rotation = JPH::Quat::sRotation(JPH::Vec3(1.0f, 2.0f, 3.0f).Normalized(), 2.0f * JPH::JPH_PI * fracture_random(&random_state));
+        const JPH::AABoxCast box_cast { JPH::AABox(from - half_extent, from + half_extent), to - from };
+
+        BenchRayCastIdCollector ray;
+        query.CastRay(JPH::RayCast(from, to - from), ray, broad_phase_filter, object_filter);
+        results.push_back(std::move(ray.ids));
+
+        BenchBodyIdCollector box, sphere, point, oriented_box;
+        query.CollideAABox(box_cast.mBox, box, broad_phase_filter, object_filter);
+        query.CollideSphere(from, half_extent.GetX(), sphere, broad_phase_filter, object_filter);
+        query.CollidePoint(from, point, broad_phase_filter, object_filter);
+        query.CollideOrientedBox(JPH::OrientedBox(JPH::Mat44::sRotationTranslation(rotation, from), half_extent), oriented_box, broad_phase_filter, object_filter);
+        results.push_back(std::move(box.ids));
+        results.push_back(std::move(sphere.ids));
+        results.push_back(std::move(point.ids));
+        results.push_back(std::move(oriented_box.ids));
+
+        BenchCastShapeIdCollector cast, cast_no_lock;
+        query.CastAABox(box_cast, cast, broad_phase_filter, object_filter);
+        query.CastAABoxNoLock(box_cast, cast_no_lock, broad_phase_filter, object_filter);
+        results.push_back(std::move(cast.ids));
+        results.push_back(std::move(cast_no_lock.ids));
+    }
+
+    if (find_pairs) {
+        JPH::BodyIDVector active_bodies;
+        physics_system->GetActiveBodies(JPH::EBodyType::RigidBody, active_bodies);
+        BenchPairIdCollector pairs;
+        query.FindCollidingPairs(active_bodies.data(), static_cast<i32>(active_bodies.size()), physics_system->GetPhysicsSettings().mSpeculativeContactDistance,
+            *ctx->object_vs_broad_phase_layer_filter, *ctx->object_layer_pair_filter, pairs);
+        results.push_back(std::move(pairs.ids));
+    }
+
+    for (std::vector<u64>& ids : results) std::sort(ids.begin(), ids.end());
+    return results;
+}
+
+func bench_sap_compare_queries(BenchContext* ctx, JPH::PhysicsSystem* quad, JPH::PhysicsSystem* sap, const char* state, bool find_pairs) -> void
+{
+    const std::vector<std::vector<u64>> quad_results = bench_sap_run_queries(ctx, quad, find_pairs);
+    const std::vector<std::vector<u64>> sap_results = bench_sap_run_queries(ctx, sap, find_pairs);
+
+    u32 num_hits = 0;
+    u32 num_mismatches = 0;
+    for (usize i = 0; i < quad_results.size(); ++i) {
+        num_hits += static_cast<u32>(quad_results[i].size());
+        if (quad_results[i] == sap_results[i]) continue;
+
+        const bool is_pairs = i == BENCH_SAP_QUERY_ROUNDS * BENCH_SAP_QUERY_TYPES;
+        if (num_mismatches < 8) {
+            LOG("[bench] sweep_and_prune: %-28s | %s %u found %zu hits, the quad tree %zu", state, is_pairs ? "FindCollidingPairs" : bench_sap_query_names[i % BENCH_SAP_QUERY_TYPES],
+                is_pairs ? 0u : static_cast<u32>(i / BENCH_SAP_QUERY_TYPES), sap_results[i].size(), quad_results[i].size());
+        }
+        num_mismatches += 1;
+    }
+
+    const usize num_pairs = find_pairs ? quad_results.back().size() : 0;
+    LOG("[bench] sweep_and_prune: %-28s | %u queries, %u hits, %zu pairs, %u mismatches", state, BENCH_SAP_QUERY_ROUNDS * BENCH_SAP_QUERY_TYPES, num_hits - static_cast<u32>(num_pairs), num_pairs, num_mismatches);
+    if (num_mismatches > 0) ctx->failed = true;
+}
+
+func bench_sap_queries(BenchContext* ctx) -> void
+{
+    JPH::PhysicsSystem* systems[2];
+    const JPH::EBroadPhaseType types[2] = { JPH::EBroadPhaseType::QuadTree, JPH::EBroadPhaseType::SweepAndPrune };
+    for (u32 s = 0; s < 2; ++s) {
+        systems[s] = new JPH::PhysicsSystem();
+        systems[s]->Init(BENCH_SAP_QUERY_BODIES, PHY_NUM_BODY_MUTEXES, BENCH_SAP_QUERY_BODIES, BENCH_SAP_QUERY_BODIES, *ctx->broad_phase_layer_interface, *ctx->object_vs_broad_phase_layer_filter, *ctx->object_layer_pair_filter, types[s]);
+    }
+    defer {
+        delete systems[0];
+        delete systems[1];
+    };
+
+    // Every change is made to both, so the bodies get the same IDs
+    auto for_each_system = [&](auto&& fn) {
+        for (JPH::PhysicsSystem* physics_system : systems) fn(physics_system->GetBodyInterfaceNoLock());
+    };
+    auto compare = [&](const char* state) {
+        bench_sap_compare_queries(ctx, systems[0], systems[1], state, false);
+        for (JPH::PhysicsSystem* physics_system : systems) physics_system->OptimizeBroadPhase();
+        char synced_state[64];
+        snprintf(synced_state, sizeof(synced_state), "%s, optimized", state);
+        bench_sap_compare_queries(ctx, systems[0], systems[1], synced_state, true);
+    };
+
+    // Boxes in a 50 m cube, a quarter static, half of the dynamic ones active. Every 64th box is big enough to end up on the
+    // large body list of the sweep and prune. They are added in two batches like the scenes do, bodies added one by one are
+    // all linked in at the root of the quad tree and queries overflow its stack before the tree is rebuilt.
+    std::vector<JPH::BodyID> ids(BENCH_SAP_QUERY_BODIES);
+    std::vector<JPH::Vec3> positions(BENCH_SAP_QUERY_BODIES);
+    for (u32 s = 0; s < 2; ++s) {
+        JPH::BodyInterface& bi = systems[s]->GetBodyInterfaceNoLock();
+        u32 random_state = 0x27d4eb2d;
+        std::vector<JPH::BodyID> batches[2];
+        for (u32 i = 0; i < BENCH_SAP_QUERY_BODIES; ++i) {
+            positions[i] = bench_sap_random_position(&random_state);
+            const f32 scale = (i % 64 == 63) ? 20.0f : 1.0f;
+            const JPH::Vec3 half_extent = scale * JPH::Vec3(0.1f + 0.9f * fracture_random(&random_state), 0.1f + 0.9f * fracture_random(&random_state), 0.1f + 0.9f * fracture_random(&random_state));
+            const bool is_static = i % 4 == 0;
+            JPH::BodyCreationSettings settings(new JPH::BoxShape(half_extent), JPH::RVec3(positions[i]), JPH::Quat::sIdentity(), is_static ? JPH::EMotionType::Static : JPH::EMotionType::Dynamic, is_static ? OBJECT_LAYER_NON_MOVING : OBJECT_LAYER_MOVING);
+            const JPH::BodyID id = bi.CreateBody(settings)->GetID();
+            batches[i % 2].push_back(id);
+            if (s == 0) ids[i] = id;
+            else JPH_ASSERT(id == ids[i]);
+        }
+        for (u32 b = 0; b < 2; ++b) {
+            const JPH::BodyInterface::AddState add_state = bi.AddBodiesPrepare(batches[b].data(), static_cast<i32>(batches[b].size()));
+            bi.AddBodiesFinalize(batches[b].data(), static_cast<i32>(batches[b].size()), add_state, b == 1 ? JPH::EActivation::Activate : JPH::EActivation::DontActivate);
+        }
+    }
+    compare("added");
+
+    for_each_system([&](JPH::BodyInterface& bi) {
+        for (u32 i = 1; i < BENCH_SAP_QUERY_BODIES; i += 4) bi.RemoveBody(ids[i]);
+    });
+    compare("removed");
+
+    for_each_system([&](JPH::BodyInterface& bi) {
+        for (u32 i = 1; i < BENCH_SAP_QUERY_BODIES; i += 8) bi.AddBody(ids[i], JPH::EActivation::Activate);
+    });
+    compare("added back");
+
+    // Inactive dynamic bodies become non moving and some static bodies moving
+    for_each_system([&](JPH::BodyInterface& bi) {
+        for (u32 i = 0; i < BENCH_SAP_QUERY_BODIES; ++i) {
+            if (i % 8 == 2) bi.SetObjectLayer(ids[i], OBJECT_LAYER_NON_MOVING);
+            else if (i % 16 == 0) bi.SetObjectLayer(ids[i], OBJECT_LAYER_MOVING);
+        }
+    });
+    compare("changed layer");
+
+    for_each_system([&](JPH::BodyInterface& bi) {
+        for (u32 i = 3; i < BENCH_SAP_QUERY_BODIES; i += 8) bi.SetPosition(ids[i], JPH::RVec3(positions[i] + JPH::Vec3(1000.0f, 0.0f, 0.0f)), JPH::EActivation::DontActivate);
+    });
+    compare("moved far");
+}
+
+//
+// Sweep and prune: runs the scenes with JPH::BroadPhaseQuadTree and with JPH::BroadPhaseSAP and compares the step time,
+// the update time, BroadPhase::FrameSync and the broad phase phases of the update. The sweep and prune broad phase sorts in
+// FrameSync while the quad tree builds its new tree in prepare, so compare frame sync + prepare. Both report every pair of bodies whose bounds overlap, so the body pairs of
+// the first step have to match, later steps diverge because the pairs reach the solver in a different order. Takes
+// --scenes, --bodies, --threads and --steps like bench_physics. Starts with bench_sap_queries, which compares the hits of
+// every query on both broad phases.
+//
+func bench_sweep_and_prune(BenchContext* ctx) -> void
+{
+    const BenchOptions* options = ctx->options;
+
+    bench_sap_queries(ctx);
+
+    std::vector<u32> scenes = options->scenes;
+    if (scenes.empty()) {
+        for (u32 i = 0; i < SCENE_NUM; ++i) scenes.push_back(i);
+    }
+
+    std::vector<u32> threads = options->threads;
+    if (threads.empty()) {
+        threads.push_back(1);
+        const u32 num_hardware_threads = std::thread::hardware_concurrency();
+        if (num_hardware_threads > 1) threads.push_back(num_hardware_threads);
+    }
+
+    constexpr usize prepare = static_cast<usize>(JPH::EPhysicsUpdatePhase::BroadPhasePrepare);
+    constexpr usize find_collisions = static_cast<usize>(JPH::EPhysicsUpdatePhase::FindCollisions);
+    constexpr usize finalize = static_cast<usize>(JPH::EPhysicsUpdatePhase::BroadPhaseFinalize);
+
+    for (u32 type : scenes) {
+        std::vector<u32> bodies = options->bodies;
+        if (bodies.empty()) bodies.assign(std::begin(scene_infos[type].default_bodies), std::end(scene_infos[type].default_bodies));
+
+        for (u32 num_bodies : bodies) {
+            for (u32 num_threads : threads) {
+                const BenchPhysicsResult quad = bench_physics_run(ctx, static_cast<SceneType>(type), num_bodies, num_threads, options->num_steps, JPH::EBroadPhaseType::QuadTree);
+                const BenchPhysicsResult sap = bench_physics_run(ctx, static_cast<SceneType>(type), num_bodies, num_threads, options->num_steps, JPH::EBroadPhaseType::SweepAndPrune);
+                LOG("[bench] sweep_and_prune: %-17s %6d bodies %3d threads | step %7.3f vs %7.3f ms (%+.1f%%) | update %7.3f vs %7.3f ms | frame sync %6.3f vs %6.3f prepare %6.3f vs %6.3f find collisions %7.3f vs %7.3f finalize %6.3f vs %6.3f ms | %.0f vs %.0f pairs",
+                    quad.scene, quad.bodies, quad.threads, quad.step_mean_ms, sap.step_mean_ms, (sap.step_mean_ms / quad.step_mean_ms - 1.0) * 100.0, quad.update_ms, sap.update_ms,
+                    quad.frame_sync_ms, sap.frame_sync_ms, quad.update_phases_ms[prepare], sap.update_phases_ms[prepare], quad.update_phases_ms[find_collisions], sap.update_phases_ms[find_collisions],
+                    quad.update_phases_ms[finalize], sap.update_phases_ms[finalize], quad.body_pairs, sap.body_pairs);
+
+                if (quad.first_body_pairs != sap.first_body_pairs) {
+                    LOG("[bench] sweep_and_prune: %-17s %6d bodies %3d threads | first step found %d pairs, the quad tree %d", quad.scene, quad.bodies, quad.threads, sap.first_body_pairs, quad.first_body_pairs);
+                    ctx->failed = true;
+                }
+            }
+        }
+    }
+}
+
+struct Benchmark
+{
+    const char* name;
+    void (*fn)(BenchContext* ctx);
+};
+
+static const Benchmark benchmarks[] = {
+    { "fracture", bench_fracture },
+    { "stroke", bench_stroke },
+    { "sim", bench_sim },
+    { "text", bench_text },
+    { "jobs", bench_jobs },
+    { "semaphore", bench_semaphore },
+    { "topology", bench_topology },
+    { "priorities", bench_priorities },
+    { "coroutines", bench_coroutines },
+    { "temp_allocator", bench_temp_allocator },
+    { "alloc", bench_alloc },
+    { "freelist", bench_freelist },
+    { "hashmap", bench_hashmap },
+    { "profile", bench_profile },
+    { "hitch", bench_hitch },
+    { "physics", bench_physics },
+    { "zero_alloc", bench_zero_alloc },
+    { "determinism", bench_determinism },
+    { "thread_tuner", bench_thread_tuner },
+    { "broad_phase", bench_broad_phase },
+    { "sweep_and_prune", bench_sweep_and_prune },
+};
+
+// Comma separated numbers, all greater than zero
+func bench_parse_list(const char* s, std::vector<u32>* out) -> bool
+{
+    out->clear();
+    while (*s) {
+        char* end;
+        const unsigned long value = strtoul(s, &end, 10);
+        if (end == s || value == 0) return false;
+        out->push_back(static_cast<u32>(value));
+        s = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != 0) return false;
+    }
+    return !out->empty();
+}
+
+func bench_parse_scenes(const char* s, std::vector<u32>* out) -> bool
+{
+    out->clear();
+    while (*s) {
+        const char* end = strchr(s, ',');
+        const std::string name = end ? std::string(s, end) : std::string(s);
+        const i32 type = scene_find(name.c_str());
+        if (type < 0) return false;
+        out->push_back(static_cast<u32>(type));
+        s = end ? end + 1 : s + name.size();
+    }
+    return !out->empty();
+}
+
+func bench_parse_option(const char* arg, BenchOptions* options) -> bool
+{
+    const char* value = strchr(arg, '=');
+    if (value == nullptr) return false;
+    const std::string name(arg, value);
+    value += 1;
+
+    if (name == "--scenes") return bench_parse_scenes(value, &options->scenes);
+    if (name == "--bodies") return bench_parse_list(value, &options->bodies);
+    if (name == "--threads") return bench_parse_list(value, &options->threads);
+    if (name == "--steps") {
+        options->num_steps = static_cast<u32>(strtoul(value, nullptr, 10));
+        return options->num_steps > 0;
+    }
+    if (name == "--json") {
+        options->json_path = value;
+        return true;
+    }
+    if (name == "--baseline") {
+        options->baseline_path = value;
+        return true;
+    }
+    if (name == "--tolerance") {
+        options->tolerance = strtod(value, nullptr);
+        return options->tolerance >= 0.0;
+    }
+    return false;
+}
+
+auto main(i32 argc, char** argv) -> i32
+{
+    const char* filter = nullptr;
+    BenchOptions options = {
+        .num_steps = 120,
+        .tolerance = 0.1,
+    };
+    for (i32 i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--", 2) != 0) {
+            filter = argv[i];
+        } else if (!bench_parse_option(argv[i], &options)) {
+            LOG("[bench] Invalid option '%s', see the top of game_bench.cpp", argv[i]);
+            return 1;
+        }
+    }
+
+    alloc_init();
+
+    JPH::Trace = jolt_trace;
+    JPH_IF_ENABLE_ASSERTS(JPH::AssertFailed = jolt_assert_failed;);
+
+    JPH::Factory::sInstance = new JPH::Factory();
+
+    JPH::RegisterTypes();
+
+    BenchContext ctx = {
+        .temp_allocator = new JPH::TempAllocatorGrowing(PHY_TEMP_ALLOCATOR_SIZE),
+        .job_system = new JPH::JobSystemThreadPool(),
+        .object_layer_pair_filter = new ObjectLayerPairFilter(),
+        .broad_phase_layer_interface = new BroadPhaseLayerInterface(),
+        .object_vs_broad_phase_layer_filter = new ObjectVsBroadPhaseLayerFilter(),
+        .options = &options,
+        .failed = false,
+    };
+
+    ctx.job_system->SetThreadTempAllocatorSize(PHY_WORKER_TEMP_ALLOCATOR_SIZE);
+    ctx.job_system->SetJobMagazineSize(PHY_JOB_MAGAZINE_SIZE);
+    ctx.job_system->Init(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers);
+
+    for (const Benchmark& b : benchmarks) {
+        if (filter && strstr(b.name, filter) == nullptr) continue;
+        LOG("[bench] Running '%s'", b.name);
+        b.fn(&ctx);
+    }
+
+    delete ctx.object_vs_broad_phase_layer_filter;
+    delete ctx.broad_phase_layer_interface;
+    delete ctx.object_layer_pair_filter;
+    delete ctx.job_system;
+    delete ctx.temp_allocator;
+
+    JPH::UnregisterTypes();
+
+    delete JPH::Factory::sInstance;
+    JPH::Factory::sInstance = nullptr;
+
+    return ctx.failed ? 1 : 0;
+}
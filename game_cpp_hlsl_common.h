@@ -5,6 +5,9 @@
 #define RDH_FRAME_STATE 1
 #define RDH_VERTEX_BUFFER_STATIC 2
 #define RDH_OBJECTS_DYNAMIC 3
+#define RDH_VERTEX_BUFFER_DYNAMIC 4
+#define RDH_GLYPH_ATLAS 5
+#define RDH_GLYPHS_DYNAMIC 6
 
 struct CppHlsl_Vertex
 {
@@ -20,6 +23,17 @@ struct CppHlsl_Object
     float _padding[2];
 };
 
+// One quad of a SDF text label. (x, y) is the top-left corner in world space.
+struct CppHlsl_Glyph
+{
+    float x, y;
+    float width, height;
+    unsigned int uv0; // Top-left texture coordinate, UNORM16 u in the low and v in the high half
+    unsigned int uv1; // Bottom-right texture coordinate
+    unsigned int color; // RGBA8, red in the lowest byte
+    float _padding;
+};
+
 struct CppHlsl_FrameState
 {
     float4x4 proj;
@@ -28,6 +42,7 @@ struct CppHlsl_FrameState
 
 #ifdef __cplusplus
 static_assert(sizeof(CppHlsl_Object) == 32);
+static_assert(sizeof(CppHlsl_Glyph) == 32);
 static_assert(sizeof(CppHlsl_FrameState) == 512);
 static_assert((sizeof(CppHlsl_FrameState) % sizeof(CppHlsl_Object)) == 0);
 static_assert((sizeof(CppHlsl_FrameState) / sizeof(CppHlsl_Object)) == 16);
@@ -0,0 +1,415 @@
+#define FRACTURE_MAX_CELLS 64
+#define FRACTURE_NUM_VARIANTS 4
+#define FRACTURE_HALF_DEPTH 0.5f
+#define FRACTURE_MIN_CELL_AREA 1.0e-4f
+
+struct FractureCell
+{
+    JPH::Ref<JPH::Shape> shape;
+    f32 x, y; // Cell centroid in the space of the source shape
+    u32 mesh_index;
+};
+
+struct FracturePattern
+{
+    f32 focus_x, focus_y; // Point around which the seeds were clustered
+    std::vector<FractureCell> cells;
+};
+
+struct FractureShape
+{
+    FracturePattern variants[FRACTURE_NUM_VARIANTS];
+};
+
+struct FracturePiece
+{
+    JPH::BodyID body_id;
+    u32 mesh_index;
+};
+
+struct FractureStats
+{
+    u64 num_spawned;
+    u64 num_released;
+    u64 num_pool_misses;
+};
+
+struct FractureSystem
+{
+    JPH::PhysicsSystem* physics_system;
+
+    std::vector<FractureShape> shapes;
+
+    // Bodies created up front (not added to the physics system) that are handed out to pieces.
+    std::vector<JPH::BodyID> free_bodies;
+    std::vector<JPH::BodyID> all_bodies;
+    JPH::Ref<JPH::Shape> placeholder_shape;
+
+    // Scratch array reused by every spawn so that the runtime path does not allocate.
+    std::vector<JPH::BodyID> batch;
+
+    u32 random_state;
+    FractureStats stats;
+};
+
+func fracture_random(u32* state) -> f32
+{
+    // xorshift32
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return static_cast<f32>(x >> 8) * (1.0f / 16777216.0f);
+}
+
+func fracture_polygon_area(const CppHlsl_Vertex* poly, u32 num) -> f32
+{
+    f32 area = 0.0f;
+    for (u32 i = 0; i < num; ++i) {
+        const CppHlsl_Vertex* a = &poly[i];
+        const CppHlsl_Vertex* b = &poly[(i + 1) % num];
+        area += a->x * b->y - b->x * a->y;
+    }
+    return 0.5f * area;
+}
+
+func fracture_polygon_centroid(const CppHlsl_Vertex* poly, u32 num, f32* out_x, f32* out_y) -> void
+{
+    f32 cx = 0.0f, cy = 0.0f, area = 0.0f;
+    for (u32 i = 0; i < num; ++i) {
+        const CppHlsl_Vertex* a = &poly[i];
+        const CppHlsl_Vertex* b = &poly[(i + 1) % num];
+        const f32 cross = a->x * b->y - b->x * a->y;
+        cx += (a->x + b->x) * cross;
+        cy += (a->y + b->y) * cross;
+        area += cross;
+    }
+    *out_x = cx / (3.0f * area);
+    *out_y = cy / (3.0f * area);
+}
+
+func fracture_point_in_convex_polygon(const std::vector<CppHlsl_Vertex>& poly, f32 x, f32 y) -> bool
+{
+    const usize num = poly.size();
+    for (usize i = 0; i < num; ++i) {
+        const CppHlsl_Vertex* a = &poly[i];
+        const CppHlsl_Vertex* b = &poly[(i + 1) % num];
+        if ((b->x - a->x) * (y - a->y) - (b->y - a->y) * (x - a->x) < 0.0f) return false;
+    }
+    return true;
+}
+
+// Keeps the part of `in` that satisfies dot(p, n) <= d (Sutherland-Hodgman against a single plane).
+func fracture_clip_polygon(const std::vector<CppHlsl_Vertex>& in, f32 nx, f32 ny, f32 d, std::vector<CppHlsl_Vertex>* out) -> void
+{
+    out->clear();
+    const usize num = in.size();
+    for (usize i = 0; i < num; ++i) {
+        const CppHlsl_Vertex a = in[i];
+        const CppHlsl_Vertex b = in[(i + 1) % num];
+        const f32 da = a.x * nx + a.y * ny - d;
+        const f32 db = b.x * nx + b.y * ny - d;
+
+        if (da <= 0.0f) out->push_back(a);
+        if ((da <= 0.0f) != (db <= 0.0f)) {
+            const f32 t = da / (da - db);
+            out->push_back({ a.x + t * (b.x - a.x), a.y + t * (b.y - a.y) });
+        }
+    }
+}
+
+// Counter-clockwise outline of a rounded rectangle centered at the origin.
+func fracture_outline_round_rect(f32 width, f32 height, f32 radius, u32 segments_per_corner) -> std::vector<CppHlsl_Vertex>
+{
+    assert(segments_per_corner > 0);
+
+    const f32 hw = 0.5f * width - radius;
+    const f32 hh = 0.5f * height - radius;
+    const f32 corners[4][2] = { { hw, hh }, { -hw, hh }, { -hw, -hh }, { hw, -hh } };
+
+    std::vector<CppHlsl_Vertex> outline;
+    outline.reserve(4 * (segments_per_corner + 1));
+
+    for (u32 c = 0; c < 4; ++c) {
+        for (u32 i = 0; i <= segments_per_corner; ++i) {
+            const f32 a = (static_cast<f32>(c) + static_cast<f32>(i) / static_cast<f32>(segments_per_corner)) * 0.5f * JPH::JPH_PI;
+            outline.push_back({ corners[c][0] + radius * cosf(a), corners[c][1] + radius * sinf(a) });
+        }
+    }
+    return outline;
+}
+
+func fracture_build_pattern(
+    const std::vector<CppHlsl_Vertex>& outline,
+    u32 num_seeds,
+    f32 focus_x,
+    f32 focus_y,
+    u32 random_state,
+    std::vector<CppHlsl_Vertex>* vertices,
+    std::vector<StaticMesh>* meshes,
+    FracturePattern* pattern) -> void
+{
+    f32 min_x = outline[0].x, max_x = outline[0].x;
+    f32 min_y = outline[0].y, max_y = outline[0].y;
+    for (const CppHlsl_Vertex& v : outline) {
+        min_x = std::min(min_x, v.x); max_x = std::max(max_x, v.x);
+        min_y = std::min(min_y, v.y); max_y = std::max(max_y, v.y);
+    }
+
+    // Half of the seeds are clustered around the focus point so that pieces get smaller near the impact.
+    std::vector<CppHlsl_Vertex> seeds;
+    seeds.reserve(num_seeds);
+    const f32 focus_radius = 0.25f * std::max(max_x - min_x, max_y - min_y);
+
+    u32 num_attempts = 0;
+    while (seeds.size() < num_seeds && num_attempts < num_seeds * 64) {
+        num_attempts += 1;
+
+        f32 x, y;
+        if (seeds.size() & 1) {
+            x = focus_x + (2.0f * fracture_random(&random_state) - 1.0f) * focus_radius;
+            y = focus_y + (2.0f * fracture_random(&random_state) - 1.0f) * focus_radius;
+        } else {
+            x = min_x + fracture_random(&random_state) * (max_x - min_x);
+            y = min_y + fracture_random(&random_state) * (max_y - min_y);
+        }
+        if (fracture_point_in_convex_polygon(outline, x, y)) seeds.push_back({ x, y });
+    }
+
+    pattern->focus_x = focus_x;
+    pattern->focus_y = focus_y;
+    pattern->cells.clear();
+
+    std::vector<CppHlsl_Vertex> cell, clipped;
+    std::vector<JPH::Vec3> points;
+
+    for (usize i = 0; i < seeds.size(); ++i) {
+        cell = outline;
+
+        // Voronoi cell of seed `i` is the outline clipped by the bisectors with all other seeds.
+        for (usize j = 0; j < seeds.size() && cell.size() >= 3; ++j) {
+            if (i == j) continue;
+
+            const f32 nx = seeds[j].x - seeds[i].x;
+            const f32 ny = seeds[j].y - seeds[i].y;
+            const f32 d = nx * 0.5f * (seeds[i].x + seeds[j].x) + ny * 0.5f * (seeds[i].y + seeds[j].y);
+
+            fracture_clip_polygon(cell, nx, ny, d, &clipped);
+            std::swap(cell, clipped);
+        }
+
+        const u32 num = static_cast<u32>(cell.size());
+        if (num < 3 || fracture_polygon_area(cell.data(), num) < FRACTURE_MIN_CELL_AREA)
+            continue;
+
+        FractureCell fc = {};
+        fracture_polygon_centroid(cell.data(), num, &fc.x, &fc.y);
+
+        // Collision shape: cell extruded along Z, in the space of the cell centroid.
+        points.clear();
+        for (const CppHlsl_Vertex& v : cell) {
+            points.push_back(JPH::Vec3(v.x - fc.x, v.y - fc.y, -FRACTURE_HALF_DEPTH));
+            points.push_back(JPH::Vec3(v.x - fc.x, v.y - fc.y, FRACTURE_HALF_DEPTH));
+        }
+        JPH::ConvexHullShapeSettings settings(points.data(), static_cast<i32>(points.size()));
+        JPH::ShapeSettings::ShapeResult result = settings.Create();
+        if (result.HasError()) {
+            LOG("[fracture] Failed to create cell hull: %s", result.GetError().c_str());
+            continue;
+        }
+        fc.shape = result.Get();
+
+        // Render mesh: triangle fan (cell is convex), in the space of the cell centroid.
+        const u32 first_vertex = static_cast<u32>(vertices->size());
+        for (u32 k = 1; k + 1 < num; ++k) {
+            vertices->push_back({ cell[0].x - fc.x, cell[0].y - fc.y });
+            vertices->push_back({ cell[k].x - fc.x, cell[k].y - fc.y });
+            vertices->push_back({ cell[k + 1].x - fc.x, cell[k + 1].y - fc.y });
+        }
+        fc.mesh_index = static_cast<u32>(meshes->size());
+        meshes->push_back({ first_vertex, static_cast<u32>(vertices->size()) - first_vertex });
+
+        pattern->cells.push_back(std::move(fc));
+    }
+}
+
+func init_fracture_system(FractureSystem* fs, JPH::PhysicsSystem* physics_system, u32 pool_size) -> void
+{
+    assert(fs && physics_system);
+
+    fs->physics_system = physics_system;
+    fs->random_state = 0x2545f491;
+    fs->placeholder_shape = new JPH::BoxShape(JPH::Vec3(0.1f, 0.1f, FRACTURE_HALF_DEPTH));
+    fs->batch.reserve(FRACTURE_MAX_CELLS);
+    fs->free_bodies.reserve(pool_size);
+    fs->all_bodies.reserve(pool_size);
+
+    JPH::BodyInterface& bi = physics_system->GetBodyInterfaceNoLock();
+
+    JPH::BodyCreationSettings settings(fs->placeholder_shape, JPH::RVec3::sZero(), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, OBJECT_LAYER_MOVING);
+    settings.mAllowedDOFs = JPH::EAllowedDOFs::Plane2D;
+
+    for (u32 i = 0; i < pool_size; ++i) {
+        JPH::Body* body = bi.CreateBody(settings);
+        if (body == nullptr) {
+            LOG("[fracture] Body pool limited to %d bodies (physics system is full)", i);
+            break;
+        }
+        fs->all_bodies.push_back(body->GetID());
+        fs->free_bodies.push_back(body->GetID());
+    }
+
+    LOG("[fracture] Body pool created (%d bodies)", static_cast<i32>(fs->free_bodies.size()));
+}
+
+func shutdown_fracture_system(FractureSystem* fs) -> void
+{
+    assert(fs);
+
+    if (fs->physics_system) {
+        JPH::BodyInterface& bi = fs->physics_system->GetBodyInterfaceNoLock();
+        for (const JPH::BodyID& id : fs->all_bodies) {
+            if (bi.IsAdded(id)) bi.RemoveBody(id);
+        }
+        if (!fs->all_bodies.empty()) bi.DestroyBodies(fs->all_bodies.data(), static_cast<i32>(fs->all_bodies.size()));
+    }
+    fs->all_bodies.clear();
+    fs->free_bodies.clear();
+    fs->shapes.clear();
+    fs->placeholder_shape = nullptr;
+    fs->physics_system = nullptr;
+}
+
+// Precomputes FRACTURE_NUM_VARIANTS Voronoi patterns for a convex outline (this is the expensive part, done at
+// load time). Render meshes for all cells are appended to `vertices`/`meshes`. Returns the fracture shape index.
+func fracture_add_shape(
+    FractureSystem* fs,
+    const std::vector<CppHlsl_Vertex>& outline,
+    u32 num_cells,
+    std::vector<CppHlsl_Vertex>* vertices,
+    std::vector<StaticMesh>* meshes) -> u32
+{
+    assert(fs && outline.size() >= 3 && num_cells <= FRACTURE_MAX_CELLS);
+    assert(fracture_polygon_area(outline.data(), static_cast<u32>(outline.size())) > 0.0f); // Must be counter-clockwise.
+
+    FractureShape shape;
+    for (u32 v = 0; v < FRACTURE_NUM_VARIANTS; ++v) {
+        // Variant 0 is focused on the center, the others on points spread around it.
+        f32 focus_x = 0.0f, focus_y = 0.0f;
+        if (v > 0) {
+            const usize k = (v - 1) * outline.size() / (FRACTURE_NUM_VARIANTS - 1);
+            const CppHlsl_Vertex& p = outline[k % outline.size()];
+            focus_x = 0.5f * p.x;
+            focus_y = 0.5f * p.y;
+        }
+        fracture_build_pattern(outline, num_cells, focus_x, focus_y, 0x9e3779b9u ^ (v * 0x85ebca6bu) ^ static_cast<u32>(fs->shapes.size()), vertices, meshes, &shape.variants[v]);
+    }
+
+    fs->shapes.push_back(std::move(shape));
+    return static_cast<u32>(fs->shapes.size() - 1);
+}
+
+// Picks the precomputed pattern whose focus is closest to the impact point (given in the local space of the source shape).
+func fracture_find_pattern(const FractureSystem* fs, u32 shape_index, f32 impact_x, f32 impact_y) -> const FracturePattern*
+{
+    assert(fs && shape_index < fs->shapes.size());
+
+    const FractureShape* shape = &fs->shapes[shape_index];
+    const FracturePattern* best = &shape->variants[0];
+    f32 best_d = FLT_MAX;
+    for (const FracturePattern& p : shape->variants) {
+        const f32 dx = p.focus_x - impact_x;
+        const f32 dy = p.focus_y - impact_y;
+        if (dx * dx + dy * dy < best_d) {
+            best_d = dx * dx + dy * dy;
+            best = &p;
+        }
+    }
+    return best;
+}
+
+// Breaks a shape at the given transform into pieces. Runtime cost is a pattern lookup plus a batched body add.
+// Pieces are appended to `out_pieces` (caller reserves capacity to avoid allocations). Returns the number of pieces.
+func fracture_spawn(
+    FractureSystem* fs,
+    u32 shape_index,
+    f32 x,
+    f32 y,
+    f32 rotation,
+    f32 impact_x,
+    f32 impact_y,
+    JPH::Vec3Arg linear_velocity,
+    f32 explode_speed,
+    std::vector<FracturePiece>* out_pieces) -> u32
+{
+    ZoneScoped;
+    assert(fs && out_pieces);
+
+    // Impact point in the local space of the source shape.
+    const f32 sin_r = sinf(rotation);
+    const f32 cos_r = cosf(rotation);
+    const f32 lx = cos_r * (impact_x - x) + sin_r * (impact_y - y);
+    const f32 ly = -sin_r * (impact_x - x) + cos_r * (impact_y - y);
+
+    const FracturePattern* pattern = fracture_find_pattern(fs, shape_index, lx, ly);
+
+    JPH::BodyInterface& bi = fs->physics_system->GetBodyInterfaceNoLock();
+    const JPH::BodyLockInterfaceNoLock& bli = fs->physics_system->GetBodyLockInterfaceNoLock();
+    const JPH::Quat q = JPH::Quat::sRotation(JPH::Vec3::sAxisZ(), rotation);
+
+    fs->batch.clear();
+    for (const FractureCell& cell : pattern->cells) {
+        if (fs->free_bodies.empty()) {
+            JPH::BodyCreationSettings settings(cell.shape, JPH::RVec3::sZero(), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, OBJECT_LAYER_MOVING);
+            settings.mAllowedDOFs = JPH::EAllowedDOFs::Plane2D;
+            JPH::Body* body = bi.CreateBody(settings);
+            if (body == nullptr) break; // Physics system is full.
+            fs->all_bodies.push_back(body->GetID());
+            fs->free_bodies.push_back(body->GetID());
+            fs->stats.num_pool_misses += 1;
+        }
+        const JPH::BodyID id = fs->free_bodies.back();
+        fs->free_bodies.pop_back();
+
+        // The body is not in the physics system yet so nobody else can touch it.
+        JPH::Body* body = bli.TryGetBody(id);
+        assert(body && !body->IsInBroadPhase());
+
+        const f32 wx = x + cos_r * cell.x - sin_r * cell.y;
+        const f32 wy = y + sin_r * cell.x + cos_r * cell.y;
+
+        body->SetShapeInternal(cell.shape, true);
+        body->SetPositionAndRotationInternal(JPH::RVec3(wx, wy, 0.0f), q);
+
+        // Push pieces away from the impact point.
+        JPH::Vec3 dir(wx - impact_x, wy - impact_y, 0.0f);
+        dir = dir.NormalizedOr(JPH::Vec3::sZero());
+        body->SetLinearVelocityClamped(linear_velocity + explode_speed * dir);
+        body->SetAngularVelocityClamped(JPH::Vec3(0.0f, 0.0f, explode_speed * (2.0f * fracture_random(&fs->random_state) - 1.0f)));
+
+        fs->batch.push_back(id);
+        out_pieces->push_back({ .body_id = id, .mesh_index = cell.mesh_index });
+    }
+
+    const i32 num = static_cast<i32>(fs->batch.size());
+    if (num > 0) {
+        const JPH::BodyInterface::AddState state = bi.AddBodiesPrepare(fs->batch.data(), num);
+        bi.AddBodiesFinalize(fs->batch.data(), num, state, JPH::EActivation::Activate);
+    }
+    fs->stats.num_spawned += static_cast<u64>(num);
+    return static_cast<u32>(num);
+}
+
+// Removes pieces from the physics system and returns their bodies to the pool.
+func fracture_release(FractureSystem* fs, JPH::BodyID* body_ids, u32 num) -> void
+{
+    ZoneScoped;
+    assert(fs);
+
+    if (num == 0) return;
+
+    fs->physics_system->GetBodyInterfaceNoLock().RemoveBodies(body_ids, static_cast<i32>(num));
+    for (u32 i = 0; i < num; ++i) fs->free_bodies.push_back(body_ids[i]);
+    fs->stats.num_released += num;
+}
@@ -1,8 +1,16 @@
 #include "game_pch.h"
 #include "game_main.h"
 #include "game_cpp_hlsl_common.h"
+#include "game_alloc.cpp"
+#include "game_profile.cpp"
 #include "game_misc.cpp"
 #include "game_gpu_context.cpp"
+#include "game_physics.cpp"
+#include "game_fracture.cpp"
+#include "game_stroke.cpp"
+#include "game_sim.cpp"
+#include "game_text.cpp"
+#include "game_task.cpp"
 
 extern "C" {
     __declspec(dllexport) extern const u32 D3D12SDKVersion = 611;
@@ -18,96 +26,42 @@ enum StaticMeshType
     STATIC_MESH_NUM,
 };
 
-struct StaticMesh
+enum DynamicMeshType
 {
-    u32 first_vertex;
-    u32 num_vertices;
-};
-
-struct Object
-{
-    u32 mesh_index;
+    DYNAMIC_MESH_TRAIL,
+    DYNAMIC_MESH_STAR,
+    DYNAMIC_MESH_NUM,
 };
 
 struct alignas(16) UploadData
 {
     CppHlsl_FrameState frame_state;
-    CppHlsl_Object objects[1024];
-};
-
-static constexpr auto OBJECT_LAYER_NON_MOVING = JPH::ObjectLayer(0);
-static constexpr auto OBJECT_LAYER_MOVING = JPH::ObjectLayer(1);
-#define OBJECT_LAYER_NUM 2
-
-static constexpr auto BROAD_PHASE_LAYER_NON_MOVING = JPH::BroadPhaseLayer(0);
-static constexpr auto BROAD_PHASE_LAYER_MOVING = JPH::BroadPhaseLayer(1);
-#define BROAD_PHASE_LAYER_NUM 2
-
-struct ObjectLayerPairFilter final : public JPH::ObjectLayerPairFilter
-{
-    virtual bool ShouldCollide(JPH::ObjectLayer object1, JPH::ObjectLayer object2) const override {
-        switch (object1) {
-            case OBJECT_LAYER_NON_MOVING: return object2 == OBJECT_LAYER_MOVING;
-            case OBJECT_LAYER_MOVING: return true;
-            default: JPH_ASSERT(false); return false;
-        }
-    }
-};
-
-struct BroadPhaseLayerInterface final : public JPH::BroadPhaseLayerInterface
-{
-    JPH::BroadPhaseLayer object_to_broad_phase[OBJECT_LAYER_NUM];
-
-    BroadPhaseLayerInterface() {
-        object_to_broad_phase[OBJECT_LAYER_NON_MOVING] = BROAD_PHASE_LAYER_NON_MOVING;
-        object_to_broad_phase[OBJECT_LAYER_MOVING] = BROAD_PHASE_LAYER_MOVING;
-    }
-
-    virtual u32 GetNumBroadPhaseLayers() const override { return BROAD_PHASE_LAYER_NUM; }
-
-    virtual JPH::BroadPhaseLayer GetBroadPhaseLayer(JPH::ObjectLayer layer) const override {
-        JPH_ASSERT(layer < OBJECT_LAYER_NUM);
-        return object_to_broad_phase[layer];
-    }
-};
-
-struct ObjectVsBroadPhaseLayerFilter final : public JPH::ObjectVsBroadPhaseLayerFilter
-{
-    virtual bool ShouldCollide(JPH::ObjectLayer layer1, JPH::BroadPhaseLayer layer2) const override {
-        switch (layer1) {
-            case OBJECT_LAYER_NON_MOVING: return layer2 == BROAD_PHASE_LAYER_MOVING;
-            case OBJECT_LAYER_MOVING: return true;
-            default: JPH_ASSERT(false); return false;
-        }
-    }
+    CppHlsl_Object objects[MAX_OBJECTS];
+    CppHlsl_Glyph glyphs[MAX_GLYPHS];
+    CppHlsl_Vertex dynamic_vertices[MAX_DYNAMIC_VERTICES];
 };
 
-func jolt_trace(const char* fmt, ...) -> void
-{
-    va_list list;
-    va_start(list, fmt);
-    char buffer[1024];
-    vsnprintf(buffer, sizeof(buffer), fmt, list);
-    va_end(list);
-
-    LOG("[physics] %s", buffer);
-}
-
-#ifdef JPH_ENABLE_ASSERTS
-func jolt_assert_failed(const char* expression, const char* message, const char* file, u32 line) -> bool
-{
-    LOG("[physics] Assert failed (%s): (%s:%d) %s", expression, file, line, message ? message : "");
-
-    return true; // breakpoint
-}
-#endif
-
 #define WINDOW_NAME "game"
 #define WINDOW_WIDTH 1200
 #define WINDOW_HEIGHT 800
-#define NUM_GPU_PIPELINES 1
+#define NUM_GPU_PIPELINES 2
 #define GPU_BUFFER_SIZE_STATIC (8 * 1024 * 1024)
-#define GPU_BUFFER_SIZE_DYNAMIC (256 * 1024)
+#define GPU_BUFFER_SIZE_DYNAMIC (512 * 1024)
+#define FRACTURE_BODY_POOL_SIZE 256
+#define FRACTURE_KILL_Y -10.0f
+#define STROKE_CACHE_SIZE 64
+#define STROKE_TRAIL_POINTS 96
+#define STROKE_NUM_WORKERS 2 // Stroke jobs run on their own JPH::JobSystemThreadPool, the thread tuner restarts the workers of the physics one
+#define STROKE_MAX_JOBS 256
+#define STROKE_MAX_BARRIERS 8
+#define STROKE_WORKER_TEMP_ALLOCATOR_SIZE (64 * 1024)
+#define TEXT_LABEL_SIZE 0.35f
+#define TEXT_MAX_STRESS_LABELS 2000
+#define PHYSICS_STATS_HISTORY 240
+
+static_assert(sizeof(UploadData) <= GPU_BUFFER_SIZE_DYNAMIC);
+static_assert((offsetof(UploadData, dynamic_vertices) % sizeof(CppHlsl_Vertex)) == 0);
+static_assert((offsetof(UploadData, glyphs) % sizeof(CppHlsl_Glyph)) == 0);
 
 struct GameState
 {
@@ -116,6 +70,7 @@ struct GameState
         ID2D1Factory7* d2d_factory;
         ID3D12Resource2* buffer_static;
         ID3D12Resource2* buffer_dynamic;
+        ID3D12Resource2* glyph_atlas;
         ID3D12Resource2* upload_buffers[GPU_MAX_BUFFERED_FRAMES];
         u8* upload_buffer_bases[GPU_MAX_BUFFERED_FRAMES];
         ID3D12PipelineState* pipelines[NUM_GPU_PIPELINES];
@@ -125,23 +80,69 @@ struct GameState
     bool is_window_minimized;
 
     std::vector<StaticMesh> meshes;
+    StaticMeshLods mesh_lods[STATIC_MESH_NUM];
+
+    f32 view_size; // Half height (or width in portrait) of the visible area in world units
+
+    struct {
+        u32 num_vertices_full; // What would be drawn with LOD 0 only
+        u32 num_vertices_drawn;
+        u32 num_objects_per_lod[MESH_MAX_LODS];
+    } lod_stats;
 
     std::vector<Object> objects;
     std::vector<CppHlsl_Object> cpp_hlsl_objects;
 
     struct {
-        JPH::TempAllocatorImpl* temp_allocator;
-        JPH::JobSystemThreadPool* job_system;
+        JPH::TempAllocatorGrowing* temp_allocator;
+        JPH::JobSystem* job_system;
         ObjectLayerPairFilter* object_layer_pair_filter;
         BroadPhaseLayerInterface* broad_phase_layer_interface;
         ObjectVsBroadPhaseLayerFilter* object_vs_broad_phase_layer_filter;
+        JPH::PhysicsSystem* physics_system;
+        PhysicsThreadTuner thread_tuner;
     } phy;
+
+    // Runs physics and fracture on its own thread. `objects` below are rebuilt each frame from its latest snapshot.
+    SimState* sim;
+    u64 next_command_id;
+    u64 respawn_command_id; // Pending SIM_COMMAND_SPAWN_OBJECT for the round rect, 0 if none
+
+    struct {
+        u64 last_step_index;
+        u32 next; // Oldest entry in update_ms
+        f32 update_ms[PHYSICS_STATS_HISTORY];
+    } physics_stats;
+
+    FractureSystem fracture;
+    u32 fracture_shape_round_rect;
+
+    struct {
+        StrokeCache* cache;
+        JPH::JobSystemThreadPool* job_system;
+        std::vector<CppHlsl_Vertex> trail_points;
+        std::vector<CppHlsl_Vertex> star_points;
+        StrokeStyle star_style;
+    } stroke;
+
+    std::vector<StaticMesh> dynamic_meshes;
+    std::vector<CppHlsl_Vertex> dynamic_vertices;
+
+    struct {
+        TextAtlas* atlas;
+        std::vector<CppHlsl_Glyph> glyphs;
+        bool show_labels;
+        i32 num_stress_labels;
+    } text;
 };
 
 func init(GameState* game_state) -> void
 {
     assert(game_state);
 
+    alloc_init();
+    if (PHY_ALLOC_WATCH) alloc_watch_install();
+
     ImGui_ImplWin32_EnableDpiAwareness();
     const f32 dpi_scale = ImGui_ImplWin32_GetDpiScaleForHwnd(nullptr);
     LOG("[game] Window DPI scale: %f", dpi_scale);
@@ -177,8 +178,6 @@ func init(GameState* game_state) -> void
         VHR(D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, __uuidof(game_state->gpu.d2d_factory), &options, reinterpret_cast<void**>(&game_state->gpu.d2d_factory)));
     }
 
-    JPH::RegisterDefaultAllocator();
-
     JPH::Trace = jolt_trace;
     JPH_IF_ENABLE_ASSERTS(JPH::AssertFailed = jolt_assert_failed;);
 
@@ -186,12 +185,74 @@ func init(GameState* game_state) -> void
 
     JPH::RegisterTypes();
 
-    game_state->phy.temp_allocator = new JPH::TempAllocatorImpl(10 * 1024 * 1024);
-    game_state->phy.job_system = new JPH::JobSystemThreadPool(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers);
+    profile_init(PHY_PROFILE_HITCH_FRAMES, PHY_PROFILE_HITCH_BUDGET);
+
+    game_state->phy.temp_allocator = new JPH::TempAllocatorGrowing(PHY_TEMP_ALLOCATOR_SIZE);
+    {
+        JPH::ThreadTopology topology;
+        topology.Detect();
+
+        const JPH::ThreadTopology::Settings settings = { .mPinThreads = PHY_PIN_THREADS };
+        const i32 num_threads = topology.GetRecommendedNumThreads(settings);
+#if PHY_WORK_STEALING_JOB_SYSTEM
+        auto job_system = new JPH::JobSystemWorkStealing();
+#else
+        auto job_system = new JPH::JobSystemThreadPool();
+        job_system->SetThreadTempAllocatorSize(PHY_WORKER_TEMP_ALLOCATOR_SIZE);
+        job_system->SetJobMagazineSize(PHY_JOB_MAGAZINE_SIZE);
+#endif
+        place_physics_workers(job_system, topology, settings, num_threads);
+        job_system->Init(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, num_threads);
+        game_state->phy.job_system = job_system;
+    }
     game_state->phy.object_layer_pair_filter = new ObjectLayerPairFilter();
     game_state->phy.broad_phase_layer_interface = new BroadPhaseLayerInterface();
     game_state->phy.object_vs_broad_phase_layer_filter = new ObjectVsBroadPhaseLayerFilter();
 
+    game_state->phy.physics_system = new JPH::PhysicsSystem();
+    game_state->phy.physics_system->Init(PHY_MAX_BODIES, PHY_NUM_BODY_MUTEXES, PHY_MAX_BODY_PAIRS, PHY_MAX_CONTACT_CONSTRAINTS, *game_state->phy.broad_phase_layer_interface, *game_state->phy.object_vs_broad_phase_layer_filter, *game_state->phy.object_layer_pair_filter, BROAD_PHASE_TYPE);
+
+    init_fracture_system(&game_state->fracture, game_state->phy.physics_system, FRACTURE_BODY_POOL_SIZE);
+
+    game_state->sim = new SimState();
+    init_sim(game_state->sim, game_state->phy.physics_system, game_state->phy.temp_allocator, game_state->phy.job_system, &game_state->fracture, PHY_FIXED_TIME_STEP, FRACTURE_KILL_Y);
+#if !PHY_WORK_STEALING_JOB_SYSTEM
+    game_state->sim->job_pool = static_cast<JPH::JobSystemThreadPool*>(game_state->phy.job_system);
+    if (PHY_TUNE_THREADS) {
+        physics_thread_tuner_init(&game_state->phy.thread_tuner, static_cast<u32>(game_state->phy.job_system->GetMaxConcurrency()));
+        game_state->sim->thread_tuner = &game_state->phy.thread_tuner;
+    }
+#endif
+    game_state->next_command_id = 1;
+
+    game_state->view_size = 5.0f;
+
+    game_state->stroke.cache = new StrokeCache();
+    init_stroke_cache(game_state->stroke.cache, STROKE_CACHE_SIZE);
+    {
+        auto job_system = new JPH::JobSystemThreadPool();
+        job_system->SetThreadTempAllocatorSize(STROKE_WORKER_TEMP_ALLOCATOR_SIZE);
+        job_system->SetThreadExitFunction([](int) { alloc_thread_exit(); });
+        job_system->Init(STROKE_MAX_JOBS, STROKE_MAX_BARRIERS, STROKE_NUM_WORKERS);
+        game_state->stroke.job_system = job_system;
+    }
+    game_state->stroke.trail_points.resize(STROKE_TRAIL_POINTS);
+    for (u32 i = 0; i < 10; ++i) {
+        const f32 a = JPH::JPH_PI * (0.5f + 0.2f * static_cast<f32>(i));
+        const f32 r = (i % 2) == 0 ? 1.0f : 0.45f;
+        game_state->stroke.star_points.push_back({ r * cosf(a), r * sinf(a) });
+    }
+    game_state->stroke.star_style = {
+        .width = 0.1f, .miter_limit = 4.0f, .tolerance = 0.005f, .join = STROKE_JOIN_MITER, .cap = STROKE_CAP_BUTT, .closed = 1,
+    };
+    game_state->dynamic_meshes.resize(DYNAMIC_MESH_NUM);
+    game_state->dynamic_vertices.reserve(MAX_DYNAMIC_VERTICES);
+
+    game_state->text.atlas = new TextAtlas();
+    if (!load_text_atlas(game_state->text.atlas, "assets/Roboto-Medium.ttf", "assets", game_state->phy.job_system)) VHR(E_FAIL);
+    game_state->text.glyphs.reserve(MAX_GLYPHS);
+    game_state->text.show_labels = true;
+
     {
         const std::vector<u8> vs = load_file("assets/s00_vs.cso");
         const std::vector<u8> ps = load_file("assets/s00_ps.cso");
@@ -220,6 +281,43 @@ func init(GameState* game_state) -> void
         VHR(gc->device->CreateRootSignature(0, vs.data(), vs.size(), IID_PPV_ARGS(&game_state->gpu.root_signatures[0])));
     }
 
+    // Text (alpha blended, one instance per glyph)
+    {
+        const std::vector<u8> vs = load_file("assets/s01_vs.cso");
+        const std::vector<u8> ps = load_file("assets/s01_ps.cso");
+
+        const D3D12_GRAPHICS_PIPELINE_STATE_DESC pso_desc = {
+            .VS = { vs.data(), vs.size() },
+            .PS = { ps.data(), ps.size() },
+            .BlendState = {
+                .RenderTarget = {
+                    {
+                        .BlendEnable = TRUE,
+                        .SrcBlend = D3D12_BLEND_SRC_ALPHA,
+                        .DestBlend = D3D12_BLEND_INV_SRC_ALPHA,
+                        .BlendOp = D3D12_BLEND_OP_ADD,
+                        .SrcBlendAlpha = D3D12_BLEND_ONE,
+                        .DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA,
+                        .BlendOpAlpha = D3D12_BLEND_OP_ADD,
+                        .RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL,
+                    },
+                },
+            },
+            .SampleMask = 0xffffffff,
+            .RasterizerState = {
+                .FillMode = D3D12_FILL_MODE_SOLID,
+                .CullMode = D3D12_CULL_MODE_NONE,
+            },
+            .PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,
+            .NumRenderTargets = 1,
+            .RTVFormats = { DXGI_FORMAT_R8G8B8A8_UNORM_SRGB },
+            .SampleDesc = { .Count = GPU_NUM_MSAA_SAMPLES },
+        };
+
+        VHR(gc->device->CreateGraphicsPipelineState(&pso_desc, IID_PPV_ARGS(&game_state->gpu.pipelines[1])));
+        VHR(gc->device->CreateRootSignature(0, vs.data(), vs.size(), IID_PPV_ARGS(&game_state->gpu.root_signatures[1])));
+    }
+
     // Upload buffers
     for (i32 i = 0; i < GPU_MAX_BUFFERED_FRAMES; ++i) {
         const D3D12_HEAP_PROPERTIES heap_desc = { .Type = D3D12_HEAP_TYPE_UPLOAD };
@@ -268,6 +366,29 @@ func init(GameState* game_state) -> void
         VHR(gc->device->CreateCommittedResource3(&heap_desc, D3D12_HEAP_FLAG_NONE, &desc, D3D12_BARRIER_LAYOUT_UNDEFINED, nullptr, nullptr, 0, nullptr, IID_PPV_ARGS(&game_state->gpu.buffer_dynamic)));
     }
 
+    // Glyph atlas
+    {
+        const D3D12_HEAP_PROPERTIES heap_desc = { .Type = D3D12_HEAP_TYPE_DEFAULT };
+        const D3D12_RESOURCE_DESC1 desc = {
+            .Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D,
+            .Width = game_state->text.atlas->header.width,
+            .Height = game_state->text.atlas->header.height,
+            .DepthOrArraySize = 1,
+            .MipLevels = 1,
+            .Format = DXGI_FORMAT_R8_UNORM,
+            .SampleDesc = { .Count = 1 },
+        };
+        VHR(gc->device->CreateCommittedResource3(&heap_desc, D3D12_HEAP_FLAG_NONE, &desc, D3D12_BARRIER_LAYOUT_COPY_DEST, nullptr, nullptr, 0, nullptr, IID_PPV_ARGS(&game_state->gpu.glyph_atlas)));
+
+        const D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {
+            .Format = DXGI_FORMAT_R8_UNORM,
+            .ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D,
+            .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
+            .Texture2D = { .MipLevels = 1 },
+        };
+        gc->device->CreateShaderResourceView(game_state->gpu.glyph_atlas, &srv_desc, { .ptr = gc->gpu_heap_start_cpu.ptr + RDH_GLYPH_ATLAS * gc->gpu_heap_descriptor_size });
+    }
+
     // Create static meshes and store them in the upload buffer
     {
         game_state->meshes.resize(STATIC_MESH_NUM);
@@ -293,6 +414,35 @@ func init(GameState* game_state) -> void
             virtual HRESULT Close() override { return S_OK; }
         } tess_sink;
 
+        // Tessellates one mesh at MESH_MAX_LODS tolerance levels. Levels that don't reduce the vertex count are dropped.
+        auto tessellate_lods = [&](StaticMeshType type, auto&& tessellate) {
+            StaticMeshLods* lods = &game_state->mesh_lods[type];
+            lods->num_lods = 0;
+
+            f32 tolerance = D2D1_DEFAULT_FLATTENING_TOLERANCE;
+            for (u32 lod = 0; lod < MESH_MAX_LODS; ++lod, tolerance *= MESH_LOD_TOLERANCE_STEP) {
+                const u32 first_vertex = static_cast<u32>(tess_sink.vertices.size());
+                tessellate(tolerance);
+                const u32 num_vertices = static_cast<u32>(tess_sink.vertices.size()) - first_vertex;
+
+                if (lod > 0 && num_vertices >= lods->levels[lod - 1].num_vertices) {
+                    tess_sink.vertices.resize(first_vertex);
+                    break;
+                }
+                lods->levels[lod] = { first_vertex, num_vertices };
+                lods->tolerances[lod] = rcp_scale * tolerance;
+                lods->num_lods += 1;
+            }
+
+            lods->radius = 0.0f;
+            for (u32 i = 0; i < lods->levels[0].num_vertices; ++i) {
+                const CppHlsl_Vertex* v = &tess_sink.vertices[lods->levels[0].first_vertex + i];
+                lods->radius = std::max(lods->radius, sqrtf(v->x * v->x + v->y * v->y));
+            }
+
+            game_state->meshes[type] = lods->levels[0];
+        };
+
         {
             const D2D1_ROUNDED_RECT shape = {
                 .rect = { -0.5f, -0.5f, 0.5f, 0.5f }, .radiusX = 0.25f, .radiusY = 0.25f,
@@ -301,11 +451,9 @@ func init(GameState* game_state) -> void
             VHR(game_state->gpu.d2d_factory->CreateRoundedRectangleGeometry(&shape, &geo));
             defer { SAFE_RELEASE(geo); };
 
-            const u32 first_vertex = static_cast<u32>(tess_sink.vertices.size());
-            VHR(geo->Tessellate({ scale, 0.0f, 0.0f, scale, 0.0f, 0.0f }, D2D1_DEFAULT_FLATTENING_TOLERANCE, &tess_sink));
-            const u32 num_vertices = static_cast<u32>(tess_sink.vertices.size()) - first_vertex;
-
-            game_state->meshes[STATIC_MESH_ROUND_RECT_1x1] = { first_vertex, num_vertices };
+            tessellate_lods(STATIC_MESH_ROUND_RECT_1x1, [&](f32 tolerance) {
+                VHR(geo->Tessellate({ scale, 0.0f, 0.0f, scale, 0.0f, 0.0f }, tolerance, &tess_sink));
+            });
         }
         {
             const D2D1_ELLIPSE shape = {
@@ -315,11 +463,9 @@ func init(GameState* game_state) -> void
             VHR(game_state->gpu.d2d_factory->CreateEllipseGeometry(&shape, &geo));
             defer { SAFE_RELEASE(geo); };
 
-            const u32 first_vertex = static_cast<u32>(tess_sink.vertices.size());
-            VHR(geo->Tessellate({ scale, 0.0f, 0.0f, scale, 0.0f, 0.0f }, D2D1_DEFAULT_FLATTENING_TOLERANCE, &tess_sink));
-            const u32 num_vertices = static_cast<u32>(tess_sink.vertices.size()) - first_vertex;
-
-            game_state->meshes[STATIC_MESH_CIRCLE_1] = { first_vertex, num_vertices };
+            tessellate_lods(STATIC_MESH_CIRCLE_1, [&](f32 tolerance) {
+                VHR(geo->Tessellate({ scale, 0.0f, 0.0f, scale, 0.0f, 0.0f }, tolerance, &tess_sink));
+            });
         }
         {
             const D2D1_RECT_F shape = { -0.5f, -0.5f, 0.5f, 0.5f };
@@ -327,11 +473,9 @@ func init(GameState* game_state) -> void
             VHR(game_state->gpu.d2d_factory->CreateRectangleGeometry(&shape, &geo));
             defer { SAFE_RELEASE(geo); };
 
-            const u32 first_vertex = static_cast<u32>(tess_sink.vertices.size());
-            VHR(geo->Tessellate({ scale, 0.0f, 0.0f, scale, 0.0f, 0.0f }, D2D1_DEFAULT_FLATTENING_TOLERANCE, &tess_sink));
-            const u32 num_vertices = static_cast<u32>(tess_sink.vertices.size()) - first_vertex;
-
-            game_state->meshes[STATIC_MESH_RECT_1x1] = { first_vertex, num_vertices };
+            tessellate_lods(STATIC_MESH_RECT_1x1, [&](f32 tolerance) {
+                VHR(geo->Tessellate({ scale, 0.0f, 0.0f, scale, 0.0f, 0.0f }, tolerance, &tess_sink));
+            });
         }
         {
             ID2D1PathGeometry* geo = nullptr;
@@ -355,23 +499,31 @@ func init(GameState* game_state) -> void
 
             VHR(sink->Close());
 
-            ID2D1PathGeometry* geo1 = nullptr;
-            VHR(game_state->gpu.d2d_factory->CreatePathGeometry(&geo1));
-            defer { SAFE_RELEASE(geo1); };
+            tessellate_lods(STATIC_MESH_PATH_00, [&](f32 tolerance) {
+                ID2D1PathGeometry* geo1 = nullptr;
+                VHR(game_state->gpu.d2d_factory->CreatePathGeometry(&geo1));
+                defer { SAFE_RELEASE(geo1); };
 
-            ID2D1GeometrySink* sink1 = nullptr;
-            VHR(geo1->Open(&sink1));
-            defer { SAFE_RELEASE(sink1); };
-            VHR(geo->Widen(0.5f, nullptr, { scale, 0.0f, 0.0f, scale, 0.0f, 0.0f }, D2D1_DEFAULT_FLATTENING_TOLERANCE, sink1));
-            VHR(sink1->Close());
+                ID2D1GeometrySink* sink1 = nullptr;
+                VHR(geo1->Open(&sink1));
+                defer { SAFE_RELEASE(sink1); };
+                VHR(geo->Widen(0.5f, nullptr, { scale, 0.0f, 0.0f, scale, 0.0f, 0.0f }, tolerance, sink1));
+                VHR(sink1->Close());
 
-            const u32 first_vertex = static_cast<u32>(tess_sink.vertices.size());
-            VHR(geo1->Tessellate(nullptr, D2D1_DEFAULT_FLATTENING_TOLERANCE, &tess_sink));
-            const u32 num_vertices = static_cast<u32>(tess_sink.vertices.size()) - first_vertex;
+                VHR(geo1->Tessellate(nullptr, tolerance, &tess_sink));
+            });
+        }
 
-            game_state->meshes[STATIC_MESH_PATH_00] = { first_vertex, num_vertices };
+        for (u32 i = 0; i < STATIC_MESH_NUM; ++i) {
+            const StaticMeshLods* lods = &game_state->mesh_lods[i];
+            LOG("[game] Static mesh %d: %d LODs, %d vertices at LOD 0, %d at LOD %d", i, lods->num_lods, lods->levels[0].num_vertices, lods->levels[lods->num_lods - 1].num_vertices, lods->num_lods - 1);
         }
 
+        // Fracture patterns (appended after the static meshes)
+        game_state->fracture_shape_round_rect = fracture_add_shape(&game_state->fracture, fracture_outline_round_rect(1.0f, 1.0f, 0.25f, 8), 12, &tess_sink.vertices, &game_state->meshes);
+
+        assert(sizeof(CppHlsl_Vertex) * tess_sink.vertices.size() <= GPU_BUFFER_SIZE_DYNAMIC);
+
         auto* ptr = reinterpret_cast<CppHlsl_Vertex*>(game_state->gpu.upload_buffer_bases[0]);
         memcpy(ptr, tess_sink.vertices.data(), sizeof(CppHlsl_Vertex) * tess_sink.vertices.size());
 
@@ -389,6 +541,38 @@ func init(GameState* game_state) -> void
         }
     }
 
+    // Atlas pixels go through their own upload buffer, released once the copy below has finished
+    ID3D12Resource2* atlas_upload_buffer = nullptr;
+    defer { SAFE_RELEASE(atlas_upload_buffer); };
+
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT atlas_footprint;
+    {
+        const D3D12_RESOURCE_DESC desc = game_state->gpu.glyph_atlas->GetDesc();
+        u64 upload_size = 0;
+        gc->device->GetCopyableFootprints(&desc, 0, 1, 0, &atlas_footprint, nullptr, nullptr, &upload_size);
+
+        const D3D12_HEAP_PROPERTIES heap_desc = { .Type = D3D12_HEAP_TYPE_UPLOAD };
+        const D3D12_RESOURCE_DESC1 buffer_desc = {
+            .Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
+            .Width = upload_size,
+            .Height = 1,
+            .DepthOrArraySize = 1,
+            .MipLevels = 1,
+            .SampleDesc = { .Count = 1 },
+            .Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR,
+        };
+        VHR(gc->device->CreateCommittedResource3(&heap_desc, D3D12_HEAP_FLAG_NONE, &buffer_desc, D3D12_BARRIER_LAYOUT_UNDEFINED, nullptr, nullptr, 0, nullptr, IID_PPV_ARGS(&atlas_upload_buffer)));
+
+        const TextAtlas* atlas = game_state->text.atlas;
+        const D3D12_RANGE range = { .Begin = 0, .End = 0 };
+        u8* ptr = nullptr;
+        VHR(atlas_upload_buffer->Map(0, &range, reinterpret_cast<void**>(&ptr)));
+        for (u32 row = 0; row < atlas->header.height; ++row) {
+            memcpy(ptr + row * atlas_footprint.Footprint.RowPitch, &atlas->pixels[row * atlas->header.width], atlas->header.width);
+        }
+        atlas_upload_buffer->Unmap(0, nullptr);
+    }
+
     // Copy upload buffer to the static buffer
     {
         VHR(gc->command_allocators[0]->Reset());
@@ -422,6 +606,38 @@ func init(GameState* game_state) -> void
 
         gc->command_list->CopyBufferRegion(game_state->gpu.buffer_static, 0, game_state->gpu.upload_buffers[0], 0, GPU_BUFFER_SIZE_DYNAMIC);
 
+        {
+            const D3D12_TEXTURE_COPY_LOCATION dst = {
+                .pResource = game_state->gpu.glyph_atlas,
+                .Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX,
+                .SubresourceIndex = 0,
+            };
+            const D3D12_TEXTURE_COPY_LOCATION src = {
+                .pResource = atlas_upload_buffer,
+                .Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT,
+                .PlacedFootprint = atlas_footprint,
+            };
+            gc->command_list->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+        }
+        {
+            const D3D12_TEXTURE_BARRIER texture_barrier = {
+                .SyncBefore = D3D12_BARRIER_SYNC_COPY,
+                .SyncAfter = D3D12_BARRIER_SYNC_NONE,
+                .AccessBefore = D3D12_BARRIER_ACCESS_COPY_DEST,
+                .AccessAfter = D3D12_BARRIER_ACCESS_NO_ACCESS,
+                .LayoutBefore = D3D12_BARRIER_LAYOUT_COPY_DEST,
+                .LayoutAfter = D3D12_BARRIER_LAYOUT_SHADER_RESOURCE,
+                .pResource = game_state->gpu.glyph_atlas,
+                .Subresources = { .IndexOrFirstMipLevel = 0xffffffff },
+            };
+            const D3D12_BARRIER_GROUP barrier_group = {
+                .Type = D3D12_BARRIER_TYPE_TEXTURE,
+                .NumBarriers = 1,
+                .pTextureBarriers = &texture_barrier,
+            };
+            gc->command_list->Barrier(1, &barrier_group);
+        }
+
         VHR(gc->command_list->Close());
 
         gc->command_queue->ExecuteCommandLists(1, reinterpret_cast<ID3D12CommandList**>(&gc->command_list));
@@ -429,17 +645,26 @@ func init(GameState* game_state) -> void
         finish_gpu_commands(gc);
     }
 
-    game_state->objects.push_back({ .mesh_index = STATIC_MESH_ROUND_RECT_1x1 });
-    game_state->cpp_hlsl_objects.push_back({ .x = -4.0f, .y = 4.0f });
+    {
+        SimState* sim = game_state->sim;
+
+        sim->objects.push_back({ .mesh_index = STATIC_MESH_ROUND_RECT_1x1 });
+        sim->cpp_hlsl_objects.push_back({ .x = -4.0f, .y = 4.0f });
 
-    game_state->objects.push_back({ .mesh_index = STATIC_MESH_RECT_1x1 });
-    game_state->cpp_hlsl_objects.push_back({ .x = 6.0f, .y = -2.0f });
+        sim->objects.push_back({ .mesh_index = STATIC_MESH_RECT_1x1 });
+        sim->cpp_hlsl_objects.push_back({ .x = 6.0f, .y = -2.0f });
 
-    game_state->objects.push_back({ .mesh_index = STATIC_MESH_CIRCLE_1 });
-    game_state->cpp_hlsl_objects.push_back({ .x = 0.0f, .y = 0.0f });
+        sim->objects.push_back({ .mesh_index = STATIC_MESH_CIRCLE_1 });
+        sim->cpp_hlsl_objects.push_back({ .x = 0.0f, .y = 0.0f });
 
-    game_state->objects.push_back({ .mesh_index = STATIC_MESH_PATH_00 });
-    game_state->cpp_hlsl_objects.push_back({ .x = 0.0f, .y = 0.0f });
+        sim->objects.push_back({ .mesh_index = STATIC_MESH_PATH_00 });
+        sim->cpp_hlsl_objects.push_back({ .x = 0.0f, .y = 0.0f });
+
+        sim_start(sim);
+    }
+
+    game_state->objects.reserve(MAX_OBJECTS);
+    game_state->cpp_hlsl_objects.reserve(MAX_OBJECTS);
 
     {
         const D3D12_SHADER_RESOURCE_VIEW_DESC desc = {
@@ -459,12 +684,36 @@ func init(GameState* game_state) -> void
             .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
             .Buffer = {
                 .FirstElement = sizeof(CppHlsl_FrameState) / sizeof(CppHlsl_Object),
-                .NumElements = static_cast<u32>(game_state->cpp_hlsl_objects.size()),
+                .NumElements = MAX_OBJECTS,
                 .StructureByteStride = sizeof(CppHlsl_Object),
             },
         };
         gc->device->CreateShaderResourceView(game_state->gpu.buffer_dynamic, &desc, { .ptr = gc->gpu_heap_start_cpu.ptr + RDH_OBJECTS_DYNAMIC * gc->gpu_heap_descriptor_size });
     }
+    {
+        const D3D12_SHADER_RESOURCE_VIEW_DESC desc = {
+            .ViewDimension = D3D12_SRV_DIMENSION_BUFFER,
+            .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
+            .Buffer = {
+                .FirstElement = offsetof(UploadData, dynamic_vertices) / sizeof(CppHlsl_Vertex),
+                .NumElements = MAX_DYNAMIC_VERTICES,
+                .StructureByteStride = sizeof(CppHlsl_Vertex),
+            },
+        };
+        gc->device->CreateShaderResourceView(game_state->gpu.buffer_dynamic, &desc, { .ptr = gc->gpu_heap_start_cpu.ptr + RDH_VERTEX_BUFFER_DYNAMIC * gc->gpu_heap_descriptor_size });
+    }
+    {
+        const D3D12_SHADER_RESOURCE_VIEW_DESC desc = {
+            .ViewDimension = D3D12_SRV_DIMENSION_BUFFER,
+            .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
+            .Buffer = {
+                .FirstElement = offsetof(UploadData, glyphs) / sizeof(CppHlsl_Glyph),
+                .NumElements = MAX_GLYPHS,
+                .StructureByteStride = sizeof(CppHlsl_Glyph),
+            },
+        };
+        gc->device->CreateShaderResourceView(game_state->gpu.buffer_dynamic, &desc, { .ptr = gc->gpu_heap_start_cpu.ptr + RDH_GLYPHS_DYNAMIC * gc->gpu_heap_descriptor_size });
+    }
 }
 
 func shutdown(GameState* game_state) -> void
@@ -476,6 +725,7 @@ func shutdown(GameState* game_state) -> void
     SAFE_RELEASE(game_state->gpu.d2d_factory);
     SAFE_RELEASE(game_state->gpu.buffer_static);
     SAFE_RELEASE(game_state->gpu.buffer_dynamic);
+    SAFE_RELEASE(game_state->gpu.glyph_atlas);
     for (i32 i = 0; i < ARRAYSIZE(game_state->gpu.upload_buffers); ++i) {
         SAFE_RELEASE(game_state->gpu.upload_buffers[i]);
     }
@@ -488,6 +738,32 @@ func shutdown(GameState* game_state) -> void
     ImGui_ImplWin32_Shutdown();
     ImGui::DestroyContext();
 
+    if (game_state->sim) {
+        sim_stop(game_state->sim);
+        delete game_state->sim;
+        game_state->sim = nullptr;
+    }
+
+    shutdown_fracture_system(&game_state->fracture);
+
+    if (game_state->stroke.job_system) {
+        delete game_state->stroke.job_system;
+        game_state->stroke.job_system = nullptr;
+    }
+    if (game_state->stroke.cache) {
+        delete game_state->stroke.cache;
+        game_state->stroke.cache = nullptr;
+    }
+
+    if (game_state->text.atlas) {
+        delete game_state->text.atlas;
+        game_state->text.atlas = nullptr;
+    }
+
+    if (game_state->phy.physics_system) {
+        delete game_state->phy.physics_system;
+        game_state->phy.physics_system = nullptr;
+    }
     if (game_state->phy.job_system) {
         delete game_state->phy.job_system;
         game_state->phy.job_system = nullptr;
@@ -509,11 +785,15 @@ func shutdown(GameState* game_state) -> void
         game_state->phy.object_vs_broad_phase_layer_filter = nullptr;
     }
 
+    profile_shutdown();
+
     JPH::UnregisterTypes();
 
     delete JPH::Factory::sInstance;
     JPH::Factory::sInstance = nullptr;
 
+    if (PHY_ALLOC_WATCH) alloc_watch_uninstall();
+
     if (game_state->gpu.gc) {
         shutdown_gpu_context(game_state->gpu.gc);
         delete game_state->gpu.gc;
@@ -686,17 +966,269 @@ func update(GameState* game_state) -> void
 
     ImGui::ShowDemoWindow();
 
+    if (ImGui::Begin("Rendering")) {
+        ImGui::SliderFloat("View size", &game_state->view_size, 1.0f, 100.0f, "%.1f", ImGuiSliderFlags_Logarithmic);
+
+        const i32 num_full = static_cast<i32>(game_state->lod_stats.num_vertices_full);
+        const i32 num_drawn = static_cast<i32>(game_state->lod_stats.num_vertices_drawn);
+        ImGui::Text("Vertices drawn: %d / %d (%d saved by LOD)", num_drawn, num_full, num_full - num_drawn);
+        for (u32 lod = 0; lod < MESH_MAX_LODS; ++lod) {
+            ImGui::Text("Objects at LOD %d: %d", static_cast<i32>(lod), static_cast<i32>(game_state->lod_stats.num_objects_per_lod[lod]));
+        }
+
+        ImGui::Checkbox("Labels", &game_state->text.show_labels);
+        ImGui::SliderInt("Stress labels", &game_state->text.num_stress_labels, 0, TEXT_MAX_STRESS_LABELS);
+        ImGui::Text("Glyphs: %d / %d", static_cast<i32>(game_state->text.glyphs.size()), MAX_GLYPHS);
+    }
+    ImGui::End();
+
+    /* Simulation */ {
+        SimState* sim = game_state->sim;
+        const SimSnapshot* snapshot = triple_buffer_acquire(&sim->snapshots);
+
+        game_state->objects.assign(snapshot->objects, snapshot->objects + snapshot->num_objects);
+        game_state->cpp_hlsl_objects.assign(snapshot->cpp_hlsl_objects, snapshot->cpp_hlsl_objects + snapshot->num_objects);
+
+        const bool has_round_rect = std::any_of(game_state->objects.begin(), game_state->objects.end(), [](const Object& obj) { return obj.mesh_index == STATIC_MESH_ROUND_RECT_1x1; });
+
+        if (ImGui::Begin("Fracture")) {
+            const FractureStats* stats = &snapshot->fracture_stats;
+            ImGui::Text("Pieces alive: %d", static_cast<i32>(stats->num_spawned - stats->num_released));
+            ImGui::Text("Pool: %d free / %d total (%d misses)", static_cast<i32>(snapshot->num_free_pool_bodies), static_cast<i32>(snapshot->num_pool_bodies), static_cast<i32>(stats->num_pool_misses));
+            ImGui::Text("Simulation step: %llu (snapshot age %.2f ms)", static_cast<unsigned long long>(snapshot->step_index), (sim_time() - snapshot->publish_time) * 1000.0);
+            const JPH::TempAllocatorGrowing::Stats* temp_stats = &snapshot->temp_allocator_stats;
+            ImGui::Text("Physics temp memory: %.2f / %.2f MiB peak (max %.2f), %d blocks, %d overflows", temp_stats->mPeakUsage / (1024.0 * 1024.0), temp_stats->mCapacity / (1024.0 * 1024.0), temp_stats->mMaxPeakUsage / (1024.0 * 1024.0), static_cast<i32>(temp_stats->mPeakNumBlocks), static_cast<i32>(temp_stats->mTotalNumOverflows));
+
+            if (ImGui::Button("Shatter round rect") && has_round_rect) {
+                const SimCommand cmd = {
+                    .id = game_state->next_command_id++,
+                    .type = SIM_COMMAND_SHATTER,
+                    .mesh_index = STATIC_MESH_ROUND_RECT_1x1,
+                    .fracture_shape = game_state->fracture_shape_round_rect,
+                };
+                if (!sim_push_command(sim, cmd)) LOG("[game] Simulation command queue is full");
+            }
+        }
+        ImGui::End();
+
+        if (ImGui::Begin("Jobs")) {
+            const SimJobStats* stats = &snapshot->job_stats;
+            if (stats->num_workers == 0) {
+                ImGui::Text("The job system doesn't keep stats");
+            } else {
+                ImGui::Text("Queue depth (high / normal / low): %d / %d / %d, max %d / %d / %d", static_cast<i32>(stats->queue_depth[0]), static_cast<i32>(stats->queue_depth[1]), static_cast<i32>(stats->queue_depth[2]), static_cast<i32>(stats->max_queue_depth[0]), static_cast<i32>(stats->max_queue_depth[1]), static_cast<i32>(stats->max_queue_depth[2]));
+                ImGui::Text("Queued by simulation thread: %d, queue full stalls: %d", static_cast<i32>(stats->jobs_queued_externally), static_cast<i32>(stats->queue_full_stalls));
+                ImGui::Text("Barrier: %d waits, %.1f us (%.1f us asleep), %d jobs run by the waiting thread", static_cast<i32>(stats->barrier_waits), stats->barrier_wait_us, stats->barrier_sleep_us, static_cast<i32>(stats->barrier_jobs_executed));
+                if (snapshot->thread_tuner_decision[0]) ImGui::Text("Thread tuner: %s", snapshot->thread_tuner_decision);
+
+                if (ImGui::BeginTable("Workers", 8, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+                    ImGui::TableSetupColumn("Worker");
+                    ImGui::TableSetupColumn("Queued");
+                    ImGui::TableSetupColumn("Executed");
+                    ImGui::TableSetupColumn("Busy (us)");
+                    ImGui::TableSetupColumn("Idle (us)");
+                    ImGui::TableSetupColumn("Wakeups (empty)");
+                    ImGui::TableSetupColumn("Latency avg (us)");
+                    ImGui::TableSetupColumn("Latency max (us)");
+                    ImGui::TableHeadersRow();
+                    for (u32 i = 0; i < stats->num_workers; ++i) {
+                        const SimWorkerStats* w = &stats->workers[i];
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn(); ImGui::Text("%d", static_cast<i32>(i + 1));
+                        ImGui::TableNextColumn(); ImGui::Text("%d", static_cast<i32>(w->jobs_queued));
+                        ImGui::TableNextColumn(); ImGui::Text("%d", static_cast<i32>(w->jobs_executed));
+                        ImGui::TableNextColumn(); ImGui::Text("%.1f", w->busy_us);
+                        ImGui::TableNextColumn(); ImGui::Text("%.1f", w->idle_us);
+                        ImGui::TableNextColumn(); ImGui::Text("%d (%d)", static_cast<i32>(w->wakeups), static_cast<i32>(w->empty_wakeups));
+                        ImGui::TableNextColumn(); ImGui::Text("%.1f", w->avg_latency_us);
+                        ImGui::TableNextColumn(); ImGui::Text("%.1f", w->max_latency_us);
+                    }
+                    ImGui::EndTable();
+                }
+            }
+        }
+        ImGui::End();
+
+        if (ImGui::Begin("Physics")) {
+            const JPH::PhysicsUpdateStats* stats = &snapshot->physics_stats;
+            constexpr f64 ns_to_ms = 1.0e-6;
+
+            auto history = &game_state->physics_stats;
+            if (snapshot->step_index != history->last_step_index) {
+                history->last_step_index = snapshot->step_index;
+                history->update_ms[history->next] = static_cast<f32>(static_cast<f64>(stats->mTotalTime) * ns_to_ms);
+                history->next = (history->next + 1) % PHYSICS_STATS_HISTORY;
+            }
+            char overlay[32];
+            snprintf(overlay, sizeof(overlay), "%.2f ms", static_cast<f64>(stats->mTotalTime) * ns_to_ms);
+            ImGui::PlotLines("Update", history->update_ms, PHYSICS_STATS_HISTORY, static_cast<i32>(history->next), overlay, 0.0f, 1000.0f * PHY_FIXED_TIME_STEP, ImVec2(0.0f, 60.0f));
+
+            ImGui::Text("Active bodies: %d (%d soft), %d woke up, %d went to sleep", static_cast<i32>(stats->mNumActiveBodies), static_cast<i32>(stats->mNumActiveSoftBodies), static_cast<i32>(stats->mNumBodiesWokeUp), static_cast<i32>(stats->mNumBodiesWentToSleep));
+            ImGui::Text("Body pairs: %d, manifolds: %d, contact constraints: %d, constraints: %d", static_cast<i32>(stats->mNumBodyPairs), static_cast<i32>(stats->mNumManifolds), static_cast<i32>(stats->mNumContactConstraints), static_cast<i32>(stats->mNumActiveConstraints));
+            ImGui::Text("Islands: %d, large: %d in %d splits, CCD bodies: %d", static_cast<i32>(stats->mNumIslands), static_cast<i32>(stats->mNumLargeIslands), static_cast<i32>(stats->mNumLargeIslandSplits), static_cast<i32>(stats->mNumCCDBodies));
+            ImGui::Text("Broad phase frame sync: %.3f ms", static_cast<f64>(stats->mBroadPhaseFrameSyncTime) * ns_to_ms);
+
+            if (ImGui::BeginTable("Phases", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+                ImGui::TableSetupColumn("Phase");
+                ImGui::TableSetupColumn("Wall (ms)");
+                ImGui::TableSetupColumn("Threads (ms)");
+                ImGui::TableSetupColumn("Jobs");
+                ImGui::TableHeadersRow();
+                for (i32 i = 0; i < static_cast<i32>(JPH::EPhysicsUpdatePhase::Count); ++i) {
+                    const auto phase = static_cast<JPH::EPhysicsUpdatePhase>(i);
+                    const JPH::PhysicsUpdateStats::Phase& p = stats->GetPhase(phase);
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn(); ImGui::TextUnformatted(JPH::PhysicsUpdateStats::sGetPhaseName(phase));
+                    ImGui::TableNextColumn(); ImGui::Text("%.3f", static_cast<f64>(p.mWallTime) * ns_to_ms);
+                    ImGui::TableNextColumn(); ImGui::Text("%.3f", static_cast<f64>(p.mThreadTime) * ns_to_ms);
+                    ImGui::TableNextColumn(); ImGui::Text("%d", static_cast<i32>(p.mNumJobs));
+                }
+                ImGui::EndTable();
+            }
+        }
+        ImGui::End();
+
+        // Bring the round rect back once all of its pieces are gone
+        if (game_state->respawn_command_id != 0 && snapshot->last_command_id >= game_state->respawn_command_id) {
+            game_state->respawn_command_id = 0;
+        }
+        if (game_state->respawn_command_id == 0 && !has_round_rect && snapshot->fracture_stats.num_spawned == snapshot->fracture_stats.num_released) {
+            const SimCommand cmd = {
+                .id = game_state->next_command_id++,
+                .type = SIM_COMMAND_SPAWN_OBJECT,
+                .mesh_index = STATIC_MESH_ROUND_RECT_1x1,
+                .x = -4.0f,
+                .y = 4.0f,
+            };
+            if (sim_push_command(sim, cmd)) game_state->respawn_command_id = cmd.id;
+        }
+
+        /* Labels */ {
+            const TextAtlas* atlas = game_state->text.atlas;
+            std::vector<CppHlsl_Glyph>* glyphs = &game_state->text.glyphs;
+            glyphs->clear();
+
+            static const char* mesh_names[STATIC_MESH_NUM] = { "Round rect", "Circle", "Rect", "Path" };
+            char label[64];
+
+            if (game_state->text.show_labels) {
+                for (usize i = 0; i < game_state->objects.size(); ++i) {
+                    const u32 mesh_index = game_state->objects[i].mesh_index;
+                    if (mesh_index >= STATIC_MESH_NUM) continue; // Fracture pieces
+
+                    const CppHlsl_Object* obj = &game_state->cpp_hlsl_objects[i];
+                    snprintf(label, sizeof(label), "%s\n(%.1f, %.1f)", mesh_names[mesh_index], static_cast<f64>(obj->x), static_cast<f64>(obj->y));
+
+                    const f32 width = text_measure(atlas, label, TEXT_LABEL_SIZE);
+                    text_layout(atlas, label, obj->x - 0.5f * width, obj->y + game_state->mesh_lods[mesh_index].radius + 2.0f * TEXT_LABEL_SIZE, TEXT_LABEL_SIZE, 0xffffffff, MAX_GLYPHS, glyphs);
+                }
+            }
+            for (i32 i = 0; i < game_state->text.num_stress_labels; ++i) {
+                snprintf(label, sizeof(label), "Label %d", i);
+                const f32 x = -8.0f + 2.0f * static_cast<f32>(i % 8);
+                const f32 y = -4.0f - 0.5f * static_cast<f32>(i / 8);
+                text_layout(atlas, label, x, y, 0.5f * TEXT_LABEL_SIZE, 0xff40c0ff, MAX_GLYPHS, glyphs);
+            }
+        }
+
+        // Render-only objects
+        assert(game_state->objects.size() + DYNAMIC_MESH_NUM <= MAX_OBJECTS);
+        game_state->objects.push_back({ .mesh_index = DYNAMIC_MESH_TRAIL, .is_dynamic_mesh = true });
+        game_state->cpp_hlsl_objects.push_back({ .x = 5.0f, .y = 2.5f });
+
+        game_state->objects.push_back({ .mesh_index = DYNAMIC_MESH_STAR, .is_dynamic_mesh = true });
+        game_state->cpp_hlsl_objects.push_back({ .x = -5.5f, .y = -2.5f });
+    }
+
+    /* Strokes */ {
+        StrokeStyle* star_style = &game_state->stroke.star_style;
+
+        if (ImGui::Begin("Stroke")) {
+            const StrokeCacheStats* stats = &game_state->stroke.cache->stats;
+            ImGui::Text("Cache: %d hits, %d misses, %d evictions, %d collisions", static_cast<i32>(stats->num_hits), static_cast<i32>(stats->num_misses), static_cast<i32>(stats->num_evictions), static_cast<i32>(stats->num_collisions));
+            ImGui::Text("Vertices reused: %d", static_cast<i32>(stats->num_vertices_reused));
+            ImGui::Text("Dynamic vertices: %d / %d", static_cast<i32>(game_state->dynamic_vertices.size()), MAX_DYNAMIC_VERTICES);
+
+            const char* joins[] = { "Miter", "Round", "Bevel" };
+            const char* caps[] = { "Butt", "Square", "Round" };
+            i32 join = static_cast<i32>(star_style->join);
+            i32 cap = static_cast<i32>(star_style->cap);
+            bool closed = star_style->closed != 0;
+
+            ImGui::SliderFloat("Width", &star_style->width, 0.01f, 0.5f);
+            ImGui::SliderFloat("Miter limit", &star_style->miter_limit, 1.0f, 10.0f);
+            ImGui::Combo("Join", &join, joins, ARRAYSIZE(joins));
+            ImGui::Combo("Cap", &cap, caps, ARRAYSIZE(caps));
+            ImGui::Checkbox("Closed", &closed);
+
+            star_style->join = static_cast<u32>(join);
+            star_style->cap = static_cast<u32>(cap);
+            star_style->closed = closed ? 1 : 0;
+        }
+        ImGui::End();
+
+        // Trail changes every frame (always a cache miss), the star only when its style is edited.
+        std::vector<CppHlsl_Vertex>& trail = game_state->stroke.trail_points;
+        for (u32 i = 0; i < STROKE_TRAIL_POINTS; ++i) {
+            const f32 t = static_cast<f32>(time) - 0.02f * static_cast<f32>(i);
+            trail[i] = { 1.5f * sinf(3.0f * t), 1.5f * sinf(2.0f * t) };
+        }
+
+        StrokePath paths[DYNAMIC_MESH_NUM] = {};
+        paths[DYNAMIC_MESH_TRAIL] = {
+            .points = trail.data(),
+            .num_points = STROKE_TRAIL_POINTS,
+            .style = { .width = 0.15f, .miter_limit = 4.0f, .tolerance = 0.005f, .join = STROKE_JOIN_ROUND, .cap = STROKE_CAP_ROUND, .closed = 0 },
+        };
+        paths[DYNAMIC_MESH_STAR] = {
+            .points = game_state->stroke.star_points.data(),
+            .num_points = static_cast<u32>(game_state->stroke.star_points.size()),
+            .style = *star_style,
+        };
+        stroke_paths(game_state->stroke.cache, game_state->stroke.job_system, paths, DYNAMIC_MESH_NUM);
+
+        game_state->dynamic_vertices.clear();
+        for (u32 i = 0; i < DYNAMIC_MESH_NUM; ++i) {
+            const std::vector<CppHlsl_Vertex>* vertices = paths[i].vertices;
+            StaticMesh* mesh = &game_state->dynamic_meshes[i];
+
+            mesh->first_vertex = static_cast<u32>(game_state->dynamic_vertices.size());
+            mesh->num_vertices = 0;
+            if (mesh->first_vertex + vertices->size() > MAX_DYNAMIC_VERTICES) continue;
+
+            mesh->num_vertices = static_cast<u32>(vertices->size());
+            game_state->dynamic_vertices.insert(game_state->dynamic_vertices.end(), vertices->begin(), vertices->end());
+        }
+    }
+
     ImGui::Render();
 }
 
+// Level for one instance of a mesh centered at (x, y): the coarsest one when the instance is outside the view
+// (half extents `view_half_width` x `view_half_height` around the origin) or only a couple of pixels large, otherwise the
+// coarsest level whose flattening error stays under MESH_LOD_MAX_PIXEL_ERROR at the current zoom.
+func select_mesh_lod(const StaticMeshLods* lods, f32 x, f32 y, f32 view_half_width, f32 view_half_height, f32 pixels_per_unit) -> u32
+{
+    if (lods->num_lods <= 1) return 0;
+    if (lods->radius * pixels_per_unit < MESH_LOD_MIN_PIXEL_RADIUS) return lods->num_lods - 1;
+    if (fabsf(x) - lods->radius > view_half_width || fabsf(y) - lods->radius > view_half_height) return lods->num_lods - 1;
+
+    u32 lod = 0;
+    while (lod + 1 < lods->num_lods && lods->tolerances[lod + 1] * pixels_per_unit <= MESH_LOD_MAX_PIXEL_ERROR) {
+        lod += 1;
+    }
+    return lod;
+}
+
 func draw(GameState* game_state) -> void
 {
     assert(game_state);
 
     GpuContext* gc = game_state->gpu.gc;
 
+    f32 pixels_per_unit, view_half_width, view_half_height;
     {
-        const f32 r = 5.0f;
+        const f32 r = game_state->view_size;
         XMMATRIX xform;
         if (gc->window_width >= gc->window_height) {
             const float aspect = static_cast<f32>(gc->window_width) / static_cast<f32>(gc->window_height);
@@ -705,13 +1237,19 @@ func draw(GameState* game_state) -> void
             const float aspect = static_cast<f32>(gc->window_height) / static_cast<f32>(gc->window_width);
             xform = XMMatrixOrthographicOffCenterLH(-r, r, -r * aspect, r * aspect, -1.0f, 1.0f);
         }
+        // Clip space x spans 2 units across the window width.
+        pixels_per_unit = 0.5f * XMVectorGetX(xform.r[0]) * static_cast<f32>(gc->window_width);
+        view_half_width = 1.0f / XMVectorGetX(xform.r[0]);
+        view_half_height = 1.0f / XMVectorGetY(xform.r[1]);
 
         auto* ptr = reinterpret_cast<UploadData*>(game_state->gpu.upload_buffer_bases[gc->frame_index]);
-        memset(ptr, 0, sizeof(UploadData));
+        memset(ptr, 0, offsetof(UploadData, glyphs));
 
         XMStoreFloat4x4(&ptr->frame_state.proj, XMMatrixTranspose(xform));
 
         memcpy(ptr->objects, game_state->cpp_hlsl_objects.data(), game_state->cpp_hlsl_objects.size() * sizeof(CppHlsl_Object));
+        memcpy(ptr->glyphs, game_state->text.glyphs.data(), game_state->text.glyphs.size() * sizeof(CppHlsl_Glyph));
+        memcpy(ptr->dynamic_vertices, game_state->dynamic_vertices.data(), game_state->dynamic_vertices.size() * sizeof(CppHlsl_Vertex));
     }
 
     {
@@ -740,7 +1278,20 @@ func draw(GameState* game_state) -> void
         gc->command_list->Barrier(1, &barrier_group);
     }
 
-    gc->command_list->CopyBufferRegion(game_state->gpu.buffer_dynamic, 0, game_state->gpu.upload_buffers[gc->frame_index], 0, sizeof(UploadData));
+    // Copy only the glyphs and dynamic vertices written this frame
+    {
+        ID3D12Resource2* upload_buffer = game_state->gpu.upload_buffers[gc->frame_index];
+        const usize glyphs_size = game_state->text.glyphs.size() * sizeof(CppHlsl_Glyph);
+        const usize vertices_size = game_state->dynamic_vertices.size() * sizeof(CppHlsl_Vertex);
+
+        gc->command_list->CopyBufferRegion(game_state->gpu.buffer_dynamic, 0, upload_buffer, 0, offsetof(UploadData, glyphs));
+        if (glyphs_size > 0) {
+            gc->command_list->CopyBufferRegion(game_state->gpu.buffer_dynamic, offsetof(UploadData, glyphs), upload_buffer, offsetof(UploadData, glyphs), glyphs_size);
+        }
+        if (vertices_size > 0) {
+            gc->command_list->CopyBufferRegion(game_state->gpu.buffer_dynamic, offsetof(UploadData, dynamic_vertices), upload_buffer, offsetof(UploadData, dynamic_vertices), vertices_size);
+        }
+    }
 
     {
         const D3D12_BUFFER_BARRIER buffer_barriers[] = {
@@ -772,17 +1323,37 @@ func draw(GameState* game_state) -> void
     gc->command_list->SetGraphicsRootSignature(game_state->gpu.root_signatures[0]);
     gc->command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
+    game_state->lod_stats = {};
+
     for (usize i = 0; i < game_state->objects.size(); ++i) {
         const Object* obj = &game_state->objects[i];
-        const u32 mesh_index = obj->mesh_index;
+        const StaticMesh* mesh = obj->is_dynamic_mesh ? &game_state->dynamic_meshes[obj->mesh_index] : &game_state->meshes[obj->mesh_index];
+
+        game_state->lod_stats.num_vertices_full += mesh->num_vertices;
+        if (!obj->is_dynamic_mesh && obj->mesh_index < STATIC_MESH_NUM) {
+            const CppHlsl_Object* instance = &game_state->cpp_hlsl_objects[i];
+            const u32 lod = select_mesh_lod(&game_state->mesh_lods[obj->mesh_index], instance->x, instance->y, view_half_width, view_half_height, pixels_per_unit);
+            mesh = &game_state->mesh_lods[obj->mesh_index].levels[lod];
+            game_state->lod_stats.num_objects_per_lod[lod] += 1;
+        }
+        game_state->lod_stats.num_vertices_drawn += mesh->num_vertices;
+
+        if (mesh->num_vertices == 0) continue;
 
         const u32 root_consts[] = {
-            game_state->meshes[mesh_index].first_vertex,
+            mesh->first_vertex,
             static_cast<u32>(i), // object index
+            static_cast<u32>(obj->is_dynamic_mesh ? RDH_VERTEX_BUFFER_DYNAMIC : RDH_VERTEX_BUFFER_STATIC),
         };
 
         gc->command_list->SetGraphicsRoot32BitConstants(0, ARRAYSIZE(root_consts), &root_consts, 0);
-        gc->command_list->DrawInstanced(game_state->meshes[mesh_index].num_vertices, 1, 0, 0);
+        gc->command_list->DrawInstanced(mesh->num_vertices, 1, 0, 0);
+    }
+
+    if (!game_state->text.glyphs.empty()) {
+        gc->command_list->SetPipelineState(game_state->gpu.pipelines[1]);
+        gc->command_list->SetGraphicsRootSignature(game_state->gpu.root_signatures[1]);
+        gc->command_list->DrawInstanced(6, static_cast<u32>(game_state->text.glyphs.size()), 0, 0);
     }
 }
 
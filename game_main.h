@@ -1,8 +1,57 @@
 #define WITH_D3D12_DEBUG_LAYER 1
 #define WITH_D3D12_GPU_BASED_VALIDATION 0
 
+#define GAME_RPMALLOC 0 // Jolt, ImGui and operator new/delete use rpmalloc instead of the CRT heap, see game_alloc.cpp
+
 #define GPU_ENABLE_VSYNC 1
 #define GPU_MAX_BUFFERED_FRAMES 2
 #define GPU_MAX_DESCRIPTORS (16 * 1024)
 #define GPU_NUM_MSAA_SAMPLES 8
 #define GPU_CLEAR_COLOR { 0.0f, 0.0f, 0.0f, 0.0f }
+
+#define PHY_MAX_BODIES (16 * 1024)
+#define PHY_NUM_BODY_MUTEXES 0
+#define PHY_MAX_BODY_PAIRS (16 * 1024)
+#define PHY_MAX_CONTACT_CONSTRAINTS (8 * 1024)
+#define PHY_FIXED_TIME_STEP (1.0f / 60.0f)
+#define PHY_TEMP_ALLOCATOR_SIZE (10 * 1024 * 1024) // Initial size, JPH::TempAllocatorGrowing adds blocks when a step needs more
+#define PHY_WORKER_TEMP_ALLOCATOR_SIZE (256 * 1024) // Scratch memory per JPH::JobSystemThreadPool worker, see JPH::JobSystem::sGetThreadTempAllocator()
+#define PHY_JOB_MAGAZINE_SIZE 16 // Free jobs a JPH::JobSystemThreadPool thread moves to / from the shared free list at once, 0 to disable
+#define PHY_WORK_STEALING_JOB_SYSTEM 0 // JPH::JobSystemWorkStealing instead of JPH::JobSystemThreadPool
+#define PHY_PIN_THREADS 1 // Pin physics workers with JPH::ThreadTopology, one per physical core, performance cores first
+#define PHY_BROAD_PHASE_SAP 0 // JPH::BroadPhaseSAP instead of JPH::BroadPhaseQuadTree, compare them with bench_sweep_and_prune
+#define PHY_TUNE_THREADS 1 // Let PhysicsThreadTuner pick how many of those workers the physics steps use, JPH::JobSystemThreadPool only
+#define PHY_PROFILE_HITCH_FRAMES 8 // JPH_PROFILE_ENABLED builds: frames kept by the JPH::Profiler flight recorder, see game_profile.cpp
+#define PHY_PROFILE_HITCH_BUDGET (8.0f / 1000.0f) // Seconds, a slower physics step dumps the recorded frames to profile_trace_hitch_*.json
+#define PHY_ALLOC_WATCH 0 // Debug: log where a physics step allocates from the heap, see alloc_watch_install()
+#define PHY_ALLOC_WATCH_WARMUP_STEPS 120 // Steps that may allocate while the scene fills up
+
+#define MAX_OBJECTS 1024
+#define MAX_DYNAMIC_VERTICES (16 * 1024)
+#define MAX_GLYPHS (4 * 1024)
+
+#define MESH_MAX_LODS 4
+#define MESH_LOD_TOLERANCE_STEP 4.0f // Flattening tolerance multiplier between consecutive LODs
+#define MESH_LOD_MAX_PIXEL_ERROR 0.5f // Max on-screen flattening error of the selected LOD
+#define MESH_LOD_MIN_PIXEL_RADIUS 2.0f // Meshes smaller than this on screen always use the coarsest LOD
+
+struct StaticMesh
+{
+    u32 first_vertex;
+    u32 num_vertices;
+};
+
+struct StaticMeshLods
+{
+    u32 num_lods;
+    f32 radius; // Bounding circle radius around the mesh origin
+    f32 tolerances[MESH_MAX_LODS]; // Flattening tolerance of each level in world units
+    StaticMesh levels[MESH_MAX_LODS]; // Finest first
+};
+
+struct Object
+{
+    u32 mesh_index;
+    JPH::BodyID body_id;
+    bool is_dynamic_mesh; // `mesh_index` refers to GameState::dynamic_meshes (rebuilt every frame)
+};
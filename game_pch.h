@@ -1,35 +1,88 @@
 #pragma once
 
+#if !defined(GAME_HEADLESS)
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #include "d3d12.h"
 #include <dxgi1_6.h>
 #include <d2d1_3.h>
+#endif
+
+#if defined(_WIN32)
+#if defined(GAME_HEADLESS)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+#include <dbghelp.h> // alloc_watch_report()
+#else
+#include <execinfo.h> // alloc_watch_report()
+#endif
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdarg.h>
+#include <assert.h>
 #include <math.h>
 #include <string.h>
 
 #include <vector>
 #include <algorithm>
 #include <functional>
+#include <unordered_map>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <coroutine>
+#include <barrier>
 
 #include "imgui.h"
+#if !defined(GAME_HEADLESS)
 #include "imgui_impl_win32.h"
 #include "imgui_impl_dx12.h"
+#endif
 
 #include "Jolt/Jolt.h"
 #include "Jolt/RegisterTypes.h"
 #include "Jolt/Core/Factory.h"
+#include "Jolt/Core/HashCombine.h"
 #include "Jolt/Core/TempAllocator.h"
+#include "Jolt/Core/TempAllocatorGrowing.h"
 #include "Jolt/Core/JobSystemThreadPool.h"
+#include "Jolt/Core/JobSystemWorkStealing.h"
+#include "Jolt/Core/JobSystemSingleThreaded.h"
+#include "Jolt/Core/ThreadTopology.h"
+#include "Jolt/Core/JobAwaiter.h"
+#include "Jolt/Core/LockFreeHashMap.h"
+#include "Jolt/Core/LockFreeOpenHashMap.h"
 #include "Jolt/Physics/PhysicsSettings.h"
 #include "Jolt/Physics/PhysicsSystem.h"
+#include "Jolt/Physics/StateRecorderImpl.h"
+#include "Jolt/Physics/DeterminismLog.h"
 #include "Jolt/Physics/Collision/Shape/BoxShape.h"
 #include "Jolt/Physics/Collision/Shape/SphereShape.h"
+#include "Jolt/Physics/Collision/Shape/ConvexHullShape.h"
+#include "Jolt/Physics/Collision/Shape/CapsuleShape.h"
+#include "Jolt/Physics/Collision/Shape/MeshShape.h"
+#include "Jolt/Physics/Collision/Shape/HeightFieldShape.h"
+#include "Jolt/Physics/Collision/RayCast.h"
+#include "Jolt/Physics/Collision/CastResult.h"
+#include "Jolt/Physics/Collision/AABoxCast.h"
+#include "Jolt/Geometry/OrientedBox.h"
+#include "Jolt/Physics/Collision/BroadPhase/BroadPhaseQuadTree.h"
+#include "Jolt/Physics/Constraints/HingeConstraint.h"
+#include "Jolt/Physics/Constraints/PointConstraint.h"
+#include "Jolt/Physics/Constraints/DistanceConstraint.h"
+#include "Jolt/Physics/Constraints/SwingTwistConstraint.h"
+#include "Jolt/Physics/Ragdoll/Ragdoll.h"
+#include "Jolt/Physics/SoftBody/SoftBodyCreationSettings.h"
+#include "Jolt/Physics/SoftBody/SoftBodySharedSettings.h"
+#include "Jolt/Physics/Character/CharacterVirtual.h"
+#include "Jolt/Skeleton/Skeleton.h"
 #include "Jolt/Physics/Body/BodyCreationSettings.h"
 #include "Jolt/Physics/Body/BodyActivationListener.h"
 
@@ -43,7 +96,9 @@ using namespace DirectX;
 #pragma warning(disable:4365)
 #pragma warning(disable:4100)
 #include "tracy/Tracy.hpp"
+#if !defined(GAME_HEADLESS)
 #include "tracy/TracyD3D12.hpp"
+#endif
 #pragma warning(pop)
 
 using u64 = uint64_t;
@@ -63,10 +118,11 @@ using f64 = double;
 
 #define LOG(fmt, ...) do \
 { \
-    fprintf(stderr, (fmt), __VA_ARGS__); \
+    fprintf(stderr, (fmt), ##__VA_ARGS__); \
     fprintf(stderr, " (%s:%d)\n", __FILE__, __LINE__); \
 } while(0)
 
+#if !defined(GAME_HEADLESS)
 #define VHR(r) do \
 { \
     if (FAILED(r)) { \
@@ -75,6 +131,7 @@ using f64 = double;
         ExitProcess(1); \
     } \
 } while(0)
+#endif
 
 #define SAFE_RELEASE(obj) do \
 { \
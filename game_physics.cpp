@@ -0,0 +1,345 @@
+static constexpr auto OBJECT_LAYER_NON_MOVING = JPH::ObjectLayer(0);
+static constexpr auto OBJECT_LAYER_MOVING = JPH::ObjectLayer(1);
+#define OBJECT_LAYER_NUM 2
+
+static constexpr auto BROAD_PHASE_LAYER_NON_MOVING = JPH::BroadPhaseLayer(0);
+static constexpr auto BROAD_PHASE_LAYER_MOVING = JPH::BroadPhaseLayer(1);
+#define BROAD_PHASE_LAYER_NUM 2
+
+static constexpr auto BROAD_PHASE_TYPE = PHY_BROAD_PHASE_SAP ? JPH::EBroadPhaseType::SweepAndPrune : JPH::EBroadPhaseType::QuadTree;
+
+struct ObjectLayerPairFilter final : public JPH::ObjectLayerPairFilter
+{
+    virtual bool ShouldCollide(JPH::ObjectLayer object1, JPH::ObjectLayer object2) const override {
+        switch (object1) {
+            case OBJECT_LAYER_NON_MOVING: return object2 == OBJECT_LAYER_MOVING;
+            case OBJECT_LAYER_MOVING: return true;
+            default: JPH_ASSERT(false); return false;
+        }
+    }
+};
+
+struct BroadPhaseLayerInterface final : public JPH::BroadPhaseLayerInterface
+{
+    JPH::BroadPhaseLayer object_to_broad_phase[OBJECT_LAYER_NUM];
+
+    BroadPhaseLayerInterface() {
+        object_to_broad_phase[OBJECT_LAYER_NON_MOVING] = BROAD_PHASE_LAYER_NON_MOVING;
+        object_to_broad_phase[OBJECT_LAYER_MOVING] = BROAD_PHASE_LAYER_MOVING;
+    }
+
+    virtual u32 GetNumBroadPhaseLayers() const override { return BROAD_PHASE_LAYER_NUM; }
+
+    virtual JPH::BroadPhaseLayer GetBroadPhaseLayer(JPH::ObjectLayer layer) const override {
+        JPH_ASSERT(layer < OBJECT_LAYER_NUM);
+        return object_to_broad_phase[layer];
+    }
+
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+    virtual const char* GetBroadPhaseLayerName(JPH::BroadPhaseLayer layer) const override {
+        switch (static_cast<JPH::BroadPhaseLayer::Type>(layer)) {
+            case static_cast<JPH::BroadPhaseLayer::Type>(BROAD_PHASE_LAYER_NON_MOVING): return "NON_MOVING";
+            case static_cast<JPH::BroadPhaseLayer::Type>(BROAD_PHASE_LAYER_MOVING): return "MOVING";
+            default: JPH_ASSERT(false); return "INVALID";
+        }
+    }
+#endif
+};
+
+struct ObjectVsBroadPhaseLayerFilter final : public JPH::ObjectVsBroadPhaseLayerFilter
+{
+    virtual bool ShouldCollide(JPH::ObjectLayer layer1, JPH::BroadPhaseLayer layer2) const override {
+        switch (layer1) {
+            case OBJECT_LAYER_NON_MOVING: return layer2 == BROAD_PHASE_LAYER_MOVING;
+            case OBJECT_LAYER_MOVING: return true;
+            default: JPH_ASSERT(false); return false;
+        }
+    }
+};
+
+func jolt_trace(const char* fmt, ...) -> void
+{
+    va_list list;
+    va_start(list, fmt);
+    char buffer[1024];
+    vsnprintf(buffer, sizeof(buffer), fmt, list);
+    va_end(list);
+
+    LOG("[physics] %s", buffer);
+}
+
+#ifdef JPH_ENABLE_ASSERTS
+func jolt_assert_failed(const char* expression, const char* message, const char* file, u32 line) -> bool
+{
+    LOG("[physics] Assert failed (%s): (%s:%d) %s", expression, file, line, message ? message : "");
+
+    return true; // breakpoint
+}
+#endif
+
+// Pins the workers of `job_system` where `topology` places them, names them for Tracy and logs the choices. Workers
+// hand their heap back with alloc_thread_exit(). Must be called before the job system is initialized because that
+// starts the threads.
+template<typename T> func place_physics_workers(T* job_system, const JPH::ThreadTopology& topology, const JPH::ThreadTopology::Settings& settings, i32 num_threads) -> void
+{
+    LOG("[physics] Topology: %d cpus, %d cores, %d nodes%s%s", static_cast<i32>(topology.GetCpus().size()), topology.GetNumCores(), topology.GetNumNodes(), topology.IsHybrid() ? ", hybrid" : "", topology.CanPinThreads() ? "" : ", pinning not supported");
+
+    JPH::Array<JPH::ThreadTopology::Placement> placements;
+    topology.Plan(num_threads, settings, placements);
+
+    for (i32 i = 0; i < num_threads; ++i) {
+        const JPH::ThreadTopology::Placement& p = placements[static_cast<usize>(i)];
+        if (p.mCpu < 0) {
+            LOG("[physics] Worker %d: not pinned", i + 1);
+        } else {
+            LOG("[physics] Worker %d: cpu %d (core %d, node %d%s%s)", i + 1, p.mCpu, p.mCore, p.mNode, p.mIsSMTSibling ? ", smt sibling" : "", p.mIsEfficiencyCore ? ", efficiency core" : "");
+        }
+    }
+
+    job_system->SetThreadInitFunction([placements](int index) {
+        const JPH::ThreadTopology::Placement& p = placements[static_cast<usize>(index)];
+
+        char name[64];
+        if (p.mCpu < 0) {
+            snprintf(name, sizeof(name), "Worker %d", index + 1);
+        } else {
+            if (!JPH::ThreadTopology::sPinCurrentThread(p.mCpu)) LOG("[physics] Failed to pin worker %d to cpu %d", index + 1, p.mCpu);
+            snprintf(name, sizeof(name), "Worker %d (cpu %d, node %d%s)", index + 1, p.mCpu, p.mNode, p.mIsEfficiencyCore ? ", E" : "");
+        }
+#if defined(TRACY_ENABLE)
+        tracy::SetThreadName(name);
+#endif
+    });
+    job_system->SetThreadExitFunction([](int) { alloc_thread_exit(); });
+}
+
+//
+// Picks the number of physics threads (including the simulation thread) from measured step times. It measures a few
+// thread counts for a window of steps each, fits T(n) = s + p / n + o * n to the medians (serial work, parallel work
+// and the cost of waking and feeding another thread) and takes the fewest threads that are predicted to be within
+// `tolerance` of the fastest. Once settled it only measures the current count, and explores the neighbouring counts
+// again when the step time drifts away from what it settled on. Decisions go to the log.
+//
+#define PHY_THREAD_TUNER_MAX_THREADS 64
+#define PHY_THREAD_TUNER_MAX_WINDOW 64
+
+enum PhysicsThreadTunerPhase : u32
+{
+    PHYSICS_THREAD_TUNER_EXPLORING,
+    PHYSICS_THREAD_TUNER_SETTLED,
+};
+
+struct PhysicsThreadTuner
+{
+    // Settings, see physics_thread_tuner_init()
+    u32 max_threads;
+    u32 window; // Steps measured per sample
+    u32 settle; // Steps ignored after the thread count changed
+    f32 tolerance; // Fewer threads win when they're predicted to be at most this much slower than the fastest count
+    f32 hysteresis; // Predicted gain needed to move away from the current count
+    f32 drift; // Change of the median step time after which it explores again
+
+    PhysicsThreadTunerPhase phase;
+    u32 threads; // For the next step
+    u32 settled_threads; // Where it was before it started exploring
+    u32 explore[8]; // Counts still to measure, the last one goes first
+    u32 num_explore;
+    u32 steps_to_settle;
+    f64 window_times[PHY_THREAD_TUNER_MAX_WINDOW];
+    u32 num_window_times;
+    f64 median[PHY_THREAD_TUNER_MAX_THREADS + 1]; // Seconds per count, 0 when not measured since the last exploration
+    f64 settled_time; // Median when it settled
+    f64 model[3]; // s, p, o
+    char decision[160]; // Last decision
+};
+
+func physics_thread_tuner_init(PhysicsThreadTuner* tuner, u32 max_threads) -> void
+{
+    *tuner = {
+        .max_threads = std::clamp<u32>(max_threads, 1, PHY_THREAD_TUNER_MAX_THREADS),
+        .window = 30,
+        .settle = 10,
+        .tolerance = 0.05f,
+        .hysteresis = 0.1f,
+        .drift = 0.3f,
+        .phase = PHYSICS_THREAD_TUNER_EXPLORING,
+    };
+    tuner->threads = tuner->max_threads;
+    tuner->settled_threads = tuner->max_threads;
+    tuner->steps_to_settle = tuner->settle;
+    snprintf(tuner->decision, sizeof(tuner->decision), "exploring from %u threads", tuner->threads);
+
+    // Start at all threads and halve, so the first counts measured are the ones that can't hitch
+    u32 counts[8];
+    u32 num_counts = 0;
+    for (u32 n = tuner->max_threads; n >= 1; n /= 2) counts[num_counts++] = n;
+    for (u32 i = num_counts; i-- > 1;) tuner->explore[tuner->num_explore++] = counts[i];
+}
+
+func physics_thread_tuner_predict(const PhysicsThreadTuner* tuner, u32 n) -> f64
+{
+    const f64 x = static_cast<f64>(n);
+    return tuner->model[0] + tuner->model[1] / x + tuner->model[2] * x;
+}
+
+// Least squares fit of the model to the measured medians, with fewer terms when there are fewer samples
+func physics_thread_tuner_fit(PhysicsThreadTuner* tuner) -> void
+{
+    f64 xs[PHY_THREAD_TUNER_MAX_THREADS], ts[PHY_THREAD_TUNER_MAX_THREADS];
+    u32 num_samples = 0;
+    for (u32 n = 1; n <= tuner->max_threads; ++n) {
+        if (tuner->median[n] <= 0.0) continue;
+        xs[num_samples] = static_cast<f64>(n);
+        ts[num_samples] = tuner->median[n];
+        ++num_samples;
+    }
+
+    tuner->model[0] = num_samples > 0 ? ts[0] : 0.0;
+    tuner->model[1] = 0.0;
+    tuner->model[2] = 0.0;
+    if (num_samples < 2) return;
+
+    // Normal equations for the basis (1, 1/n, n), solved with Cramer's rule
+    for (u32 num_terms = num_samples >= 3 ? 3u : 2u; num_terms >= 2; --num_terms) {
+        f64 a[3][3] = {}, b[3] = {};
+        for (u32 i = 0; i < num_samples; ++i) {
+            const f64 basis[3] = { 1.0, 1.0 / xs[i], xs[i] };
+            for (u32 r = 0; r < num_terms; ++r) {
+                for (u32 c = 0; c < num_terms; ++c) a[r][c] += basis[r] * basis[c];
+                b[r] += basis[r] * ts[i];
+            }
+        }
+        if (num_terms == 2) a[2][2] = 1.0;
+
+        auto det = [](const f64 m[3][3]) {
+            return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+        };
+        const f64 d = det(a);
+        if (fabs(d) < 1.0e-30) continue;
+
+        f64 solution[3];
+        for (u32 c = 0; c < 3; ++c) {
+            f64 m[3][3];
+            memcpy(m, a, sizeof(m));
+            for (u32 r = 0; r < 3; ++r) m[r][c] = b[r];
+            solution[c] = det(m) / d;
+        }
+
+        // A negative per thread cost only shows up with noisy samples, drop the term
+        if (num_terms == 3 && solution[2] < 0.0) continue;
+
+        tuner->model[0] = solution[0];
+        tuner->model[1] = solution[1];
+        tuner->model[2] = num_terms == 3 ? solution[2] : 0.0;
+        return;
+    }
+}
+
+func physics_thread_tuner_decide(PhysicsThreadTuner* tuner) -> void
+{
+    physics_thread_tuner_fit(tuner);
+
+    f64 best_time = DBL_MAX;
+    for (u32 n = 1; n <= tuner->max_threads; ++n) best_time = std::min(best_time, physics_thread_tuner_predict(tuner, n));
+
+    u32 choice = tuner->max_threads;
+    for (u32 n = 1; n <= tuner->max_threads; ++n) {
+        if (physics_thread_tuner_predict(tuner, n) <= best_time * (1.0 + tuner->tolerance)) {
+            choice = n;
+            break;
+        }
+    }
+
+    // Only move when it's predicted to pay off, or when the extra threads of the current count buy nothing
+    const u32 current = tuner->settled_threads;
+    const f64 current_time = physics_thread_tuner_predict(tuner, current);
+    const f64 choice_time = physics_thread_tuner_predict(tuner, choice);
+    const bool faster = choice_time < current_time * (1.0 - tuner->hysteresis);
+    const bool cheaper = choice < current && choice_time <= current_time * (1.0 + tuner->tolerance);
+    if (!faster && !cheaper) choice = current;
+
+    const f64 serial_time = physics_thread_tuner_predict(tuner, 1);
+    const f64 efficiency = serial_time / (static_cast<f64>(choice) * physics_thread_tuner_predict(tuner, choice));
+    snprintf(tuner->decision, sizeof(tuner->decision), "%u -> %u threads, %.3f -> %.3f ms predicted, efficiency %.2f (s %.3f p %.3f o %.4f ms)",
+        current, choice, current_time * 1000.0, physics_thread_tuner_predict(tuner, choice) * 1000.0, efficiency, tuner->model[0] * 1000.0, tuner->model[1] * 1000.0, tuner->model[2] * 1000.0);
+    LOG("[physics] Thread tuner: %s", tuner->decision);
+
+    if (choice != tuner->threads) tuner->steps_to_settle = tuner->settle;
+    tuner->threads = choice;
+    tuner->settled_threads = choice;
+    tuner->settled_time = tuner->median[choice]; // 0 when it moved to a count that wasn't measured, the next window fills it in
+    tuner->phase = PHYSICS_THREAD_TUNER_SETTLED;
+}
+
+// Measure the current count and its neighbours again, the old samples are from another scene
+func physics_thread_tuner_explore_neighbors(PhysicsThreadTuner* tuner) -> void
+{
+    for (f64& median : tuner->median) median = 0.0;
+
+    const u32 current = tuner->threads;
+    const u32 lower = current / 2;
+    const u32 upper = std::min(current * 2, tuner->max_threads);
+
+    tuner->num_explore = 0;
+    if (upper > current) tuner->explore[tuner->num_explore++] = upper;
+    if (lower > 0) tuner->explore[tuner->num_explore++] = lower;
+    tuner->phase = PHYSICS_THREAD_TUNER_EXPLORING;
+}
+
+// Call after every physics step with the time the update took, returns the number of threads for the next step
+func physics_thread_tuner_add_step(PhysicsThreadTuner* tuner, f64 step_time) -> u32
+{
+    if (tuner->steps_to_settle > 0) {
+        --tuner->steps_to_settle;
+        return tuner->threads;
+    }
+
+    tuner->window_times[tuner->num_window_times++] = step_time;
+    if (tuner->num_window_times < std::min<u32>(tuner->window, PHY_THREAD_TUNER_MAX_WINDOW)) return tuner->threads;
+
+    // The median is what a step usually costs, one hitch in the window doesn't move it
+    f64* mid = tuner->window_times + tuner->num_window_times / 2;
+    std::nth_element(tuner->window_times, mid, tuner->window_times + tuner->num_window_times);
+    const f64 median = *mid;
+    tuner->num_window_times = 0;
+    tuner->median[tuner->threads] = median;
+
+    if (tuner->phase == PHYSICS_THREAD_TUNER_EXPLORING) {
+        if (tuner->num_explore == 0) {
+            physics_thread_tuner_decide(tuner);
+            return tuner->threads;
+        }
+
+        // Once a count is clearly slower than the best one, counts with even fewer threads won't win, skip them
+        f64 best_time = DBL_MAX;
+        for (u32 n = 1; n <= tuner->max_threads; ++n) {
+            if (tuner->median[n] > 0.0) best_time = std::min(best_time, tuner->median[n]);
+        }
+        const u32 next = tuner->explore[tuner->num_explore - 1];
+        if (next < tuner->threads && median > best_time * (1.0 + 4.0 * tuner->tolerance)) {
+            tuner->num_explore = 0;
+            physics_thread_tuner_decide(tuner);
+            return tuner->threads;
+        }
+
+        --tuner->num_explore;
+        tuner->threads = next;
+        tuner->steps_to_settle = tuner->settle;
+        return tuner->threads;
+    }
+
+    if (tuner->settled_time <= 0.0) {
+        tuner->settled_time = median;
+    } else if (fabs(median - tuner->settled_time) > tuner->settled_time * tuner->drift) {
+        LOG("[physics] Thread tuner: step time moved from %.3f to %.3f ms at %u threads, exploring again", tuner->settled_time * 1000.0, median * 1000.0, tuner->threads);
+        physics_thread_tuner_explore_neighbors(tuner);
+        tuner->median[tuner->threads] = median;
+        if (tuner->num_explore == 0) {
+            physics_thread_tuner_decide(tuner);
+        } else {
+            tuner->threads = tuner->explore[--tuner->num_explore];
+            tuner->steps_to_settle = tuner->settle;
+        }
+    }
+    return tuner->threads;
+}
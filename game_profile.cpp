@@ -0,0 +1,151 @@
+//
+// Jolt profiling (JPH_EXTERNAL_PROFILE): every JPH_PROFILE scope in Jolt becomes a Tracy zone and JPH_PROFILE_THREAD_START
+// names the thread. Tracy wants a source location that lives forever per zone, so we make one per JPH_PROFILE site, name
+// and color the first time they show up and cache it per thread. After that a zone costs a small cache lookup plus what
+// Tracy's own ZoneScoped costs. Without Tracy the scopes do nothing.
+//
+
+#if defined(JPH_EXTERNAL_PROFILE)
+
+#if defined(TRACY_ENABLE)
+
+struct ProfileLocationKey
+{
+    const JPH::ExternalProfileSite* site;
+    const char* name;
+    u32 color;
+
+    auto operator==(const ProfileLocationKey&) const -> bool = default;
+};
+
+// All source locations handed to Tracy, they're never freed. Only used when a thread sees a key for the first time.
+static std::mutex profile_locations_mutex;
+static std::vector<std::pair<ProfileLocationKey, tracy::SourceLocationData*>> profile_locations;
+
+// Jolt colors are Color::GetUInt32() (0xAABBGGRR), Tracy wants 0xRRGGBB. Scopes without a color get a distinct one per name.
+func profile_tracy_color(const char* name, u32 color) -> u32
+{
+    if (color == 0) color = JPH::Color::sGetDistinctColor(static_cast<i32>(JPH::HashBytes(name, static_cast<JPH::uint>(strlen(name))) & 0x7fffffff)).GetUInt32();
+    const JPH::Color c(color);
+    return (static_cast<u32>(c.r) << 16) | (static_cast<u32>(c.g) << 8) | c.b;
+}
+
+func profile_find_location(const ProfileLocationKey& key) -> const tracy::SourceLocationData*
+{
+    std::lock_guard lock(profile_locations_mutex);
+    for (const auto& [k, location] : profile_locations) {
+        if (k == key) return location;
+    }
+
+    auto location = new tracy::SourceLocationData{
+        .name = key.name,
+        .function = key.site->mFunction,
+        .file = key.site->mFile,
+        .line = key.site->mLine,
+        .color = profile_tracy_color(key.name, key.color),
+    };
+    profile_locations.push_back({ key, location });
+    return location;
+}
+
+// Direct mapped per thread cache in front of profile_find_location, a collision just means another trip to the mutex
+func profile_get_location(const JPH::ExternalProfileSite* site, const char* name, u32 color) -> const tracy::SourceLocationData*
+{
+    constexpr u32 cache_size = 256;
+    struct Cache
+    {
+        ProfileLocationKey keys[cache_size];
+        const tracy::SourceLocationData* locations[cache_size];
+    };
+    static thread_local Cache cache = {};
+
+    const ProfileLocationKey key = { site, name, color };
+    const u64 hash = (reinterpret_cast<uintptr_t>(site) ^ (reinterpret_cast<uintptr_t>(name) * 0x9e3779b97f4a7c15ull) ^ color) >> 4;
+    const u32 index = static_cast<u32>(hash ^ (hash >> 17)) & (cache_size - 1);
+    if (cache.locations[index] == nullptr || !(cache.keys[index] == key)) {
+        cache.keys[index] = key;
+        cache.locations[index] = profile_find_location(key);
+    }
+    return cache.locations[index];
+}
+
+static_assert(sizeof(tracy::ScopedZone) <= 64 && alignof(tracy::ScopedZone) <= 16, "Doesn't fit in ExternalProfileMeasurement::mUserData");
+
+JPH::ExternalProfileMeasurement::ExternalProfileMeasurement(const ExternalProfileSite& inSite, const char* inName, uint32 inColor)
+{
+    new (mUserData) tracy::ScopedZone(profile_get_location(&inSite, inName, inColor));
+}
+
+JPH::ExternalProfileMeasurement::~ExternalProfileMeasurement()
+{
+    reinterpret_cast<tracy::ScopedZone*>(mUserData)->~ScopedZone();
+}
+
+void JPH::ExternalProfileThreadStart(const char* inName)
+{
+    tracy::SetThreadName(inName);
+}
+
+#else
+
+JPH::ExternalProfileMeasurement::ExternalProfileMeasurement(const ExternalProfileSite&, const char*, uint32) {}
+JPH::ExternalProfileMeasurement::~ExternalProfileMeasurement() {}
+void JPH::ExternalProfileThreadStart(const char*) {}
+
+#endif // TRACY_ENABLE
+
+#endif // JPH_EXTERNAL_PROFILE
+
+//
+// Jolt's own profiler (JPH_PROFILE_ENABLED without JPH_EXTERNAL_PROFILE), for machines without a Tracy viewer. It runs as a
+// flight recorder: every thread keeps its last samples in a ring buffer and a physics step that takes longer than the budget
+// writes the last frames to profile_trace_hitch_<frame>.json, which chrome://tracing and Perfetto can open. The file is written
+// on a background thread. Without it these do nothing.
+//
+
+#if defined(JPH_PROFILE_ENABLED) && !defined(JPH_EXTERNAL_PROFILE)
+
+// Must be called before the job system starts its workers, otherwise they aren't recorded
+func profile_init(u32 num_frames, f32 frame_budget) -> void
+{
+    JPH::Profiler::sInstance = new JPH::Profiler();
+
+    JPH::Profiler::FlightRecorderSettings settings;
+    settings.mNumFrames = num_frames;
+    settings.mFrameBudget = frame_budget;
+    JPH::Profiler::sInstance->SetFlightRecorder(settings);
+}
+
+// Waits until pending dumps are written. All recorded threads must have called profile_thread_end() or exited.
+func profile_shutdown() -> void
+{
+    delete JPH::Profiler::sInstance;
+    JPH::Profiler::sInstance = nullptr;
+}
+
+func profile_thread_start(const char* name) -> void
+{
+    if (JPH::Profiler::sInstance) JPH::ProfileThread::sSetInstance(new JPH::ProfileThread(name));
+}
+
+func profile_thread_end() -> void
+{
+    delete JPH::ProfileThread::sGetInstance();
+    JPH::ProfileThread::sSetInstance(nullptr);
+}
+
+// Call after every physics step, the time from the first sample of the step to this call is checked against the budget
+func profile_next_frame() -> void
+{
+    if (JPH::Profiler::sInstance) JPH::Profiler::sInstance->NextFrame();
+}
+
+#else
+
+func profile_init(u32, f32) -> void {}
+func profile_shutdown() -> void {}
+func profile_thread_start(const char*) -> void {}
+func profile_thread_end() -> void {}
+func profile_next_frame() -> void {}
+
+#endif // JPH_PROFILE_ENABLED && !JPH_EXTERNAL_PROFILE
@@ -0,0 +1,543 @@
+//
+// Physics scenes for the headless benchmarks (game_bench.cpp). Unlike the game these are full 3D and nothing is allowed
+// to sleep, so a scene keeps costing the same after it settled and a step measures the solver instead of the sleep
+// test. Every scene is built from a fixed seed, the same parameters give the same scene.
+//
+
+enum SceneType : u32
+{
+    SCENE_BOX_PYRAMID,      // Square pyramids of boxes, 385 per pyramid
+    SCENE_SPHERE_PILE,      // Spheres dropped into a box
+    SCENE_RAGDOLL_PILE,     // 11 part ragdolls dropped into a box, bodies / 11 of them
+    SCENE_TERRAIN,          // Boxes and spheres on a height field and a mesh, plus SCENE_RAYS_PER_STEP rays every step
+    SCENE_CONSTRAINT_CHAINS,// Chains of SCENE_CHAIN_LENGTH links hanging from the world, hinge, point and distance constraints
+    SCENE_SOFT_BODIES,      // Cloths of SCENE_CLOTH_SIZE^2 vertices falling onto pillars, one body per cloth
+    SCENE_CHARACTERS,       // Virtual characters walking in circles between obstacles and boxes they push around
+    SCENE_NUM,
+};
+
+struct SceneInfo
+{
+    const char* name;
+    u32 default_bodies[2];
+};
+
+static const SceneInfo scene_infos[SCENE_NUM] = {
+    { "box_pyramid", { 1000, 4000 } },
+    { "sphere_pile", { 2000, 8000 } },
+    { "ragdoll_pile", { 440, 1760 } },
+    { "terrain", { 500, 2000 } },
+    { "constraint_chains", { 1000, 4000 } },
+    { "soft_bodies", { 16, 64 } },
+    { "characters", { 64, 256 } },
+};
+
+#define SCENE_RAYS_PER_STEP 4096
+#define SCENE_RAYS_PER_JOB 256
+#define SCENE_CHAIN_LENGTH 20
+#define SCENE_CLOTH_SIZE 16
+#define SCENE_RAGDOLL_PARTS 11
+
+struct Scene
+{
+    SceneType type;
+    JPH::PhysicsSystem* physics_system;
+    u32 num_bodies; // What the scene was asked for: bodies, or cloths / characters for those scenes
+    u32 step;
+
+    std::vector<JPH::Ref<JPH::Ragdoll>> ragdolls;
+    std::vector<JPH::Ref<JPH::CharacterVirtual>> characters;
+    u64 num_ray_hits;
+    JPH::EPhysicsUpdateError update_errors; // Of all steps so far, a full contact buffer drops contacts in an order that depends on the threads
+    bool watch_allocations; // Count the heap allocations of PhysicsSystem::Update, needs alloc_watch_install()
+};
+
+struct SceneStepStats
+{
+    // Time spent in each part of scene_step(), seconds
+    f64 characters;
+    f64 update;
+    f64 queries;
+
+    u32 update_allocations; // With Scene::watch_allocations
+    JPH::PhysicsUpdateStats physics; // Phase timings and counts of the update
+};
+
+func scene_find(const char* name) -> i32
+{
+    for (u32 i = 0; i < SCENE_NUM; ++i) {
+        if (strcmp(scene_infos[i].name, name) == 0) return static_cast<i32>(i);
+    }
+    return -1;
+}
+
+func scene_dynamic_body(const JPH::Shape* shape, JPH::RVec3Arg position, JPH::QuatArg rotation) -> JPH::BodyCreationSettings
+{
+    JPH::BodyCreationSettings settings(shape, position, rotation, JPH::EMotionType::Dynamic, OBJECT_LAYER_MOVING);
+    settings.mAllowSleeping = false;
+    return settings;
+}
+
+func scene_add_static_box(JPH::PhysicsSystem* physics_system, JPH::Vec3Arg half_extent, JPH::RVec3Arg position) -> void
+{
+    JPH::BodyCreationSettings settings(new JPH::BoxShape(half_extent), position, JPH::Quat::sIdentity(), JPH::EMotionType::Static, OBJECT_LAYER_NON_MOVING);
+    physics_system->GetBodyInterfaceNoLock().CreateAndAddBody(settings, JPH::EActivation::DontActivate);
+}
+
+// Floor at y = 0 with walls of `height` around a square of 2 * `half_extent`
+func scene_add_box(JPH::PhysicsSystem* physics_system, f32 half_extent, f32 height) -> void
+{
+    scene_add_static_box(physics_system, JPH::Vec3(half_extent + 1.0f, 1.0f, half_extent + 1.0f), JPH::RVec3(0.0f, -1.0f, 0.0f));
+    if (height <= 0.0f) return;
+
+    const f32 h = 0.5f * height;
+    scene_add_static_box(physics_system, JPH::Vec3(0.5f, h, half_extent), JPH::RVec3(-half_extent - 0.5f, h, 0.0f));
+    scene_add_static_box(physics_system, JPH::Vec3(0.5f, h, half_extent), JPH::RVec3(half_extent + 0.5f, h, 0.0f));
+    scene_add_static_box(physics_system, JPH::Vec3(half_extent + 1.0f, h, 0.5f), JPH::RVec3(0.0f, h, -half_extent - 0.5f));
+    scene_add_static_box(physics_system, JPH::Vec3(half_extent + 1.0f, h, 0.5f), JPH::RVec3(0.0f, h, half_extent + 0.5f));
+}
+
+// Smallest grid side that holds `count` cells
+func scene_grid_side(u32 count) -> u32
+{
+    u32 side = 1;
+    while (side * side < count) side += 1;
+    return side;
+}
+
+func scene_add_box_pyramids(Scene* scene) -> void
+{
+    constexpr u32 base = 10;
+    constexpr u32 boxes_per_pyramid = base * (base + 1) * (2 * base + 1) / 6;
+    constexpr f32 spacing = 14.0f;
+
+    JPH::BodyInterface& bi = scene->physics_system->GetBodyInterfaceNoLock();
+    const u32 side = scene_grid_side((scene->num_bodies + boxes_per_pyramid - 1) / boxes_per_pyramid);
+    const f32 half_extent = 0.5f * spacing * static_cast<f32>(side) + 5.0f;
+    scene_add_box(scene->physics_system, half_extent, 0.0f);
+
+    JPH::RefConst<JPH::Shape> box = new JPH::BoxShape(JPH::Vec3(0.5f, 0.5f, 0.5f));
+    u32 num_boxes = 0;
+    for (u32 p = 0; num_boxes < scene->num_bodies; ++p) {
+        const f32 px = (static_cast<f32>(p % side) - 0.5f * static_cast<f32>(side - 1)) * spacing;
+        const f32 pz = (static_cast<f32>(p / side) - 0.5f * static_cast<f32>(side - 1)) * spacing;
+        for (u32 layer = 0; layer < base && num_boxes < scene->num_bodies; ++layer) {
+            const u32 s = base - layer;
+            for (u32 i = 0; i < s * s && num_boxes < scene->num_bodies; ++i) {
+                const f32 x = px + (static_cast<f32>(i % s) - 0.5f * static_cast<f32>(s - 1)) * 1.01f;
+                const f32 z = pz + (static_cast<f32>(i / s) - 0.5f * static_cast<f32>(s - 1)) * 1.01f;
+                bi.CreateAndAddBody(scene_dynamic_body(box, JPH::RVec3(x, 0.5f + static_cast<f32>(layer), z), JPH::Quat::sIdentity()), JPH::EActivation::Activate);
+                num_boxes += 1;
+            }
+        }
+    }
+}
+
+func scene_add_sphere_pile(Scene* scene) -> void
+{
+    constexpr f32 radius = 0.5f;
+    constexpr f32 spacing = 1.2f;
+
+    JPH::BodyInterface& bi = scene->physics_system->GetBodyInterfaceNoLock();
+    const u32 side = std::max(2u, scene_grid_side((scene->num_bodies + 9) / 10)); // About 10 layers
+    const u32 num_layers = (scene->num_bodies + side * side - 1) / (side * side);
+    const f32 half_extent = 0.5f * spacing * static_cast<f32>(side);
+    scene_add_box(scene->physics_system, half_extent, spacing * static_cast<f32>(num_layers) + 2.0f);
+
+    JPH::RefConst<JPH::Shape> sphere = new JPH::SphereShape(radius);
+    u32 random_state = 0x2545f491;
+    for (u32 i = 0; i < scene->num_bodies; ++i) {
+        const u32 layer = i / (side * side);
+        const u32 cell = i % (side * side);
+        const f32 x = (static_cast<f32>(cell % side) - 0.5f * static_cast<f32>(side - 1)) * spacing + 0.1f * (fracture_random(&random_state) - 0.5f);
+        const f32 z = (static_cast<f32>(cell / side) - 0.5f * static_cast<f32>(side - 1)) * spacing + 0.1f * (fracture_random(&random_state) - 0.5f);
+        bi.CreateAndAddBody(scene_dynamic_body(sphere, JPH::RVec3(x, radius + spacing * static_cast<f32>(layer), z), JPH::Quat::sIdentity()), JPH::EActivation::Activate);
+    }
+}
+
+// A standing humanoid of capsules with swing twist joints, feet at y = 0
+func scene_create_ragdoll_settings() -> JPH::Ref<JPH::RagdollSettings>
+{
+    struct PartDesc
+    {
+        const char* name;
+        i32 parent;
+        JPH::Vec3 position;
+        bool horizontal;
+        f32 half_height;
+        f32 radius;
+        JPH::Vec3 pivot;
+        JPH::Vec3 twist_axis;
+    };
+    const PartDesc parts[SCENE_RAGDOLL_PARTS] = {
+        { "pelvis", -1, JPH::Vec3(0.0f, 1.0f, 0.0f), false, 0.1f, 0.15f, JPH::Vec3::sZero(), JPH::Vec3::sZero() },
+        { "chest", 0, JPH::Vec3(0.0f, 1.35f, 0.0f), false, 0.15f, 0.15f, JPH::Vec3(0.0f, 1.15f, 0.0f), JPH::Vec3::sAxisY() },
+        { "head", 1, JPH::Vec3(0.0f, 1.75f, 0.0f), false, 0.05f, 0.12f, JPH::Vec3(0.0f, 1.6f, 0.0f), JPH::Vec3::sAxisY() },
+        { "upper_arm_l", 1, JPH::Vec3(-0.4f, 1.45f, 0.0f), true, 0.12f, 0.06f, JPH::Vec3(-0.22f, 1.45f, 0.0f), -JPH::Vec3::sAxisX() },
+        { "lower_arm_l", 3, JPH::Vec3(-0.75f, 1.45f, 0.0f), true, 0.12f, 0.05f, JPH::Vec3(-0.58f, 1.45f, 0.0f), -JPH::Vec3::sAxisX() },
+        { "upper_arm_r", 1, JPH::Vec3(0.4f, 1.45f, 0.0f), true, 0.12f, 0.06f, JPH::Vec3(0.22f, 1.45f, 0.0f), JPH::Vec3::sAxisX() },
+        { "lower_arm_r", 5, JPH::Vec3(0.75f, 1.45f, 0.0f), true, 0.12f, 0.05f, JPH::Vec3(0.58f, 1.45f, 0.0f), JPH::Vec3::sAxisX() },
+        { "upper_leg_l", 0, JPH::Vec3(-0.1f, 0.65f, 0.0f), false, 0.15f, 0.08f, JPH::Vec3(-0.1f, 0.9f, 0.0f), -JPH::Vec3::sAxisY() },
+        { "lower_leg_l", 7, JPH::Vec3(-0.1f, 0.22f, 0.0f), false, 0.15f, 0.07f, JPH::Vec3(-0.1f, 0.43f, 0.0f), -JPH::Vec3::sAxisY() },
+        { "upper_leg_r", 0, JPH::Vec3(0.1f, 0.65f, 0.0f), false, 0.15f, 0.08f, JPH::Vec3(0.1f, 0.9f, 0.0f), -JPH::Vec3::sAxisY() },
+        { "lower_leg_r", 9, JPH::Vec3(0.1f, 0.22f, 0.0f), false, 0.15f, 0.07f, JPH::Vec3(0.1f, 0.43f, 0.0f), -JPH::Vec3::sAxisY() },
+    };
+
+    JPH::Ref<JPH::RagdollSettings> settings = new JPH::RagdollSettings();
+    settings->mSkeleton = new JPH::Skeleton();
+    settings->mParts.resize(SCENE_RAGDOLL_PARTS);
+
+    const JPH::Quat horizontal = JPH::Quat::sRotation(JPH::Vec3::sAxisZ(), 0.5f * JPH::JPH_PI);
+    for (u32 i = 0; i < SCENE_RAGDOLL_PARTS; ++i) {
+        const PartDesc& d = parts[i];
+        settings->mSkeleton->AddJoint(d.name, d.parent);
+
+        JPH::RagdollSettings::Part& part = settings->mParts[i];
+        part.SetShape(new JPH::CapsuleShape(d.half_height, d.radius));
+        part.mPosition = JPH::RVec3(d.position);
+        part.mRotation = d.horizontal ? horizontal : JPH::Quat::sIdentity();
+        part.mMotionType = JPH::EMotionType::Dynamic;
+        part.mObjectLayer = OBJECT_LAYER_MOVING;
+        part.mAllowSleeping = false;
+
+        if (d.parent >= 0) {
+            JPH::Ref<JPH::SwingTwistConstraintSettings> constraint = new JPH::SwingTwistConstraintSettings();
+            constraint->mPosition1 = constraint->mPosition2 = JPH::RVec3(d.pivot);
+            constraint->mTwistAxis1 = constraint->mTwistAxis2 = d.twist_axis;
+            constraint->mPlaneAxis1 = constraint->mPlaneAxis2 = JPH::Vec3::sAxisZ();
+            constraint->mNormalHalfConeAngle = 0.5f;
+            constraint->mPlaneHalfConeAngle = 0.5f;
+            constraint->mTwistMinAngle = -0.3f;
+            constraint->mTwistMaxAngle = 0.3f;
+            part.mToParent = constraint;
+        }
+    }
+
+    settings->Stabilize();
+    settings->DisableParentChildCollisions();
+    return settings;
+}
+
+// Ragdolls lying down with a random yaw, layer on layer
+func scene_add_ragdoll_pile(Scene* scene) -> void
+{
+    constexpr f32 spacing = 2.2f;
+
+    const u32 num_ragdolls = std::max(1u, scene->num_bodies / SCENE_RAGDOLL_PARTS);
+    const u32 side = std::max(2u, scene_grid_side((num_ragdolls + 3) / 4)); // About 4 layers
+    const f32 half_extent = 0.5f * spacing * static_cast<f32>(side) + 0.5f;
+    scene_add_box(scene->physics_system, half_extent, 4.0f);
+
+    JPH::Ref<JPH::RagdollSettings> settings = scene_create_ragdoll_settings();
+
+    JPH::Mat44 joints[SCENE_RAGDOLL_PARTS];
+    u32 random_state = 0x6c8e9cf5;
+    for (u32 i = 0; i < num_ragdolls; ++i) {
+        const u32 layer = i / (side * side);
+        const u32 cell = i % (side * side);
+        const f32 x = (static_cast<f32>(cell % side) - 0.5f * static_cast<f32>(side - 1)) * spacing;
+        const f32 z = (static_cast<f32>(cell / side) - 0.5f * static_cast<f32>(side - 1)) * spacing;
+        const JPH::Quat yaw = JPH::Quat::sRotation(JPH::Vec3::sAxisY(), 2.0f * JPH::JPH_PI * fracture_random(&random_state));
+        const JPH::Mat44 root = JPH::Mat44::sRotation(yaw * JPH::Quat::sRotation(JPH::Vec3::sAxisX(), 0.5f * JPH::JPH_PI)) * JPH::Mat44::sTranslation(JPH::Vec3(0.0f, -1.0f, 0.0f));
+        for (u32 j = 0; j < SCENE_RAGDOLL_PARTS; ++j) {
+            const JPH::RagdollSettings::Part& part = settings->mParts[j];
+            joints[j] = root * JPH::Mat44::sRotationTranslation(part.mRotation, JPH::Vec3(part.mPosition));
+        }
+
+        JPH::Ref<JPH::Ragdoll> ragdoll = settings->CreateRagdoll(static_cast<JPH::CollisionGroup::GroupID>(i), 0, scene->physics_system);
+        ragdoll->SetPose(JPH::RVec3(x, 0.5f + 0.8f * static_cast<f32>(layer), z), joints, false);
+        ragdoll->AddToPhysicsSystem(JPH::EActivation::Activate, false);
+        scene->ragdolls.push_back(ragdoll);
+    }
+}
+
+func scene_terrain_height(f32 x, f32 z) -> f32
+{
+    return 2.0f * sinf(0.1f * x) * cosf(0.13f * z) + sinf(0.31f * x + 0.2f * z);
+}
+
+// A 128 x 128 m height field for x < 0 and a mesh of the same surface for x > 0, with a floor far below to catch what rolls off
+func scene_add_terrain(Scene* scene) -> void
+{
+    constexpr u32 num_samples = 128;
+    constexpr u32 num_quads = 64;
+    constexpr f32 quad_size = 2.0f;
+
+    JPH::BodyInterface& bi = scene->physics_system->GetBodyInterfaceNoLock();
+
+    std::vector<f32> samples(num_samples * num_samples);
+    for (u32 z = 0; z < num_samples; ++z) {
+        for (u32 x = 0; x < num_samples; ++x) samples[z * num_samples + x] = scene_terrain_height(static_cast<f32>(x) - 127.0f, static_cast<f32>(z) - 64.0f);
+    }
+    JPH::HeightFieldShapeSettings height_field(samples.data(), JPH::Vec3(-127.0f, 0.0f, -64.0f), JPH::Vec3::sReplicate(1.0f), num_samples);
+    bi.CreateAndAddBody(JPH::BodyCreationSettings(height_field.Create().Get(), JPH::RVec3::sZero(), JPH::Quat::sIdentity(), JPH::EMotionType::Static, OBJECT_LAYER_NON_MOVING), JPH::EActivation::DontActivate);
+
+    JPH::TriangleList triangles;
+    triangles.reserve(2 * num_quads * num_quads);
+    auto vertex = [](u32 x, u32 z) { const f32 fx = quad_size * static_cast<f32>(x), fz = quad_size * static_cast<f32>(z) - 64.0f; return JPH::Float3(fx, scene_terrain_height(fx, fz), fz); };
+    for (u32 z = 0; z < num_quads; ++z) {
+        for (u32 x = 0; x < num_quads; ++x) {
+            triangles.push_back(JPH::Triangle(vertex(x, z), vertex(x, z + 1), vertex(x + 1, z + 1)));
+            triangles.push_back(JPH::Triangle(vertex(x, z), vertex(x + 1, z + 1), vertex(x + 1, z)));
+        }
+    }
+    JPH::MeshShapeSettings mesh(triangles);
+    bi.CreateAndAddBody(JPH::BodyCreationSettings(mesh.Create().Get(), JPH::RVec3::sZero(), JPH::Quat::sIdentity(), JPH::EMotionType::Static, OBJECT_LAYER_NON_MOVING), JPH::EActivation::DontActivate);
+
+    scene_add_static_box(scene->physics_system, JPH::Vec3(200.0f, 1.0f, 200.0f), JPH::RVec3(0.0f, -21.0f, 0.0f));
+
+    JPH::RefConst<JPH::Shape> box = new JPH::BoxShape(JPH::Vec3(0.5f, 0.5f, 0.5f));
+    JPH::RefConst<JPH::Shape> sphere = new JPH::SphereShape(0.5f);
+    constexpr u32 columns = 24, rows = 12;
+    for (u32 i = 0; i < scene->num_bodies; ++i) {
+        const u32 layer = i / (columns * rows);
+        const u32 cell = i % (columns * rows);
+        const f32 x = (static_cast<f32>(cell % columns) - 0.5f * static_cast<f32>(columns - 1)) * 10.0f;
+        const f32 z = (static_cast<f32>(cell / columns) - 0.5f * static_cast<f32>(rows - 1)) * 10.0f;
+        const f32 y = scene_terrain_height(x, z) + 3.0f + 2.0f * static_cast<f32>(layer);
+        bi.CreateAndAddBody(scene_dynamic_body((i & 1) ? sphere : box, JPH::RVec3(x, y, z), JPH::Quat::sIdentity()), JPH::EActivation::Activate);
+    }
+}
+
+// Chains start out horizontal and swing down, every third one uses hinges, point or distance constraints
+func scene_add_constraint_chains(Scene* scene) -> void
+{
+    constexpr f32 link_length = 1.0f;
+    constexpr f32 row_spacing = SCENE_CHAIN_LENGTH * link_length + 2.0f;
+
+    JPH::BodyInterface& bi = scene->physics_system->GetBodyInterfaceNoLock();
+    const u32 num_chains = std::max(1u, scene->num_bodies / SCENE_CHAIN_LENGTH);
+    const u32 side = scene_grid_side(num_chains);
+    scene_add_box(scene->physics_system, 0.5f * row_spacing * static_cast<f32>(side) + 5.0f, 0.0f);
+
+    JPH::RefConst<JPH::Shape> link = new JPH::BoxShape(JPH::Vec3(0.4f, 0.1f, 0.1f));
+    constexpr f32 height = SCENE_CHAIN_LENGTH * link_length + 5.0f;
+    for (u32 c = 0; c < num_chains; ++c) {
+        const f32 x0 = (static_cast<f32>(c / side) - 0.5f * static_cast<f32>(side)) * row_spacing;
+        const f32 z = (static_cast<f32>(c % side) - 0.5f * static_cast<f32>(side - 1)) * 1.0f;
+
+        JPH::Body* prev = &JPH::Body::sFixedToWorld;
+        for (u32 i = 0; i < SCENE_CHAIN_LENGTH; ++i) {
+            const f32 x = x0 + (static_cast<f32>(i) + 0.5f) * link_length;
+            JPH::Body* body = bi.CreateBody(scene_dynamic_body(link, JPH::RVec3(x, height, z), JPH::Quat::sIdentity()));
+            bi.AddBody(body->GetID(), JPH::EActivation::Activate);
+
+            const JPH::RVec3 pivot(x - 0.5f * link_length, height, z);
+            JPH::Ref<JPH::TwoBodyConstraintSettings> settings;
+            switch (c % 3) {
+                case 0: {
+                    auto hinge = new JPH::HingeConstraintSettings();
+                    hinge->mPoint1 = hinge->mPoint2 = pivot;
+                    hinge->mHingeAxis1 = hinge->mHingeAxis2 = JPH::Vec3::sAxisZ();
+                    hinge->mNormalAxis1 = hinge->mNormalAxis2 = JPH::Vec3::sAxisX();
+                    settings = hinge;
+                } break;
+                case 1: {
+                    auto point = new JPH::PointConstraintSettings();
+                    point->mPoint1 = point->mPoint2 = pivot;
+                    settings = point;
+                } break;
+                default: {
+                    auto distance = new JPH::DistanceConstraintSettings();
+                    distance->mPoint1 = pivot - JPH::Vec3(0.1f, 0.0f, 0.0f);
+                    distance->mPoint2 = pivot + JPH::Vec3(0.1f, 0.0f, 0.0f);
+                    settings = distance;
+                } break;
+            }
+            scene->physics_system->AddConstraint(settings->Create(*prev, *body));
+            prev = body;
+        }
+    }
+}
+
+func scene_create_cloth_settings() -> JPH::Ref<JPH::SoftBodySharedSettings>
+{
+    constexpr f32 spacing = 0.25f;
+    constexpr f32 compliance = 1.0e-4f;
+    constexpr u32 n = SCENE_CLOTH_SIZE;
+
+    JPH::Ref<JPH::SoftBodySharedSettings> settings = new JPH::SoftBodySharedSettings();
+    const f32 offset = 0.5f * spacing * static_cast<f32>(n - 1);
+    for (u32 z = 0; z < n; ++z) {
+        for (u32 x = 0; x < n; ++x) settings->mVertices.push_back(JPH::SoftBodySharedSettings::Vertex(JPH::Float3(spacing * static_cast<f32>(x) - offset, 0.0f, spacing * static_cast<f32>(z) - offset)));
+    }
+
+    auto index = [](u32 x, u32 z) { return z * n + x; };
+    for (u32 z = 0; z < n; ++z) {
+        for (u32 x = 0; x < n; ++x) {
+            if (x + 1 < n) settings->mEdgeConstraints.push_back(JPH::SoftBodySharedSettings::Edge(index(x, z), index(x + 1, z), compliance));
+            if (z + 1 < n) settings->mEdgeConstraints.push_back(JPH::SoftBodySharedSettings::Edge(index(x, z), index(x, z + 1), compliance));
+            if (x + 1 < n && z + 1 < n) {
+                settings->mEdgeConstraints.push_back(JPH::SoftBodySharedSettings::Edge(index(x, z), index(x + 1, z + 1), compliance));
+                settings->mEdgeConstraints.push_back(JPH::SoftBodySharedSettings::Edge(index(x + 1, z), index(x, z + 1), compliance));
+                settings->AddFace(JPH::SoftBodySharedSettings::Face(index(x, z), index(x, z + 1), index(x + 1, z + 1)));
+                settings->AddFace(JPH::SoftBodySharedSettings::Face(index(x, z), index(x + 1, z + 1), index(x + 1, z)));
+            }
+        }
+    }
+    settings->CalculateEdgeLengths();
+    settings->Optimize();
+    return settings;
+}
+
+func scene_add_soft_bodies(Scene* scene) -> void
+{
+    constexpr f32 spacing = 6.0f;
+
+    JPH::BodyInterface& bi = scene->physics_system->GetBodyInterfaceNoLock();
+    const u32 side = scene_grid_side(scene->num_bodies);
+    scene_add_box(scene->physics_system, 0.5f * spacing * static_cast<f32>(side) + 2.0f, 0.0f);
+
+    JPH::Ref<JPH::SoftBodySharedSettings> cloth = scene_create_cloth_settings();
+    u32 random_state = 0x1b873593;
+    for (u32 i = 0; i < scene->num_bodies; ++i) {
+        const f32 x = (static_cast<f32>(i % side) - 0.5f * static_cast<f32>(side - 1)) * spacing;
+        const f32 z = (static_cast<f32>(i / side) - 0.5f * static_cast<f32>(side - 1)) * spacing;
+        scene_add_static_box(scene->physics_system, JPH::Vec3(0.5f, 1.5f, 0.5f), JPH::RVec3(x, 1.5f, z));
+
+        JPH::SoftBodyCreationSettings settings(cloth, JPH::RVec3(x, 4.0f, z), JPH::Quat::sRotation(JPH::Vec3::sAxisY(), fracture_random(&random_state)), OBJECT_LAYER_MOVING);
+        settings.mAllowSleeping = false;
+        bi.CreateAndAddSoftBody(settings, JPH::EActivation::Activate);
+    }
+}
+
+// Characters walk between static pillars and push dynamic boxes, one box and one pillar per four characters
+func scene_add_characters(Scene* scene) -> void
+{
+    constexpr f32 spacing = 3.0f;
+
+    JPH::BodyInterface& bi = scene->physics_system->GetBodyInterfaceNoLock();
+    const u32 side = scene_grid_side(scene->num_bodies);
+    const f32 half_extent = 0.5f * spacing * static_cast<f32>(side) + 4.0f;
+    scene_add_box(scene->physics_system, half_extent, 2.0f);
+
+    JPH::RefConst<JPH::Shape> box = new JPH::BoxShape(JPH::Vec3(0.4f, 0.4f, 0.4f));
+    u32 random_state = 0x68e31da4;
+    for (u32 i = 0; i < scene->num_bodies / 4; ++i) {
+        const f32 x = (2.0f * fracture_random(&random_state) - 1.0f) * (half_extent - 1.0f);
+        const f32 z = (2.0f * fracture_random(&random_state) - 1.0f) * (half_extent - 1.0f);
+        scene_add_static_box(scene->physics_system, JPH::Vec3(0.3f, 1.0f, 0.3f), JPH::RVec3(x, 1.0f, z));
+
+        const f32 bx = (2.0f * fracture_random(&random_state) - 1.0f) * (half_extent - 1.0f);
+        const f32 bz = (2.0f * fracture_random(&random_state) - 1.0f) * (half_extent - 1.0f);
+        bi.CreateAndAddBody(scene_dynamic_body(box, JPH::RVec3(bx, 0.4f, bz), JPH::Quat::sIdentity()), JPH::EActivation::Activate);
+    }
+
+    JPH::CharacterVirtualSettings settings;
+    settings.mShape = new JPH::CapsuleShape(0.6f, 0.3f);
+    for (u32 i = 0; i < scene->num_bodies; ++i) {
+        const f32 x = (static_cast<f32>(i % side) - 0.5f * static_cast<f32>(side - 1)) * spacing;
+        const f32 z = (static_cast<f32>(i / side) - 0.5f * static_cast<f32>(side - 1)) * spacing;
+        scene->characters.push_back(new JPH::CharacterVirtual(&settings, JPH::RVec3(x, 0.95f, z), JPH::Quat::sIdentity(), scene->physics_system));
+    }
+}
+
+func scene_create(Scene* scene, SceneType type, u32 num_bodies, const BroadPhaseLayerInterface* broad_phase_layer_interface, const ObjectVsBroadPhaseLayerFilter* object_vs_broad_phase_layer_filter, const ObjectLayerPairFilter* object_layer_pair_filter, JPH::EBroadPhaseType broad_phase_type) -> void
+{
+    ZoneScoped;
+
+    scene->type = type;
+    scene->num_bodies = num_bodies;
+    scene->step = 0;
+    scene->num_ray_hits = 0;
+    scene->update_errors = JPH::EPhysicsUpdateError::None;
+    scene->watch_allocations = false;
+
+    // Room for the static bodies (a pillar per cloth, obstacles and boxes next to the characters). Piles need a lot more pairs
+    // and contacts than bodies, a box in a pyramid touches up to 9 others.
+    const u32 max_bodies = num_bodies * (type == SCENE_SOFT_BODIES || type == SCENE_CHARACTERS ? 2 : 1) + 64;
+    scene->physics_system = new JPH::PhysicsSystem();
+    scene->physics_system->Init(max_bodies, PHY_NUM_BODY_MUTEXES, 16 * max_bodies, 8 * max_bodies, *broad_phase_layer_interface, *object_vs_broad_phase_layer_filter, *object_layer_pair_filter, broad_phase_type);
+
+    switch (type) {
+        case SCENE_BOX_PYRAMID: scene_add_box_pyramids(scene); break;
+        case SCENE_SPHERE_PILE: scene_add_sphere_pile(scene); break;
+        case SCENE_RAGDOLL_PILE: scene_add_ragdoll_pile(scene); break;
+        case SCENE_TERRAIN: scene_add_terrain(scene); break;
+        case SCENE_CONSTRAINT_CHAINS: scene_add_constraint_chains(scene); break;
+        case SCENE_SOFT_BODIES: scene_add_soft_bodies(scene); break;
+        case SCENE_CHARACTERS: scene_add_characters(scene); break;
+        default: JPH_ASSERT(false); break;
+    }
+
+    scene->physics_system->OptimizeBroadPhase();
+}
+
+func scene_destroy(Scene* scene) -> void
+{
+    for (JPH::Ragdoll* ragdoll : scene->ragdolls) ragdoll->RemoveFromPhysicsSystem(false);
+    scene->ragdolls.clear();
+    scene->characters.clear();
+
+    delete scene->physics_system;
+    scene->physics_system = nullptr;
+}
+
+// Rays straight down onto the terrain from random points, spread over jobs
+func scene_cast_rays(Scene* scene, JPH::JobSystem* job_system) -> void
+{
+    const JPH::NarrowPhaseQuery& query = scene->physics_system->GetNarrowPhaseQuery();
+    std::atomic<u64> num_hits = 0;
+
+    auto cast = [scene, &query, &num_hits](u32 job) {
+        u32 random_state = (0x9e3779b9u ^ (scene->step * 0x85ebca6bu) ^ (job * 0xc2b2ae35u)) | 1u;
+        u64 hits = 0;
+        for (u32 i = 0; i < SCENE_RAYS_PER_JOB; ++i) {
+            const f32 x = (2.0f * fracture_random(&random_state) - 1.0f) * 126.0f;
+            const f32 z = (2.0f * fracture_random(&random_state) - 1.0f) * 63.0f;
+            const JPH::RRayCast ray(JPH::RVec3(x, 50.0f, z), JPH::Vec3(fracture_random(&random_state) - 0.5f, -100.0f, fracture_random(&random_state) - 0.5f));
+            JPH::RayCastResult result;
+            if (query.CastRay(ray, result)) hits += 1;
+        }
+        num_hits.fetch_add(hits, std::memory_order_relaxed);
+    };
+
+    JPH::JobSystem::Barrier* barrier = job_system->CreateBarrier();
+    for (u32 job = 0; job < SCENE_RAYS_PER_STEP / SCENE_RAYS_PER_JOB; ++job) {
+        barrier->AddJob(job_system->CreateJob("SceneRays", JPH::Color::sOrange, [&cast, job]() { cast(job); }));
+    }
+    job_system->WaitForJobs(barrier);
+    job_system->DestroyBarrier(barrier);
+
+    scene->num_ray_hits += num_hits.load(std::memory_order_relaxed);
+}
+
+// Characters walk in circles of 5 m at 3 m/s, each starting at another point of its circle
+func scene_update_characters(Scene* scene, JPH::TempAllocator* temp_allocator) -> void
+{
+    const JPH::Vec3 gravity = scene->physics_system->GetGravity();
+    const JPH::DefaultBroadPhaseLayerFilter broad_phase_filter = scene->physics_system->GetDefaultBroadPhaseLayerFilter(OBJECT_LAYER_MOVING);
+    const JPH::DefaultObjectLayerFilter object_filter = scene->physics_system->GetDefaultLayerFilter(OBJECT_LAYER_MOVING);
+
+    for (u32 i = 0; i < static_cast<u32>(scene->characters.size()); ++i) {
+        JPH::CharacterVirtual* character = scene->characters[i];
+
+        const f32 angle = 0.6f * static_cast<f32>(scene->step) * PHY_FIXED_TIME_STEP + 2.399963f * static_cast<f32>(i);
+        const JPH::Vec3 walk = 3.0f * JPH::Vec3(cosf(angle), 0.0f, sinf(angle));
+        const JPH::Vec3 fall = character->IsSupported() ? JPH::Vec3::sZero() : JPH::Vec3(0.0f, character->GetLinearVelocity().GetY(), 0.0f) + gravity * PHY_FIXED_TIME_STEP;
+        character->SetLinearVelocity(walk + fall);
+        character->Update(PHY_FIXED_TIME_STEP, gravity, broad_phase_filter, object_filter, JPH::BodyFilter(), JPH::ShapeFilter(), *temp_allocator);
+    }
+}
+
+// One fixed step: characters move, the physics system updates, then the queries of the step run
+func scene_step(Scene* scene, JPH::TempAllocator* temp_allocator, JPH::JobSystem* job_system, SceneStepStats* stats) -> void
+{
+    const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    if (!scene->characters.empty()) scene_update_characters(scene, temp_allocator);
+
+    const std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    if (scene->watch_allocations) alloc_watch_begin();
+    scene->update_errors |= scene->physics_system->Update(PHY_FIXED_TIME_STEP, 1, temp_allocator, job_system, &stats->physics);
+    stats->update_allocations = scene->watch_allocations ? alloc_watch_end() : 0;
+
+    const std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+    if (scene->type == SCENE_TERRAIN) scene_cast_rays(scene, job_system);
+
+    const std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+    stats->characters = std::chrono::duration<f64>(t1 - t0).count();
+    stats->update = std::chrono::duration<f64>(t2 - t1).count();
+    stats->queries = std::chrono::duration<f64>(t3 - t2).count();
+
+    scene->step += 1;
+}
@@ -3,11 +3,12 @@
 #if defined(_S00)
 
 #define ROOT_SIGNATURE "RootFlags(CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED), " \
-    "RootConstants(b0, num32BitConstants = 2)"
+    "RootConstants(b0, num32BitConstants = 3)"
 
 struct RootConst {
     uint first_vertex;
     uint object_index;
+    uint vertex_buffer_index; // RDH_VERTEX_BUFFER_STATIC or RDH_VERTEX_BUFFER_DYNAMIC
 };
 ConstantBuffer<RootConst> root_const : register(b0);
 
@@ -17,7 +18,7 @@ void s00_vs(
     out float4 out_position : SV_Position)
 {
     StructuredBuffer<CppHlsl_FrameState> frame_state_buffer = ResourceDescriptorHeap[RDH_FRAME_STATE];
-    StructuredBuffer<CppHlsl_Vertex> vertex_buffer = ResourceDescriptorHeap[RDH_VERTEX_BUFFER_STATIC];
+    StructuredBuffer<CppHlsl_Vertex> vertex_buffer = ResourceDescriptorHeap[root_const.vertex_buffer_index];
     StructuredBuffer<CppHlsl_Object> object_buffer = ResourceDescriptorHeap[RDH_OBJECTS_DYNAMIC];
 
     const uint first_vertex = root_const.first_vertex;
@@ -48,3 +49,58 @@ void s00_ps(
 }
 
 #endif
+
+#if defined(_S01)
+
+#define ROOT_SIGNATURE "RootFlags(CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED), " \
+    "StaticSampler(s0, filter = FILTER_MIN_MAG_MIP_LINEAR, addressU = TEXTURE_ADDRESS_CLAMP, addressV = TEXTURE_ADDRESS_CLAMP)"
+
+SamplerState sam_linear : register(s0);
+
+// One instance per glyph, 6 vertices per instance.
+[RootSignature(ROOT_SIGNATURE)]
+void s01_vs(
+    uint vertex_index : SV_VertexID,
+    uint instance_index : SV_InstanceID,
+    out float4 out_position : SV_Position,
+    out float2 out_uv : _Uv,
+    out float4 out_color : _Color)
+{
+    StructuredBuffer<CppHlsl_FrameState> frame_state_buffer = ResourceDescriptorHeap[RDH_FRAME_STATE];
+    StructuredBuffer<CppHlsl_Glyph> glyph_buffer = ResourceDescriptorHeap[RDH_GLYPHS_DYNAMIC];
+
+    const CppHlsl_FrameState frame_state = frame_state_buffer[0];
+    const CppHlsl_Glyph glyph = glyph_buffer[instance_index];
+
+    const uint corners[6] = { 0, 1, 2, 2, 1, 3 };
+    const uint corner = corners[vertex_index];
+    const float cx = (float)(corner & 1);
+    const float cy = (float)(corner >> 1);
+
+    const float2 uv0 = float2(glyph.uv0 & 0xffff, glyph.uv0 >> 16) / 65535.0;
+    const float2 uv1 = float2(glyph.uv1 & 0xffff, glyph.uv1 >> 16) / 65535.0;
+
+    const float2 p = float2(glyph.x + cx * glyph.width, glyph.y - cy * glyph.height);
+    out_position = mul(float4(p, 0.0, 1.0), frame_state.proj);
+    out_uv = lerp(uv0, uv1, float2(cx, cy));
+    out_color = float4(glyph.color & 0xff, (glyph.color >> 8) & 0xff, (glyph.color >> 16) & 0xff, glyph.color >> 24) / 255.0;
+}
+
+[RootSignature(ROOT_SIGNATURE)]
+void s01_ps(
+    float4 position : SV_Position,
+    float2 uv : _Uv,
+    float4 color : _Color,
+    out float4 out_color : SV_Target0)
+{
+    Texture2D<float> atlas = ResourceDescriptorHeap[RDH_GLYPH_ATLAS];
+
+    // Distance is 0.5 on the outline; fwidth keeps the edge about one pixel wide at any scale.
+    const float d = atlas.Sample(sam_linear, uv);
+    const float w = max(fwidth(d), 1.0 / 255.0);
+    const float alpha = smoothstep(0.5 - w, 0.5 + w, d);
+
+    out_color = float4(color.rgb, color.a * alpha);
+}
+
+#endif
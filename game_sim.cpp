@@ -0,0 +1,470 @@
+#define SIM_COMMAND_QUEUE_SIZE 256
+#define SIM_MAX_STEPS_BEHIND 4 // The step clock is reset when the simulation falls further behind than this
+#define SIM_CACHE_LINE_SIZE 64
+#define SIM_MAX_OBJECTS (MAX_OBJECTS - 16) // Leaves room for render-only objects
+#define SIM_MAX_JOB_WORKERS 64 // Workers beyond this are left out of SimJobStats
+
+//
+// Lock-free single producer / single consumer ring buffer
+//
+
+template<typename T, u32 N> struct SpscQueue
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0);
+
+    alignas(SIM_CACHE_LINE_SIZE) std::atomic<u32> head; // Next item to pop, written by the consumer
+    alignas(SIM_CACHE_LINE_SIZE) std::atomic<u32> tail; // Next free slot, written by the producer
+    alignas(SIM_CACHE_LINE_SIZE) u32 producer_head; // Producer's cached copy of `head`
+    alignas(SIM_CACHE_LINE_SIZE) u32 consumer_tail; // Consumer's cached copy of `tail`
+    alignas(SIM_CACHE_LINE_SIZE) T items[N];
+};
+
+template<typename T, u32 N> func spsc_push(SpscQueue<T, N>* q, const T& item) -> bool
+{
+    const u32 tail = q->tail.load(std::memory_order_relaxed);
+    if (tail - q->producer_head == N) {
+        q->producer_head = q->head.load(std::memory_order_acquire);
+        if (tail - q->producer_head == N) return false; // Full
+    }
+    q->items[tail & (N - 1)] = item;
+    q->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template<typename T, u32 N> func spsc_pop(SpscQueue<T, N>* q, T* item) -> bool
+{
+    const u32 head = q->head.load(std::memory_order_relaxed);
+    if (head == q->consumer_tail) {
+        q->consumer_tail = q->tail.load(std::memory_order_acquire);
+        if (head == q->consumer_tail) return false; // Empty
+    }
+    *item = q->items[head & (N - 1)];
+    q->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+//
+// Triple buffer: the producer always has a slot to write, the consumer always reads the latest complete slot and
+// neither ever waits for the other.
+//
+
+#define TRIPLE_BUFFER_DIRTY_BIT 0x4u
+
+template<typename T> struct TripleBuffer
+{
+    T slots[3];
+    alignas(SIM_CACHE_LINE_SIZE) std::atomic<u32> middle; // Slot index | TRIPLE_BUFFER_DIRTY_BIT when not yet consumed
+    alignas(SIM_CACHE_LINE_SIZE) u32 back; // Producer only
+    alignas(SIM_CACHE_LINE_SIZE) u32 front; // Consumer only
+};
+
+template<typename T> func init_triple_buffer(TripleBuffer<T>* tb) -> void
+{
+    tb->front = 0;
+    tb->middle.store(1, std::memory_order_relaxed);
+    tb->back = 2;
+}
+
+template<typename T> func triple_buffer_back(TripleBuffer<T>* tb) -> T*
+{
+    return &tb->slots[tb->back];
+}
+
+// Makes the back slot visible to the consumer. The slot must not be touched by the producer afterwards.
+template<typename T> func triple_buffer_publish(TripleBuffer<T>* tb) -> void
+{
+    const u32 old = tb->middle.exchange(tb->back | TRIPLE_BUFFER_DIRTY_BIT, std::memory_order_acq_rel);
+    tb->back = old & ~TRIPLE_BUFFER_DIRTY_BIT;
+}
+
+// Returns the most recently published slot. `is_new` tells whether it changed since the previous call.
+template<typename T> func triple_buffer_acquire(TripleBuffer<T>* tb, bool* is_new = nullptr) -> const T*
+{
+    const bool has_new = (tb->middle.load(std::memory_order_relaxed) & TRIPLE_BUFFER_DIRTY_BIT) != 0;
+    if (has_new) {
+        const u32 old = tb->middle.exchange(tb->front, std::memory_order_acq_rel);
+        tb->front = old & ~TRIPLE_BUFFER_DIRTY_BIT;
+    }
+    if (is_new) *is_new = has_new;
+    return &tb->slots[tb->front];
+}
+
+//
+// Simulation thread
+//
+
+enum SimCommandType
+{
+    SIM_COMMAND_SPAWN_OBJECT, // Adds a static object with `mesh_index` at (x, y)
+    SIM_COMMAND_SHATTER, // Replaces the first object with `mesh_index` by the pieces of `fracture_shape`
+};
+
+struct SimCommand
+{
+    u64 id; // Echoed back in SimSnapshot::last_command_id once processed
+    u32 type;
+    u32 mesh_index;
+    u32 fracture_shape;
+    f32 x, y;
+};
+
+struct SimWorkerStats
+{
+    u32 jobs_queued;
+    u32 jobs_executed;
+    u32 wakeups;
+    u32 empty_wakeups; // Woke up but another thread took the job first
+    f32 busy_us;
+    f32 idle_us; // Parked on the semaphore
+    f32 avg_latency_us; // Queued to started
+    f32 max_latency_us;
+};
+
+// What the job system did during one step, from two JPH::JobSystemThreadPool::GetStats() snapshots
+struct SimJobStats
+{
+    u32 num_workers; // 0 when the job system doesn't keep stats
+    u32 jobs_queued_externally; // By the simulation thread
+    u32 queue_full_stalls;
+    u32 queue_depth[JPH::cNumJobPriorities]; // At the end of the step
+    u32 max_queue_depth[JPH::cNumJobPriorities];
+    u32 barrier_waits;
+    u32 barrier_jobs_executed; // By the simulation thread while it waited
+    f32 barrier_wait_us;
+    f32 barrier_sleep_us;
+    SimWorkerStats workers[SIM_MAX_JOB_WORKERS];
+};
+
+// Everything the render thread needs from one simulation step. Never modified once published.
+struct SimSnapshot
+{
+    u64 step_index;
+    u64 last_command_id;
+    f64 publish_time;
+    FractureStats fracture_stats;
+    JPH::TempAllocatorGrowing::Stats temp_allocator_stats; // Peak and overflows of the last step
+    SimJobStats job_stats;
+    JPH::PhysicsUpdateStats physics_stats; // Phase timings and counts of the last step
+    char thread_tuner_decision[160]; // Empty without a thread tuner
+    u32 num_free_pool_bodies;
+    u32 num_pool_bodies;
+    u32 num_objects;
+    Object objects[SIM_MAX_OBJECTS];
+    CppHlsl_Object cpp_hlsl_objects[SIM_MAX_OBJECTS];
+};
+
+struct SimState
+{
+    // Owned by the simulation thread while it runs
+    JPH::PhysicsSystem* physics_system;
+    JPH::TempAllocatorGrowing* temp_allocator;
+    JPH::JobSystem* job_system;
+    JPH::JobSystemThreadPool* job_pool; // Same as job_system when that's a thread pool, for its stats. Set between init_sim() and sim_start(). Only the simulation thread may queue jobs on it once it started.
+    JPH::JobSystemThreadPool::Stats job_pool_stats[2]; // Before and after the last step
+    JPH::PhysicsUpdateStats physics_stats; // Of the last step
+    PhysicsThreadTuner* thread_tuner; // Picks the number of threads of job_pool, null keeps it. Set between init_sim() and sim_start().
+    FractureSystem* fracture;
+    f32 step_interval; // Seconds of wall time per step, 0 steps as fast as possible
+    f32 kill_y; // Fracture pieces below this height go back to the pool
+
+    std::vector<Object> objects;
+    std::vector<CppHlsl_Object> cpp_hlsl_objects;
+    std::vector<FracturePiece> fracture_pieces;
+    std::vector<JPH::BodyID> release_batch;
+    u64 step_index;
+    u64 last_command_id;
+
+    // Shared
+    SpscQueue<SimCommand, SIM_COMMAND_QUEUE_SIZE> commands;
+    TripleBuffer<SimSnapshot> snapshots;
+    std::atomic<bool> quit;
+    std::thread thread;
+};
+
+func sim_time() -> f64
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+}
+
+// `objects` may be filled by the caller between init_sim() and sim_start().
+func init_sim(SimState* sim, JPH::PhysicsSystem* physics_system, JPH::TempAllocatorGrowing* temp_allocator, JPH::JobSystem* job_system, FractureSystem* fracture, f32 step_interval, f32 kill_y) -> void
+{
+    assert(sim && physics_system && temp_allocator && fracture);
+
+    sim->physics_system = physics_system;
+    sim->temp_allocator = temp_allocator;
+    sim->job_system = job_system;
+    sim->fracture = fracture;
+    sim->step_interval = step_interval;
+    sim->kill_y = kill_y;
+
+    sim->objects.reserve(SIM_MAX_OBJECTS);
+    sim->cpp_hlsl_objects.reserve(SIM_MAX_OBJECTS);
+    sim->fracture_pieces.reserve(FRACTURE_MAX_CELLS);
+    sim->release_batch.reserve(SIM_MAX_OBJECTS);
+
+    sim->commands.head.store(0, std::memory_order_relaxed);
+    sim->commands.tail.store(0, std::memory_order_relaxed);
+    sim->commands.producer_head = 0;
+    sim->commands.consumer_tail = 0;
+    init_triple_buffer(&sim->snapshots);
+    sim->quit.store(false, std::memory_order_relaxed);
+    sim->step_index = 0;
+    sim->last_command_id = 0;
+}
+
+func sim_execute_command(SimState* sim, const SimCommand* cmd) -> void
+{
+    switch (cmd->type) {
+        case SIM_COMMAND_SPAWN_OBJECT: {
+            if (sim->objects.size() >= SIM_MAX_OBJECTS) break;
+            sim->objects.push_back({ .mesh_index = cmd->mesh_index });
+            sim->cpp_hlsl_objects.push_back({ .x = cmd->x, .y = cmd->y });
+        } break;
+        case SIM_COMMAND_SHATTER: {
+            for (usize i = 0; i < sim->objects.size(); ++i) {
+                if (sim->objects[i].mesh_index != cmd->mesh_index || !sim->objects[i].body_id.IsInvalid()) continue;
+
+                const CppHlsl_Object src = sim->cpp_hlsl_objects[i];
+                sim->objects.erase(sim->objects.begin() + static_cast<isize>(i));
+                sim->cpp_hlsl_objects.erase(sim->cpp_hlsl_objects.begin() + static_cast<isize>(i));
+
+                sim->fracture_pieces.clear();
+                fracture_spawn(sim->fracture, cmd->fracture_shape, src.x, src.y, src.rotation_in_radians, src.x + 0.25f, src.y + 0.25f, JPH::Vec3::sZero(), 2.0f, &sim->fracture_pieces);
+
+                sim->release_batch.clear();
+                for (const FracturePiece& piece : sim->fracture_pieces) {
+                    if (sim->objects.size() >= SIM_MAX_OBJECTS) {
+                        sim->release_batch.push_back(piece.body_id); // No room to track it, back to the pool
+                        continue;
+                    }
+                    sim->objects.push_back({ .mesh_index = piece.mesh_index, .body_id = piece.body_id });
+                    sim->cpp_hlsl_objects.push_back({ .x = src.x, .y = src.y, .scalex = 1.0f, .scaley = 1.0f });
+                }
+                fracture_release(sim->fracture, sim->release_batch.data(), static_cast<u32>(sim->release_batch.size()));
+                break;
+            }
+        } break;
+        default:
+            assert(false);
+            break;
+    }
+    sim->last_command_id = cmd->id;
+}
+
+// Turns the counters of the last step into `out` and plots them
+func sim_collect_job_stats(SimState* sim, SimJobStats* out) -> void
+{
+    out->num_workers = 0;
+    if (!sim->job_pool) return;
+
+    const JPH::JobSystemThreadPool::Stats& prev = sim->job_pool_stats[0];
+    const JPH::JobSystemThreadPool::Stats& cur = sim->job_pool_stats[1];
+    constexpr f32 ns_to_us = 1.0f / 1000.0f;
+
+    out->num_workers = static_cast<u32>(std::min<usize>(cur.mWorkers.size(), SIM_MAX_JOB_WORKERS));
+    out->jobs_queued_externally = static_cast<u32>(cur.mNumJobsQueuedExternally - prev.mNumJobsQueuedExternally);
+    out->queue_full_stalls = static_cast<u32>(cur.mNumQueueFullStalls - prev.mNumQueueFullStalls);
+    for (u32 p = 0; p < JPH::cNumJobPriorities; ++p) {
+        out->queue_depth[p] = cur.mQueueDepth[p];
+        out->max_queue_depth[p] = cur.mMaxQueueDepth[p];
+    }
+    out->barrier_waits = static_cast<u32>(cur.mBarriers.mNumWaits - prev.mBarriers.mNumWaits);
+    out->barrier_jobs_executed = static_cast<u32>(cur.mBarriers.mNumJobsExecuted - prev.mBarriers.mNumJobsExecuted);
+    out->barrier_wait_us = static_cast<f32>(cur.mBarriers.mWaitTime - prev.mBarriers.mWaitTime) * ns_to_us;
+    out->barrier_sleep_us = static_cast<f32>(cur.mBarriers.mSleepTime - prev.mBarriers.mSleepTime) * ns_to_us;
+
+    u32 jobs_executed = 0;
+    f32 busy_us = 0.0f;
+    f32 idle_us = 0.0f;
+    f32 latency_us = 0.0f;
+    f32 max_latency_us = 0.0f;
+    for (u32 i = 0; i < out->num_workers; ++i) {
+        // A pool that changed its number of threads starts over
+        const JPH::JobSystemThreadPool::WorkerStats empty = {};
+        const JPH::JobSystemThreadPool::WorkerStats& a = i < prev.mWorkers.size() ? prev.mWorkers[i] : empty;
+        const JPH::JobSystemThreadPool::WorkerStats& b = cur.mWorkers[i];
+
+        SimWorkerStats* w = &out->workers[i];
+        w->jobs_queued = static_cast<u32>(b.mNumJobsQueued - a.mNumJobsQueued);
+        w->jobs_executed = static_cast<u32>(b.mNumJobsExecuted - a.mNumJobsExecuted);
+        w->wakeups = static_cast<u32>(b.mNumWakeups - a.mNumWakeups);
+        w->empty_wakeups = static_cast<u32>(b.mNumEmptyWakeups - a.mNumEmptyWakeups);
+        w->busy_us = static_cast<f32>(b.mBusyTime - a.mBusyTime) * ns_to_us;
+        w->idle_us = static_cast<f32>(b.mIdleTime - a.mIdleTime) * ns_to_us;
+        w->avg_latency_us = w->jobs_executed > 0 ? static_cast<f32>(b.mQueueLatency - a.mQueueLatency) * ns_to_us / static_cast<f32>(w->jobs_executed) : 0.0f;
+        w->max_latency_us = static_cast<f32>(b.mMaxQueueLatency) * ns_to_us;
+
+        jobs_executed += w->jobs_executed;
+        busy_us += w->busy_us;
+        idle_us += w->idle_us;
+        latency_us += w->avg_latency_us * static_cast<f32>(w->jobs_executed);
+        max_latency_us = std::max(max_latency_us, w->max_latency_us);
+    }
+
+    TracyPlot("Jobs executed by workers", static_cast<i64>(jobs_executed));
+    TracyPlot("Jobs executed by barrier", static_cast<i64>(out->barrier_jobs_executed));
+    TracyPlot("Job queue depth max", static_cast<i64>(out->max_queue_depth[0] + out->max_queue_depth[1] + out->max_queue_depth[2]));
+    TracyPlot("Job latency avg (us)", jobs_executed > 0 ? static_cast<f64>(latency_us / static_cast<f32>(jobs_executed)) : 0.0);
+    TracyPlot("Job latency max (us)", static_cast<f64>(max_latency_us));
+    TracyPlot("Worker busy (%)", busy_us + idle_us > 0.0f ? static_cast<f64>(100.0f * busy_us / (busy_us + idle_us)) : 0.0);
+    TracyPlot("Barrier wait (us)", static_cast<f64>(out->barrier_wait_us));
+    TracyPlot("Barrier sleep (us)", static_cast<f64>(out->barrier_sleep_us));
+}
+
+#if defined(TRACY_ENABLE)
+func sim_plot_physics_stats(const JPH::PhysicsUpdateStats& stats) -> void
+{
+    constexpr f64 ns_to_ms = 1.0e-6;
+    TracyPlot("Physics update (ms)", static_cast<f64>(stats.mTotalTime) * ns_to_ms);
+    TracyPlot("Physics find collisions (ms)", static_cast<f64>(stats.GetPhase(JPH::EPhysicsUpdatePhase::FindCollisions).mWallTime) * ns_to_ms);
+    TracyPlot("Physics velocity solver (ms)", static_cast<f64>(stats.GetPhase(JPH::EPhysicsUpdatePhase::SolveVelocityConstraints).mWallTime) * ns_to_ms);
+    TracyPlot("Physics position solver (ms)", static_cast<f64>(stats.GetPhase(JPH::EPhysicsUpdatePhase::SolvePositionConstraints).mWallTime) * ns_to_ms);
+    TracyPlot("Physics active bodies", static_cast<i64>(stats.mNumActiveBodies));
+    TracyPlot("Physics body pairs", static_cast<i64>(stats.mNumBodyPairs));
+    TracyPlot("Physics contact constraints", static_cast<i64>(stats.mNumContactConstraints));
+    TracyPlot("Physics islands", static_cast<i64>(stats.mNumIslands));
+    TracyPlot("Physics bodies woke up", static_cast<i64>(stats.mNumBodiesWokeUp));
+    TracyPlot("Physics bodies went to sleep", static_cast<i64>(stats.mNumBodiesWentToSleep));
+}
+#else
+func sim_plot_physics_stats(const JPH::PhysicsUpdateStats&) -> void {}
+#endif
+
+func sim_step(SimState* sim) -> void
+{
+    ZoneScoped;
+
+    SimCommand cmd;
+    while (spsc_pop(&sim->commands, &cmd)) {
+        sim_execute_command(sim, &cmd);
+    }
+
+    sim->temp_allocator->ResetPeakUsage();
+    if (sim->job_pool) {
+        sim->job_pool->ResetPeakStats();
+        sim->job_pool->GetStats(sim->job_pool_stats[0]);
+    }
+    if (PHY_ALLOC_WATCH) alloc_watch_begin();
+    sim->physics_system->Update(PHY_FIXED_TIME_STEP, 1, sim->temp_allocator, sim->job_system, &sim->physics_stats);
+    sim->step_index += 1;
+    if (PHY_ALLOC_WATCH) {
+        const u32 num_allocations = alloc_watch_end();
+        if (num_allocations > 0 && sim->step_index > PHY_ALLOC_WATCH_WARMUP_STEPS) {
+            LOG("[sim] Step %llu: %u heap allocations", static_cast<unsigned long long>(sim->step_index), num_allocations);
+            alloc_watch_report("[sim]");
+        }
+        alloc_watch_clear();
+    }
+    if (sim->job_pool) sim->job_pool->GetStats(sim->job_pool_stats[1]);
+    profile_next_frame();
+    sim_plot_physics_stats(sim->physics_stats);
+
+    // Restarting the workers between steps is safe: no physics jobs are in flight and no other thread queues jobs on this
+    // pool while the simulation runs (the main thread strokes paths on its own pool)
+    if (sim->thread_tuner) {
+        const i32 num_threads = static_cast<i32>(physics_thread_tuner_add_step(sim->thread_tuner, static_cast<f64>(sim->physics_stats.mTotalTime) * 1.0e-9));
+        if (num_threads != sim->job_pool->GetMaxConcurrency()) sim->job_pool->SetNumThreads(num_threads - 1);
+        TracyPlot("Physics threads", static_cast<i64>(num_threads));
+    }
+
+    const JPH::TempAllocatorGrowing::Stats& temp_stats = sim->temp_allocator->GetStats();
+    TracyPlot("Physics temp peak (KiB)", static_cast<i64>(temp_stats.mPeakUsage / 1024));
+    TracyPlot("Physics temp capacity (KiB)", static_cast<i64>(temp_stats.mCapacity / 1024));
+    TracyPlot("Physics temp overflows", static_cast<i64>(temp_stats.mNumOverflows));
+    if (temp_stats.mNumOverflows > 0) {
+        LOG("[sim] Step %llu: temp allocator grew to %u blocks, %u KiB (peak %u KiB)", static_cast<unsigned long long>(sim->step_index), temp_stats.mPeakNumBlocks, temp_stats.mPeakCapacity / 1024, temp_stats.mPeakUsage / 1024);
+    }
+
+    const JPH::BodyInterface& bi = sim->physics_system->GetBodyInterfaceNoLock();
+
+    // Sync objects with their bodies and return pieces that fell out of the view to the pool
+    sim->release_batch.clear();
+    for (usize i = sim->objects.size(); i-- > 0;) {
+        const JPH::BodyID body_id = sim->objects[i].body_id;
+        if (body_id.IsInvalid()) continue;
+
+        JPH::RVec3 position;
+        JPH::Quat rotation;
+        bi.GetPositionAndRotation(body_id, position, rotation);
+
+        if (position.GetY() < sim->kill_y) {
+            sim->release_batch.push_back(body_id);
+            sim->objects[i] = sim->objects.back();
+            sim->objects.pop_back();
+            sim->cpp_hlsl_objects[i] = sim->cpp_hlsl_objects.back();
+            sim->cpp_hlsl_objects.pop_back();
+            continue;
+        }
+
+        CppHlsl_Object* obj = &sim->cpp_hlsl_objects[i];
+        obj->x = static_cast<f32>(position.GetX());
+        obj->y = static_cast<f32>(position.GetY());
+        obj->rotation_in_radians = rotation.GetRotationAngle(JPH::Vec3::sAxisZ());
+    }
+    fracture_release(sim->fracture, sim->release_batch.data(), static_cast<u32>(sim->release_batch.size()));
+
+    // Publish
+    SimSnapshot* snapshot = triple_buffer_back(&sim->snapshots);
+    snapshot->step_index = sim->step_index;
+    snapshot->last_command_id = sim->last_command_id;
+    snapshot->fracture_stats = sim->fracture->stats;
+    snapshot->temp_allocator_stats = temp_stats;
+    sim_collect_job_stats(sim, &snapshot->job_stats);
+    snapshot->physics_stats = sim->physics_stats;
+    snprintf(snapshot->thread_tuner_decision, sizeof(snapshot->thread_tuner_decision), "%s", sim->thread_tuner ? sim->thread_tuner->decision : "");
+    snapshot->num_free_pool_bodies = static_cast<u32>(sim->fracture->free_bodies.size());
+    snapshot->num_pool_bodies = static_cast<u32>(sim->fracture->all_bodies.size());
+    snapshot->num_objects = static_cast<u32>(sim->objects.size());
+    memcpy(snapshot->objects, sim->objects.data(), sim->objects.size() * sizeof(Object));
+    memcpy(snapshot->cpp_hlsl_objects, sim->cpp_hlsl_objects.data(), sim->cpp_hlsl_objects.size() * sizeof(CppHlsl_Object));
+    snapshot->publish_time = sim_time();
+    triple_buffer_publish(&sim->snapshots);
+}
+
+func sim_thread_main(SimState* sim) -> void
+{
+#if defined(TRACY_ENABLE)
+    tracy::SetThreadName("Simulation");
+#endif
+    profile_thread_start("Simulation");
+    LOG("[sim] Simulation thread started");
+
+    f64 next_step_time = sim_time();
+    while (!sim->quit.load(std::memory_order_relaxed)) {
+        sim_step(sim);
+
+        if (sim->step_interval > 0.0f) {
+            next_step_time += sim->step_interval;
+
+            const f64 now = sim_time();
+            if (now > next_step_time + SIM_MAX_STEPS_BEHIND * sim->step_interval) next_step_time = now;
+            if (next_step_time > now) std::this_thread::sleep_for(std::chrono::duration<f64>(next_step_time - now));
+        }
+    }
+
+    LOG("[sim] Simulation thread stopped after %llu steps", static_cast<unsigned long long>(sim->step_index));
+    profile_thread_end();
+    alloc_thread_exit();
+}
+
+func sim_start(SimState* sim) -> void
+{
+    // The first snapshot is published synchronously so the render thread never sees an empty world.
+    sim_step(sim);
+    sim->thread = std::thread(sim_thread_main, sim);
+}
+
+func sim_stop(SimState* sim) -> void
+{
+    if (!sim->thread.joinable()) return;
+    sim->quit.store(true, std::memory_order_relaxed);
+    sim->thread.join();
+}
+
+// Called from the render thread. Returns false when the queue is full (the command should be retried next frame).
+func sim_push_command(SimState* sim, SimCommand cmd) -> bool
+{
+    return spsc_push(&sim->commands, cmd);
+}
@@ -0,0 +1,423 @@
+#define STROKE_JOIN_MITER 0
+#define STROKE_JOIN_ROUND 1
+#define STROKE_JOIN_BEVEL 2
+
+#define STROKE_CAP_BUTT 0
+#define STROKE_CAP_SQUARE 1
+#define STROKE_CAP_ROUND 2
+
+#define STROKE_INVALID_ENTRY 0xffffffff
+#define STROKE_PATHS_PER_JOB 8
+
+// All members are 4 bytes wide so the struct has no padding and can be hashed as raw memory.
+struct StrokeStyle
+{
+    f32 width;
+    f32 miter_limit; // Miter length / half width, above which a miter join falls back to bevel
+    f32 tolerance; // Max distance between a round join/cap and its flattened version
+    u32 join;
+    u32 cap;
+    u32 closed;
+};
+static_assert(sizeof(StrokeStyle) == 24);
+
+struct StrokePath
+{
+    const CppHlsl_Vertex* points;
+    u32 num_points;
+    StrokeStyle style;
+
+    // Output of stroke_paths(), triangle list. Valid until the next call to stroke_paths().
+    const std::vector<CppHlsl_Vertex>* vertices;
+};
+
+struct StrokeCacheEntry
+{
+    u64 key;
+    StrokeStyle style; // Full key, compared on a hit since different paths can have the same hash
+    std::vector<CppHlsl_Vertex> points;
+    u64 last_batch;
+    u32 prev, next; // LRU list (head is the most recently used entry)
+    bool is_valid;
+    std::vector<CppHlsl_Vertex> vertices;
+};
+
+struct StrokeCacheStats
+{
+    u64 num_hits;
+    u64 num_misses;
+    u64 num_evictions;
+    u64 num_collisions;
+    u64 num_vertices_reused;
+};
+
+struct StrokeCache
+{
+    std::vector<StrokeCacheEntry> entries;
+    std::unordered_map<u64, u32> lookup;
+    u32 head, tail;
+    u64 batch;
+
+    // Paths (and the entries they go to) that need tessellating in the current batch.
+    std::vector<u32> miss_paths;
+    std::vector<u32> miss_entries;
+
+    StrokeCacheStats stats;
+};
+
+//
+// Stroker
+//
+
+// Per-path scratch memory. Segment data is kept as SoA so the direction/normal pass runs 4 segments at a time.
+// Each array has room for stroke_scratch_capacity() floats.
+struct StrokeScratch
+{
+    f32* px; // Points with zero length segments removed
+    f32* py;
+    f32* dx; // Normalized segment directions
+    f32* dy;
+};
+
+// Floats per StrokeScratch array for polylines of up to `max_points` points: one for the closing point and up to
+// three padding lanes.
+func stroke_scratch_capacity(u32 max_points) -> usize
+{
+    return max_points + 4;
+}
+
+func stroke_emit_triangle(std::vector<CppHlsl_Vertex>* out, f32 ax, f32 ay, f32 bx, f32 by, f32 cx, f32 cy) -> void
+{
+    out->push_back({ ax, ay });
+    out->push_back({ bx, by });
+    out->push_back({ cx, cy });
+}
+
+// Triangle fan around (cx, cy) from angle a0 sweeping by `sweep` radians.
+func stroke_emit_arc(std::vector<CppHlsl_Vertex>* out, f32 cx, f32 cy, f32 radius, f32 a0, f32 sweep, f32 tolerance) -> void
+{
+    const f32 t = std::clamp(1.0f - tolerance / radius, -1.0f, 1.0f);
+    const f32 max_step = std::max(2.0f * acosf(t), 0.05f);
+    const u32 num_steps = std::max(1u, static_cast<u32>(ceilf(fabsf(sweep) / max_step)));
+    const f32 step = sweep / static_cast<f32>(num_steps);
+
+    f32 x0 = cx + radius * cosf(a0);
+    f32 y0 = cy + radius * sinf(a0);
+    for (u32 i = 1; i <= num_steps; ++i) {
+        const f32 a = a0 + step * static_cast<f32>(i);
+        const f32 x1 = cx + radius * cosf(a);
+        const f32 y1 = cy + radius * sinf(a);
+        stroke_emit_triangle(out, cx, cy, x0, y0, x1, y1);
+        x0 = x1;
+        y0 = y1;
+    }
+}
+
+// Join between incoming segment direction (ax, ay) and outgoing direction (bx, by) at point (px, py).
+func stroke_emit_join(std::vector<CppHlsl_Vertex>* out, const StrokeStyle* style, f32 px, f32 py, f32 ax, f32 ay, f32 bx, f32 by) -> void
+{
+    const f32 hw = 0.5f * style->width;
+    const f32 cross = ax * by - ay * bx;
+    const f32 dot = ax * bx + ay * by;
+    if (fabsf(cross) < 1.0e-6f && dot > 0.0f) return; // Collinear, segment quads already meet.
+
+    // Outer side of the turn is on the right for a left turn and on the left for a right turn.
+    const f32 s = cross > 0.0f ? -1.0f : 1.0f;
+    const f32 n0x = -ay * s, n0y = ax * s;
+    const f32 n1x = -by * s, n1y = bx * s;
+
+    const f32 p0x = px + n0x * hw, p0y = py + n0y * hw;
+    const f32 p1x = px + n1x * hw, p1y = py + n1y * hw;
+
+    switch (style->join) {
+        case STROKE_JOIN_MITER: {
+            f32 mx = n0x + n1x, my = n0y + n1y;
+            const f32 len = sqrtf(mx * mx + my * my);
+            if (len > 1.0e-6f) {
+                mx /= len;
+                my /= len;
+                const f32 cos_half = mx * n1x + my * n1y;
+                if (cos_half > 1.0e-6f && 1.0f / cos_half <= style->miter_limit) {
+                    const f32 tx = px + mx * hw / cos_half;
+                    const f32 ty = py + my * hw / cos_half;
+                    stroke_emit_triangle(out, px, py, p0x, p0y, tx, ty);
+                    stroke_emit_triangle(out, px, py, tx, ty, p1x, p1y);
+                    return;
+                }
+            }
+            stroke_emit_triangle(out, px, py, p0x, p0y, p1x, p1y);
+        } break;
+        case STROKE_JOIN_ROUND: {
+            const f32 a0 = atan2f(n0y, n0x);
+            f32 sweep = atan2f(n1y, n1x) - a0;
+            if (sweep > JPH::JPH_PI) sweep -= 2.0f * JPH::JPH_PI;
+            if (sweep < -JPH::JPH_PI) sweep += 2.0f * JPH::JPH_PI;
+            stroke_emit_arc(out, px, py, hw, a0, sweep, style->tolerance);
+        } break;
+        default:
+            stroke_emit_triangle(out, px, py, p0x, p0y, p1x, p1y);
+            break;
+    }
+}
+
+// Cap at (px, py) facing direction (dx, dy) (away from the stroke).
+func stroke_emit_cap(std::vector<CppHlsl_Vertex>* out, const StrokeStyle* style, f32 px, f32 py, f32 dx, f32 dy) -> void
+{
+    const f32 hw = 0.5f * style->width;
+    const f32 nx = -dy * hw, ny = dx * hw;
+
+    switch (style->cap) {
+        case STROKE_CAP_SQUARE: {
+            const f32 ex = px + dx * hw, ey = py + dy * hw;
+            stroke_emit_triangle(out, px + nx, py + ny, px - nx, py - ny, ex + nx, ey + ny);
+            stroke_emit_triangle(out, ex + nx, ey + ny, px - nx, py - ny, ex - nx, ey - ny);
+        } break;
+        case STROKE_CAP_ROUND:
+            stroke_emit_arc(out, px, py, hw, atan2f(ny, nx), -JPH::JPH_PI, style->tolerance);
+            break;
+        default:
+            break;
+    }
+}
+
+// Strokes a polyline into a triangle list. Triangles may overlap on the inner side of joins, which is fine for
+// opaque rendering.
+// `scratch` must have room for stroke_scratch_capacity(num_points) floats per array.
+func stroke_polyline(const CppHlsl_Vertex* points, u32 num_points, const StrokeStyle* style, const StrokeScratch* scratch, std::vector<CppHlsl_Vertex>* out) -> void
+{
+    ZoneScoped;
+    assert(style && scratch && out);
+
+    out->clear();
+
+    // Remove zero length segments
+    usize num = 0;
+    for (u32 i = 0; i < num_points; ++i) {
+        if (num > 0 && fabsf(points[i].x - scratch->px[num - 1]) < 1.0e-6f && fabsf(points[i].y - scratch->py[num - 1]) < 1.0e-6f)
+            continue;
+        scratch->px[num] = points[i].x;
+        scratch->py[num] = points[i].y;
+        num += 1;
+    }
+    if (style->closed && num > 2) {
+        // Repeat the first point so the closing segment is handled like any other.
+        scratch->px[num] = scratch->px[0];
+        scratch->py[num] = scratch->py[0];
+        num += 1;
+    }
+
+    if (num < 2) return;
+    const usize num_segments = num - 1;
+
+    // Segment directions, 4 at a time. Arrays are padded to a multiple of 4 (padding lanes get a dummy direction).
+    const usize num_padded = (num_segments + 3) & ~static_cast<usize>(3);
+    for (usize i = num; i < num_padded + 1; ++i) {
+        scratch->px[i] = scratch->px[num - 1] + 1.0f;
+        scratch->py[i] = scratch->py[num - 1];
+    }
+
+    for (usize i = 0; i < num_padded; i += 4) {
+        const JPH::Vec4 x0(scratch->px[i + 0], scratch->px[i + 1], scratch->px[i + 2], scratch->px[i + 3]);
+        const JPH::Vec4 y0(scratch->py[i + 0], scratch->py[i + 1], scratch->py[i + 2], scratch->py[i + 3]);
+        const JPH::Vec4 x1(scratch->px[i + 1], scratch->px[i + 2], scratch->px[i + 3], scratch->px[i + 4]);
+        const JPH::Vec4 y1(scratch->py[i + 1], scratch->py[i + 2], scratch->py[i + 3], scratch->py[i + 4]);
+
+        const JPH::Vec4 dx = x1 - x0;
+        const JPH::Vec4 dy = y1 - y0;
+        const JPH::Vec4 rcp_len = (dx * dx + dy * dy).Sqrt().Reciprocal();
+
+        (dx * rcp_len).StoreFloat4(reinterpret_cast<JPH::Float4*>(&scratch->dx[i]));
+        (dy * rcp_len).StoreFloat4(reinterpret_cast<JPH::Float4*>(&scratch->dy[i]));
+    }
+
+    const f32 hw = 0.5f * style->width;
+    const f32* px = scratch->px;
+    const f32* py = scratch->py;
+    const f32* dx = scratch->dx;
+    const f32* dy = scratch->dy;
+
+    // Segment quads
+    for (usize i = 0; i < num_segments; ++i) {
+        const f32 nx = -dy[i] * hw, ny = dx[i] * hw;
+        stroke_emit_triangle(out, px[i] + nx, py[i] + ny, px[i] - nx, py[i] - ny, px[i + 1] + nx, py[i + 1] + ny);
+        stroke_emit_triangle(out, px[i + 1] + nx, py[i + 1] + ny, px[i] - nx, py[i] - ny, px[i + 1] - nx, py[i + 1] - ny);
+    }
+
+    // Joins
+    for (usize i = 1; i < num_segments; ++i) {
+        stroke_emit_join(out, style, px[i], py[i], dx[i - 1], dy[i - 1], dx[i], dy[i]);
+    }
+
+    if (style->closed && num > 3) {
+        stroke_emit_join(out, style, px[0], py[0], dx[num_segments - 1], dy[num_segments - 1], dx[0], dy[0]);
+    } else {
+        stroke_emit_cap(out, style, px[0], py[0], -dx[0], -dy[0]);
+        stroke_emit_cap(out, style, px[num_segments], py[num_segments], dx[num_segments - 1], dy[num_segments - 1]);
+    }
+}
+
+//
+// Cache
+//
+
+func stroke_hash(const StrokePath* path) -> u64
+{
+    u64 hash = JPH::HashBytes(&path->style, sizeof(path->style));
+    hash = JPH::Hash64(hash ^ path->num_points);
+    for (u32 i = 0; i < path->num_points; ++i) {
+        u64 v;
+        memcpy(&v, &path->points[i], sizeof(v));
+        hash = JPH::Hash64(hash ^ v);
+    }
+    return hash;
+}
+
+func stroke_cache_entry_matches(const StrokeCacheEntry* e, const StrokePath* path) -> bool
+{
+    return e->points.size() == path->num_points
+        && memcmp(&e->style, &path->style, sizeof(e->style)) == 0
+        && memcmp(e->points.data(), path->points, path->num_points * sizeof(CppHlsl_Vertex)) == 0;
+}
+
+func init_stroke_cache(StrokeCache* cache, u32 capacity) -> void
+{
+    assert(cache && capacity > 0);
+
+    cache->entries.resize(capacity);
+    cache->lookup.reserve(capacity);
+    cache->miss_paths.reserve(capacity);
+    cache->miss_entries.reserve(capacity);
+
+    for (u32 i = 0; i < capacity; ++i) {
+        StrokeCacheEntry* e = &cache->entries[i];
+        e->prev = i == 0 ? STROKE_INVALID_ENTRY : i - 1;
+        e->next = i + 1 == capacity ? STROKE_INVALID_ENTRY : i + 1;
+        e->is_valid = false;
+    }
+    cache->head = 0;
+    cache->tail = capacity - 1;
+    cache->batch = 0;
+    cache->stats = {};
+}
+
+func stroke_cache_unlink(StrokeCache* cache, u32 index) -> void
+{
+    StrokeCacheEntry* e = &cache->entries[index];
+    if (e->prev != STROKE_INVALID_ENTRY) cache->entries[e->prev].next = e->next; else cache->head = e->next;
+    if (e->next != STROKE_INVALID_ENTRY) cache->entries[e->next].prev = e->prev; else cache->tail = e->prev;
+}
+
+func stroke_cache_push_front(StrokeCache* cache, u32 index) -> void
+{
+    StrokeCacheEntry* e = &cache->entries[index];
+    e->prev = STROKE_INVALID_ENTRY;
+    e->next = cache->head;
+    if (cache->head != STROKE_INVALID_ENTRY) cache->entries[cache->head].prev = index;
+    cache->head = index;
+    if (cache->tail == STROKE_INVALID_ENTRY) cache->tail = index;
+}
+
+// Tessellates `paths` (or fetches them from the cache) and sets `StrokePath::vertices` for each of them.
+// Misses are tessellated in parallel on `job_system` (can be null).
+func stroke_paths(StrokeCache* cache, JPH::JobSystem* job_system, StrokePath* paths, u32 num_paths) -> void
+{
+    ZoneScoped;
+    assert(cache && num_paths <= cache->entries.size());
+
+    cache->batch += 1;
+    cache->miss_paths.clear();
+    cache->miss_entries.clear();
+
+    for (u32 i = 0; i < num_paths; ++i) {
+        StrokePath* path = &paths[i];
+        const u64 key = stroke_hash(path);
+
+        u32 index;
+        auto it = cache->lookup.find(key);
+        if (it != cache->lookup.end() && stroke_cache_entry_matches(&cache->entries[it->second], path)) {
+            index = it->second;
+            cache->stats.num_hits += 1;
+            cache->stats.num_vertices_reused += cache->entries[index].vertices.size();
+        } else {
+            // On a hash collision the other path is dropped from the cache. If this batch already uses it, this path isn't cached instead.
+            bool is_cached = true;
+            if (it != cache->lookup.end()) {
+                StrokeCacheEntry* other = &cache->entries[it->second];
+                if (other->last_batch == cache->batch) {
+                    is_cached = false;
+                } else {
+                    other->is_valid = false;
+                    cache->lookup.erase(it);
+                }
+                cache->stats.num_collisions += 1;
+            }
+
+            // Evict the least recently used entry. Entries used by this batch are at the front so the tail is never one of them.
+            index = cache->tail;
+            StrokeCacheEntry* e = &cache->entries[index];
+            assert(e->last_batch != cache->batch);
+            if (e->is_valid) {
+                cache->lookup.erase(e->key);
+                cache->stats.num_evictions += 1;
+            }
+            e->key = key;
+            e->style = path->style;
+            e->points.assign(path->points, path->points + path->num_points);
+            e->is_valid = is_cached;
+            if (is_cached) cache->lookup[key] = index;
+            cache->miss_paths.push_back(i);
+            cache->miss_entries.push_back(index);
+            cache->stats.num_misses += 1;
+        }
+
+        StrokeCacheEntry* e = &cache->entries[index];
+        e->last_batch = cache->batch;
+        stroke_cache_unlink(cache, index);
+        stroke_cache_push_front(cache, index);
+
+        path->vertices = &e->vertices;
+    }
+
+    const u32 num_misses = static_cast<u32>(cache->miss_paths.size());
+    if (num_misses == 0) return;
+
+    auto tessellate = [cache, paths](u32 first, u32 last) {
+        u32 max_points = 0;
+        for (u32 m = first; m < last; ++m) max_points = std::max(max_points, paths[cache->miss_paths[m]].num_points);
+
+        // Scratch comes from the worker's temp allocator when there is one, so a job doesn't touch the heap for it
+        const usize capacity = stroke_scratch_capacity(max_points);
+        const u32 num_bytes = static_cast<u32>(4 * capacity * sizeof(f32));
+        JPH::TempAllocator* temp_allocator = JPH::JobSystem::sGetThreadTempAllocator();
+        std::vector<f32> heap_memory;
+        f32* memory;
+        if (temp_allocator) {
+            memory = static_cast<f32*>(temp_allocator->Allocate(num_bytes));
+        } else {
+            heap_memory.resize(4 * capacity);
+            memory = heap_memory.data();
+        }
+        const StrokeScratch scratch = { memory, memory + capacity, memory + 2 * capacity, memory + 3 * capacity };
+
+        for (u32 m = first; m < last; ++m) {
+            const StrokePath* path = &paths[cache->miss_paths[m]];
+            stroke_polyline(path->points, path->num_points, &path->style, &scratch, &cache->entries[cache->miss_entries[m]].vertices);
+        }
+
+        if (temp_allocator) temp_allocator->Free(memory, num_bytes);
+    };
+
+    if (job_system == nullptr || num_misses <= STROKE_PATHS_PER_JOB) {
+        tessellate(0, num_misses);
+        return;
+    }
+
+    JPH::JobSystem::Barrier* barrier = job_system->CreateBarrier();
+    for (u32 first = 0; first < num_misses; first += STROKE_PATHS_PER_JOB) {
+        const u32 last = std::min(first + STROKE_PATHS_PER_JOB, num_misses);
+        const JPH::JobHandle job = job_system->CreateJob("StrokePaths", JPH::Color::sGreen, [&tessellate, first, last]() { tessellate(first, last); });
+        barrier->AddJob(job);
+    }
+    job_system->WaitForJobs(barrier);
+    job_system->DestroyBarrier(barrier);
+}
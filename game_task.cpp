@@ -0,0 +1,24 @@
+//
+// Coroutine tasks on top of the physics job system. A task runs on the calling thread until its first co_await and
+// destroys itself when it returns. Awaiting jobs with JPH::JobAwaiter suspends the task instead of blocking a thread;
+// it is resumed on the worker that finishes the last awaited job. `co_await JPH::ResumeOnJobSystem(job_system)` moves a
+// task that was started on the main thread to a worker.
+//
+
+struct Task
+{
+    struct promise_type
+    {
+        auto get_return_object() -> Task { return {}; }
+        auto initial_suspend() noexcept -> std::suspend_never { return {}; }
+        auto final_suspend() noexcept -> std::suspend_never { return {}; }
+        auto return_void() -> void {}
+        auto unhandled_exception() -> void { std::terminate(); }
+    };
+};
+
+// Runs `fn` as a job; `co_await` the result to suspend until the job has finished.
+template<typename F> func task_run(JPH::JobSystem* job_system, const char* name, F&& fn) -> JPH::JobAwaiter
+{
+    return JPH::JobAwaiter(job_system->CreateJob(name, JPH::Color::sCyan, std::forward<F>(fn)));
+}
@@ -0,0 +1,332 @@
+#pragma warning(push)
+#pragma warning(disable:4018)
+#pragma warning(disable:4100)
+#pragma warning(disable:4146)
+#pragma warning(disable:4189)
+#pragma warning(disable:4242)
+#pragma warning(disable:4244)
+#pragma warning(disable:4267)
+#pragma warning(disable:4365)
+#pragma warning(disable:4389)
+#pragma warning(disable:4456)
+#pragma warning(disable:4457)
+#pragma warning(disable:4701)
+#pragma warning(disable:4702)
+#pragma warning(disable:4706)
+#pragma warning(disable:5219)
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "imstb_truetype.h"
+#pragma warning(pop)
+
+#define TEXT_FIRST_CHAR 32
+#define TEXT_NUM_CHARS 95 // Printable ASCII
+#define TEXT_SDF_PIXEL_HEIGHT 48.0f // Font size the SDF is rasterized at
+#define TEXT_SDF_PADDING 6 // Distance range (in SDF pixels) encoded around each glyph
+#define TEXT_SDF_ONEDGE 128
+#define TEXT_ATLAS_WIDTH 512
+#define TEXT_ATLAS_SPACING 1
+#define TEXT_CACHE_MAGIC 0x41464453 // 'SDFA'
+#define TEXT_CACHE_VERSION 1
+
+struct TextGlyph
+{
+    u16 x, y, width, height; // Rect in the atlas (pixels)
+    f32 offset_x, offset_y; // Top-left corner of the rect relative to the pen position (SDF pixels, y down)
+    f32 advance; // SDF pixels
+};
+
+// Everything below except `pixels` is written to the cache file as is.
+struct TextAtlasHeader
+{
+    u32 magic;
+    u32 version;
+    u64 key;
+    u32 width, height;
+    f32 ascent, descent, line_gap; // SDF pixels
+};
+
+struct TextAtlas
+{
+    TextAtlasHeader header;
+    TextGlyph glyphs[TEXT_NUM_CHARS];
+    f32 kerning[TEXT_NUM_CHARS * TEXT_NUM_CHARS]; // SDF pixels, [first * TEXT_NUM_CHARS + second]
+    std::vector<u8> pixels; // R8, header.width * header.height
+};
+
+func text_read_file(const char* filename) -> std::vector<u8>
+{
+    std::vector<u8> data;
+
+    FILE* file = fopen(filename, "rb");
+    if (file == nullptr) return data;
+    defer { fclose(file); };
+
+    fseek(file, 0, SEEK_END);
+    const long size_in_bytes = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size_in_bytes <= 0) return data;
+
+    data.resize(static_cast<usize>(size_in_bytes));
+    if (fread(data.data(), 1, data.size(), file) != data.size()) data.clear();
+    return data;
+}
+
+// Identifies the font file together with every parameter that affects the generated atlas.
+func text_atlas_key(const std::vector<u8>& font_data) -> u64
+{
+    const u32 params[] = {
+        TEXT_CACHE_VERSION, TEXT_FIRST_CHAR, TEXT_NUM_CHARS, static_cast<u32>(TEXT_SDF_PIXEL_HEIGHT), TEXT_SDF_PADDING, TEXT_SDF_ONEDGE, TEXT_ATLAS_WIDTH, TEXT_ATLAS_SPACING,
+    };
+    const u64 hash = JPH::HashBytes(font_data.data(), static_cast<u32>(font_data.size()));
+    return JPH::HashBytes(params, sizeof(params), hash);
+}
+
+// Generates the SDF bitmap of every glyph (one job per glyph when `job_system` is not null) and packs them into
+// rows of the atlas.
+func build_text_atlas(TextAtlas* atlas, const std::vector<u8>& font_data, JPH::JobSystem* job_system) -> bool
+{
+    ZoneScoped;
+    assert(atlas);
+
+    stbtt_fontinfo font;
+    if (!stbtt_InitFont(&font, font_data.data(), stbtt_GetFontOffsetForIndex(font_data.data(), 0))) return false;
+
+    const f32 scale = stbtt_ScaleForPixelHeight(&font, TEXT_SDF_PIXEL_HEIGHT);
+
+    i32 ascent, descent, line_gap;
+    stbtt_GetFontVMetrics(&font, &ascent, &descent, &line_gap);
+
+    atlas->header = {
+        .magic = TEXT_CACHE_MAGIC,
+        .version = TEXT_CACHE_VERSION,
+        .key = text_atlas_key(font_data),
+        .width = TEXT_ATLAS_WIDTH,
+        .height = 0,
+        .ascent = scale * static_cast<f32>(ascent),
+        .descent = scale * static_cast<f32>(descent),
+        .line_gap = scale * static_cast<f32>(line_gap),
+    };
+
+    // Rasterize
+    std::vector<u8> bitmaps[TEXT_NUM_CHARS];
+
+    auto rasterize = [&](u32 index) {
+        const i32 glyph_index = stbtt_FindGlyphIndex(&font, static_cast<i32>(TEXT_FIRST_CHAR + index));
+
+        i32 advance, lsb;
+        stbtt_GetGlyphHMetrics(&font, glyph_index, &advance, &lsb);
+
+        i32 w = 0, h = 0, xoff = 0, yoff = 0;
+        u8* sdf = stbtt_GetGlyphSDF(&font, scale, glyph_index, TEXT_SDF_PADDING, TEXT_SDF_ONEDGE, static_cast<f32>(TEXT_SDF_ONEDGE) / TEXT_SDF_PADDING, &w, &h, &xoff, &yoff);
+
+        TextGlyph* glyph = &atlas->glyphs[index];
+        *glyph = {
+            .width = static_cast<u16>(w),
+            .height = static_cast<u16>(h),
+            .offset_x = static_cast<f32>(xoff),
+            .offset_y = static_cast<f32>(yoff),
+            .advance = scale * static_cast<f32>(advance),
+        };
+        if (sdf) {
+            bitmaps[index].assign(sdf, sdf + w * h);
+            stbtt_FreeSDF(sdf, nullptr);
+        }
+    };
+
+    if (job_system) {
+        JPH::JobSystem::Barrier* barrier = job_system->CreateBarrier();
+        for (u32 i = 0; i < TEXT_NUM_CHARS; ++i) {
+            barrier->AddJob(job_system->CreateJob("TextSdfGlyph", JPH::Color::sCyan, [&rasterize, i]() { rasterize(i); }));
+        }
+        job_system->WaitForJobs(barrier);
+        job_system->DestroyBarrier(barrier);
+    } else {
+        for (u32 i = 0; i < TEXT_NUM_CHARS; ++i) rasterize(i);
+    }
+
+    // Kerning
+    for (u32 a = 0; a < TEXT_NUM_CHARS; ++a) {
+        const i32 ga = stbtt_FindGlyphIndex(&font, static_cast<i32>(TEXT_FIRST_CHAR + a));
+        for (u32 b = 0; b < TEXT_NUM_CHARS; ++b) {
+            const i32 gb = stbtt_FindGlyphIndex(&font, static_cast<i32>(TEXT_FIRST_CHAR + b));
+            atlas->kerning[a * TEXT_NUM_CHARS + b] = scale * static_cast<f32>(stbtt_GetGlyphKernAdvance(&font, ga, gb));
+        }
+    }
+
+    // Pack, tallest first, into shelves
+    u32 order[TEXT_NUM_CHARS];
+    for (u32 i = 0; i < TEXT_NUM_CHARS; ++i) order[i] = i;
+    std::sort(order, order + TEXT_NUM_CHARS, [atlas](u32 a, u32 b) { return atlas->glyphs[a].height > atlas->glyphs[b].height; });
+
+    u32 x = 0, y = 0, shelf_height = 0;
+    for (u32 i = 0; i < TEXT_NUM_CHARS; ++i) {
+        TextGlyph* glyph = &atlas->glyphs[order[i]];
+        if (glyph->width == 0) continue;
+
+        if (x + glyph->width > TEXT_ATLAS_WIDTH) {
+            x = 0;
+            y += shelf_height + TEXT_ATLAS_SPACING;
+            shelf_height = 0;
+        }
+        glyph->x = static_cast<u16>(x);
+        glyph->y = static_cast<u16>(y);
+        x += glyph->width + TEXT_ATLAS_SPACING;
+        shelf_height = std::max(shelf_height, static_cast<u32>(glyph->height));
+    }
+
+    u32 height = 1;
+    while (height < y + shelf_height) height *= 2;
+    atlas->header.height = height;
+
+    atlas->pixels.assign(TEXT_ATLAS_WIDTH * height, 0);
+    for (u32 i = 0; i < TEXT_NUM_CHARS; ++i) {
+        const TextGlyph* glyph = &atlas->glyphs[i];
+        for (u32 row = 0; row < glyph->height; ++row) {
+            memcpy(&atlas->pixels[(glyph->y + row) * TEXT_ATLAS_WIDTH + glyph->x], &bitmaps[i][row * glyph->width], glyph->width);
+        }
+    }
+    return true;
+}
+
+func text_atlas_cache_path(const char* cache_dir, u64 key, char* path, usize path_size) -> void
+{
+    snprintf(path, path_size, "%s/font_%016llx.sdf", cache_dir, static_cast<unsigned long long>(key));
+}
+
+func read_text_atlas_cache(TextAtlas* atlas, const char* path, u64 key) -> bool
+{
+    const std::vector<u8> data = text_read_file(path);
+    constexpr usize fixed_size = sizeof(TextAtlasHeader) + sizeof(atlas->glyphs) + sizeof(atlas->kerning);
+    if (data.size() < fixed_size) return false;
+
+    TextAtlasHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != TEXT_CACHE_MAGIC || header.version != TEXT_CACHE_VERSION || header.key != key) return false;
+    if (data.size() != fixed_size + static_cast<usize>(header.width) * header.height) return false;
+
+    const u8* ptr = data.data();
+    atlas->header = header;
+    memcpy(atlas->glyphs, ptr + sizeof(TextAtlasHeader), sizeof(atlas->glyphs));
+    memcpy(atlas->kerning, ptr + sizeof(TextAtlasHeader) + sizeof(atlas->glyphs), sizeof(atlas->kerning));
+    atlas->pixels.assign(ptr + fixed_size, ptr + data.size());
+    return true;
+}
+
+func write_text_atlas_cache(const TextAtlas* atlas, const char* path) -> bool
+{
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) return false;
+    defer { fclose(file); };
+
+    bool ok = fwrite(&atlas->header, sizeof(atlas->header), 1, file) == 1;
+    ok = ok && fwrite(atlas->glyphs, sizeof(atlas->glyphs), 1, file) == 1;
+    ok = ok && fwrite(atlas->kerning, sizeof(atlas->kerning), 1, file) == 1;
+    ok = ok && fwrite(atlas->pixels.data(), atlas->pixels.size(), 1, file) == 1;
+    return ok;
+}
+
+// Loads the atlas from `cache_dir` when a file generated from the same font and parameters exists, otherwise builds
+// it and writes it there.
+func load_text_atlas(TextAtlas* atlas, const char* font_filename, const char* cache_dir, JPH::JobSystem* job_system) -> bool
+{
+    ZoneScoped;
+    assert(atlas && font_filename && cache_dir);
+
+    const std::vector<u8> font_data = text_read_file(font_filename);
+    if (font_data.empty()) {
+        LOG("[text] Failed to read font '%s'", font_filename);
+        return false;
+    }
+
+    const u64 key = text_atlas_key(font_data);
+    char path[256];
+    text_atlas_cache_path(cache_dir, key, path, sizeof(path));
+
+    if (read_text_atlas_cache(atlas, path, key)) {
+        LOG("[text] SDF atlas loaded from '%s' (%dx%d)", path, atlas->header.width, atlas->header.height);
+        return true;
+    }
+
+    if (!build_text_atlas(atlas, font_data, job_system)) {
+        LOG("[text] Failed to parse font '%s'", font_filename);
+        return false;
+    }
+    if (!write_text_atlas_cache(atlas, path)) LOG("[text] Failed to write SDF atlas cache '%s'", path);
+
+    LOG("[text] SDF atlas generated (%dx%d)", atlas->header.width, atlas->header.height);
+    return true;
+}
+
+func text_pack_uv(f32 u, f32 v) -> u32
+{
+    return static_cast<u32>(u * 65535.0f + 0.5f) | (static_cast<u32>(v * 65535.0f + 0.5f) << 16);
+}
+
+func text_char_index(char c) -> u32
+{
+    const u32 index = static_cast<u32>(static_cast<u8>(c)) - TEXT_FIRST_CHAR;
+    return index < TEXT_NUM_CHARS ? index : static_cast<u32>('?' - TEXT_FIRST_CHAR);
+}
+
+// Width of the longest line of `text` in world units for a font `size` (em height) in world units.
+func text_measure(const TextAtlas* atlas, const char* text, f32 size) -> f32
+{
+    const f32 scale = size / TEXT_SDF_PIXEL_HEIGHT;
+
+    f32 width = 0.0f, pen = 0.0f;
+    u32 prev = TEXT_NUM_CHARS;
+    for (const char* c = text; *c; ++c) {
+        if (*c == '\n') {
+            width = std::max(width, pen);
+            pen = 0.0f;
+            prev = TEXT_NUM_CHARS;
+            continue;
+        }
+        const u32 index = text_char_index(*c);
+        if (prev < TEXT_NUM_CHARS) pen += atlas->kerning[prev * TEXT_NUM_CHARS + index];
+        pen += atlas->glyphs[index].advance;
+        prev = index;
+    }
+    return std::max(width, pen) * scale;
+}
+
+// Appends one quad per visible glyph of `text` to `out` (at most `max_glyphs` in total). (x, y) is the start of the
+// first baseline in world units, `size` is the em height in world units.
+func text_layout(const TextAtlas* atlas, const char* text, f32 x, f32 y, f32 size, u32 color, usize max_glyphs, std::vector<CppHlsl_Glyph>* out) -> void
+{
+    const f32 scale = size / TEXT_SDF_PIXEL_HEIGHT;
+    const f32 rcp_width = 1.0f / static_cast<f32>(atlas->header.width);
+    const f32 rcp_height = 1.0f / static_cast<f32>(atlas->header.height);
+    const f32 line_advance = (atlas->header.ascent - atlas->header.descent + atlas->header.line_gap) * scale;
+
+    f32 pen_x = x, pen_y = y;
+    u32 prev = TEXT_NUM_CHARS;
+    for (const char* c = text; *c; ++c) {
+        if (*c == '\n') {
+            pen_x = x;
+            pen_y -= line_advance;
+            prev = TEXT_NUM_CHARS;
+            continue;
+        }
+
+        const u32 index = text_char_index(*c);
+        const TextGlyph* glyph = &atlas->glyphs[index];
+        if (prev < TEXT_NUM_CHARS) pen_x += atlas->kerning[prev * TEXT_NUM_CHARS + index] * scale;
+        prev = index;
+
+        if (glyph->width > 0) {
+            if (out->size() >= max_glyphs) return;
+
+            out->push_back({
+                .x = pen_x + glyph->offset_x * scale,
+                .y = pen_y - glyph->offset_y * scale,
+                .width = static_cast<f32>(glyph->width) * scale,
+                .height = static_cast<f32>(glyph->height) * scale,
+                .uv0 = text_pack_uv(static_cast<f32>(glyph->x) * rcp_width, static_cast<f32>(glyph->y) * rcp_height),
+                .uv1 = text_pack_uv(static_cast<f32>(glyph->x + glyph->width) * rcp_width, static_cast<f32>(glyph->y + glyph->height) * rcp_height),
+                .color = color,
+            });
+        }
+        pen_x += glyph->advance * scale;
+    }
+}